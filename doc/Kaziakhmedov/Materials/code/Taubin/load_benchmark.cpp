@@ -0,0 +1,197 @@
+// Times the binary STL loaders on synthetic meshes, once per vertex welding mode.
+//
+// Example usage: load_benchmark [triangle_count ...]
+// With no arguments, meshes of 1M, 10M and 50M triangles are used.
+
+#include "../../../../../src/common/mesh.h"
+
+#include <string>
+using std::string;
+
+#include <sstream>
+using std::ostringstream;
+
+#include <chrono>
+#include <cstdio> // for remove()
+#include <cstdlib> // for strtoul()
+
+
+// Writes a rectangular height field grid as a binary STL file. Interior vertices
+// are shared by six triangles, which is typical of what the loader sees.
+bool write_synthetic_stereo_lithography_file(const char *const file_name, const size_t num_triangles)
+{
+	ofstream out(file_name, ios_base::binary);
+
+	if(out.fail())
+		return false;
+
+	const size_t header_size = 80;
+	vector<char> header(header_size, 0);
+	const unsigned int num_triangles_ui = static_cast<unsigned int>(num_triangles);
+
+	out.write(&header[0], header_size);
+	out.write(reinterpret_cast<const char *>(&num_triangles_ui), sizeof(unsigned int));
+
+	const size_t per_triangle_data_size = (12*sizeof(float) + sizeof(short unsigned int));
+	const size_t buffer_width = 65536;
+	vector<char> buffer(per_triangle_data_size*buffer_width, 0);
+	size_t buffer_count = 0;
+
+	size_t grid_width = 1;
+
+	while(2*grid_width*grid_width < num_triangles)
+		grid_width++;
+
+	for(size_t i = 0; i < num_triangles; i++)
+	{
+		const size_t quad = i / 2;
+		const float x = static_cast<float>(quad % grid_width);
+		const float y = static_cast<float>(quad / grid_width);
+
+		vertex_3 v[3];
+
+		if(0 == i % 2)
+		{
+			v[0] = vertex_3(x, y, 0); v[1] = vertex_3(x + 1, y, 0); v[2] = vertex_3(x + 1, y + 1, 0);
+		}
+		else
+		{
+			v[0] = vertex_3(x, y, 0); v[1] = vertex_3(x + 1, y + 1, 0); v[2] = vertex_3(x, y + 1, 0);
+		}
+
+		// Add a little relief, so that the z components vary too.
+		for(size_t j = 0; j < 3; j++)
+			v[j].z = sin(v[j].x*0.1f)*cos(v[j].y*0.1f);
+
+		char *cp = &buffer[buffer_count*per_triangle_data_size];
+		const vertex_3 normal(0, 0, 1);
+
+		memcpy(cp, &normal, 3*sizeof(float)); cp += 3*sizeof(float);
+
+		for(size_t j = 0; j < 3; j++)
+		{
+			memcpy(cp, &v[j].x, sizeof(float)); cp += sizeof(float);
+			memcpy(cp, &v[j].y, sizeof(float)); cp += sizeof(float);
+			memcpy(cp, &v[j].z, sizeof(float)); cp += sizeof(float);
+		}
+
+		if(++buffer_count == buffer_width)
+		{
+			out.write(&buffer[0], per_triangle_data_size*buffer_count);
+			buffer_count = 0;
+		}
+	}
+
+	if(buffer_count > 0)
+		out.write(&buffer[0], per_triangle_data_size*buffer_count);
+
+	return !out.fail();
+}
+
+double time_load(indexed_mesh &mesh, const char *const file_name, const weld_mode mode, const float epsilon, const bool mapped = false, const size_t num_threads = 1)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	bool loaded = false;
+
+	if(true == mapped)
+		loaded = mesh.load_from_mapped_binary_stereo_lithography_file(file_name, false, mode, epsilon, num_threads);
+	else
+		loaded = mesh.load_from_binary_stereo_lithography_file(file_name, false, 65536, mode, epsilon);
+
+	if(false == loaded)
+		return -1.0;
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	return elapsed.count();
+}
+
+// FNV-1a over the triangle index data, to check that two loads numbered vertices identically.
+uint64_t checksum_triangles(const indexed_mesh &mesh)
+{
+	uint64_t h = 14695981039346656037ULL;
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+		for(size_t j = 0; j < 3; j++)
+			h = (h ^ mesh.triangles[i].vertex_indices[j]) * 1099511628211ULL;
+
+	return h;
+}
+
+int main(int argc, char **argv)
+{
+	size_t num_threads = thread::hardware_concurrency();
+
+	if(num_threads < 2)
+		num_threads = 2;
+
+	vector<size_t> sizes;
+
+	for(int i = 1; i < argc; i++)
+		sizes.push_back(strtoul(argv[i], 0, 10));
+
+	if(0 == sizes.size())
+	{
+		sizes.push_back(1000000);
+		sizes.push_back(10000000);
+		sizes.push_back(50000000);
+	}
+
+	for(size_t i = 0; i < sizes.size(); i++)
+	{
+		ostringstream oss;
+		oss << "load_benchmark_" << sizes[i] << ".stl";
+		const string file_name = oss.str();
+
+		cout << "Generating " << sizes[i] << " triangles" << endl;
+
+		if(false == write_synthetic_stereo_lithography_file(file_name.c_str(), sizes[i]))
+		{
+			cout << "Error: Could not write file " << file_name << endl;
+			return 2;
+		}
+
+		indexed_mesh mesh;
+
+		const double set_time = time_load(mesh, file_name.c_str(), WELD_EXACT_SET, 0.0f);
+		const size_t set_vertex_count = mesh.vertices.size();
+		mesh.clear();
+
+		const double hash_time = time_load(mesh, file_name.c_str(), WELD_EXACT_HASH, 0.0f);
+		const size_t hash_vertex_count = mesh.vertices.size();
+		mesh.clear();
+
+		const double grid_time = time_load(mesh, file_name.c_str(), WELD_EPSILON_GRID, 1e-4f);
+		const size_t grid_vertex_count = mesh.vertices.size();
+		mesh.clear();
+
+		const double mapped_time = time_load(mesh, file_name.c_str(), WELD_EXACT_HASH, 0.0f, true);
+		const size_t mapped_vertex_count = mesh.vertices.size();
+		const uint64_t mapped_checksum = checksum_triangles(mesh);
+		mesh.clear();
+
+		const double parallel_time = time_load(mesh, file_name.c_str(), WELD_EXACT_HASH, 0.0f, true, num_threads);
+		const size_t parallel_vertex_count = mesh.vertices.size();
+		const uint64_t parallel_checksum = checksum_triangles(mesh);
+		mesh.clear();
+
+		remove(file_name.c_str());
+
+		cout << endl;
+		cout << "Triangles: " << sizes[i] << endl;
+		cout << "  std::set:     " << set_time << " s (" << set_vertex_count << " vertices)" << endl;
+		cout << "  hash:         " << hash_time << " s (" << hash_vertex_count << " vertices)" << endl;
+		cout << "  epsilon grid: " << grid_time << " s (" << grid_vertex_count << " vertices)" << endl;
+		cout << "  mapped hash:  " << mapped_time << " s (" << mapped_vertex_count << " vertices)" << endl;
+		cout << "  " << num_threads << " threads:   " << parallel_time << " s (" << parallel_vertex_count << " vertices, ";
+		cout << ((mapped_checksum == parallel_checksum) ? "identical" : "DIFFERENT") << " indices)" << endl;
+
+		if(hash_time > 0)
+			cout << "  speedup (hash vs set): " << set_time / hash_time << "x" << endl;
+
+		cout << endl;
+	}
+
+	return 0;
+}
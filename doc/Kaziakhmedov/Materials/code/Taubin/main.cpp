@@ -1,4 +1,4 @@
-#include "mesh.h"
+#include "../../../../../src/common/mesh.h"
 
 #include <string>
 using std::string;
@@ -13,8 +13,9 @@ int main(int argc, char **argv)
 	}
 
 	indexed_mesh mesh;
+	const size_t num_threads = thread::hardware_concurrency();
 
-	if(false == mesh.load_from_binary_stereo_lithography_file(argv[1]))
+	if(false == mesh.load_from_mapped_binary_stereo_lithography_file(argv[1], true, WELD_EXACT_HASH, 0.0f, num_threads))
 	{
 		cout << "Error: Could not properly read file " << argv[1] << endl;
 		return 2;
@@ -25,7 +26,7 @@ int main(int argc, char **argv)
 	float lambda = 0.5f;
 	float mu = -0.53f;
 	
-	mesh.taubin_smooth(lambda, mu, 10);
+	mesh.taubin_smooth(lambda, mu, 10, num_threads);
 
 	string out_file_name = argv[1];
 	out_file_name = "smoothed_" + out_file_name;
@@ -0,0 +1,141 @@
+// Times union, intersection and difference of pairs of closed meshes, from 100K to 5M
+// triangles each, and checks every result: that it is closed (each edge used once in each
+// direction) and that its volume agrees with the others,
+//
+//   vol(A u B) + vol(A n B) = vol(A) + vol(B)
+//   vol(A - B) = vol(A) - vol(A n B)
+//
+// The meshes are two linked tori. Two harder cases follow at a fixed size: a torus against
+// a copy of itself, where every face coincides with another, and two boxes tessellated at
+// different resolutions that share three faces, where coplanar triangles overlap and cross.
+//
+// Example usage: boolean_benchmark [max_triangles [num_threads]]
+
+#include "mesh_boolean.h"
+#include "test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+static bool run_case(const char *const name, const indexed_mesh &mesh_a, const indexed_mesh &mesh_b, const size_t num_threads)
+{
+	cout << name << ": " << mesh_a.triangles.size() << " + " << mesh_b.triangles.size() << " triangles" << endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	boolean_operand a, b;
+
+	if(false == a.init(mesh_a) || false == b.init(mesh_b))
+	{
+		cout << "  Error: an operand has no triangles" << endl;
+		return false;
+	}
+
+	cout << "  operands prepared in " << seconds_since(start) << " s" << endl;
+
+	const char *const operation_names[3] = { "union", "intersection", "difference" };
+	const boolean_operation operations[3] = { BOOLEAN_UNION, BOOLEAN_INTERSECTION, BOOLEAN_DIFFERENCE };
+	double volumes[3] = { 0.0, 0.0, 0.0 };
+	bool passed = true;
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		mesh_boolean boolean;
+		indexed_mesh result;
+
+		start = std::chrono::steady_clock::now();
+		boolean.compute(a, b, operations[i], result, num_threads);
+		const double total_time = seconds_since(start);
+
+		const bool closed = is_closed(result);
+		volumes[i] = mesh_volume(result);
+		passed = passed && closed && 0 == boolean.unrecovered_segment_count && 0 == boolean.irregular_pair_count;
+
+		cout << "  " << operation_names[i] << ": " << result.triangles.size() << " triangles in " << total_time << " s "
+		     << "(broad " << boolean.broad_phase_time << ", narrow " << boolean.narrow_phase_time << ", split " << boolean.split_time
+		     << ", classify " << boolean.classify_time << ", assemble " << boolean.assemble_time << ")" << endl;
+		cout << "    " << boolean.candidate_pair_count << " candidate pairs, " << boolean.intersecting_pair_count << " crossing, "
+		     << boolean.cut_point_count << " new vertices, " << boolean.cut_triangle_count << " triangles split; "
+		     << (closed ? "closed" : "NOT CLOSED");
+
+		if(0 != boolean.unrecovered_segment_count || 0 != boolean.irregular_pair_count)
+			cout << ", " << boolean.unrecovered_segment_count << " unrecovered, " << boolean.irregular_pair_count << " irregular";
+
+		cout << endl;
+	}
+
+	const double volume_a = mesh_volume(mesh_a), volume_b = mesh_volume(mesh_b);
+	const double tolerance = 1e-5*(fabs(volume_a) + fabs(volume_b));
+	const double sum_error = fabs(volumes[0] + volumes[1] - volume_a - volume_b);
+	const double difference_error = fabs(volumes[2] - (volume_a - volumes[1]));
+
+	cout << "  volumes: A " << volume_a << ", B " << volume_b << ", union " << volumes[0] << ", intersection " << volumes[1] << ", difference " << volumes[2] << endl;
+	cout << "  identities: " << sum_error << " and " << difference_error << ((sum_error <= tolerance && difference_error <= tolerance) ? " (ok)" : " (FAILED)") << endl;
+
+	return passed && sum_error <= tolerance && difference_error <= tolerance;
+}
+
+int main(int argc, char **argv)
+{
+	size_t max_triangles = 5000000;
+	size_t num_threads = thread::hardware_concurrency();
+
+	if(argc > 1)
+		max_triangles = strtoul(argv[1], 0, 10);
+
+	if(argc > 2)
+		num_threads = strtoul(argv[2], 0, 10);
+
+	if(max_triangles < 1000 || 0 == num_threads)
+	{
+		cout << "Example usage: " << argv[0] << " [max_triangles [num_threads]]" << endl;
+		return 1;
+	}
+
+	cout << "Using " << num_threads << " threads" << endl;
+
+	bool passed = true;
+	const size_t sizes[5] = { 100000, 500000, 1000000, 2000000, 5000000 };
+
+	for(size_t i = 0; i < 5 && sizes[i] <= max_triangles; i++)
+	{
+		const double offset_a[3] = { 0.0, 0.0, 0.0 }, offset_b[3] = { 0.6, 0.0137, -0.0071 };
+		indexed_mesh a, b;
+
+		make_torus(a, sizes[i], 1.0, 0.35, false, offset_a);
+		make_torus(b, sizes[i], 1.0, 0.35, true, offset_b);
+
+		passed = run_case("Linked tori", a, b, num_threads) && passed;
+	}
+
+	{
+		const size_t size = (max_triangles < 100000) ? max_triangles : 100000;
+		const double offset[3] = { 0.0, 0.0, 0.0 };
+		indexed_mesh a;
+
+		make_torus(a, size, 1.0, 0.35, false, offset);
+
+		passed = run_case("Torus against itself", a, a, num_threads) && passed;
+	}
+
+	{
+		const float min_a[3] = { 0.0f, 0.0f, 0.0f }, max_a[3] = { 1.0f, 1.0f, 1.0f };
+		const float min_b[3] = { 0.3f, 0.0f, 0.0f }, max_b[3] = { 1.0f, 0.7f, 1.3f };
+		indexed_mesh a, b;
+
+		make_box(a, min_a, max_a, 40);
+		make_box(b, min_b, max_b, 23);
+
+		passed = run_case("Boxes sharing faces", a, b, num_threads) && passed;
+	}
+
+	cout << (passed ? "All results closed and consistent" : "SOME RESULTS FAILED") << endl;
+
+	return passed ? 0 : 2;
+}
@@ -0,0 +1,258 @@
+// Times BSP tree construction and BSP booleans, and checks every result as
+// boolean_benchmark does: that it is closed (each edge used once in each direction) and
+// that its volume agrees with the others,
+//
+//   vol(A u B) + vol(A n B) = vol(A) + vol(B)
+//   vol(A - B) = vol(A) - vol(A n B)
+//
+// The cases are two linked tori, a torus against a copy of itself and two boxes sharing
+// faces. Each tree is also turned straight back into a mesh, which must be closed and keep
+// the volume, and each boolean is run again on one thread, which must give the same mesh.
+//
+// Last, a bone is cut by several implants in turn, each boolean taking the tree of the
+// last result, and the time of each is set against that of building the bone's tree. Only
+// the final tree is turned into a mesh.
+//
+// Example usage: bsp_benchmark [max_triangles [num_threads]]
+
+#include "bsp_tree.h"
+#include "test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+static bool same_mesh(const indexed_mesh &a, const indexed_mesh &b)
+{
+	if(a.vertices.size() != b.vertices.size() || a.triangles.size() != b.triangles.size())
+		return false;
+
+	for(size_t i = 0; i < a.vertices.size(); i++)
+		if(!(a.vertices[i] == b.vertices[i]))
+			return false;
+
+	for(size_t i = 0; i < a.triangles.size(); i++)
+		for(size_t k = 0; k < 3; k++)
+			if(a.triangles[i].vertex_indices[k] != b.triangles[i].vertex_indices[k])
+				return false;
+
+	return true;
+}
+
+static bool build_tree(const char *const name, const indexed_mesh &mesh, bsp_tree &tree, const size_t num_threads)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if(false == tree.build(mesh, num_threads))
+	{
+		cout << "  Error: " << name << " has no triangles" << endl;
+		return false;
+	}
+
+	const double build_time = seconds_since(start);
+
+	indexed_mesh round_trip;
+	start = std::chrono::steady_clock::now();
+	const size_t open_count = tree.to_mesh(round_trip, num_threads);
+	const double convert_time = seconds_since(start);
+
+	const double volume = mesh_volume(mesh), tree_volume = mesh_volume(round_trip);
+	const bool passed = (0 == open_count && true == is_closed(round_trip) && fabs(volume - tree_volume) <= 1e-5*fabs(volume));
+
+	cout << "  " << name << ": " << tree.nodes.size() << " nodes, " << tree.pool.polygons.size() << " polygons, "
+	     << tree.memory_usage()/(1024*1024) << " MB, built in " << build_time << " s; back to "
+	     << round_trip.triangles.size() << " triangles in " << convert_time << " s, " << (passed ? "closed, same volume" : "NOT THE SAME SOLID") << endl;
+
+	return passed;
+}
+
+static bool run_case(const char *const name, const indexed_mesh &mesh_a, const indexed_mesh &mesh_b, const size_t num_threads)
+{
+	cout << name << ": " << mesh_a.triangles.size() << " + " << mesh_b.triangles.size() << " triangles" << endl;
+
+	bsp_tree a, b;
+
+	if(false == build_tree("A", mesh_a, a, num_threads) || false == build_tree("B", mesh_b, b, num_threads))
+		return false;
+
+	const char *const operation_names[3] = { "union", "intersection", "difference" };
+	const boolean_operation operations[3] = { BOOLEAN_UNION, BOOLEAN_INTERSECTION, BOOLEAN_DIFFERENCE };
+	double volumes[3] = { 0.0, 0.0, 0.0 };
+	bool passed = true;
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		bsp_boolean boolean;
+		bsp_tree tree;
+		indexed_mesh result;
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		boolean.compute(a, b, operations[i], tree, num_threads);
+		const double boolean_time = seconds_since(start);
+
+		start = std::chrono::steady_clock::now();
+		const size_t open_count = tree.to_mesh(result, num_threads);
+		const double convert_time = seconds_since(start);
+
+		// The same on one thread.
+		bsp_boolean serial_boolean;
+		bsp_tree serial_tree;
+		indexed_mesh serial_result;
+		serial_boolean.compute(a, b, operations[i], serial_tree, 1);
+		serial_tree.to_mesh(serial_result);
+
+		const bool closed = (0 == open_count && true == is_closed(result));
+		const bool identical = same_mesh(result, serial_result);
+		volumes[i] = mesh_volume(result);
+		passed = passed && closed && identical;
+
+		cout << "  " << operation_names[i] << ": " << result.triangles.size() << " triangles in " << boolean_time + convert_time << " s "
+		     << "(clip " << boolean.clip_time << ", build " << boolean.build_time << ", to mesh " << convert_time << ")" << endl;
+		cout << "    " << boolean.clipped_polygon_count << " polygons clipped, " << boolean.reused_polygon_count << " reused, " << boolean.result_polygon_count << " in the result, "
+		     << tree.nodes.size() << " nodes; " << (closed ? "closed" : "NOT CLOSED");
+
+		if(0 != open_count)
+			cout << ", " << open_count << " open edges";
+
+		cout << ", " << (identical ? "same on one thread" : "DIFFERENT ON ONE THREAD") << endl;
+	}
+
+	const double volume_a = mesh_volume(mesh_a), volume_b = mesh_volume(mesh_b);
+	const double tolerance = 1e-5*(fabs(volume_a) + fabs(volume_b));
+	const double sum_error = fabs(volumes[0] + volumes[1] - volume_a - volume_b);
+	const double difference_error = fabs(volumes[2] - (volume_a - volumes[1]));
+
+	cout << "  volumes: A " << volume_a << ", B " << volume_b << ", union " << volumes[0] << ", intersection " << volumes[1] << ", difference " << volumes[2] << endl;
+	cout << "  identities: " << sum_error << " and " << difference_error << ((sum_error <= tolerance && difference_error <= tolerance) ? " (ok)" : " (FAILED)") << endl;
+
+	return passed && sum_error <= tolerance && difference_error <= tolerance;
+}
+
+// A bone (a torus) with implants (small upright tori) cut out of it one after another.
+// The bone's tree is built once, and each result's tree goes straight into the next
+// boolean. The bone must lose some volume, but no more than the implants have.
+static bool run_reuse_case(const size_t num_triangles, const size_t num_threads)
+{
+	const size_t implant_count = 4;
+	const double bone_offset[3] = { 0.0, 0.0, 0.0 };
+	indexed_mesh bone;
+	make_torus(bone, num_triangles, 1.0, 0.35, false, bone_offset);
+
+	cout << "Bone reused: " << bone.triangles.size() << " triangles, " << implant_count << " implants" << endl;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bsp_tree tree;
+	tree.build(bone, num_threads);
+	const double bone_time = seconds_since(start);
+
+	cout << "  bone tree built once in " << bone_time << " s" << endl;
+
+	const double pi = 4.0*atan(1.0);
+	double implants_volume = 0.0;
+
+	for(size_t i = 0; i < implant_count; i++)
+	{
+		const double angle = 2.0*pi*i/implant_count;
+		const double offset[3] = { cos(angle), sin(angle), 0.2 };
+		indexed_mesh implant;
+		make_torus(implant, num_triangles/10, 0.2, 0.06, true, offset);
+		implants_volume += mesh_volume(implant);
+
+		start = std::chrono::steady_clock::now();
+
+		bsp_tree implant_tree, result_tree;
+		bsp_boolean boolean;
+		implant_tree.build(implant, num_threads);
+		boolean.compute(tree, implant_tree, BOOLEAN_DIFFERENCE, result_tree, num_threads);
+
+		const double boolean_time = seconds_since(start);
+
+		tree.planes.swap(result_tree.planes);
+		tree.nodes.swap(result_tree.nodes);
+		tree.pool.polygons.swap(result_tree.pool.polygons);
+		tree.pool.sides.swap(result_tree.pool.sides);
+
+		cout << "  implant " << i << ": " << boolean_time << " s with its own tree (" << boolean_time / bone_time << " of the bone's build), "
+		     << boolean.reused_polygon_count << " polygons reused, " << tree.pool.polygons.size() << " in the result" << endl;
+	}
+
+	start = std::chrono::steady_clock::now();
+	indexed_mesh result;
+	const size_t open_count = tree.to_mesh(result, num_threads);
+	const double convert_time = seconds_since(start);
+
+	const bool closed = (0 == open_count && true == is_closed(result));
+	const double bone_volume = mesh_volume(bone), result_volume = mesh_volume(result);
+	const bool cut = (result_volume < bone_volume && result_volume > bone_volume - implants_volume);
+
+	cout << "  result: " << result.triangles.size() << " triangles in " << convert_time << " s, " << (closed ? "closed" : "NOT CLOSED")
+	     << ", volume " << result_volume << " of the bone's " << bone_volume << (cut ? "" : " (WRONG)") << endl;
+
+	return closed && cut;
+}
+
+int main(int argc, char **argv)
+{
+	size_t max_triangles = 100000;
+	size_t num_threads = thread::hardware_concurrency();
+
+	if(argc > 1)
+		max_triangles = strtoul(argv[1], 0, 10);
+
+	if(argc > 2)
+		num_threads = strtoul(argv[2], 0, 10);
+
+	if(max_triangles < 1000 || 0 == num_threads)
+	{
+		cout << "Example usage: " << argv[0] << " [max_triangles [num_threads]]" << endl;
+		return 1;
+	}
+
+	cout << "Using " << num_threads << " threads" << endl;
+
+	bool passed = true;
+	const size_t sizes[3] = { 20000, 100000, 200000 };
+
+	for(size_t i = 0; i < 3 && sizes[i] <= max_triangles; i++)
+	{
+		const double offset_a[3] = { 0.0, 0.0, 0.0 }, offset_b[3] = { 0.6, 0.0137, -0.0071 };
+		indexed_mesh a, b;
+
+		make_torus(a, sizes[i], 1.0, 0.35, false, offset_a);
+		make_torus(b, sizes[i], 1.0, 0.35, true, offset_b);
+
+		passed = run_case("Linked tori", a, b, num_threads) && passed;
+	}
+
+	{
+		const size_t size = (max_triangles < 20000) ? max_triangles : 20000;
+		const double offset[3] = { 0.0, 0.0, 0.0 };
+		indexed_mesh a;
+
+		make_torus(a, size, 1.0, 0.35, false, offset);
+
+		passed = run_case("Torus against itself", a, a, num_threads) && passed;
+	}
+
+	{
+		const float min_a[3] = { 0.0f, 0.0f, 0.0f }, max_a[3] = { 1.0f, 1.0f, 1.0f };
+		const float min_b[3] = { 0.3f, 0.0f, 0.0f }, max_b[3] = { 1.0f, 0.7f, 1.3f };
+		indexed_mesh a, b;
+
+		make_box(a, min_a, max_a, 40);
+		make_box(b, min_b, max_b, 23);
+
+		passed = run_case("Boxes sharing faces", a, b, num_threads) && passed;
+	}
+
+	passed = run_reuse_case((max_triangles < 50000) ? max_triangles : 50000, num_threads) && passed;
+
+	cout << (passed ? "All results closed and consistent" : "SOME RESULTS FAILED") << endl;
+
+	return passed ? 0 : 2;
+}
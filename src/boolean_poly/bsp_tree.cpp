@@ -0,0 +1,2778 @@
+#include "bsp_tree.h"
+#include "test_support.h" // for seconds_since()
+#include "../common/vertex_welder.h"
+
+#include <algorithm>
+using std::sort;
+using std::lower_bound;
+using std::unique;
+using std::binary_search;
+
+#include <atomic>
+using std::atomic;
+
+#include <thread>
+using std::thread;
+
+#include <functional>
+using std::ref;
+using std::cref;
+
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+
+
+static inline float coordinate(const vertex_3 &p, const size_t axis)
+{
+	return (0 == axis) ? p.x : ((1 == axis) ? p.y : p.z);
+}
+
+
+void bsp_polygon_pool::clear(void)
+{
+	polygons.clear();
+	sides.clear();
+}
+
+uint32_t bsp_polygon_pool::add(const bsp_polygon_pool &from, const uint32_t i, const uint32_t plane_offset, const bool flip)
+{
+	// from may be this pool, so nothing is held by reference across a push_back().
+	bsp_polygon p = from.polygons[i];
+	const uint32_t first_side = p.first_side;
+
+	p.support += plane_offset;
+	p.first_side = static_cast<uint32_t>(sides.size());
+	p.next = bsp_tree::none;
+	p.flipped = (p.flipped != flip);
+
+	for(uint32_t k = 0; k < p.side_count; k++)
+	{
+		bsp_side s = from.sides[first_side + k];
+		s.plane += plane_offset;
+		sides.push_back(s);
+	}
+
+	polygons.push_back(p);
+
+	return static_cast<uint32_t>(polygons.size() - 1);
+}
+
+void bsp_polygon_pool::append(const bsp_polygon_pool &from)
+{
+	const uint32_t side_offset = static_cast<uint32_t>(sides.size());
+
+	sides.insert(sides.end(), from.sides.begin(), from.sides.end());
+	polygons.reserve(polygons.size() + from.polygons.size());
+
+	for(size_t i = 0; i < from.polygons.size(); i++)
+	{
+		bsp_polygon p = from.polygons[i];
+		p.first_side += side_offset;
+		p.next = bsp_tree::none;
+		polygons.push_back(p);
+	}
+}
+
+
+enum polygon_side
+{
+	POLYGON_COPLANAR_FRONT, // In the plane, facing the same way
+	POLYGON_COPLANAR_BACK,  // In the plane, facing the other way
+	POLYGON_FRONT,
+	POLYGON_BACK,
+	POLYGON_SPANNING
+};
+
+// Kept by each thread, so that splitting does not allocate.
+class split_scratch
+{
+public:
+	vector<bsp_side> sides;
+	vector<int> signs;
+	vector<bsp_side> crossings; // crossings[i]: where edge i crosses the plane, if it does
+};
+
+// Appends the part of the polygon on the given side (+1 for front, -1 for back) of plane h
+// to pool. Each corner keeps the edge plane it had; where an edge crosses h, the new corner
+// is where the edge's plane meets h, and the edge along h that joins the two crossings
+// lies in h.
+static uint32_t add_piece(bsp_polygon_pool &pool, const bsp_polygon &polygon, const split_scratch &scratch, const int side, const uint32_t h)
+{
+	const size_t count = scratch.sides.size();
+	bsp_polygon piece;
+	piece.support = polygon.support;
+	piece.first_side = static_cast<uint32_t>(pool.sides.size());
+	piece.next = bsp_tree::none;
+	piece.flipped = polygon.flipped;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		const size_t j = (i + 1) % count;
+		const int here = side*scratch.signs[i], there = side*scratch.signs[j];
+
+		if(here > 0)
+		{
+			pool.sides.push_back(scratch.sides[i]);
+
+			if(there < 0)
+			{
+				bsp_side leaving = scratch.crossings[i];
+				leaving.plane = h;
+				pool.sides.push_back(leaving);
+			}
+		}
+		else if(0 == here)
+		{
+			// The piece's edge from here runs along h unless it heads into the piece.
+			bsp_side s = scratch.sides[i];
+
+			if(there <= 0)
+				s.plane = h;
+
+			pool.sides.push_back(s);
+		}
+		else if(there > 0)
+		{
+			pool.sides.push_back(scratch.crossings[i]);
+		}
+	}
+
+	piece.side_count = static_cast<uint32_t>(pool.sides.size() - piece.first_side);
+	pool.polygons.push_back(piece);
+
+	return static_cast<uint32_t>(pool.polygons.size() - 1);
+}
+
+// Whether p and q are one plane, held under two indices (e.g. a face that both operands of
+// a boolean have). Only nearly parallel normals are worth the exact test.
+static bool same_plane(const plane_3 &p, const plane_3 &q)
+{
+	const double *const n = p.normal;
+	const double *const m = q.normal;
+	const double c[3] = { n[1]*m[2] - n[2]*m[1], n[2]*m[0] - n[0]*m[2], n[0]*m[1] - n[1]*m[0] };
+	const double nn = n[0]*n[0] + n[1]*n[1] + n[2]*n[2], mm = m[0]*m[0] + m[1]*m[1] + m[2]*m[2];
+
+	if(c[0]*c[0] + c[1]*c[1] + c[2]*c[2] > 1e-12*nn*mm)
+		return false;
+
+	for(size_t k = 0; k < 3; k++)
+		if(0 != orient3d(p.points[0], p.points[1], p.points[2], q.points[k]))
+			return false;
+
+	return true;
+}
+
+// Where polygon index of pool lies against plane h, taken to face the other way if
+// h_flipped. A spanning polygon is split, and its pieces are appended to pool as front and
+// back; the polygon itself is left as it was.
+//
+// Each corner is classified by classify_point(), which is exact, so the pieces of one
+// polygon agree with each other and with every other polygon split by h on which corners
+// are on h and on which side the rest are.
+static polygon_side split_polygon(const vector<plane_3> &planes, bsp_polygon_pool &pool, const uint32_t index, const uint32_t h, const bool h_flipped, uint32_t &front, uint32_t &back, split_scratch &scratch)
+{
+	const bsp_polygon polygon = pool.polygons[index];
+
+	if(polygon.support == h)
+		return (polygon.flipped == h_flipped) ? POLYGON_COPLANAR_FRONT : POLYGON_COPLANAR_BACK;
+
+	const size_t count = polygon.side_count;
+	const bsp_side *const sides = &pool.sides[polygon.first_side];
+	const plane_3 &support = planes[polygon.support];
+	bool any_front = false, any_back = false;
+
+	// The support under another index has every corner on it, which would otherwise take
+	// exact arithmetic to find out, corner by corner.
+	const bool on_h = same_plane(support, planes[h]);
+
+	scratch.signs.assign(count, 0);
+
+	for(size_t i = 0; i < count && false == on_h; i++)
+	{
+		const uint32_t incoming = sides[(i + count - 1) % count].plane;
+		int sign = 0;
+
+		// A corner on h by construction needs no test.
+		if(incoming != h && sides[i].plane != h)
+			sign = classify_point(support, planes[incoming], planes[sides[i].plane], sides[i].position, sides[i].error, planes[h]);
+
+		if(true == h_flipped)
+			sign = -sign;
+
+		scratch.signs[i] = sign;
+
+		if(sign > 0)
+			any_front = true;
+		else if(sign < 0)
+			any_back = true;
+	}
+
+	if(false == any_front && false == any_back)
+	{
+		// Two different planes through the same points: their normals are parallel, so the
+		// rounded ones are nowhere near perpendicular.
+		const double *const n = support.normal;
+		const double *const m = planes[h].normal;
+		const bool same_normal = (n[0]*m[0] + n[1]*m[1] + n[2]*m[2] > 0.0);
+
+		return (same_normal == (polygon.flipped == h_flipped)) ? POLYGON_COPLANAR_FRONT : POLYGON_COPLANAR_BACK;
+	}
+
+	if(false == any_back)
+		return POLYGON_FRONT;
+
+	if(false == any_front)
+		return POLYGON_BACK;
+
+	// sides points into pool, which the pieces are about to grow.
+	scratch.sides.assign(sides, sides + count);
+	scratch.crossings.resize(count);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		const size_t j = (i + 1) % count;
+
+		if(scratch.signs[i]*scratch.signs[j] >= 0)
+			continue;
+
+		bsp_side &x = scratch.crossings[i];
+		x.plane = scratch.sides[i].plane;
+
+		// The edge's plane, the support and h meet in one point, since the edge's ends are
+		// on either side of h; the test is only there to keep the corner finite.
+		if(false == intersect_planes(support, planes[x.plane], planes[h], x.position, x.error))
+		{
+			for(size_t k = 0; k < 3; k++)
+				x.position[k] = 0.5*(scratch.sides[i].position[k] + scratch.sides[j].position[k]);
+
+			x.error = HUGE_VAL;
+		}
+	}
+
+	front = add_piece(pool, polygon, scratch, 1, h);
+	back = add_piece(pool, polygon, scratch, -1, h);
+
+	return POLYGON_SPANNING;
+}
+
+
+class bounding_box
+{
+public:
+	bounding_box(void) : empty(true) { /* custom constructor */ }
+
+	inline void add(const double p[3])
+	{
+		for(size_t k = 0; k < 3; k++)
+		{
+			if(true == empty || p[k] < min[k])
+				min[k] = p[k];
+
+			if(true == empty || p[k] > max[k])
+				max[k] = p[k];
+		}
+
+		empty = false;
+	}
+
+	// Every point within error of p along each axis.
+	inline void add(const double p[3], const double error)
+	{
+		const double low[3] = { p[0] - error, p[1] - error, p[2] - error };
+		const double high[3] = { p[0] + error, p[1] + error, p[2] + error };
+
+		add(low);
+		add(high);
+	}
+
+	inline void add(const bounding_box &other)
+	{
+		if(false == other.empty)
+		{
+			add(other.min);
+			add(other.max);
+		}
+	}
+
+	// Whether the boxes have no point in common.
+	inline bool misses(const bounding_box &other) const
+	{
+		if(true == empty || true == other.empty)
+			return true;
+
+		for(size_t k = 0; k < 3; k++)
+			if(max[k] < other.min[k] || other.max[k] < min[k])
+				return true;
+
+		return false;
+	}
+
+	inline double area(void) const
+	{
+		if(true == empty)
+			return 0.0;
+
+		const double x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+
+		return 2.0*(x*y + y*z + z*x);
+	}
+
+	bool empty;
+	double min[3];
+	double max[3];
+};
+
+// The plane across axis at coordinate c, with its normal pointing up the axis.
+static plane_3 axis_plane(const size_t axis, const float c)
+{
+	float a[3] = { 0.0f, 0.0f, 0.0f };
+	float b[3] = { 0.0f, 0.0f, 0.0f };
+	float d[3] = { 0.0f, 0.0f, 0.0f };
+
+	a[axis] = b[axis] = d[axis] = c;
+	b[(axis + 1) % 3] = 1.0f;
+	d[(axis + 2) % 3] = 1.0f;
+
+	plane_3 h;
+	h.set(vertex_3(a[0], a[1], a[2]), vertex_3(b[0], b[1], b[2]), vertex_3(d[0], d[1], d[2]));
+
+	return h;
+}
+
+// Planes across each axis, at 1/cut_steps steps through the box of the polygons, which
+// can divide a node where no polygon's plane does. planes[first] is the first across x.
+class cutting_grid
+{
+public:
+	static const size_t cut_steps = 1024;
+
+	// Appends the planes to planes and returns the grid.
+	void add(const bsp_polygon_pool &pool, vector<plane_3> &planes);
+
+	// The plane across axis nearest to coordinate x, or bsp_tree::none.
+	uint32_t nearest(const size_t axis, const double x) const;
+
+	uint32_t first;
+	double min[3];
+	double max[3];
+};
+
+void cutting_grid::add(const bsp_polygon_pool &pool, vector<plane_3> &planes)
+{
+	bounding_box box;
+
+	for(size_t i = 0; i < pool.sides.size(); i++)
+		box.add(pool.sides[i].position);
+
+	first = static_cast<uint32_t>(planes.size());
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		min[k] = box.min[k];
+		max[k] = box.max[k];
+
+		for(size_t i = 1; i < cut_steps; i++)
+			planes.push_back(axis_plane(k, static_cast<float>(min[k] + (max[k] - min[k])*i/cut_steps)));
+	}
+}
+
+uint32_t cutting_grid::nearest(const size_t axis, const double x) const
+{
+	if(false == (max[axis] > min[axis]))
+		return bsp_tree::none;
+
+	const double i = floor((x - min[axis])/(max[axis] - min[axis])*cut_steps + 0.5);
+
+	if(i < 1.0 || i > cut_steps - 1)
+		return bsp_tree::none;
+
+	return first + static_cast<uint32_t>(axis*(cut_steps - 1) + (static_cast<size_t>(i) - 1));
+}
+
+// Costs plane h, taken to face the other way if flipped, as a divider of the sample: the
+// area of the box of what lands in front times the number of polygons there, plus the
+// same behind, with a spanning polygon counted on both sides. Polygons in h are left out.
+static double splitter_cost(const vector<plane_3> &planes, const bsp_polygon_pool &pool, const vector<uint32_t> &sample, const uint32_t plane, const bool flipped, size_t &front_count, size_t &back_count)
+{
+	const plane_3 &h = planes[plane];
+	const double sign = (true == flipped) ? -1.0 : 1.0;
+	const double normal_size = fabs(h.normal[0]) + fabs(h.normal[1]) + fabs(h.normal[2]);
+
+	bounding_box front_box, back_box;
+	front_count = back_count = 0;
+
+	for(size_t s = 0; s < sample.size(); s++)
+	{
+		const bsp_polygon &p = pool.polygons[sample[s]];
+
+		if(p.support == plane)
+			continue;
+
+		bool in_front = false, in_back = false;
+
+		for(uint32_t k = 0; k < p.side_count; k++)
+		{
+			const double *const x = pool.sides[p.first_side + k].position;
+			const double distance = sign*(h.normal[0]*x[0] + h.normal[1]*x[1] + h.normal[2]*x[2] + h.offset);
+			const double tolerance = 1e-12*(normal_size*(fabs(x[0]) + fabs(x[1]) + fabs(x[2])) + fabs(h.offset));
+
+			if(distance > tolerance)
+			{
+				in_front = true;
+				front_box.add(x);
+			}
+			else if(distance < -tolerance)
+			{
+				in_back = true;
+				back_box.add(x);
+			}
+			else
+			{
+				front_box.add(x);
+				back_box.add(x);
+			}
+		}
+
+		if(true == in_front)
+			front_count++;
+
+		if(true == in_back)
+			back_count++;
+	}
+
+	return front_box.area()*front_count + back_box.area()*back_count;
+}
+
+// Picks the plane of a node over the polygons in list. Each of a few candidates, spread
+// through the list, is costed on a sample of the polygons by splitter_cost(), using their
+// rounded corners, and so is the grid plane across the middle of the sample's box. A
+// plane that leaves everything on one side costs as much as not dividing at all, which the
+// planes of a convex patch do; there the grid plane divides instead, as long as the
+// sample has polygons strictly on both sides of it, so that a node without polygons of its
+// own never ends a branch. Only lists of a few dozen polygons or more are cut.
+static void choose_splitter(const vector<plane_3> &planes, const bsp_polygon_pool &pool, const cutting_grid &grid, const vector<uint32_t> &list, bsp_node &node)
+{
+	const size_t max_candidates = 8, max_samples = 64;
+	const size_t candidate_count = (list.size() < max_candidates) ? list.size() : max_candidates;
+	const size_t sample_count = (list.size() < max_samples) ? list.size() : max_samples;
+
+	// Below this, a chain of polygon planes is short, and cuts only chop polygons up.
+	const size_t min_cut_size = 64;
+
+	vector<uint32_t> sample(sample_count);
+	bounding_box box;
+
+	for(size_t s = 0; s < sample_count; s++)
+	{
+		sample[s] = list[s*list.size()/sample_count];
+
+		const bsp_polygon &p = pool.polygons[sample[s]];
+
+		for(uint32_t k = 0; k < p.side_count; k++)
+			box.add(pool.sides[p.first_side + k].position);
+	}
+
+	node.plane = pool.polygons[list[0]].support;
+	node.flipped = pool.polygons[list[0]].flipped;
+
+	if(list.size() < 2)
+		return;
+
+	double best_cost = HUGE_VAL;
+	size_t front_count, back_count;
+
+	for(size_t c = 0; c < candidate_count; c++)
+	{
+		const bsp_polygon &splitter = pool.polygons[list[c*list.size()/candidate_count]];
+		const double cost = splitter_cost(planes, pool, sample, splitter.support, splitter.flipped, front_count, back_count);
+
+		if(cost < best_cost)
+		{
+			best_cost = cost;
+			node.plane = splitter.support;
+			node.flipped = splitter.flipped;
+		}
+	}
+
+	size_t axis = 0;
+
+	for(size_t k = 1; k < 3; k++)
+		if(box.max[k] - box.min[k] > box.max[axis] - box.min[axis])
+			axis = k;
+
+	const uint32_t cut = (list.size() < min_cut_size) ? bsp_tree::none : grid.nearest(axis, 0.5*(box.min[axis] + box.max[axis]));
+
+	if(bsp_tree::none == cut)
+		return;
+
+	const double cost = splitter_cost(planes, pool, sample, cut, false, front_count, back_count);
+
+	if(cost < best_cost && front_count > 0 && back_count > 0)
+	{
+		node.plane = cut;
+		node.flipped = false;
+	}
+}
+
+static inline void link_child(vector<bsp_node> &nodes, const uint32_t parent, const bool front, const uint32_t child)
+{
+	if(bsp_tree::none == parent)
+		return;
+
+	if(true == front)
+		nodes[parent].front = child;
+	else
+		nodes[parent].back = child;
+}
+
+// Appends a node for the polygons in list: picks its plane, keeps the polygons that lie in
+// it, and divides the rest into front and back, splitting those that span it.
+static uint32_t make_node(const vector<plane_3> &planes, bsp_polygon_pool &pool, const cutting_grid &grid, vector<bsp_node> &nodes, const vector<uint32_t> &list, vector<uint32_t> &front, vector<uint32_t> &back, split_scratch &scratch)
+{
+	bsp_node node;
+	choose_splitter(planes, pool, grid, list, node);
+	node.front = node.back = node.polygons = bsp_tree::none;
+
+	front.clear();
+	back.clear();
+
+	for(size_t i = 0; i < list.size(); i++)
+	{
+		uint32_t front_piece = bsp_tree::none, back_piece = bsp_tree::none;
+
+		switch(split_polygon(planes, pool, list[i], node.plane, node.flipped, front_piece, back_piece, scratch))
+		{
+		case POLYGON_COPLANAR_FRONT:
+		case POLYGON_COPLANAR_BACK:
+			pool.polygons[list[i]].next = node.polygons;
+			node.polygons = list[i];
+			break;
+		case POLYGON_FRONT:
+			front.push_back(list[i]);
+			break;
+		case POLYGON_BACK:
+			back.push_back(list[i]);
+			break;
+		default:
+			front.push_back(front_piece);
+			back.push_back(back_piece);
+			break;
+		}
+	}
+
+	nodes.push_back(node);
+
+	return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+class build_task
+{
+public:
+	uint32_t parent; // bsp_tree::none for the root
+	bool front;      // Whether the subtree is the parent's front child
+	vector<uint32_t> polygons;
+};
+
+// Builds the subtree over list, polygons of source, into nodes and pool, which start
+// empty. nodes[0] is its root.
+static void build_subtree(const vector<plane_3> &planes, const bsp_polygon_pool &source, const cutting_grid &grid, const vector<uint32_t> &list, vector<bsp_node> &nodes, bsp_polygon_pool &pool)
+{
+	split_scratch scratch;
+	vector<uint32_t> front, back;
+	vector<build_task> stack(1);
+
+	stack[0].parent = bsp_tree::none;
+	stack[0].front = false;
+	stack[0].polygons.reserve(list.size());
+
+	for(size_t i = 0; i < list.size(); i++)
+		stack[0].polygons.push_back(pool.add(source, list[i], 0, false));
+
+	while(false == stack.empty())
+	{
+		build_task task;
+		task.parent = stack.back().parent;
+		task.front = stack.back().front;
+		task.polygons.swap(stack.back().polygons);
+		stack.pop_back();
+
+		const uint32_t node = make_node(planes, pool, grid, nodes, task.polygons, front, back, scratch);
+		link_child(nodes, task.parent, task.front, node);
+
+		if(false == back.empty())
+		{
+			stack.push_back(build_task());
+			stack.back().parent = node;
+			stack.back().front = false;
+			stack.back().polygons.swap(back);
+		}
+
+		if(false == front.empty())
+		{
+			stack.push_back(build_task());
+			stack.back().parent = node;
+			stack.back().front = true;
+			stack.back().polygons.swap(front);
+		}
+	}
+}
+
+// Builds subtrees, taking the next unclaimed one each time, until there are none left.
+static void build_subtrees(const vector<plane_3> &planes, const bsp_polygon_pool &source, const cutting_grid &grid, const vector<build_task> &tasks, vector< vector<bsp_node> > &task_nodes, vector<bsp_polygon_pool> &task_pools, atomic<size_t> &next_task)
+{
+	for(size_t i = next_task++; i < tasks.size(); i = next_task++)
+		build_subtree(planes, source, grid, tasks[i].polygons, task_nodes[i], task_pools[i]);
+}
+
+static inline uint32_t renumber_plane(const uint32_t plane, const vector<plane_3> &from, vector<uint32_t> &new_index, vector<plane_3> &to)
+{
+	if(bsp_tree::none == new_index[plane])
+	{
+		new_index[plane] = static_cast<uint32_t>(to.size());
+		to.push_back(from[plane]);
+	}
+
+	return new_index[plane];
+}
+
+// Rewrites the tree with its nodes in depth-first order, front child first, the polygons
+// in the order of their nodes, and only the planes still in use. What was left behind by
+// splitting, by building in pieces or by a boolean is dropped, and the tree comes out the
+// same whatever order it was built in.
+static void compact(bsp_tree &tree)
+{
+	vector<plane_3> planes;
+	vector<bsp_node> nodes;
+	bsp_polygon_pool pool;
+	vector<uint32_t> new_plane(tree.planes.size(), bsp_tree::none);
+
+	nodes.reserve(tree.nodes.size());
+
+	class visit
+	{
+	public:
+		uint32_t node;
+		uint32_t parent;
+		bool front;
+	};
+
+	vector<visit> stack(1);
+	stack[0].node = 0;
+	stack[0].parent = bsp_tree::none;
+	stack[0].front = false;
+
+	while(false == stack.empty())
+	{
+		const visit v = stack.back();
+		stack.pop_back();
+
+		const bsp_node &old_node = tree.nodes[v.node];
+		const uint32_t index = static_cast<uint32_t>(nodes.size());
+
+		bsp_node node;
+		node.plane = renumber_plane(old_node.plane, tree.planes, new_plane, planes);
+		node.flipped = old_node.flipped;
+		node.front = node.back = node.polygons = bsp_tree::none;
+
+		uint32_t last = bsp_tree::none;
+
+		for(uint32_t p = old_node.polygons; bsp_tree::none != p; p = tree.pool.polygons[p].next)
+		{
+			const bsp_polygon &old_polygon = tree.pool.polygons[p];
+
+			bsp_polygon polygon = old_polygon;
+			polygon.support = renumber_plane(old_polygon.support, tree.planes, new_plane, planes);
+			polygon.first_side = static_cast<uint32_t>(pool.sides.size());
+			polygon.next = bsp_tree::none;
+
+			for(uint32_t k = 0; k < old_polygon.side_count; k++)
+			{
+				bsp_side s = tree.pool.sides[old_polygon.first_side + k];
+				s.plane = renumber_plane(s.plane, tree.planes, new_plane, planes);
+				pool.sides.push_back(s);
+			}
+
+			const uint32_t polygon_index = static_cast<uint32_t>(pool.polygons.size());
+			pool.polygons.push_back(polygon);
+
+			if(bsp_tree::none == last)
+				node.polygons = polygon_index;
+			else
+				pool.polygons[last].next = polygon_index;
+
+			last = polygon_index;
+		}
+
+		nodes.push_back(node);
+		link_child(nodes, v.parent, v.front, index);
+
+		visit child;
+		child.parent = index;
+
+		if(bsp_tree::none != old_node.back)
+		{
+			child.node = old_node.back;
+			child.front = false;
+			stack.push_back(child);
+		}
+
+		if(bsp_tree::none != old_node.front)
+		{
+			child.node = old_node.front;
+			child.front = true;
+			stack.push_back(child);
+		}
+	}
+
+	tree.planes.swap(planes);
+	tree.nodes.swap(nodes);
+	tree.pool.polygons.swap(pool.polygons);
+	tree.pool.sides.swap(pool.sides);
+}
+
+// Appends a subtree built apart, with its indices moved past what is there, and hangs it
+// under parent.
+static void hang_subtree(vector<bsp_node> &nodes, bsp_polygon_pool &pool, const vector<bsp_node> &sub_nodes, const bsp_polygon_pool &sub_pool, const uint32_t parent, const bool front)
+{
+	const uint32_t none = bsp_tree::none;
+	const uint32_t node_offset = static_cast<uint32_t>(nodes.size());
+	const uint32_t polygon_offset = static_cast<uint32_t>(pool.polygons.size());
+	const uint32_t side_offset = static_cast<uint32_t>(pool.sides.size());
+
+	pool.sides.insert(pool.sides.end(), sub_pool.sides.begin(), sub_pool.sides.end());
+
+	for(size_t j = 0; j < sub_pool.polygons.size(); j++)
+	{
+		bsp_polygon p = sub_pool.polygons[j];
+		p.first_side += side_offset;
+
+		if(none != p.next)
+			p.next += polygon_offset;
+
+		pool.polygons.push_back(p);
+	}
+
+	for(size_t j = 0; j < sub_nodes.size(); j++)
+	{
+		bsp_node n = sub_nodes[j];
+
+		if(none != n.front)
+			n.front += node_offset;
+
+		if(none != n.back)
+			n.back += node_offset;
+
+		if(none != n.polygons)
+			n.polygons += polygon_offset;
+
+		nodes.push_back(n);
+	}
+
+	link_child(nodes, parent, front, node_offset);
+}
+
+// Builds nodes over the polygons in pool, appending the planes of the cutting grid to
+// planes, as bsp_tree::build_nodes() does but without compacting.
+static void build_over(vector<plane_3> &planes, bsp_polygon_pool &pool, vector<bsp_node> &nodes, const size_t num_threads)
+{
+	const uint32_t none = bsp_tree::none;
+
+	nodes.clear();
+
+	if(true == pool.polygons.empty())
+		return;
+
+	// Those that end up unused go in compact().
+	cutting_grid grid;
+	grid.add(pool, planes);
+
+	vector<build_task> tasks(1);
+	tasks[0].parent = none;
+	tasks[0].front = false;
+	tasks[0].polygons.resize(pool.polygons.size());
+
+	for(size_t i = 0; i < pool.polygons.size(); i++)
+	{
+		pool.polygons[i].next = none;
+		tasks[0].polygons[i] = static_cast<uint32_t>(i);
+	}
+
+	if(num_threads > 1)
+	{
+		// Build the top of the tree breadth first until there is enough work to share out.
+		// Small subtrees are carried along as they are.
+		const size_t wanted_tasks = 32*num_threads, min_task_size = 64;
+		split_scratch scratch;
+		vector<uint32_t> front, back;
+		bool split_any = true;
+
+		while(tasks.size() < wanted_tasks && true == split_any)
+		{
+			vector<build_task> next_tasks;
+			split_any = false;
+
+			for(size_t i = 0; i < tasks.size(); i++)
+			{
+				if(tasks[i].polygons.size() < min_task_size)
+				{
+					next_tasks.push_back(build_task());
+					next_tasks.back().parent = tasks[i].parent;
+					next_tasks.back().front = tasks[i].front;
+					next_tasks.back().polygons.swap(tasks[i].polygons);
+					continue;
+				}
+
+				const uint32_t node = make_node(planes, pool, grid, nodes, tasks[i].polygons, front, back, scratch);
+				link_child(nodes, tasks[i].parent, tasks[i].front, node);
+				split_any = true;
+
+				if(false == front.empty())
+				{
+					next_tasks.push_back(build_task());
+					next_tasks.back().parent = node;
+					next_tasks.back().front = true;
+					next_tasks.back().polygons.swap(front);
+				}
+
+				if(false == back.empty())
+				{
+					next_tasks.push_back(build_task());
+					next_tasks.back().parent = node;
+					next_tasks.back().front = false;
+					next_tasks.back().polygons.swap(back);
+				}
+			}
+
+			tasks.swap(next_tasks);
+		}
+	}
+
+	vector< vector<bsp_node> > task_nodes(tasks.size());
+	vector<bsp_polygon_pool> task_pools(tasks.size());
+	atomic<size_t> next_task(0);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < num_threads && t < tasks.size(); t++)
+		threads.push_back(thread(build_subtrees, cref(planes), cref(pool), cref(grid), cref(tasks), ref(task_nodes), ref(task_pools), ref(next_task)));
+
+	build_subtrees(planes, pool, grid, tasks, task_nodes, task_pools, next_task);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	// Hang each subtree under its parent.
+	for(size_t i = 0; i < tasks.size(); i++)
+	{
+		hang_subtree(nodes, pool, task_nodes[i], task_pools[i], tasks[i].parent, tasks[i].front);
+
+		vector<bsp_node>().swap(task_nodes[i]);
+		task_pools[i].clear();
+	}
+}
+
+void bsp_tree::build_nodes(const size_t num_threads)
+{
+	build_over(planes, pool, nodes, num_threads);
+
+	if(false == nodes.empty())
+		compact(*this);
+}
+
+class directed_edge
+{
+public:
+	mesh_index from;
+	mesh_index to;
+	uint32_t triangle;
+	uint32_t corner; // The edge runs from this corner of the triangle to the next
+
+	inline bool operator<(const directed_edge &right) const
+	{
+		if(from < right.from)
+			return true;
+		else if(from > right.from)
+			return false;
+
+		return to < right.to;
+	}
+};
+
+static void list_edges(const vector<indexed_triangle> &triangles, vector<directed_edge> &edges)
+{
+	edges.resize(3*triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		for(size_t k = 0; k < 3; k++)
+		{
+			directed_edge &e = edges[3*i + k];
+			e.from = triangles[i].vertex_indices[k];
+			e.to = triangles[i].vertex_indices[(k + 1) % 3];
+			e.triangle = static_cast<uint32_t>(i);
+			e.corner = static_cast<uint32_t>(k);
+		}
+	}
+
+	sort(edges.begin(), edges.end());
+}
+
+// The first edge from -> to, or edges.end().
+static vector<directed_edge>::const_iterator find_edge(const vector<directed_edge> &edges, const mesh_index from, const mesh_index to)
+{
+	directed_edge key;
+	key.from = from;
+	key.to = to;
+
+	const vector<directed_edge>::const_iterator i = lower_bound(edges.begin(), edges.end(), key);
+
+	if(i != edges.end() && i->from == from && i->to == to)
+		return i;
+
+	return edges.end();
+}
+
+bool bsp_tree::build(const indexed_mesh &mesh, const size_t num_threads)
+{
+	clear();
+
+	// Weld exactly, as boolean_operand::init() does, so that neighbours share indices.
+	vertex_welder welder(mesh.vertices.size());
+	vector<vertex_3> vertices;
+	vector<mesh_index> remap(mesh.vertices.size());
+
+	for(size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const size_t index = welder.weld(mesh.vertices[i]);
+
+		if(index == vertices.size())
+			vertices.push_back(mesh.vertices[i]);
+
+		remap[i] = static_cast<mesh_index>(index);
+	}
+
+	vector<indexed_triangle> triangles;
+	triangles.reserve(mesh.triangles.size());
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		indexed_triangle t;
+
+		for(size_t k = 0; k < 3; k++)
+			t.vertex_indices[k] = remap[mesh.triangles[i].vertex_indices[k]];
+
+		if(true == collinear(vertices[t.vertex_indices[0]], vertices[t.vertex_indices[1]], vertices[t.vertex_indices[2]]))
+			continue;
+
+		triangles.push_back(t);
+	}
+
+	if(true == triangles.empty())
+		return false;
+
+	// Plane i is the support of triangle i; planes for open or flat edges follow.
+	planes.resize(triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+		planes[i].set(vertices[triangles[i].vertex_indices[0]], vertices[triangles[i].vertex_indices[1]], vertices[triangles[i].vertex_indices[2]]);
+
+	vector<directed_edge> edges;
+	list_edges(triangles, edges);
+
+	pool.polygons.resize(triangles.size());
+	pool.sides.resize(3*triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		bsp_polygon &p = pool.polygons[i];
+		p.support = static_cast<uint32_t>(i);
+		p.first_side = static_cast<uint32_t>(3*i);
+		p.side_count = 3;
+		p.next = none;
+		p.flipped = false;
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			const vertex_3 &a = vertices[triangles[i].vertex_indices[k]];
+			const vertex_3 &b = vertices[triangles[i].vertex_indices[(k + 1) % 3]];
+			const vertex_3 &c = vertices[triangles[i].vertex_indices[(k + 2) % 3]];
+
+			bsp_side &s = pool.sides[3*i + k];
+			s.position[0] = a.x;
+			s.position[1] = a.y;
+			s.position[2] = a.z;
+			s.error = 0.0;
+			s.plane = none;
+
+			// The edge is bounded by the neighbour's plane, unless that is the support again.
+			const vector<directed_edge>::const_iterator twin = find_edge(edges, triangles[i].vertex_indices[(k + 1) % 3], triangles[i].vertex_indices[k]);
+
+			if(edges.end() != twin)
+			{
+				const vertex_3 &d = vertices[triangles[twin->triangle].vertex_indices[(twin->corner + 2) % 3]];
+
+				if(0 != orient3d(a, b, c, d))
+					s.plane = twin->triangle;
+			}
+
+			if(none != s.plane)
+				continue;
+
+			// A plane through the edge and a point off the support, moved along the axis
+			// that the support faces most.
+			const double *const n = planes[i].normal;
+			const size_t axis = (fabs(n[0]) >= fabs(n[1]) && fabs(n[0]) >= fabs(n[2])) ? 0 : ((fabs(n[1]) >= fabs(n[2])) ? 1 : 2);
+			float q[3] = { a.x, a.y, a.z };
+			const float step = fabs(coordinate(b, 0) - a.x) + fabs(coordinate(b, 1) - a.y) + fabs(coordinate(b, 2) - a.z);
+
+			q[axis] += step;
+
+			if(q[axis] == coordinate(a, axis))
+				q[axis] = nextafterf(q[axis], HUGE_VALF);
+
+			plane_3 edge_plane;
+			edge_plane.set(a, b, vertex_3(q[0], q[1], q[2]));
+
+			s.plane = static_cast<uint32_t>(planes.size());
+			planes.push_back(edge_plane);
+		}
+	}
+
+	build_nodes(num_threads);
+
+	return true;
+}
+
+void bsp_tree::clear(void)
+{
+	planes.clear();
+	nodes.clear();
+	pool.clear();
+}
+
+size_t bsp_tree::memory_usage(void) const
+{
+	return planes.capacity()*sizeof(plane_3) + nodes.capacity()*sizeof(bsp_node) + pool.polygons.capacity()*sizeof(bsp_polygon) + pool.sides.capacity()*sizeof(bsp_side);
+}
+
+
+// A corner of a polygon as the three planes that meet there, in increasing order.
+class corner_planes
+{
+public:
+	corner_planes(const bsp_polygon &p, const uint32_t k, const vector<bsp_side> &sides) : side(p.first_side + k)
+	{
+		planes[0] = p.support;
+		planes[1] = sides[p.first_side + (k + p.side_count - 1) % p.side_count].plane;
+		planes[2] = sides[side].plane;
+		sort(planes, planes + 3);
+	}
+
+	uint32_t planes[3];
+	uint32_t side; // Into the sides, for the corner's position
+};
+
+// Whether two corners are the same point.
+static bool same_point(const vector<plane_3> &planes, const vector<bsp_side> &sides, const corner_planes &a, const corner_planes &b)
+{
+	if(a.planes[0] == b.planes[0] && a.planes[1] == b.planes[1] && a.planes[2] == b.planes[2])
+		return true;
+
+	const bsp_side &at = sides[a.side], &bt = sides[b.side];
+
+	// Corners of the input mesh are held exactly.
+	if(0.0 == at.error && 0.0 == bt.error)
+		return at.position[0] == bt.position[0] && at.position[1] == bt.position[1] && at.position[2] == bt.position[2];
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		if(b.planes[k] == a.planes[0] || b.planes[k] == a.planes[1] || b.planes[k] == a.planes[2])
+			continue;
+
+		if(0 != classify_point(planes[a.planes[0]], planes[a.planes[1]], planes[a.planes[2]], at.position, at.error, planes[b.planes[k]]))
+			return false;
+	}
+
+	return true;
+}
+
+// Where each vertex of a mesh from to_mesh() came from, for exact tests on it.
+class vertex_origins
+{
+public:
+	vertex_origins(const vector<plane_3> &src_planes, const vector<bsp_side> &src_sides, const vector<corner_planes> &src_corners) : planes(src_planes), sides(src_sides), corners(src_corners) { /* custom constructor */ }
+
+	// Where vertex v is, far more closely than its float.
+	inline const double *position(const mesh_index v) const { return sides[corners[v].side].position; }
+
+	// Compares vertices a and b along an axis, as compare_points() does.
+	inline int compare(const mesh_index a, const mesh_index b, const size_t axis) const
+	{
+		const corner_planes &c = corners[a], &d = corners[b];
+		const bsp_side &s = sides[c.side], &t = sides[d.side];
+
+		return compare_points(planes[c.planes[0]], planes[c.planes[1]], planes[c.planes[2]], s.position, s.error, planes[d.planes[0]], planes[d.planes[1]], planes[d.planes[2]], t.position, t.error, axis);
+	}
+
+	// Whether vertex v lies on the line of two planes, as made by line_key().
+	bool on_line(const mesh_index v, const uint64_t line) const
+	{
+		const corner_planes &c = corners[v];
+		const bsp_side &s = sides[c.side];
+		const uint32_t line_planes[2] = { static_cast<uint32_t>(line >> 32), static_cast<uint32_t>(line & 0xFFFFFFFF) };
+
+		for(size_t k = 0; k < 2; k++)
+		{
+			if(line_planes[k] == c.planes[0] || line_planes[k] == c.planes[1] || line_planes[k] == c.planes[2])
+				continue;
+
+			if(0 != classify_point(planes[c.planes[0]], planes[c.planes[1]], planes[c.planes[2]], s.position, s.error, planes[line_planes[k]]))
+				return false;
+		}
+
+		return true;
+	}
+
+	const vector<plane_3> &planes;
+	const vector<bsp_side> &sides;
+	const vector<corner_planes> &corners;
+};
+
+// The line that a polygon's edge runs along, as the two planes it lies in, lower index
+// first. Every piece of the edge, on either side of it, has the same one.
+static inline uint64_t line_key(const uint32_t p, const uint32_t q)
+{
+	return (p < q) ? ((static_cast<uint64_t>(p) << 32) | q) : ((static_cast<uint64_t>(q) << 32) | p);
+}
+
+// For a triangle edge that is not on a polygon's border.
+static const uint64_t no_line = ~static_cast<uint64_t>(0);
+
+// A corner of a triangle being mended, and the triangle's edges it lies on (bit k for the
+// edge from corner k).
+class ring_corner
+{
+public:
+	ring_corner(const mesh_index src_vertex, const unsigned int src_edges) : vertex(src_vertex), edges(src_edges) { /* custom constructor */ }
+
+	mesh_index vertex;
+	unsigned int edges;
+};
+
+// The line of the triangle edge from u to v, where u and v are corners of a ring made
+// from a triangle whose edges run along lines[3].
+static inline uint64_t ring_line(const ring_corner &u, const ring_corner &v, const uint64_t lines[3])
+{
+	const unsigned int shared = u.edges & v.edges;
+
+	if(0 == shared)
+		return no_line;
+
+	return lines[(shared & 1) ? 0 : ((shared & 2) ? 1 : 2)];
+}
+
+// Triangulates a triangle with corners added along its edges, by cutting off its fattest
+// corner each time. A corner whose neighbours are on one edge is not cut off, since other
+// corners lie between them, unless they are all that is left.
+static void triangulate_ring(const vertex_origins &origins, vector<ring_corner> &ring, const double normal[3], const uint64_t lines[3], vector<indexed_triangle> &out, vector<uint64_t> &out_lines)
+{
+	while(ring.size() > 3)
+	{
+		size_t best = ring.size();
+		double best_area = 0.0;
+
+		for(size_t i = 0; i < ring.size(); i++)
+		{
+			const ring_corner &prev = ring[(i + ring.size() - 1) % ring.size()];
+			const ring_corner &next = ring[(i + 1) % ring.size()];
+
+			if(0 != (prev.edges & next.edges))
+				continue;
+
+			const double *a = origins.position(prev.vertex), *b = origins.position(ring[i].vertex), *c = origins.position(next.vertex);
+			const double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const double area = normal[0]*(u[1]*v[2] - u[2]*v[1]) + normal[1]*(u[2]*v[0] - u[0]*v[2]) + normal[2]*(u[0]*v[1] - u[1]*v[0]);
+
+			if(area > best_area)
+			{
+				best_area = area;
+				best = i;
+			}
+		}
+
+		if(ring.size() == best)
+			break;
+
+		const ring_corner &prev = ring[(best + ring.size() - 1) % ring.size()];
+		const ring_corner &next = ring[(best + 1) % ring.size()];
+
+		indexed_triangle t;
+		t.vertex_indices[0] = prev.vertex;
+		t.vertex_indices[1] = ring[best].vertex;
+		t.vertex_indices[2] = next.vertex;
+		out.push_back(t);
+		out_lines.push_back(ring_line(prev, ring[best], lines));
+		out_lines.push_back(ring_line(ring[best], next, lines));
+		out_lines.push_back(no_line);
+
+		ring.erase(ring.begin() + best);
+	}
+
+	// Whatever is left has no area to speak of; a fan at least keeps every edge shared.
+	for(size_t i = 1; i + 1 < ring.size(); i++)
+	{
+		indexed_triangle t;
+		t.vertex_indices[0] = ring[0].vertex;
+		t.vertex_indices[1] = ring[i].vertex;
+		t.vertex_indices[2] = ring[i + 1].vertex;
+		out.push_back(t);
+		out_lines.push_back(ring_line(ring[0], ring[i], lines));
+		out_lines.push_back(ring_line(ring[i], ring[i + 1], lines));
+		out_lines.push_back(ring_line(ring[i + 1], ring[0], lines));
+	}
+}
+
+static uint32_t find_root(vector<uint32_t> &parent, uint32_t i)
+{
+	while(parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+
+	return i;
+}
+
+static inline void unite(vector<uint32_t> &parent, const uint32_t i, const uint32_t j)
+{
+	parent[find_root(parent, i)] = find_root(parent, j);
+}
+
+static inline double distance_1(const double a[3], const double b[3])
+{
+	return fabs(b[0] - a[0]) + fabs(b[1] - a[1]) + fabs(b[2] - a[2]);
+}
+
+// How far p is from the line through a and b.
+static double line_distance(const double p[3], const double a[3], const double b[3])
+{
+	const double d[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	const double w[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+	const double c[3] = { w[1]*d[2] - w[2]*d[1], w[2]*d[0] - w[0]*d[2], w[0]*d[1] - w[1]*d[0] };
+	const double length = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+
+	if(0.0 == length)
+		return 0.0;
+
+	return sqrt(c[0]*c[0] + c[1]*c[1] + c[2]*c[2]) / length;
+}
+
+class edge_insertion
+{
+public:
+	uint32_t triangle;
+	uint32_t corner;
+	uint32_t first; // Into the inserted vertices, in order from the edge's start to its end
+	uint32_t count;
+
+	inline bool operator<(const edge_insertion &right) const
+	{
+		if(triangle < right.triangle)
+			return true;
+		else if(triangle > right.triangle)
+			return false;
+
+		return corner < right.corner;
+	}
+};
+
+// Orders vertices on one line by where they are along one axis, exactly.
+class along_axis
+{
+public:
+	along_axis(const vertex_origins &src_origins, const size_t src_axis) : origins(src_origins), axis(src_axis) { /* custom constructor */ }
+
+	inline bool operator()(const mesh_index a, const mesh_index b) const
+	{
+		if(a == b)
+			return false;
+
+		const int order = origins.compare(a, b, axis);
+
+		// Only the same point is level, and that is one vertex.
+		if(0 == order)
+			return a < b;
+
+		return order < 0;
+	}
+
+	const vertex_origins &origins;
+	size_t axis;
+};
+
+// Edges without a partner come in groups along one line: a long edge on one side, and on
+// the other the shorter edges it was split into (a T-junction). Each edge of a group gets
+// every vertex of the group that lies within it, so that both sides end up with the same
+// edges.
+//
+// The groups are found exactly: the pieces of an edge all lie in the same two planes,
+// whose indices are in lines, three per triangle. Where two coplanar polygons each bounded
+// their shared edge by a plane of their own, the same line has two keys; long edges that
+// meet at a vertex and look collinear are grouped if the far end of one is exactly on the
+// other's line. Points are ordered along a line exactly too, so that corners closer than a
+// float apart still go in the right way round.
+//
+// Returns the number of edges still without a partner.
+static size_t mend_t_junctions(indexed_mesh &mesh, vector<uint64_t> &lines, const vertex_origins &origins)
+{
+	double largest = 0.0;
+
+	for(size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const double *p = origins.position(static_cast<mesh_index>(i));
+		const double m = fabs(p[0]) + fabs(p[1]) + fabs(p[2]);
+
+		if(m > largest)
+			largest = m;
+	}
+
+	// Edges much longer than a float's rounding have a direction worth comparing; the
+	// comparison only saves exact tests.
+	const double tolerance = 8.0*FLT_EPSILON*largest;
+	const double long_edge = 64.0*tolerance;
+
+	vector<directed_edge> edges, open;
+	size_t open_count = 0;
+
+	// A few passes, as a vertex put into an edge can be the start of another T-junction.
+	for(size_t pass = 0; ; pass++)
+	{
+		list_edges(mesh.triangles, edges);
+		open.clear();
+
+		for(size_t i = 0; i < edges.size(); i++)
+			if(edges.end() == find_edge(edges, edges[i].to, edges[i].from))
+				open.push_back(edges[i]);
+
+		open_count = open.size();
+
+		if(0 == open_count || 4 == pass)
+			break;
+
+		vector<uint32_t> parent(open.size());
+
+		for(size_t i = 0; i < parent.size(); i++)
+			parent[i] = static_cast<uint32_t>(i);
+
+		// The same line exactly.
+		vector< pair<uint64_t, uint32_t> > keyed;
+		keyed.reserve(open.size());
+
+		for(size_t i = 0; i < open.size(); i++)
+		{
+			const uint64_t line = lines[3*open[i].triangle + open[i].corner];
+
+			if(no_line != line)
+				keyed.push_back(make_pair(line, static_cast<uint32_t>(i)));
+		}
+
+		sort(keyed.begin(), keyed.end());
+
+		for(size_t i = 1; i < keyed.size(); i++)
+			if(keyed[i].first == keyed[i - 1].first)
+				unite(parent, keyed[i].second, keyed[i - 1].second);
+
+		// Long edges on the same line under another key.
+		vector< pair<mesh_index, uint32_t> > ends;
+		ends.reserve(2*open.size());
+
+		for(size_t i = 0; i < open.size(); i++)
+		{
+			if(no_line == lines[3*open[i].triangle + open[i].corner] || distance_1(origins.position(open[i].from), origins.position(open[i].to)) <= long_edge)
+				continue;
+
+			ends.push_back(make_pair(open[i].from, static_cast<uint32_t>(i)));
+			ends.push_back(make_pair(open[i].to, static_cast<uint32_t>(i)));
+		}
+
+		sort(ends.begin(), ends.end());
+
+		for(size_t first = 0, last = 0; first < ends.size(); first = last)
+		{
+			for(last = first + 1; last < ends.size() && ends[last].first == ends[first].first; last++);
+
+			const mesh_index v = ends[first].first;
+
+			for(size_t i = first; i < last; i++)
+			{
+				for(size_t j = i + 1; j < last; j++)
+				{
+					const directed_edge &e = open[ends[i].second], &f = open[ends[j].second];
+					const uint64_t e_line = lines[3*e.triangle + e.corner], f_line = lines[3*f.triangle + f.corner];
+
+					if(e_line == f_line)
+						continue;
+
+					const mesh_index far_end = (f.from == v) ? f.to : f.from;
+					const double *p = origins.position(v);
+					const double *q = origins.position((e.from == v) ? e.to : e.from);
+					const double *r = origins.position(far_end);
+
+					if(line_distance(r, p, q) <= tolerance && true == origins.on_line(far_end, e_line))
+						unite(parent, ends[i].second, ends[j].second);
+				}
+			}
+		}
+
+		vector< pair<uint32_t, uint32_t> > groups(open.size());
+
+		for(size_t i = 0; i < open.size(); i++)
+			groups[i] = make_pair(find_root(parent, static_cast<uint32_t>(i)), static_cast<uint32_t>(i));
+
+		sort(groups.begin(), groups.end());
+
+		vector<edge_insertion> insertions;
+		vector<mesh_index> inserted;
+		vector<mesh_index> points;
+
+		for(size_t first = 0, last = 0; first < groups.size(); first = last)
+		{
+			for(last = first + 1; last < groups.size() && groups[last].first == groups[first].first; last++);
+
+			if(last - first < 2)
+				continue;
+
+			// Order the group's vertices along the axis that its longest edge runs most along;
+			// the group is on one line, exactly, so the order is.
+			size_t longest = first;
+			double longest_length = -1.0;
+
+			for(size_t i = first; i < last; i++)
+			{
+				const double length = distance_1(origins.position(open[groups[i].second].from), origins.position(open[groups[i].second].to));
+
+				if(length > longest_length)
+				{
+					longest_length = length;
+					longest = i;
+				}
+			}
+
+			const double *origin = origins.position(open[groups[longest].second].from);
+			const double *toward = origins.position(open[groups[longest].second].to);
+			size_t axis = 0;
+
+			for(size_t k = 1; k < 3; k++)
+				if(fabs(toward[k] - origin[k]) > fabs(toward[axis] - origin[axis]))
+					axis = k;
+
+			points.clear();
+
+			for(size_t i = first; i < last; i++)
+			{
+				points.push_back(open[groups[i].second].from);
+				points.push_back(open[groups[i].second].to);
+			}
+
+			sort(points.begin(), points.end(), along_axis(origins, axis));
+			points.erase(unique(points.begin(), points.end()), points.end());
+
+			for(size_t i = first; i < last; i++)
+			{
+				const directed_edge &e = open[groups[i].second];
+				size_t from = 0, to = 0;
+
+				for(size_t j = 0; j < points.size(); j++)
+				{
+					if(points[j] == e.from)
+						from = j;
+
+					if(points[j] == e.to)
+						to = j;
+				}
+
+				if((from > to ? from - to : to - from) < 2)
+					continue;
+
+				edge_insertion insertion;
+				insertion.triangle = e.triangle;
+				insertion.corner = e.corner;
+				insertion.first = static_cast<uint32_t>(inserted.size());
+
+				if(from < to)
+				{
+					for(size_t j = from + 1; j < to; j++)
+						inserted.push_back(points[j]);
+				}
+				else
+				{
+					for(size_t j = from - 1; j > to; j--)
+						inserted.push_back(points[j]);
+				}
+
+				insertion.count = static_cast<uint32_t>(inserted.size() - insertion.first);
+				insertions.push_back(insertion);
+			}
+		}
+
+		if(true == insertions.empty())
+			break;
+
+		sort(insertions.begin(), insertions.end());
+
+		vector<ring_corner> ring;
+		vector<indexed_triangle> pieces;
+		vector<uint64_t> piece_lines;
+
+		for(size_t first = 0, last = 0; first < insertions.size(); first = last)
+		{
+			const uint32_t triangle = insertions[first].triangle;
+
+			for(last = first + 1; last < insertions.size() && insertions[last].triangle == triangle; last++);
+
+			const indexed_triangle t = mesh.triangles[triangle];
+			const uint64_t triangle_lines[3] = { lines[3*triangle], lines[3*triangle + 1], lines[3*triangle + 2] };
+			ring.clear();
+
+			for(size_t k = 0, next = first; k < 3; k++)
+			{
+				ring.push_back(ring_corner(t.vertex_indices[k], (1u << k) | (1u << ((k + 2) % 3))));
+
+				if(next < last && insertions[next].corner == k)
+				{
+					for(uint32_t j = 0; j < insertions[next].count; j++)
+						ring.push_back(ring_corner(inserted[insertions[next].first + j], 1u << k));
+
+					next++;
+				}
+			}
+
+			const double *a = origins.position(t.vertex_indices[0]), *b = origins.position(t.vertex_indices[1]), *c = origins.position(t.vertex_indices[2]);
+			const double u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			const double v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			const double normal[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+
+			pieces.clear();
+			piece_lines.clear();
+			triangulate_ring(origins, ring, normal, triangle_lines, pieces, piece_lines);
+
+			mesh.triangles[triangle] = pieces[0];
+
+			for(size_t k = 0; k < 3; k++)
+				lines[3*triangle + k] = piece_lines[k];
+
+			mesh.triangles.insert(mesh.triangles.end(), pieces.begin() + 1, pieces.end());
+			lines.insert(lines.end(), piece_lines.begin() + 3, piece_lines.end());
+		}
+	}
+
+	return open_count;
+}
+
+// A polygon of to_mesh(), as its corners: indices into the pool's sides, each giving where
+// the corner is and the plane of the edge that leaves it.
+class face_ring
+{
+public:
+	uint32_t support;
+	bool flipped;
+	uint32_t first; // Into the ring sides
+	uint32_t count;
+};
+
+// An edge of a ring, between welded vertices. The rings of one face share its key.
+class ring_edge
+{
+public:
+	uint64_t face;
+	mesh_index from;
+	mesh_index to;
+	uint32_t ring;
+	uint32_t corner; // The edge runs from this corner of the ring to the next
+
+	inline bool operator<(const ring_edge &right) const
+	{
+		if(face != right.face)
+			return face < right.face;
+
+		if(from != right.from)
+			return from < right.from;
+
+		if(to != right.to)
+			return to < right.to;
+
+		return ring < right.ring;
+	}
+};
+
+static inline uint64_t face_key(const face_ring &r)
+{
+	return (static_cast<uint64_t>(r.support) << 1) | (true == r.flipped ? 1 : 0);
+}
+
+// The side of plane h that corner k of the ring lies on.
+static int ring_corner_side(const vector<plane_3> &planes, const vector<bsp_side> &sides, const vector<uint32_t> &ring_sides, const face_ring &r, const uint32_t k, const uint32_t h)
+{
+	const bsp_side &s = sides[ring_sides[r.first + k]];
+	const uint32_t incoming = sides[ring_sides[r.first + (k + r.count - 1) % r.count]].plane;
+
+	if(h == r.support || h == incoming || h == s.plane)
+		return 0;
+
+	return classify_point(planes[r.support], planes[incoming], planes[s.plane], s.position, s.error, planes[h]);
+}
+
+// Where two rings are joined at a corner, whose edges come in along plane incoming from
+// ring r and leave along outgoing into ring t: 1 if the corner stays, 0 if the edges run
+// on along one line and it goes, -1 if the join would not be convex there. Corner k of r,
+// off incoming, tells which side of it is inside; corner m of t is the one after the join.
+static int join_corner(const vector<plane_3> &planes, const vector<bsp_side> &sides, const vector<uint32_t> &ring_sides, const face_ring &r, const uint32_t k, const face_ring &t, const uint32_t m, const uint32_t incoming, const uint32_t outgoing)
+{
+	if(incoming == outgoing)
+		return 0;
+
+	const int inside = ring_corner_side(planes, sides, ring_sides, r, k, incoming);
+	const int turn = ring_corner_side(planes, sides, ring_sides, t, m, incoming);
+
+	if(0 == inside)
+		return -1;
+
+	if(0 == turn)
+		return 0;
+
+	return (turn == inside) ? 1 : -1;
+}
+
+// Joins ring a, whose edge from corner i runs from u to v, and ring b, whose edge from
+// corner j runs back from v to u, into a new ring if their union is convex.
+static bool join_rings(const vector<plane_3> &planes, const vector<bsp_side> &sides, vector<face_ring> &rings, vector<uint32_t> &ring_sides, const uint32_t ra, const uint32_t i, const uint32_t rb, const uint32_t j)
+{
+	const face_ring a = rings[ra], b = rings[rb];
+	const uint32_t n = a.count, m = b.count;
+
+	// At u, a's edges come in and b's go on; at v, the other way round.
+	const uint32_t u_in = sides[ring_sides[a.first + (i + n - 1) % n]].plane, u_out = sides[ring_sides[b.first + (j + 1) % m]].plane;
+	const uint32_t v_in = sides[ring_sides[b.first + (j + m - 1) % m]].plane, v_out = sides[ring_sides[a.first + (i + 1) % n]].plane;
+
+	const int keep_u = join_corner(planes, sides, ring_sides, a, (i + 1) % n, b, (j + 2) % m, u_in, u_out);
+	const int keep_v = join_corner(planes, sides, ring_sides, b, (j + 1) % m, a, (i + 2) % n, v_in, v_out);
+
+	if(keep_u < 0 || keep_v < 0 || n + m - 2 - (0 == keep_u ? 1 : 0) - (0 == keep_v ? 1 : 0) < 3)
+		return false;
+
+	face_ring joined = a;
+	joined.first = static_cast<uint32_t>(ring_sides.size());
+
+	// From v round a to u, then round b back to v.
+	for(uint32_t k = (0 == keep_v) ? 2 : 1; k < n; k++)
+	{
+		const uint32_t side = ring_sides[a.first + (i + k) % n];
+		ring_sides.push_back(side);
+	}
+
+	for(uint32_t k = (0 == keep_u) ? 2 : 1; k < m; k++)
+	{
+		const uint32_t side = ring_sides[b.first + (j + k) % m];
+		ring_sides.push_back(side);
+	}
+
+	joined.count = static_cast<uint32_t>(ring_sides.size() - joined.first);
+	rings.push_back(joined);
+
+	return true;
+}
+
+// Building and clipping cut a polygon into fragments, each of which would otherwise be
+// triangulated or built over apart. Two fragments of one face (the same support, facing
+// the same way) that share a whole edge, between the same corners by corner_vertex (one
+// per side of the pool), are joined wherever their union is convex, in passes until
+// nothing more joins. Where a cut crossed an edge, the corner goes again, so a polygon
+// that was split and kept whole comes back as it was. Returns the joined rings, in order.
+static void join_fragments(const vector<plane_3> &planes, const bsp_polygon_pool &pool, const vector<mesh_index> &corner_vertex, vector<face_ring> &rings, vector<uint32_t> &ring_sides)
+{
+	rings.resize(pool.polygons.size());
+	ring_sides.resize(pool.sides.size());
+
+	vector< pair<uint64_t, uint32_t> > faces(rings.size());
+
+	for(size_t i = 0; i < rings.size(); i++)
+	{
+		const bsp_polygon &p = pool.polygons[i];
+		rings[i].support = p.support;
+		rings[i].flipped = p.flipped;
+		rings[i].first = p.first_side;
+		rings[i].count = p.side_count;
+
+		for(uint32_t k = 0; k < p.side_count; k++)
+			ring_sides[p.first_side + k] = p.first_side + k;
+
+		faces[i] = make_pair(face_key(rings[i]), static_cast<uint32_t>(i));
+	}
+
+	sort(faces.begin(), faces.end());
+
+	// Only faces in more than one piece.
+	vector<uint32_t> candidates;
+
+	for(size_t first = 0, last = 0; first < faces.size(); first = last)
+	{
+		for(last = first + 1; last < faces.size() && faces[last].first == faces[first].first; last++);
+
+		if(last - first > 1)
+			for(size_t i = first; i < last; i++)
+				candidates.push_back(faces[i].second);
+	}
+
+	vector<bool> alive(rings.size(), true);
+	vector<ring_edge> edges;
+	vector<uint64_t> joined_faces;
+
+	while(false == candidates.empty())
+	{
+		edges.clear();
+
+		for(size_t c = 0; c < candidates.size(); c++)
+		{
+			const face_ring &r = rings[candidates[c]];
+
+			for(uint32_t k = 0; k < r.count; k++)
+			{
+				ring_edge e;
+				e.face = face_key(r);
+				e.from = corner_vertex[ring_sides[r.first + k]];
+				e.to = corner_vertex[ring_sides[r.first + (k + 1) % r.count]];
+				e.ring = candidates[c];
+				e.corner = k;
+				edges.push_back(e);
+			}
+		}
+
+		sort(edges.begin(), edges.end());
+
+		// A ring joins once per pass, as the new ring's corners are numbered afresh.
+		vector<bool> used(rings.size(), false);
+		joined_faces.clear();
+
+		for(size_t i = 0; i < edges.size(); i++)
+		{
+			const ring_edge &e = edges[i];
+
+			if(true == used[e.ring])
+				continue;
+
+			ring_edge key;
+			key.face = e.face;
+			key.from = e.to;
+			key.to = e.from;
+			key.ring = 0;
+
+			const vector<ring_edge>::const_iterator twin = lower_bound(edges.begin(), edges.end(), key);
+
+			if(twin == edges.end() || twin->face != e.face || twin->from != e.to || twin->to != e.from || twin->ring == e.ring || true == used[twin->ring])
+				continue;
+
+			if(false == join_rings(planes, pool.sides, rings, ring_sides, e.ring, e.corner, twin->ring, twin->corner))
+				continue;
+
+			used[e.ring] = used[twin->ring] = true;
+			alive[e.ring] = alive[twin->ring] = false;
+			alive.push_back(true);
+			joined_faces.push_back(e.face);
+		}
+
+		// The next pass looks again at the faces that joined.
+		sort(joined_faces.begin(), joined_faces.end());
+
+		vector<uint32_t> next;
+
+		for(size_t c = 0; c < candidates.size(); c++)
+			if(true == alive[candidates[c]] && true == binary_search(joined_faces.begin(), joined_faces.end(), face_key(rings[candidates[c]])))
+				next.push_back(candidates[c]);
+
+		for(size_t r = used.size(); r < rings.size(); r++)
+			next.push_back(static_cast<uint32_t>(r));
+
+		candidates.swap(next);
+	}
+
+	size_t count = 0;
+
+	for(size_t i = 0; i < rings.size(); i++)
+		if(true == alive[i])
+			rings[count++] = rings[i];
+
+	rings.resize(count);
+}
+
+// Joins the fragments of each face in pool, as to_mesh() does, matching corners by the
+// three planes they are cut out by, which the two sides of a cut share.
+static void join_pool_fragments(const vector<plane_3> &planes, bsp_polygon_pool &pool)
+{
+	// The planes of each corner, as (first, second) and (third, side).
+	vector< pair<uint64_t, uint64_t> > keyed(pool.sides.size());
+
+	for(size_t i = 0; i < pool.polygons.size(); i++)
+	{
+		const bsp_polygon &p = pool.polygons[i];
+
+		for(uint32_t k = 0; k < p.side_count; k++)
+		{
+			const corner_planes corner(p, k, pool.sides);
+			keyed[corner.side] = make_pair((static_cast<uint64_t>(corner.planes[0]) << 32) | corner.planes[1], (static_cast<uint64_t>(corner.planes[2]) << 32) | corner.side);
+		}
+	}
+
+	sort(keyed.begin(), keyed.end());
+
+	vector<mesh_index> corner_id(pool.sides.size());
+	mesh_index id = 0;
+
+	for(size_t i = 0; i < keyed.size(); i++)
+	{
+		if(i > 0 && (keyed[i].first != keyed[i - 1].first || (keyed[i].second >> 32) != (keyed[i - 1].second >> 32)))
+			id++;
+
+		corner_id[keyed[i].second & 0xFFFFFFFF] = id;
+	}
+
+	vector<face_ring> rings;
+	vector<uint32_t> ring_sides;
+	join_fragments(planes, pool, corner_id, rings, ring_sides);
+
+	bsp_polygon_pool joined;
+	joined.polygons.reserve(rings.size());
+	joined.sides.reserve(pool.sides.size());
+
+	for(size_t i = 0; i < rings.size(); i++)
+	{
+		bsp_polygon p;
+		p.support = rings[i].support;
+		p.first_side = static_cast<uint32_t>(joined.sides.size());
+		p.side_count = rings[i].count;
+		p.next = bsp_tree::none;
+		p.flipped = rings[i].flipped;
+
+		for(uint32_t k = 0; k < rings[i].count; k++)
+			joined.sides.push_back(pool.sides[ring_sides[rings[i].first + k]]);
+
+		joined.polygons.push_back(p);
+	}
+
+	pool.polygons.swap(joined.polygons);
+	pool.sides.swap(joined.sides);
+}
+
+size_t bsp_tree::to_mesh(indexed_mesh &mesh, const size_t num_threads) const
+{
+	mesh.clear();
+
+	// Corners are welded by the points they are, not by where they round to: two corners
+	// are one vertex if they are cut out by the same three planes, or, failing that, if
+	// one lies on the other's planes. Distinct points that round to the same float stay
+	// distinct vertices, so the mesh is closed whatever the rounding does.
+	vertex_welder welder(pool.sides.size());
+	vector<mesh_index> corner_vertex(pool.sides.size());
+	vector<mesh_index> first_exact; // Per rounded position: the first vertex there
+	vector<mesh_index> next_exact;  // Per vertex: the next vertex at the same rounded position
+	vector<corner_planes> vertex_corners; // Per vertex: the corner it was first made from
+	vector<vertex_3> vertices;
+
+	for(size_t i = 0; i < pool.polygons.size(); i++)
+	{
+		const bsp_polygon &p = pool.polygons[i];
+
+		for(uint32_t k = 0; k < p.side_count; k++)
+		{
+			const corner_planes corner(p, k, pool.sides);
+			const bsp_side &s = pool.sides[corner.side];
+			const vertex_3 v = round_point(planes[corner.planes[0]], planes[corner.planes[1]], planes[corner.planes[2]], s.position, s.error);
+			const size_t rounded = welder.weld(v);
+
+			if(rounded == first_exact.size())
+				first_exact.push_back(static_cast<mesh_index>(none));
+
+			mesh_index index = first_exact[rounded];
+
+			while(none != index && false == same_point(planes, pool.sides, corner, vertex_corners[index]))
+				index = next_exact[index];
+
+			if(none == index)
+			{
+				index = static_cast<mesh_index>(vertices.size());
+				vertices.push_back(v);
+				vertex_corners.push_back(corner);
+				next_exact.push_back(first_exact[rounded]);
+				first_exact[rounded] = index;
+			}
+
+			corner_vertex[p.first_side + k] = index;
+		}
+	}
+
+	vector<face_ring> rings;
+	vector<uint32_t> ring_sides;
+	join_fragments(planes, pool, corner_vertex, rings, ring_sides);
+
+	// Corners that joining took out of every ring are left out; the rest keep their order.
+	vector<mesh_index> new_index(vertices.size(), static_cast<mesh_index>(none));
+
+	for(size_t i = 0; i < rings.size(); i++)
+		for(uint32_t k = 0; k < rings[i].count; k++)
+			new_index[corner_vertex[ring_sides[rings[i].first + k]]] = 0;
+
+	vector<corner_planes> used_corners;
+
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		if(none == new_index[i])
+			continue;
+
+		new_index[i] = static_cast<mesh_index>(mesh.vertices.size());
+		mesh.vertices.push_back(vertices[i]);
+		used_corners.push_back(vertex_corners[i]);
+	}
+
+	// The line of each triangle edge that runs along a polygon's edge, for mending.
+	vector<uint64_t> lines;
+	vector< pair<mesh_index, uint64_t> > ring; // A corner, and the line of the edge leaving it
+
+	for(size_t i = 0; i < rings.size(); i++)
+	{
+		const face_ring &r = rings[i];
+		ring.clear();
+
+		for(uint32_t k = 0; k < r.count; k++)
+		{
+			// Turned over, the corners are taken backwards, and the edge from corner j to
+			// j - 1 is side j - 1's.
+			const uint32_t corner = (true == r.flipped) ? r.count - 1 - k : k;
+			const uint32_t side = (true == r.flipped) ? (corner + r.count - 1) % r.count : corner;
+
+			ring.push_back(make_pair(new_index[corner_vertex[ring_sides[r.first + corner]]], line_key(r.support, pool.sides[ring_sides[r.first + side]].plane)));
+		}
+
+		for(size_t k = 1; k + 1 < ring.size(); k++)
+		{
+			indexed_triangle t;
+			t.vertex_indices[0] = ring[0].first;
+			t.vertex_indices[1] = ring[k].first;
+			t.vertex_indices[2] = ring[k + 1].first;
+
+			mesh.triangles.push_back(t);
+			lines.push_back((1 == k) ? ring[0].second : no_line);
+			lines.push_back(ring[k].second);
+			lines.push_back((k + 2 == ring.size()) ? ring[k + 1].second : no_line);
+		}
+	}
+
+	const size_t open_count = mend_t_junctions(mesh, lines, vertex_origins(planes, pool.sides, used_corners));
+
+	mesh.generate_adjacency(num_threads);
+
+	return open_count;
+}
+
+bsp_boolean::bsp_boolean(void) : clipped_polygon_count(0), reused_polygon_count(0), result_polygon_count(0), clip_time(0.0), build_time(0.0)
+{
+	/* default constructor */
+}
+
+static bounding_box polygon_box(const bsp_polygon_pool &pool, const uint32_t index)
+{
+	const bsp_polygon &p = pool.polygons[index];
+	bounding_box box;
+
+	for(uint32_t k = 0; k < p.side_count; k++)
+		box.add(pool.sides[p.first_side + k].position, pool.sides[p.first_side + k].error);
+
+	return box;
+}
+
+// The box of the polygons under each node of the tree, the node's own included. Children
+// come after their parents (see compact()), so one pass from the back gathers them.
+static void subtree_boxes(const bsp_tree &tree, vector<bounding_box> &boxes)
+{
+	boxes.assign(tree.nodes.size(), bounding_box());
+
+	for(size_t i = tree.nodes.size(); i-- > 0; )
+	{
+		const bsp_node &node = tree.nodes[i];
+
+		for(uint32_t p = node.polygons; bsp_tree::none != p; p = tree.pool.polygons[p].next)
+			boxes[i].add(polygon_box(tree.pool, p));
+
+		if(bsp_tree::none != node.front)
+			boxes[i].add(boxes[node.front]);
+
+		if(bsp_tree::none != node.back)
+			boxes[i].add(boxes[node.back]);
+	}
+}
+
+// What clip_polygons() pushes down which tree.
+class clip_job
+{
+public:
+	clip_job(const vector<plane_3> &src_planes, const bsp_polygon_pool &src_source, const uint32_t src_source_offset, const bool src_flip, const bsp_tree &src_tree, const vector<bounding_box> &src_boxes, const uint32_t src_tree_offset, const bool src_inverted)
+		: planes(src_planes), source(src_source), source_offset(src_source_offset), flip(src_flip), tree(src_tree), boxes(src_boxes), tree_offset(src_tree_offset), inverted(src_inverted) { /* custom constructor */ }
+
+	const vector<plane_3> &planes;
+	const bsp_polygon_pool &source;
+	const uint32_t source_offset; // Added to the source polygons' plane indices
+	const bool flip;              // The source polygons are taken turned over
+	const bsp_tree &tree;
+	const vector<bounding_box> &boxes; // The tree's, from subtree_boxes()
+	const uint32_t tree_offset;   // Added to the tree's plane indices
+	const bool inverted;          // The tree is taken inside out: planes turned over, children swapped
+};
+
+class node_piece
+{
+public:
+	node_piece(const uint32_t src_node, const uint32_t src_piece) : node(src_node), piece(src_piece) { /* custom constructor */ }
+
+	uint32_t node;
+	uint32_t piece;
+};
+
+// Whether the first corner of polygon index of pool is inside the solid of job's tree,
+// going down from node without splitting anything. A corner on a node's plane goes to
+// its front.
+static bool corner_inside(const clip_job &job, uint32_t node, const bsp_polygon_pool &pool, const uint32_t index)
+{
+	const bsp_polygon &p = pool.polygons[index];
+	const bsp_side &corner = pool.sides[p.first_side];
+	const uint32_t incoming = pool.sides[p.first_side + p.side_count - 1].plane;
+
+	for(;;)
+	{
+		const bsp_node &n = job.tree.nodes[node];
+		const uint32_t h = n.plane + job.tree_offset;
+		int sign = 0;
+
+		if(h != p.support && h != incoming && h != corner.plane)
+			sign = classify_point(job.planes[p.support], job.planes[incoming], job.planes[corner.plane], corner.position, corner.error, job.planes[h]);
+
+		if(n.flipped != job.inverted)
+			sign = -sign;
+
+		const uint32_t front_child = (true == job.inverted) ? n.back : n.front;
+		const uint32_t back_child = (true == job.inverted) ? n.front : n.back;
+		const uint32_t child = (sign >= 0) ? front_child : back_child;
+
+		if(bsp_tree::none == child)
+			return (sign < 0);
+
+		node = child;
+	}
+}
+
+// Pushes source polygon index down the tree, splitting it at every node it spans, and
+// appends the pieces that reach a region outside the tree's solid to out. Pieces in a node's
+// plane go on to its front if they face the same way, and to its back otherwise. If every
+// piece is kept, the polygon goes to out whole, as most polygons away from the other
+// solid's surface do; they would otherwise come out in as many pieces as the tree has
+// planes across them.
+//
+// A piece clear of the box of everything under a node meets none of the solid's surface
+// there, so it is all inside or all outside, and one of its corners, taken down the
+// subtree on its own, tells which. Away from the other solid, that settles a polygon in
+// one pass down the tree, with no splitting at all.
+static void clip_polygon(const clip_job &job, const uint32_t index, bsp_polygon_pool &work, vector<node_piece> &stack, vector<uint32_t> &kept, split_scratch &scratch, bsp_polygon_pool &out)
+{
+	work.clear();
+	stack.clear();
+	kept.clear();
+
+	const uint32_t whole = work.add(job.source, index, job.source_offset, job.flip);
+	bool any_dropped = false;
+
+	stack.push_back(node_piece(0, whole));
+
+	while(false == stack.empty())
+	{
+		const node_piece item = stack.back();
+		stack.pop_back();
+
+		if(true == job.boxes[item.node].misses(polygon_box(work, item.piece)))
+		{
+			if(true == corner_inside(job, item.node, work, item.piece))
+				any_dropped = true;
+			else
+				kept.push_back(item.piece);
+
+			continue;
+		}
+
+		const bsp_node &node = job.tree.nodes[item.node];
+		const uint32_t front_child = (true == job.inverted) ? node.back : node.front;
+		const uint32_t back_child = (true == job.inverted) ? node.front : node.back;
+		uint32_t front = bsp_tree::none, back = bsp_tree::none;
+
+		switch(split_polygon(job.planes, work, item.piece, node.plane + job.tree_offset, node.flipped != job.inverted, front, back, scratch))
+		{
+		case POLYGON_COPLANAR_FRONT:
+		case POLYGON_FRONT:
+			front = item.piece;
+			break;
+		case POLYGON_COPLANAR_BACK:
+		case POLYGON_BACK:
+			back = item.piece;
+			break;
+		default:
+			break;
+		}
+
+		if(bsp_tree::none != back)
+		{
+			if(bsp_tree::none == back_child)
+				any_dropped = true;
+			else
+				stack.push_back(node_piece(back_child, back));
+		}
+
+		if(bsp_tree::none != front)
+		{
+			if(bsp_tree::none == front_child)
+				kept.push_back(front);
+			else
+				stack.push_back(node_piece(front_child, front));
+		}
+	}
+
+	if(false == any_dropped)
+	{
+		out.add(work, whole, 0, false);
+		return;
+	}
+
+	for(size_t i = 0; i < kept.size(); i++)
+		out.add(work, kept[i], 0, false);
+}
+
+// Clips ranges of polygons, taking the next unclaimed one each time, until there are none left.
+static void clip_ranges(const clip_job &job, vector<bsp_polygon_pool> &range_pools, atomic<size_t> &next_range)
+{
+	const size_t count = job.source.polygons.size();
+	bsp_polygon_pool work;
+	vector<node_piece> stack;
+	vector<uint32_t> kept;
+	split_scratch scratch;
+
+	for(size_t r = next_range++; r < range_pools.size(); r = next_range++)
+		for(size_t i = r*count/range_pools.size(); i < (r + 1)*count/range_pools.size(); i++)
+			clip_polygon(job, static_cast<uint32_t>(i), work, stack, kept, scratch, range_pools[r]);
+}
+
+// The pieces of job.source outside job.tree, in the order of the polygons they came from.
+static void clip_polygons(const clip_job &job, bsp_polygon_pool &out, const size_t num_threads)
+{
+	const size_t range_count = (num_threads <= 1) ? 1 : 32*num_threads;
+	vector<bsp_polygon_pool> range_pools(range_count);
+	atomic<size_t> next_range(0);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < num_threads; t++)
+		threads.push_back(thread(clip_ranges, cref(job), ref(range_pools), ref(next_range)));
+
+	clip_ranges(job, range_pools, next_range);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	out.clear();
+
+	for(size_t r = 0; r < range_count; r++)
+		out.append(range_pools[r]);
+}
+
+static void turn_over(bsp_polygon_pool &pool)
+{
+	for(size_t i = 0; i < pool.polygons.size(); i++)
+		pool.polygons[i].flipped = !pool.polygons[i].flipped;
+}
+
+// A box with float faces a little way out from one of a boolean's operands, and the six
+// regions around it, each in front of one face: region 0 below the box across x, 1 above
+// it, then 2 and 3 below and above it across y within its x range, and 4 and 5 across z
+// within its x and y ranges. A chain of nodes, one per face in that order, each with its
+// region in front and the next node behind, leaves the box itself behind the last.
+class box_regions
+{
+public:
+	// Sets the box around box and appends the planes of its faces. Returns false if box is
+	// not finite.
+	bool set(const bounding_box &box, vector<plane_3> &planes);
+
+	// Which side of plane h, taken to face the other way if flipped, all of region lies
+	// on: +1 in front, -1 behind, or 0 if it reaches h. Exact.
+	int side(const plane_3 &h, const bool flipped, const size_t region) const;
+
+	// Whether the face's node takes its plane turned over, so that its region is in front.
+	static inline bool face_flipped(const size_t face) { return (0 == face % 2); }
+
+	static const size_t inside = 6;
+
+	float min[3];
+	float max[3];
+	uint32_t first_plane; // Face k's plane is first_plane + k
+};
+
+bool box_regions::set(const bounding_box &box, vector<plane_3> &planes)
+{
+	if(true == box.empty)
+		return false;
+
+	double extent = 0.0;
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		if(false == (box.max[k] - box.min[k] < HUGE_VAL))
+			return false;
+
+		if(box.max[k] - box.min[k] > extent)
+			extent = box.max[k] - box.min[k];
+	}
+
+	// Clear of the operand's polygons, so that none of them reaches a face.
+	const double margin = 1e-3*extent;
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		min[k] = static_cast<float>(box.min[k] - margin);
+		max[k] = static_cast<float>(box.max[k] + margin);
+
+		while(false == (min[k] < box.min[k]))
+			min[k] = nextafterf(min[k], -HUGE_VALF);
+
+		while(false == (max[k] > box.max[k]))
+			max[k] = nextafterf(max[k], HUGE_VALF);
+
+		if(false == (max[k] - min[k] < HUGE_VALF))
+			return false;
+	}
+
+	first_plane = static_cast<uint32_t>(planes.size());
+
+	for(size_t face = 0; face < 6; face++)
+		planes.push_back(axis_plane(face/2, (0 == face % 2) ? min[face/2] : max[face/2]));
+
+	return true;
+}
+
+int box_regions::side(const plane_3 &h, const bool flipped, const size_t region) const
+{
+	const size_t axis = region/2;
+	float values[3][2];
+	size_t counts[3];
+	int open_side = 0; // The side the region runs off to along axis, if h is not along it
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		if(k < axis)
+		{
+			values[k][0] = min[k];
+			values[k][1] = max[k];
+			counts[k] = 2;
+			continue;
+		}
+
+		// The sign of h's normal along the axis, exactly: orient2d() of its points across it.
+		const size_t u = (k + 1) % 3, v = (k + 2) % 3;
+		const double a[2] = { coordinate(h.points[0], u), coordinate(h.points[0], v) };
+		const double b[2] = { coordinate(h.points[1], u), coordinate(h.points[1], v) };
+		const double c[2] = { coordinate(h.points[2], u), coordinate(h.points[2], v) };
+		const int normal_sign = (true == flipped) ? -orient2d(a, b, c) : orient2d(a, b, c);
+
+		counts[k] = 1;
+
+		if(k > axis)
+		{
+			// Open both ways, the region is on one side only if h runs along the axis, and
+			// then any coordinate will do.
+			if(0 != normal_sign)
+				return 0;
+
+			values[k][0] = 0.0f;
+		}
+		else
+		{
+			values[k][0] = (0 == region % 2) ? min[k] : max[k];
+			open_side = (0 == region % 2) ? -normal_sign : normal_sign;
+		}
+	}
+
+	int sign = 0;
+
+	for(size_t i = 0; i < counts[0]; i++)
+	{
+		for(size_t j = 0; j < counts[1]; j++)
+		{
+			for(size_t k = 0; k < counts[2]; k++)
+			{
+				int s = orient3d(h.points[0], h.points[1], h.points[2], vertex_3(values[0][i], values[1][j], values[2][k]));
+
+				if(true == flipped)
+					s = -s;
+
+				if(0 == s || (0 != sign && s != sign))
+					return 0;
+
+				sign = s;
+			}
+		}
+	}
+
+	return (0 == open_side || open_side == sign) ? sign : 0;
+}
+
+// The polygons of one of a boolean's operands, sorted into the regions around the other's
+// box: each polygon lies in one region, in the box, or is split across faces. Pieces are
+// numbered with the result's planes.
+class polygon_regions
+{
+public:
+	static const uint8_t split = 0xFF;
+
+	vector<uint8_t> region;       // Per polygon: its region (box_regions::inside for the box), or split
+	vector<uint32_t> first_piece; // Per split polygon: its first piece in outside_pieces
+	bsp_polygon_pool outside_pieces; // Of split polygons, in the order of the polygons
+	vector<uint8_t> piece_region;
+	vector<uint32_t> piece_polygon;
+	bsp_polygon_pool inside;      // The polygons and pieces in the box
+	size_t region_counts[6];      // Polygons and pieces in each region
+};
+
+// Sorts the polygons of source as the chain of face nodes would: at each face, what is in
+// front goes to its region, what is behind goes on, and a polygon that spans the face is
+// split. Only polygons near a face need the exact test. source's planes are planes from
+// plane_offset on.
+static void sort_into_regions(const vector<plane_3> &planes, const bsp_polygon_pool &source, const uint32_t plane_offset, const box_regions &regions, polygon_regions &sorted)
+{
+	sorted.region.assign(source.polygons.size(), 0);
+	sorted.first_piece.assign(source.polygons.size(), bsp_tree::none);
+	sorted.outside_pieces.clear();
+	sorted.piece_region.clear();
+	sorted.piece_polygon.clear();
+	sorted.inside.clear();
+
+	for(size_t k = 0; k < 6; k++)
+		sorted.region_counts[k] = 0;
+
+	bsp_polygon_pool work;
+	split_scratch scratch;
+	vector< pair<uint32_t, uint8_t> > pieces;
+
+	for(size_t i = 0; i < source.polygons.size(); i++)
+	{
+		work.clear();
+		pieces.clear();
+
+		uint32_t current = work.add(source, static_cast<uint32_t>(i), plane_offset, false);
+
+		for(size_t face = 0; face < 6 && bsp_tree::none != current; face++)
+		{
+			const size_t axis = face/2;
+			const bool low = box_regions::face_flipped(face);
+			const double c = (true == low) ? regions.min[axis] : regions.max[axis];
+			const bounding_box box = polygon_box(work, current);
+
+			if((true == low) ? (box.max[axis] < c) : (box.min[axis] > c))
+			{
+				pieces.push_back(make_pair(current, static_cast<uint8_t>(face)));
+				current = bsp_tree::none;
+				continue;
+			}
+
+			if((true == low) ? (box.min[axis] > c) : (box.max[axis] < c))
+				continue;
+
+			uint32_t front = bsp_tree::none, back = bsp_tree::none;
+
+			switch(split_polygon(planes, work, current, regions.first_plane + static_cast<uint32_t>(face), low, front, back, scratch))
+			{
+			case POLYGON_BACK:
+				break;
+			case POLYGON_SPANNING:
+				pieces.push_back(make_pair(front, static_cast<uint8_t>(face)));
+				current = back;
+				break;
+			default:
+				pieces.push_back(make_pair(current, static_cast<uint8_t>(face)));
+				current = bsp_tree::none;
+				break;
+			}
+		}
+
+		if(bsp_tree::none != current)
+			pieces.push_back(make_pair(current, static_cast<uint8_t>(box_regions::inside)));
+
+		if(1 == pieces.size())
+			sorted.region[i] = pieces[0].second;
+		else
+		{
+			sorted.region[i] = polygon_regions::split;
+			sorted.first_piece[i] = static_cast<uint32_t>(sorted.outside_pieces.polygons.size());
+		}
+
+		for(size_t j = 0; j < pieces.size(); j++)
+		{
+			if(box_regions::inside == pieces[j].second)
+			{
+				sorted.inside.add(work, pieces[j].first, 0, false);
+				continue;
+			}
+
+			sorted.region_counts[pieces[j].second]++;
+
+			if(pieces.size() > 1)
+			{
+				sorted.outside_pieces.add(work, pieces[j].first, 0, false);
+				sorted.piece_region.push_back(pieces[j].second);
+				sorted.piece_polygon.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	}
+}
+
+// Copies the part of tree that lies in a region into nodes and pool, as the child of
+// parent on the given side. A node whose plane has the whole region on one side is passed
+// over for that side's child, and each node copied keeps only its polygons and pieces in
+// the region, so only the nodes that the region reaches are copied, and no polygon is
+// clipped or split again. tree's planes are the result's from plane_offset on.
+static void copy_region(const bsp_tree &tree, const uint32_t plane_offset, const box_regions &regions, const size_t region, const polygon_regions &sorted, const uint32_t parent, const bool front, vector<bsp_node> &nodes, bsp_polygon_pool &pool)
+{
+	const uint32_t none = bsp_tree::none;
+
+	class visit
+	{
+	public:
+		uint32_t node;
+		uint32_t parent;
+		bool front;
+	};
+
+	vector<visit> stack(1);
+	stack[0].node = 0;
+	stack[0].parent = parent;
+	stack[0].front = front;
+
+	while(false == stack.empty())
+	{
+		const visit v = stack.back();
+		stack.pop_back();
+
+		uint32_t index = v.node;
+		int side = 0;
+
+		for(;;)
+		{
+			const bsp_node &n = tree.nodes[index];
+			side = regions.side(tree.planes[n.plane], n.flipped, region);
+
+			const uint32_t child = (side > 0) ? n.front : n.back;
+
+			if(0 == side || none == child)
+				break;
+
+			index = child;
+		}
+
+		const bsp_node &old_node = tree.nodes[index];
+		bsp_node node = old_node;
+		node.plane += plane_offset;
+		node.front = node.back = node.polygons = none;
+
+		if(0 != side)
+		{
+			// The region is all outside (in front) or all inside. A front child of none is
+			// the one and a back child of none the other, so where the slot is the wrong one
+			// for it, a node with the region on the right side stands in.
+			if((side > 0) != v.front)
+			{
+				nodes.push_back(node);
+				link_child(nodes, v.parent, v.front, static_cast<uint32_t>(nodes.size() - 1));
+			}
+
+			continue;
+		}
+
+		uint32_t last = none;
+
+		for(uint32_t p = old_node.polygons; none != p; p = tree.pool.polygons[p].next)
+		{
+			uint32_t first = p, count = 1;
+			const bsp_polygon_pool *from = &tree.pool;
+
+			if(polygon_regions::split == sorted.region[p])
+			{
+				from = &sorted.outside_pieces;
+				first = sorted.first_piece[p];
+
+				for(count = 0; first + count < sorted.piece_polygon.size() && p == sorted.piece_polygon[first + count]; count++);
+			}
+			else if(region != sorted.region[p])
+			{
+				continue;
+			}
+
+			for(uint32_t j = first; j < first + count; j++)
+			{
+				if(from == &sorted.outside_pieces && region != sorted.piece_region[j])
+					continue;
+
+				const uint32_t added = pool.add(*from, j, (from == &tree.pool) ? plane_offset : 0, false);
+
+				if(none == last)
+					node.polygons = added;
+				else
+					pool.polygons[last].next = added;
+
+				last = added;
+			}
+		}
+
+		const uint32_t node_index = static_cast<uint32_t>(nodes.size());
+		nodes.push_back(node);
+		link_child(nodes, v.parent, v.front, node_index);
+
+		visit child;
+		child.parent = node_index;
+
+		if(none != old_node.back)
+		{
+			child.node = old_node.back;
+			child.front = false;
+			stack.push_back(child);
+		}
+
+		if(none != old_node.front)
+		{
+			child.node = old_node.front;
+			child.front = true;
+			stack.push_back(child);
+		}
+	}
+}
+
+// Appends the chain of face nodes around regions' box, as the child of parent on the given
+// side, each with a copy of tree for its region in front. Returns the last face node, whose
+// back is the box.
+static uint32_t hang_regions(const bsp_tree &tree, const uint32_t plane_offset, const box_regions &regions, const polygon_regions &sorted, const uint32_t parent, const bool front, vector<bsp_node> &nodes, bsp_polygon_pool &pool)
+{
+	const uint32_t first = static_cast<uint32_t>(nodes.size());
+
+	for(size_t face = 0; face < 6; face++)
+	{
+		bsp_node node;
+		node.plane = regions.first_plane + static_cast<uint32_t>(face);
+		node.flipped = box_regions::face_flipped(face);
+		node.front = bsp_tree::none;
+		node.back = (face < 5) ? first + static_cast<uint32_t>(face + 1) : bsp_tree::none;
+		node.polygons = bsp_tree::none;
+		nodes.push_back(node);
+	}
+
+	link_child(nodes, parent, front, first);
+
+	for(size_t face = 0; face < 6; face++)
+		if(sorted.region_counts[face] > 0)
+			copy_region(tree, plane_offset, regions, face, sorted, first + static_cast<uint32_t>(face), true, nodes, pool);
+
+	return first + 5;
+}
+
+// Adds the polygons and pieces sorted outside the box to count; returns whether there are any.
+static bool add_reused(const polygon_regions &sorted, size_t &count)
+{
+	size_t reused = 0;
+
+	for(size_t k = 0; k < 6; k++)
+		reused += sorted.region_counts[k];
+
+	count += reused;
+
+	return (reused > 0);
+}
+
+// Whether p is inside the solid of tree; a point on a node's plane goes to its front.
+static bool point_inside(const bsp_tree &tree, const vertex_3 &p)
+{
+	uint32_t index = 0;
+
+	for(;;)
+	{
+		const bsp_node &node = tree.nodes[index];
+		const plane_3 &h = tree.planes[node.plane];
+		int sign = orient3d(h.points[0], h.points[1], h.points[2], p);
+
+		if(true == node.flipped)
+			sign = -sign;
+
+		const uint32_t child = (sign >= 0) ? node.front : node.back;
+
+		if(bsp_tree::none == child)
+			return (sign < 0);
+
+		index = child;
+	}
+}
+
+bool bsp_boolean::compute(const bsp_tree &a, const bsp_tree &b, const boolean_operation operation, bsp_tree &result, const size_t num_threads)
+{
+	clipped_polygon_count = reused_polygon_count = result_polygon_count = 0;
+	clip_time = build_time = 0.0;
+
+	if(true == a.empty() || true == b.empty())
+		return false;
+
+	const size_t thread_count = (0 == num_threads) ? 1 : num_threads;
+
+	// Both trees' planes, b's after a's; result may be a or b, so it is only written at the end.
+	bsp_tree out;
+	out.planes.reserve(a.planes.size() + b.planes.size() + 12);
+	out.planes.insert(out.planes.end(), a.planes.begin(), a.planes.end());
+	out.planes.insert(out.planes.end(), b.planes.begin(), b.planes.end());
+
+	const uint32_t offset_b = static_cast<uint32_t>(a.planes.size());
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	vector<bounding_box> boxes_a, boxes_b;
+	subtree_boxes(a, boxes_a);
+	subtree_boxes(b, boxes_b);
+
+	// A union or a difference is a itself away from b. Around a box just larger than b's,
+	// a's polygons are taken over as they are, in copies of the parts of a's tree that
+	// reach them. A union is likewise b itself away from a, so within b's box the same is
+	// done for b around a's box. Only what is inside both boxes is clipped and built afresh.
+	box_regions regions_a, regions_b; // Around a's box and around b's
+	polygon_regions sorted_a, sorted_b;
+	bool reuse_a = (BOOLEAN_INTERSECTION != operation && true == regions_b.set(boxes_b[0], out.planes));
+	bool reuse_b = (BOOLEAN_UNION == operation && true == regions_a.set(boxes_a[0], out.planes));
+
+	if(true == reuse_a)
+	{
+		sort_into_regions(out.planes, a.pool, 0, regions_b, sorted_a);
+		reuse_a = add_reused(sorted_a, reused_polygon_count);
+	}
+
+	if(true == reuse_b)
+	{
+		sort_into_regions(out.planes, b.pool, offset_b, regions_a, sorted_b);
+		reuse_b = add_reused(sorted_b, reused_polygon_count);
+	}
+
+	const bsp_polygon_pool &clipped_a = (true == reuse_a) ? sorted_a.inside : a.pool;
+	const bsp_polygon_pool &source_b = (true == reuse_b) ? sorted_b.inside : b.pool;
+	const uint32_t source_b_offset = (true == reuse_b) ? 0 : offset_b;
+
+	// As in CSG by clipping (~ is turning inside out, clip(P, T) the pieces of P outside T):
+	//
+	//   A u B = clip(A, B) + ~clip(~clip(B, A), A)
+	//   A n B = ~clip(~A, ~B) + ~clip(~clip(B, ~A), ~A)
+	//   A - B = ~clip(~A, B) + clip(~clip(B, ~A), ~A)
+	//
+	// Where faces of A and B coincide, the second clip of B's pieces against A drops B's
+	// copy, so each such face comes out once, or not at all where the two face each other.
+	const bool invert_a = (BOOLEAN_UNION != operation);
+	const bool invert_b = (BOOLEAN_INTERSECTION == operation);
+	bsp_polygon_pool kept_a, clipped_b, kept_b;
+
+	clip_polygons(clip_job(out.planes, clipped_a, 0, invert_a, b, boxes_b, offset_b, invert_b), kept_a, thread_count);
+	clip_polygons(clip_job(out.planes, source_b, source_b_offset, false, a, boxes_a, 0, invert_a), clipped_b, thread_count);
+	clip_polygons(clip_job(out.planes, clipped_b, 0, true, a, boxes_a, 0, invert_a), kept_b, thread_count);
+
+	clipped_polygon_count = clipped_a.polygons.size() + source_b.polygons.size() + clipped_b.polygons.size();
+
+	if(true == invert_a)
+		turn_over(kept_a);
+
+	if(BOOLEAN_DIFFERENCE != operation)
+		turn_over(kept_b);
+
+	clip_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+
+	bsp_polygon_pool built;
+	built.append(kept_a);
+	built.append(kept_b);
+	join_pool_fragments(out.planes, built);
+
+	if(false == reuse_a && false == reuse_b)
+	{
+		out.pool.polygons.swap(built.polygons);
+		out.pool.sides.swap(built.sides);
+		out.build_nodes(thread_count);
+	}
+	else
+	{
+		// The chains of face nodes, b's box inside a's regions and a's inside b's.
+		uint32_t parent = bsp_tree::none;
+
+		if(true == reuse_a)
+			parent = hang_regions(a, 0, regions_b, sorted_a, parent, false, out.nodes, out.pool);
+
+		if(true == reuse_b)
+			parent = hang_regions(b, offset_b, regions_a, sorted_b, parent, false, out.nodes, out.pool);
+
+		// The innermost box, behind the last face, from what was clipped. With nothing
+		// there, it is all one thing, which its middle tells.
+		vector<bsp_node> box_nodes;
+		build_over(out.planes, built, box_nodes, thread_count);
+
+		if(false == box_nodes.empty())
+		{
+			hang_subtree(out.nodes, out.pool, box_nodes, built, parent, false);
+		}
+		else
+		{
+			float low[3], high[3];
+			bool empty = false;
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				low[k] = (true == reuse_a) ? regions_b.min[k] : -HUGE_VALF;
+				high[k] = (true == reuse_a) ? regions_b.max[k] : HUGE_VALF;
+
+				if(true == reuse_b && regions_a.min[k] > low[k])
+					low[k] = regions_a.min[k];
+
+				if(true == reuse_b && regions_a.max[k] < high[k])
+					high[k] = regions_a.max[k];
+
+				empty = empty || false == (low[k] < high[k]);
+			}
+
+			const vertex_3 middle(0.5f*low[0] + 0.5f*high[0], 0.5f*low[1] + 0.5f*high[1], 0.5f*low[2] + 0.5f*high[2]);
+
+			const bool in_a = (false == empty && true == point_inside(a, middle));
+			const bool in_b = (false == empty && true == point_inside(b, middle));
+
+			if(false == empty && false == ((BOOLEAN_UNION == operation) ? (in_a || in_b) : (in_a && false == in_b)))
+			{
+				// All outside: a node with the box in front of it.
+				bsp_node node = out.nodes[parent];
+				node.flipped = !node.flipped;
+				node.front = node.back = bsp_tree::none;
+				out.nodes.push_back(node);
+				out.nodes[parent].back = static_cast<uint32_t>(out.nodes.size() - 1);
+			}
+		}
+
+		compact(out);
+	}
+
+	result_polygon_count = out.pool.polygons.size();
+
+	result.planes.swap(out.planes);
+	result.nodes.swap(out.nodes);
+	result.pool.polygons.swap(out.pool.polygons);
+	result.pool.sides.swap(out.pool.sides);
+
+	build_time = seconds_since(start);
+
+	return true;
+}
@@ -0,0 +1,140 @@
+#ifndef BSP_TREE_H
+#define BSP_TREE_H
+
+#include "exact_predicates.h"
+#include "mesh_boolean.h"
+#include "../common/mesh.h"
+
+#include <vector>
+using std::vector;
+
+#include <stdint.h>
+
+
+// One corner of a polygon, and the edge that leaves it.
+class bsp_side
+{
+public:
+	double position[3]; // Where the corner is, rounded
+	double error;       // A bound on how far each coordinate of position is from the exact one
+	uint32_t plane;     // The plane that the edge from this corner to the next lies in
+};
+
+// A convex polygon in plane-based form: its support plane and, for each edge, a plane that
+// the edge lies in. Corner i is where the support, side i - 1's plane and side i's plane
+// meet, so splitting a polygon never moves a corner that was already there, and a new
+// corner is exact for as long as the planes are.
+class bsp_polygon
+{
+public:
+	uint32_t support;
+	uint32_t first_side; // Into the sides of the pool that holds the polygon
+	uint32_t side_count;
+	uint32_t next;       // The next polygon in the same node, or bsp_tree::none
+	bool flipped;        // Faces against its support plane's normal
+};
+
+class bsp_polygon_pool
+{
+public:
+	void clear(void);
+
+	// Appends a copy of polygon i of from, with its plane indices moved by plane_offset and
+	// turned over if flip is set. Returns its index.
+	uint32_t add(const bsp_polygon_pool &from, const uint32_t i, const uint32_t plane_offset, const bool flip);
+
+	// Appends all of from's polygons.
+	void append(const bsp_polygon_pool &from);
+
+	vector<bsp_polygon> polygons;
+	vector<bsp_side> sides;
+};
+
+// The region in front of a node (on the side its plane's normal points to, or the other
+// side if flipped) is outside the solid, and behind it inside, unless a child divides the
+// region further.
+class bsp_node
+{
+public:
+	uint32_t plane;
+	bool flipped;
+	uint32_t front;    // Child node, or bsp_tree::none for a region that is all outside
+	uint32_t back;     // ... or bsp_tree::none for a region that is all inside
+	uint32_t polygons; // The first polygon lying in the plane, or bsp_tree::none
+};
+
+// See: Merging BSP Trees Yields Polyhedral Set Operations by B. Naylor, J. Amanatides and W. Thibault
+// See: Fast, Exact, Linear Booleans by G. Bernstein and D. Fussell
+//
+// A closed mesh as a binary space partitioning tree whose nodes are the planes of its
+// triangles, and, where those would only make a long chain (as on a convex patch), planes
+// across the axes that hold no polygon. Each triangle starts out as a polygon bounded by
+// its neighbours' planes, and polygons are only ever split by planes, never rounded, so a
+// tree that went through any number of booleans is as exact as one built from a mesh.
+//
+// The plane of each node is picked by a cost like the surface area heuristic of ray
+// tracing: of a few candidate planes and a cut across the middle, the one that minimises
+// the number of polygons on each side times the area of their box, measured on a sample of
+// the polygons. The top of the tree is built breadth first until there are a few dozen
+// subtrees per thread, which the threads then build one at a time, each into its own
+// pool. The tree comes out the same whatever the number of threads.
+class bsp_tree
+{
+public:
+	// Returns false if the mesh has no triangle with area.
+	bool build(const indexed_mesh &mesh, const size_t num_threads = 1);
+
+	// Builds the tree over the polygons already in pool, whose planes are in planes.
+	void build_nodes(const size_t num_threads = 1);
+
+	void clear(void);
+	bool empty(void) const { return nodes.empty(); }
+	size_t memory_usage(void) const;
+
+	// Rounds the corners to float, welds them exactly, joins the fragments that each face
+	// was cut into back into convex polygons where they share whole edges, and triangulates
+	// each polygon. A polygon's edge often has corners of the polygons across it along its
+	// length, which are then added to its triangles so that every edge is shared. Returns
+	// the number of edges still without a partner, which is zero when the tree is closed.
+	size_t to_mesh(indexed_mesh &mesh, const size_t num_threads = 1) const;
+
+	static const uint32_t none = 0xFFFFFFFF;
+
+	vector<plane_3> planes;
+	vector<bsp_node> nodes; // nodes[0] is the root
+	bsp_polygon_pool pool;  // The polygons of every node
+};
+
+// Union, intersection and difference of two trees, as in CSG by clipping: the polygons of
+// each tree are pushed down the other (or the other turned inside out), and the pieces
+// that end up in the region the operation keeps form the result. Neither operand is
+// changed, so a tree built once (e.g. of a bone) can go into any number of booleans, and a
+// result can go into the next.
+//
+// Only polygons near the other solid's surface are split: a piece clear of the box of
+// everything under a node is settled by one of its corners. A union or difference is a
+// itself away from b, so a's polygons outside a box around b are not clipped at all; the
+// result tree keeps them in copies of the parts of a's tree that reach them. A union is
+// likewise b away from a, so within b's box the same is done for b around a's box. Only
+// what is inside both boxes is built afresh, as in bsp_tree::build_nodes(). Polygons are
+// clipped in parallel, a range of them at a time, and the result keeps only the planes it
+// uses.
+class bsp_boolean
+{
+public:
+	bsp_boolean(void);
+
+	bool compute(const bsp_tree &a, const bsp_tree &b, const boolean_operation operation, bsp_tree &result, const size_t num_threads = 1);
+
+	// Counts from the last compute().
+	size_t clipped_polygon_count; // Polygons pushed down a tree
+	size_t reused_polygon_count;  // Polygons outside the other operand's box, taken over unclipped
+	size_t result_polygon_count;
+
+	// Seconds spent in each phase of the last compute().
+	double clip_time;
+	double build_time;
+};
+
+
+#endif
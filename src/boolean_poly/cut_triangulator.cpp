@@ -0,0 +1,823 @@
+#include "cut_triangulator.h"
+#include "exact_predicates.h"
+
+#include <algorithm>
+using std::sort;
+using std::swap;
+using std::binary_search;
+
+#include <cmath>
+
+#include <utility>
+using std::pair;
+using std::make_pair;
+
+
+bool cut_triangulator::triangulate(const vertex_3 corners[3], const mesh_index corner_ids[3], const bool collinear_corners, const vector<cut_point> &points, const vector<size_t> &segments, vector<indexed_triangle> &triangles, vector<uint8_t> &cut_edges)
+{
+	if(true == collinear_corners)
+		return triangulate_sliver(corners, points, segments, triangles, cut_edges, corner_ids);
+
+	const bool recovered = triangulate_plane(corners, points, segments);
+
+	for(size_t i = 0; i < local_triangles.size(); i++)
+	{
+		const local_triangle &lt = local_triangles[i];
+		indexed_triangle t;
+		uint8_t mask = 0;
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			const int v = lt.v[k];
+			t.vertex_indices[k] = (v < 3) ? corner_ids[v] : points[v - 3].id;
+
+			if(true == lt.constrained[k])
+				mask |= static_cast<uint8_t>(1 << k);
+		}
+
+		triangles.push_back(t);
+		cut_edges.push_back(mask);
+	}
+
+	return recovered;
+}
+
+// Orders local vertices along one axis.
+class axis_order
+{
+public:
+	axis_order(const vector<implicit_point> &src_points, const size_t src_axis, const bool src_descending) : points(src_points), axis(src_axis), descending(src_descending) { /* custom constructor */ }
+
+	inline bool operator()(const int left, const int right) const
+	{
+		const int c = compare(points[left], points[right], axis);
+
+		return (true == descending) ? c > 0 : c < 0;
+	}
+
+	const vector<implicit_point> &points;
+	size_t axis;
+	bool descending;
+};
+
+bool cut_triangulator::triangulate_plane(const vertex_3 corners[3], const vector<cut_point> &points, const vector<size_t> &segments)
+{
+	const size_t num_vertices = 3 + points.size();
+
+	local_points.resize(num_vertices);
+	vertex_triangles.assign(num_vertices, -1);
+	local_triangles.clear();
+
+	for(size_t i = 0; i < 3; i++)
+		local_points[i].set(corners[i]);
+
+	for(size_t i = 0; i < points.size(); i++)
+		local_points[3 + i] = points[i].point;
+
+	const double *c[3] = { local_points[0].position, local_points[1].position, local_points[2].position };
+	double e1[3], e2[3];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		e1[i] = c[1][i] - c[0][i];
+		e2[i] = c[2][i] - c[0][i];
+	}
+
+	const double normal[3] = { e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0] };
+
+	// Drop the axis the normal is closest to, keeping the other two in cyclic order,
+	// swapped if need be so that the corners turn counter-clockwise.
+	size_t axis = 0;
+
+	if(fabs(normal[1]) > fabs(normal[axis]))
+		axis = 1;
+
+	if(fabs(normal[2]) > fabs(normal[axis]))
+		axis = 2;
+
+	u = (axis + 1) % 3;
+	v = (axis + 2) % 3;
+
+	if(normal[axis] < 0.0)
+		swap(u, v);
+
+	for(size_t i = 0; i < 3; i++)
+		vertex_triangles[i] = 0;
+
+	add_triangle(0, 1, 2);
+
+	// Points on the edges, in order from corner k towards corner k + 1.
+	for(int k = 0; k < 3; k++)
+	{
+		const int next = (k + 1) % 3;
+		const size_t along = (fabs(c[next][u] - c[k][u]) >= fabs(c[next][v] - c[k][v])) ? u : v;
+
+		vector<int> on_edge;
+
+		for(size_t i = 0; i < points.size(); i++)
+			if(k == points[i].edge)
+				on_edge.push_back(static_cast<int>(3 + i));
+
+		sort(on_edge.begin(), on_edge.end(), axis_order(local_points, along, c[next][along] < c[k][along]));
+
+		int previous = k;
+
+		for(size_t i = 0; i < on_edge.size(); i++)
+		{
+			int tri = -1, edge = -1;
+			find_edge(previous, next, tri, edge);
+			split_edge(tri, edge, on_edge[i]);
+			previous = on_edge[i];
+		}
+	}
+
+	// Points inside. One may land on an edge between two others, if they are all cut by one plane.
+	int last = 0;
+
+	for(size_t i = 0; i < points.size(); i++)
+	{
+		if(-1 != points[i].edge)
+			continue;
+
+		const int p = static_cast<int>(3 + i);
+		const int t = locate(p, last);
+		const local_triangle &lt = local_triangles[t];
+		int on_edge = -1;
+
+		for(int k = 0; k < 3; k++)
+			if(0 == orient(lt.v[k], lt.v[(k + 1) % 3], p))
+				on_edge = (-1 == on_edge) ? k : 3;
+
+		if(-1 == on_edge || 3 == on_edge)
+			split_triangle(t, p);
+		else
+			split_edge(t, on_edge, p);
+
+		last = vertex_triangles[p];
+	}
+
+	bool recovered = true;
+
+	for(size_t i = 0; i + 1 < segments.size(); i += 2)
+		if(false == recover_segment(static_cast<int>(3 + segments[i]), static_cast<int>(3 + segments[i + 1]), 0))
+			recovered = false;
+
+	return recovered;
+}
+
+bool cut_triangulator::triangulate_sliver(const vertex_3 corners[3], const vector<cut_point> &points, const vector<size_t> &segments, vector<indexed_triangle> &triangles, vector<uint8_t> &cut_edges, const mesh_index corner_ids[3])
+{
+	local_points.resize(3 + points.size());
+
+	for(size_t i = 0; i < 3; i++)
+		local_points[i].set(corners[i]);
+
+	for(size_t i = 0; i < points.size(); i++)
+		local_points[3 + i] = points[i].point;
+
+	// The long edge runs from corner k to corner k + 1; the third corner lies between them.
+	int k = 0;
+	double longest = -1.0;
+
+	for(int i = 0; i < 3; i++)
+	{
+		const double *a = local_points[i].position, *b = local_points[(i + 1) % 3].position;
+		const double length_sq = (b[0] - a[0])*(b[0] - a[0]) + (b[1] - a[1])*(b[1] - a[1]) + (b[2] - a[2])*(b[2] - a[2]);
+
+		if(length_sq > longest)
+		{
+			longest = length_sq;
+			k = i;
+		}
+	}
+
+	const int start = k, end = (k + 1) % 3, middle = (k + 2) % 3;
+	const double *s = local_points[start].position, *e = local_points[end].position;
+
+	size_t along = 0;
+
+	for(size_t i = 1; i < 3; i++)
+		if(fabs(e[i] - s[i]) > fabs(e[along] - s[along]))
+			along = i;
+
+	const axis_order order(local_points, along, e[along] < s[along]);
+
+	// Both sides of the sliver as chains from start to end, in order along the line:
+	// the long edge, and the two short edges by way of the middle corner.
+	vector<int> long_side, short_side(1, middle);
+
+	for(size_t i = 0; i < points.size(); i++)
+	{
+		if(start == points[i].edge)
+			long_side.push_back(static_cast<int>(3 + i));
+		else if(-1 != points[i].edge)
+			short_side.push_back(static_cast<int>(3 + i));
+	}
+
+	sort(long_side.begin(), long_side.end(), order);
+	sort(short_side.begin(), short_side.end(), order);
+	long_side.insert(long_side.begin(), start);
+	short_side.insert(short_side.begin(), start);
+	long_side.push_back(end);
+	short_side.push_back(end);
+
+	vector<int> long_positions(3 + points.size(), -1), short_positions(3 + points.size(), -1);
+
+	for(size_t i = 1; i + 1 < long_side.size(); i++)
+		long_positions[long_side[i]] = static_cast<int>(i);
+
+	for(size_t i = 1; i + 1 < short_side.size(); i++)
+		short_positions[short_side[i]] = static_cast<int>(i);
+
+	// Each segment is a rung across the sliver. They cannot cross, so sorted along the
+	// long side they must also be in order along the short side.
+	bool recovered = true;
+	vector< pair<int, int> > rungs;
+	vector< pair<int, int> > rung_edges;
+
+	for(size_t i = 0; i + 1 < segments.size(); i += 2)
+	{
+		int a = static_cast<int>(3 + segments[i]), b = static_cast<int>(3 + segments[i + 1]);
+
+		if(-1 == long_positions[a])
+			swap(a, b);
+
+		if(-1 == long_positions[a] || -1 == short_positions[b])
+		{
+			recovered = false;
+			continue;
+		}
+
+		rungs.push_back(make_pair(long_positions[a], short_positions[b]));
+		rung_edges.push_back((a < b) ? make_pair(a, b) : make_pair(b, a));
+	}
+
+	sort(rungs.begin(), rungs.end());
+	sort(rung_edges.begin(), rung_edges.end());
+
+	vector< pair<int, int> > stops(1, make_pair(0, 0));
+
+	for(size_t i = 0; i < rungs.size(); i++)
+	{
+		if(rungs[i].first <= stops.back().first || rungs[i].second <= stops.back().second)
+		{
+			recovered = false;
+			continue;
+		}
+
+		stops.push_back(rungs[i]);
+	}
+
+	stops.push_back(make_pair(static_cast<int>(long_side.size() - 1), static_cast<int>(short_side.size() - 1)));
+
+	// Zip between each pair of rungs. Going around the original triangle, the long side is
+	// walked forwards and the short side backwards, which fixes each sub-triangle's winding.
+	for(size_t r = 0; r + 1 < stops.size(); r++)
+	{
+		int i = stops[r].first, j = stops[r].second;
+
+		while(i < stops[r + 1].first || j < stops[r + 1].second)
+		{
+			int w[3];
+
+			if(j == stops[r + 1].second || (i < stops[r + 1].first && false == order(short_side[j + 1], long_side[i + 1])))
+			{
+				w[0] = long_side[i];
+				w[1] = long_side[i + 1];
+				w[2] = short_side[j];
+				i++;
+			}
+			else
+			{
+				w[0] = short_side[j + 1];
+				w[1] = short_side[j];
+				w[2] = long_side[i];
+				j++;
+			}
+
+			// Where the two sides meet at a corner, the first step has nothing to close.
+			if(w[0] == w[1] || w[1] == w[2] || w[2] == w[0])
+				continue;
+
+			indexed_triangle t;
+			uint8_t mask = 0;
+
+			for(size_t m = 0; m < 3; m++)
+			{
+				t.vertex_indices[m] = (w[m] < 3) ? corner_ids[w[m]] : points[w[m] - 3].id;
+
+				const int a = w[m], b = w[(m + 1) % 3];
+				const pair<int, int> edge = (a < b) ? make_pair(a, b) : make_pair(b, a);
+
+				if(true == binary_search(rung_edges.begin(), rung_edges.end(), edge))
+					mask |= static_cast<uint8_t>(1 << m);
+			}
+
+			triangles.push_back(t);
+			cut_edges.push_back(mask);
+		}
+	}
+
+	return recovered;
+}
+
+int cut_triangulator::orient(const int a, const int b, const int c) const
+{
+	return orient2d(local_points[a], local_points[b], local_points[c], u, v);
+}
+
+// Whether r, which lies on the line through a and b, is on b's side of a.
+bool cut_triangulator::ahead(const int a, const int b, const int r) const
+{
+	size_t axis = u;
+	int direction = compare(local_points[b], local_points[a], u);
+
+	if(0 == direction)
+	{
+		axis = v;
+		direction = compare(local_points[b], local_points[a], v);
+	}
+
+	return direction == compare(local_points[r], local_points[a], axis);
+}
+
+// Renumbers the corners of triangle t so that edge k becomes edge 0.
+void cut_triangulator::rotate(const int t, const int k)
+{
+	if(0 == k)
+		return;
+
+	local_triangle &lt = local_triangles[t];
+	const local_triangle old = lt;
+
+	for(int i = 0; i < 3; i++)
+	{
+		lt.v[i] = old.v[(i + k) % 3];
+		lt.n[i] = old.n[(i + k) % 3];
+		lt.constrained[i] = old.constrained[(i + k) % 3];
+	}
+}
+
+void cut_triangulator::replace_neighbour(const int t, const int old_neighbour, const int new_neighbour)
+{
+	if(-1 == t)
+		return;
+
+	for(size_t k = 0; k < 3; k++)
+		if(old_neighbour == local_triangles[t].n[k])
+			local_triangles[t].n[k] = new_neighbour;
+}
+
+int cut_triangulator::add_triangle(const int a, const int b, const int c)
+{
+	local_triangle lt;
+
+	lt.v[0] = a;
+	lt.v[1] = b;
+	lt.v[2] = c;
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		lt.n[k] = -1;
+		lt.constrained[k] = false;
+	}
+
+	local_triangles.push_back(lt);
+
+	return static_cast<int>(local_triangles.size() - 1);
+}
+
+// (a, b, c) becomes (a, b, p), (b, c, p) and (c, a, p).
+void cut_triangulator::split_triangle(const int t, const int p)
+{
+	const local_triangle old = local_triangles[t];
+	const int a = old.v[0], b = old.v[1], c = old.v[2];
+
+	const int t1 = add_triangle(b, c, p);
+	const int t2 = add_triangle(c, a, p);
+
+	local_triangle &t0 = local_triangles[t];
+	t0.v[2] = p;
+	t0.n[1] = t1;
+	t0.n[2] = t2;
+	t0.constrained[1] = t0.constrained[2] = false;
+
+	local_triangles[t1].n[0] = old.n[1];
+	local_triangles[t1].n[1] = t2;
+	local_triangles[t1].n[2] = t;
+	local_triangles[t1].constrained[0] = old.constrained[1];
+
+	local_triangles[t2].n[0] = old.n[2];
+	local_triangles[t2].n[1] = t;
+	local_triangles[t2].n[2] = t1;
+	local_triangles[t2].constrained[0] = old.constrained[2];
+
+	replace_neighbour(old.n[1], t, t1);
+	replace_neighbour(old.n[2], t, t2);
+
+	vertex_triangles[a] = t;
+	vertex_triangles[b] = t;
+	vertex_triangles[c] = t1;
+	vertex_triangles[p] = t;
+}
+
+// Edge k of t, from a to b, gets p in its middle: (a, b, c) becomes (a, p, c) and (p, b, c),
+// and the triangle across it, (b, a, d), becomes (b, p, d) and (p, a, d).
+void cut_triangulator::split_edge(const int t, const int k, const int p)
+{
+	rotate(t, k);
+
+	const local_triangle old = local_triangles[t];
+	const int a = old.v[0], b = old.v[1], c = old.v[2];
+	const int u = old.n[0];
+
+	const int t1 = add_triangle(p, b, c);
+
+	local_triangle &t0 = local_triangles[t];
+	t0.v[1] = p;
+	t0.n[1] = t1;
+	t0.constrained[1] = false;
+
+	local_triangles[t1].n[1] = old.n[1];
+	local_triangles[t1].n[2] = t;
+	local_triangles[t1].constrained[0] = old.constrained[0];
+	local_triangles[t1].constrained[1] = old.constrained[1];
+
+	replace_neighbour(old.n[1], t, t1);
+
+	vertex_triangles[a] = t;
+	vertex_triangles[c] = t;
+	vertex_triangles[p] = t;
+	vertex_triangles[b] = t1;
+
+	if(-1 == u)
+	{
+		local_triangles[t].n[0] = -1;
+		local_triangles[t1].n[0] = -1;
+		return;
+	}
+
+	for(int j = 0; j < 3; j++)
+	{
+		if(b == local_triangles[u].v[j])
+		{
+			rotate(u, j);
+			break;
+		}
+	}
+
+	const local_triangle old_u = local_triangles[u];
+	const int d = old_u.v[2];
+
+	const int u1 = add_triangle(p, a, d);
+
+	local_triangle &u0 = local_triangles[u];
+	u0.v[1] = p;
+	u0.n[0] = t1;
+	u0.n[1] = u1;
+	u0.constrained[1] = false;
+
+	local_triangles[u1].n[0] = t;
+	local_triangles[u1].n[1] = old_u.n[1];
+	local_triangles[u1].n[2] = u;
+	local_triangles[u1].constrained[0] = old_u.constrained[0];
+	local_triangles[u1].constrained[1] = old_u.constrained[1];
+
+	replace_neighbour(old_u.n[1], u, u1);
+
+	local_triangles[t].n[0] = u1;
+	local_triangles[t1].n[0] = u;
+
+	vertex_triangles[d] = u;
+}
+
+// Edge k of t, from a to b, is replaced by the other diagonal of the two triangles
+// that share it: (a, b, c) and (b, a, d) become (c, a, d) and (d, b, c).
+void cut_triangulator::flip(const int t, const int k)
+{
+	rotate(t, k);
+
+	const int u = local_triangles[t].n[0];
+	const int b = local_triangles[t].v[1];
+
+	for(int j = 0; j < 3; j++)
+	{
+		if(b == local_triangles[u].v[j])
+		{
+			rotate(u, j);
+			break;
+		}
+	}
+
+	const local_triangle old_t = local_triangles[t];
+	const local_triangle old_u = local_triangles[u];
+	const int a = old_t.v[0], c = old_t.v[2], d = old_u.v[2];
+
+	local_triangle &nt = local_triangles[t];
+	nt.v[0] = c;
+	nt.v[1] = a;
+	nt.v[2] = d;
+	nt.n[0] = old_t.n[2];
+	nt.n[1] = old_u.n[1];
+	nt.n[2] = u;
+	nt.constrained[0] = old_t.constrained[2];
+	nt.constrained[1] = old_u.constrained[1];
+	nt.constrained[2] = false;
+
+	local_triangle &nu = local_triangles[u];
+	nu.v[0] = d;
+	nu.v[1] = b;
+	nu.v[2] = c;
+	nu.n[0] = old_u.n[2];
+	nu.n[1] = old_t.n[1];
+	nu.n[2] = t;
+	nu.constrained[0] = old_u.constrained[2];
+	nu.constrained[1] = old_t.constrained[1];
+	nu.constrained[2] = false;
+
+	replace_neighbour(old_u.n[1], u, t);
+	replace_neighbour(old_t.n[1], t, u);
+
+	vertex_triangles[a] = t;
+	vertex_triangles[c] = t;
+	vertex_triangles[d] = t;
+	vertex_triangles[b] = u;
+}
+
+// The triangles around local vertex a.
+void cut_triangulator::gather_fan(const int a, vector<int> &triangles_around) const
+{
+	triangles_around.clear();
+
+	const int first = vertex_triangles[a];
+
+	if(-1 == first)
+		return;
+
+	int t = first;
+	bool closed = false;
+
+	while(triangles_around.size() <= local_triangles.size())
+	{
+		triangles_around.push_back(t);
+
+		const local_triangle &lt = local_triangles[t];
+		const int i = (a == lt.v[0]) ? 0 : ((a == lt.v[1]) ? 1 : 2);
+
+		t = lt.n[(i + 2) % 3];
+
+		if(-1 == t)
+			break;
+
+		if(first == t)
+		{
+			closed = true;
+			break;
+		}
+	}
+
+	if(true == closed)
+		return;
+
+	// a is on the boundary: go the other way from the first triangle as well.
+	const local_triangle &lt = local_triangles[first];
+	t = lt.n[(a == lt.v[0]) ? 0 : ((a == lt.v[1]) ? 1 : 2)];
+
+	while(-1 != t && triangles_around.size() <= local_triangles.size())
+	{
+		triangles_around.push_back(t);
+
+		const local_triangle &next = local_triangles[t];
+		t = next.n[(a == next.v[0]) ? 0 : ((a == next.v[1]) ? 1 : 2)];
+	}
+}
+
+bool cut_triangulator::find_edge(const int a, const int b, int &t, int &k) const
+{
+	vector<int> triangles_around;
+	gather_fan(a, triangles_around);
+
+	for(size_t i = 0; i < triangles_around.size(); i++)
+	{
+		const local_triangle &lt = local_triangles[triangles_around[i]];
+
+		for(int j = 0; j < 3; j++)
+		{
+			const int from = lt.v[j], to = lt.v[(j + 1) % 3];
+
+			if((a == from && b == to) || (b == from && a == to))
+			{
+				t = triangles_around[i];
+				k = j;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Walks from triangle start towards local vertex p, and returns the triangle holding it.
+// Falls back on a search of every triangle, should the walk go round in circles.
+int cut_triangulator::locate(const int p, const int start) const
+{
+	int t = start;
+	const size_t limit = 4*local_triangles.size() + 16;
+
+	for(size_t step = 0; step < limit; step++)
+	{
+		const local_triangle &lt = local_triangles[t];
+		int next = -2;
+
+		for(size_t j = 0; j < 3; j++)
+		{
+			// Start from a different edge each step, so the walk cannot cycle for long.
+			const size_t k = (j + step) % 3;
+
+			if(orient(lt.v[k], lt.v[(k + 1) % 3], p) < 0)
+			{
+				next = lt.n[k];
+				break;
+			}
+		}
+
+		if(-2 == next)
+			return t;
+
+		if(-1 == next)
+			break;
+
+		t = next;
+	}
+
+	for(size_t i = 0; i < local_triangles.size(); i++)
+	{
+		const local_triangle &lt = local_triangles[i];
+
+		if(orient(lt.v[0], lt.v[1], p) >= 0 && orient(lt.v[1], lt.v[2], p) >= 0 && orient(lt.v[2], lt.v[0], p) >= 0)
+			return static_cast<int>(i);
+	}
+
+	return start;
+}
+
+// Makes the segment from local vertex a to local vertex b an edge, and marks it constrained.
+bool cut_triangulator::recover_segment(const int a, const int b, const size_t depth)
+{
+	if(a == b)
+		return true;
+
+	if(depth > 64)
+		return false;
+
+	int t = -1, k = -1;
+
+	if(false == find_edge(a, b, t, k))
+	{
+		// Find the triangle around a through which the segment leaves, then walk along it,
+		// noting each edge it crosses. A vertex right on the segment splits it in two.
+		vector<int> triangles_around;
+		gather_fan(a, triangles_around);
+
+		int current = -1, right = -1, left = -1;
+
+		for(size_t i = 0; i < triangles_around.size() && -1 == current; i++)
+		{
+			const local_triangle &lt = local_triangles[triangles_around[i]];
+			const int j = (a == lt.v[0]) ? 0 : ((a == lt.v[1]) ? 1 : 2);
+			const int r = lt.v[(j + 1) % 3], l = lt.v[(j + 2) % 3];
+
+			const int o_r = orient(a, b, r);
+			const int o_l = orient(a, b, l);
+
+			if(0 == o_r && true == ahead(a, b, r))
+				return recover_segment(a, r, depth + 1) && recover_segment(r, b, depth + 1);
+
+			if(0 == o_l && true == ahead(a, b, l))
+				return recover_segment(a, l, depth + 1) && recover_segment(l, b, depth + 1);
+
+			if(o_r < 0 && o_l > 0)
+			{
+				current = triangles_around[i];
+				right = r;
+				left = l;
+			}
+		}
+
+		if(-1 == current)
+			return false;
+
+		vector<int> queue;
+		queue.push_back(right);
+		queue.push_back(left);
+
+		for(size_t step = 0; ; step++)
+		{
+			if(step > local_triangles.size())
+				return false;
+
+			const local_triangle &lt = local_triangles[current];
+			int next = -1;
+
+			for(int j = 0; j < 3; j++)
+			{
+				const int from = lt.v[j], to = lt.v[(j + 1) % 3];
+
+				if((right == from && left == to) || (left == from && right == to))
+					next = lt.n[j];
+			}
+
+			if(-1 == next)
+				return false;
+
+			const local_triangle &nt = local_triangles[next];
+			int w = -1;
+
+			for(int j = 0; j < 3; j++)
+				if(right != nt.v[j] && left != nt.v[j])
+					w = nt.v[j];
+
+			if(b == w)
+				break;
+
+			const int o_w = orient(a, b, w);
+
+			if(0 == o_w)
+				return recover_segment(a, w, depth + 1) && recover_segment(w, b, depth + 1);
+
+			if(o_w < 0)
+				right = w;
+			else
+				left = w;
+
+			queue.push_back(right);
+			queue.push_back(left);
+			current = next;
+		}
+
+		// Flip the crossing edges away. An edge whose two triangles do not make a convex
+		// quadrilateral goes to the back of the queue, to be tried again once its
+		// neighbours have moved.
+		const size_t crossings = queue.size() / 2;
+		const size_t limit = 50*crossings*crossings + 200;
+		size_t head = 0;
+
+		for(size_t iteration = 0; head < queue.size(); iteration++)
+		{
+			if(iteration > limit)
+				return false;
+
+			const int r = queue[head++];
+			const int l = queue[head++];
+
+			int et = -1, ek = -1;
+
+			if(false == find_edge(r, l, et, ek))
+				continue;
+
+			const local_triangle &lt = local_triangles[et];
+			const int u = lt.n[ek];
+
+			if(true == lt.constrained[ek] || -1 == u)
+				return false;
+
+			const int p = lt.v[(ek + 2) % 3];
+			int q = -1;
+
+			for(int j = 0; j < 3; j++)
+				if(r != local_triangles[u].v[j] && l != local_triangles[u].v[j])
+					q = local_triangles[u].v[j];
+
+			if(orient(p, q, r)*orient(p, q, l) < 0)
+			{
+				flip(et, ek);
+
+				if(p != a && p != b && q != a && q != b && orient(a, b, p)*orient(a, b, q) < 0)
+				{
+					queue.push_back(p);
+					queue.push_back(q);
+				}
+			}
+			else
+			{
+				queue.push_back(r);
+				queue.push_back(l);
+			}
+		}
+
+		if(false == find_edge(a, b, t, k))
+			return false;
+	}
+
+	local_triangle &lt = local_triangles[t];
+	lt.constrained[k] = true;
+
+	const int u = lt.n[k];
+
+	if(-1 != u)
+		for(int j = 0; j < 3; j++)
+			if(lt.v[k] == local_triangles[u].v[(j + 1) % 3] && lt.v[(k + 1) % 3] == local_triangles[u].v[j])
+				local_triangles[u].constrained[j] = true;
+
+	return true;
+}
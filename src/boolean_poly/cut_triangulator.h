@@ -0,0 +1,78 @@
+#ifndef CUT_TRIANGULATOR_H
+#define CUT_TRIANGULATOR_H
+
+#include "exact_predicates.h"
+
+#include <vector>
+using std::vector;
+
+
+// Where another surface cuts a triangle: on one of its edges, or inside it.
+class cut_point
+{
+public:
+	mesh_index id;         // The vertex index this point will have in the output
+	int edge;              // k if the point lies on the edge from corner k to corner k + 1, or -1 if inside
+	implicit_point point;
+};
+
+// Splits one triangle along the segments where another surface crosses it.
+//
+// The triangle is projected onto the coordinate plane its normal is closest to. The points
+// on its edges are inserted first, in order along each edge, by splitting the boundary;
+// the points inside go in next, each one splitting the triangle it lands in. Then each
+// segment is made an edge by flipping the edges that cross it, as in Sloan's constrained
+// triangulation.
+//
+// Every decision is an exact predicate on the implicit points (see exact_predicates.h),
+// so every decision is consistent with every other. Points that coincide until the
+// translation of one mesh separates them, as where two surfaces share faces, are ordered
+// by it like any others.
+//
+// A triangle whose corners are collinear has no plane to project onto. It is split
+// topologically instead: every segment runs from a point on its long edge to a point on
+// one of its two short ones, and the sliver between the segments is zipped up in order
+// along the line.
+class cut_triangulator
+{
+public:
+	// segments holds pairs of indices into points. The sub-triangles are appended to
+	// triangles, wound like the original, and each gets a mask in cut_edges with bit k
+	// set if its edge from corner k to corner k + 1 lies along a segment. Returns false if
+	// some segment could not be made an edge; the rest of the split is still valid.
+	bool triangulate(const vertex_3 corners[3], const mesh_index corner_ids[3], const bool collinear_corners, const vector<cut_point> &points, const vector<size_t> &segments, vector<indexed_triangle> &triangles, vector<uint8_t> &cut_edges);
+
+private:
+	class local_triangle
+	{
+	public:
+		int v[3];              // Local vertex indices, counter-clockwise
+		int n[3];              // The triangle across the edge from v[k] to v[k + 1], or -1
+		bool constrained[3];
+	};
+
+	bool triangulate_plane(const vertex_3 corners[3], const vector<cut_point> &points, const vector<size_t> &segments);
+	bool triangulate_sliver(const vertex_3 corners[3], const vector<cut_point> &points, const vector<size_t> &segments, vector<indexed_triangle> &triangles, vector<uint8_t> &cut_edges, const mesh_index corner_ids[3]);
+
+	int orient(const int a, const int b, const int c) const;
+	bool ahead(const int a, const int b, const int r) const;
+	void rotate(const int t, const int k);
+	void replace_neighbour(const int t, const int old_neighbour, const int new_neighbour);
+	int add_triangle(const int a, const int b, const int c);
+	void split_triangle(const int t, const int p);
+	void split_edge(const int t, const int k, const int p);
+	void flip(const int t, const int k);
+	void gather_fan(const int a, vector<int> &triangles_around) const;
+	bool find_edge(const int a, const int b, int &t, int &k) const;
+	int locate(const int p, const int start) const;
+	bool recover_segment(const int a, const int b, const size_t depth);
+
+	vector<implicit_point> local_points; // The corners, then the points
+	size_t u;                            // The coordinates the triangle is projected onto
+	size_t v;
+	vector<int> vertex_triangles;        // A triangle that uses each local vertex
+	vector<local_triangle> local_triangles;
+};
+
+
+#endif
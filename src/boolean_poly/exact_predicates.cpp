@@ -0,0 +1,1138 @@
+#include "exact_predicates.h"
+
+#include <cmath>
+#include <cstring> // for memcpy()
+
+#include <limits>
+using std::numeric_limits;
+
+
+// Half an ulp of one, the unit roundoff of double arithmetic.
+static const double epsilon = 1.1102230246251565e-16;
+
+// Shewchuk's first-stage error bounds.
+static const double ccw_error_bound = (3.0 + 16.0*epsilon)*epsilon;
+static const double o3d_error_bound = (7.0 + 56.0*epsilon)*epsilon;
+
+// 2^27 + 1, for splitting a double into two 26-bit halves.
+static const double splitter = 134217729.0;
+
+
+// A number held exactly as the sum of its terms, which do not overlap and are sorted by
+// increasing magnitude, so the last term carries the sign. Products are compressed as
+// they are built, which keeps even the determinants on implicit points to a few dozen terms.
+class expansion
+{
+public:
+	expansion(void) : length(1) { terms[0] = 0.0; }
+	explicit expansion(const double value) : length(1) { terms[0] = value; }
+	expansion(const expansion &rhs) : length(rhs.length) { copy_terms(rhs); }
+
+	// Only the terms in use are copied; most expansions are far shorter than max_terms.
+	inline expansion &operator=(const expansion &rhs)
+	{
+		length = rhs.length;
+		copy_terms(rhs);
+
+		return *this;
+	}
+
+	inline int sign(void) const
+	{
+		if(terms[length - 1] > 0.0)
+			return 1;
+		else if(terms[length - 1] < 0.0)
+			return -1;
+
+		return 0;
+	}
+
+	static const int max_terms = 256;
+
+	double terms[max_terms];
+	int length;
+
+private:
+	inline void copy_terms(const expansion &rhs)
+	{
+		for(int i = 0; i < length; i++)
+			terms[i] = rhs.terms[i];
+	}
+};
+
+
+static inline void fast_two_sum(const double a, const double b, double &x, double &y)
+{
+	x = a + b;
+	const double b_virtual = x - a;
+	y = b - b_virtual;
+}
+
+static inline void two_sum(const double a, const double b, double &x, double &y)
+{
+	x = a + b;
+	const double b_virtual = x - a;
+	const double a_virtual = x - b_virtual;
+	const double b_roundoff = b - b_virtual;
+	const double a_roundoff = a - a_virtual;
+	y = a_roundoff + b_roundoff;
+}
+
+static inline void two_diff(const double a, const double b, double &x, double &y)
+{
+	x = a - b;
+	const double b_virtual = a - x;
+	const double a_virtual = x + b_virtual;
+	const double b_roundoff = b_virtual - b;
+	const double a_roundoff = a - a_virtual;
+	y = a_roundoff + b_roundoff;
+}
+
+static inline void two_product(const double a, const double b, double &x, double &y)
+{
+	x = a*b;
+
+#ifdef FP_FAST_FMA
+	y = fma(a, b, -x);
+#else
+	double c = splitter*a;
+	const double a_hi = c - (c - a);
+	const double a_lo = a - a_hi;
+
+	c = splitter*b;
+	const double b_hi = c - (c - b);
+	const double b_lo = b - b_hi;
+
+	const double err1 = x - a_hi*b_hi;
+	const double err2 = err1 - a_lo*b_hi;
+	const double err3 = err2 - a_hi*b_lo;
+	y = a_lo*b_lo - err3;
+#endif
+}
+
+// The exact difference a - b, as an expansion of one or two terms.
+static inline void difference(const double a, const double b, expansion &h)
+{
+	double x, y;
+	two_diff(a, b, x, y);
+
+	h.length = 0;
+
+	if(0.0 != y)
+		h.terms[h.length++] = y;
+
+	h.terms[h.length++] = x;
+}
+
+static inline void negate_terms(expansion &e)
+{
+	for(int i = 0; i < e.length; i++)
+		e.terms[i] = -e.terms[i];
+}
+
+// h = e + f (Shewchuk's fast_expansion_sum_zeroelim()). h must not be e or f.
+static void add(const expansion &e, const expansion &f, expansion &h)
+{
+	int e_index = 0, f_index = 0;
+	double e_now = e.terms[0], f_now = f.terms[0];
+	double q, q_new, hh;
+
+	if((f_now > e_now) == (f_now > -e_now))
+	{
+		q = e_now;
+		e_now = (++e_index < e.length) ? e.terms[e_index] : 0.0;
+	}
+	else
+	{
+		q = f_now;
+		f_now = (++f_index < f.length) ? f.terms[f_index] : 0.0;
+	}
+
+	h.length = 0;
+
+	if(e_index < e.length && f_index < f.length)
+	{
+		if((f_now > e_now) == (f_now > -e_now))
+		{
+			fast_two_sum(e_now, q, q_new, hh);
+			e_now = (++e_index < e.length) ? e.terms[e_index] : 0.0;
+		}
+		else
+		{
+			fast_two_sum(f_now, q, q_new, hh);
+			f_now = (++f_index < f.length) ? f.terms[f_index] : 0.0;
+		}
+
+		q = q_new;
+
+		if(0.0 != hh)
+			h.terms[h.length++] = hh;
+
+		while(e_index < e.length && f_index < f.length)
+		{
+			if((f_now > e_now) == (f_now > -e_now))
+			{
+				two_sum(q, e_now, q_new, hh);
+				e_now = (++e_index < e.length) ? e.terms[e_index] : 0.0;
+			}
+			else
+			{
+				two_sum(q, f_now, q_new, hh);
+				f_now = (++f_index < f.length) ? f.terms[f_index] : 0.0;
+			}
+
+			q = q_new;
+
+			if(0.0 != hh)
+				h.terms[h.length++] = hh;
+		}
+	}
+
+	while(e_index < e.length)
+	{
+		two_sum(q, e_now, q_new, hh);
+		e_now = (++e_index < e.length) ? e.terms[e_index] : 0.0;
+		q = q_new;
+
+		if(0.0 != hh)
+			h.terms[h.length++] = hh;
+	}
+
+	while(f_index < f.length)
+	{
+		two_sum(q, f_now, q_new, hh);
+		f_now = (++f_index < f.length) ? f.terms[f_index] : 0.0;
+		q = q_new;
+
+		if(0.0 != hh)
+			h.terms[h.length++] = hh;
+	}
+
+	if(0.0 != q || 0 == h.length)
+		h.terms[h.length++] = q;
+}
+
+static void subtract(const expansion &e, const expansion &f, expansion &h)
+{
+	expansion negated_f = f;
+	negate_terms(negated_f);
+	add(e, negated_f, h);
+}
+
+// h = e*b (Shewchuk's scale_expansion_zeroelim()). h must not be e.
+static void scale(const expansion &e, const double b, expansion &h)
+{
+	double q, hh, product1, product0, sum;
+
+	two_product(e.terms[0], b, q, hh);
+	h.length = 0;
+
+	if(0.0 != hh)
+		h.terms[h.length++] = hh;
+
+	for(int i = 1; i < e.length; i++)
+	{
+		two_product(e.terms[i], b, product1, product0);
+		two_sum(q, product0, sum, hh);
+
+		if(0.0 != hh)
+			h.terms[h.length++] = hh;
+
+		fast_two_sum(product1, sum, q, hh);
+
+		if(0.0 != hh)
+			h.terms[h.length++] = hh;
+	}
+
+	if(0.0 != q || 0 == h.length)
+		h.terms[h.length++] = q;
+}
+
+// Rewrites e with as few terms as it takes (Shewchuk's compress()).
+static void compress(expansion &e)
+{
+	int bottom = e.length - 1;
+	double q = e.terms[bottom], q_new, small;
+
+	for(int i = e.length - 2; i >= 0; i--)
+	{
+		fast_two_sum(q, e.terms[i], q_new, small);
+
+		if(0.0 != small)
+		{
+			e.terms[bottom--] = q_new;
+			q = small;
+		}
+		else
+			q = q_new;
+	}
+
+	int top = 0;
+
+	for(int i = bottom + 1; i < e.length; i++)
+	{
+		fast_two_sum(e.terms[i], q, q_new, small);
+
+		if(0.0 != small)
+			e.terms[top++] = small;
+
+		q = q_new;
+	}
+
+	e.terms[top++] = q;
+	e.length = top;
+}
+
+// h = e*f, one term of f at a time. h must not be e or f.
+static void multiply(const expansion &e, const expansion &f, expansion &h)
+{
+	scale(e, f.terms[0], h);
+
+	for(int i = 1; i < f.length; i++)
+	{
+		expansion scaled, sum;
+		scale(e, f.terms[i], scaled);
+		add(h, scaled, sum);
+		compress(sum);
+		h = sum;
+	}
+}
+
+// out = the component of x cross y that comes from coordinates i and j: x[i]*y[j] - x[j]*y[i].
+static void cross_component(const expansion x[3], const expansion y[3], const size_t i, const size_t j, expansion &out)
+{
+	expansion left, right;
+	multiply(x[i], y[j], left);
+	multiply(x[j], y[i], right);
+	subtract(left, right, out);
+}
+
+static void cross(const expansion x[3], const expansion y[3], expansion out[3])
+{
+	cross_component(x, y, 1, 2, out[0]);
+	cross_component(x, y, 2, 0, out[1]);
+	cross_component(x, y, 0, 1, out[2]);
+}
+
+static void differences(const vertex_3 &p, const vertex_3 &origin, expansion out[3])
+{
+	difference(p.x, origin.x, out[0]);
+	difference(p.y, origin.y, out[1]);
+	difference(p.z, origin.z, out[2]);
+}
+
+static int exact_orient3d(const expansion u[3], const expansion v[3], const expansion w[3])
+{
+	expansion vw[3];
+	cross(v, w, vw);
+
+	expansion x, y, z, xy, xyz;
+	multiply(u[0], vw[0], x);
+	multiply(u[1], vw[1], y);
+	multiply(u[2], vw[2], z);
+	add(x, y, xy);
+	add(xy, z, xyz);
+
+	return xyz.sign();
+}
+
+int orient3d(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const vertex_3 &d)
+{
+	const double ux = static_cast<double>(b.x) - a.x, uy = static_cast<double>(b.y) - a.y, uz = static_cast<double>(b.z) - a.z;
+	const double vx = static_cast<double>(c.x) - a.x, vy = static_cast<double>(c.y) - a.y, vz = static_cast<double>(c.z) - a.z;
+	const double wx = static_cast<double>(d.x) - a.x, wy = static_cast<double>(d.y) - a.y, wz = static_cast<double>(d.z) - a.z;
+
+	const double vy_wz = vy*wz, vz_wy = vz*wy;
+	const double vz_wx = vz*wx, vx_wz = vx*wz;
+	const double vx_wy = vx*wy, vy_wx = vy*wx;
+
+	const double det = ux*(vy_wz - vz_wy) + uy*(vz_wx - vx_wz) + uz*(vx_wy - vy_wx);
+
+	const double permanent = fabs(ux)*(fabs(vy_wz) + fabs(vz_wy)) + fabs(uy)*(fabs(vz_wx) + fabs(vx_wz)) + fabs(uz)*(fabs(vx_wy) + fabs(vy_wx));
+	const double error_bound = o3d_error_bound*permanent;
+
+	if(det > error_bound)
+		return 1;
+	else if(-det > error_bound)
+		return -1;
+
+	expansion u[3], v[3], w[3];
+	differences(b, a, u);
+	differences(c, a, v);
+	differences(d, a, w);
+
+	return exact_orient3d(u, v, w);
+}
+
+int orient2d(const double a[2], const double b[2], const double c[2])
+{
+	const double left = (b[0] - a[0])*(c[1] - a[1]);
+	const double right = (b[1] - a[1])*(c[0] - a[0]);
+	const double det = left - right;
+	const double error_bound = ccw_error_bound*(fabs(left) + fabs(right));
+
+	if(det > error_bound)
+		return 1;
+	else if(-det > error_bound)
+		return -1;
+
+	expansion u[2], v[2];
+	difference(b[0], a[0], u[0]);
+	difference(b[1], a[1], u[1]);
+	difference(c[0], a[0], v[0]);
+	difference(c[1], a[1], v[1]);
+
+	expansion l, r, result;
+	multiply(u[0], v[1], l);
+	multiply(u[1], v[0], r);
+	subtract(l, r, result);
+
+	return result.sign();
+}
+
+bool collinear(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c)
+{
+	const double xy[3][2] = { { a.x, a.y }, { b.x, b.y }, { c.x, c.y } };
+	const double yz[3][2] = { { a.y, a.z }, { b.y, b.z }, { c.y, c.z } };
+	const double zx[3][2] = { { a.z, a.x }, { b.z, b.x }, { c.z, c.x } };
+
+	return 0 == orient2d(xy[0], xy[1], xy[2]) && 0 == orient2d(yz[0], yz[1], yz[2]) && 0 == orient2d(zx[0], zx[1], zx[2]);
+}
+
+// k*e added to sum, for k in {-1, 0, 1}.
+static void accumulate(const int k, const expansion &e, expansion &sum)
+{
+	if(0 == k)
+		return;
+
+	expansion result;
+
+	if(k > 0)
+		add(sum, e, result);
+	else
+		subtract(sum, e, result);
+
+	sum = result;
+}
+
+int orient3d(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const vertex_3 &d, const unsigned int moved)
+{
+	const int s = orient3d(a, b, c, d);
+
+	if(0 != s)
+		return s;
+
+	// With u = b - a, v = c - a and w = d - a each growing by k*delta (k being the
+	// difference of the moved flags), the determinant u.(v x w) grows by
+	// delta.(k_u (v x w) + k_v (w x u) + k_w (u x v)); the terms in delta squared vanish.
+	const int k_a = (moved >> 0) & 1;
+	const int k_u = static_cast<int>((moved >> 1) & 1) - k_a;
+	const int k_v = static_cast<int>((moved >> 2) & 1) - k_a;
+	const int k_w = static_cast<int>((moved >> 3) & 1) - k_a;
+
+	if(0 == k_u && 0 == k_v && 0 == k_w)
+		return 0;
+
+	expansion u[3], v[3], w[3];
+	differences(b, a, u);
+	differences(c, a, v);
+	differences(d, a, w);
+
+	expansion gradient[3];
+
+	if(0 != k_u)
+	{
+		expansion vw[3];
+		cross(v, w, vw);
+
+		for(size_t i = 0; i < 3; i++)
+			accumulate(k_u, vw[i], gradient[i]);
+	}
+
+	if(0 != k_v)
+	{
+		expansion wu[3];
+		cross(w, u, wu);
+
+		for(size_t i = 0; i < 3; i++)
+			accumulate(k_v, wu[i], gradient[i]);
+	}
+
+	if(0 != k_w)
+	{
+		expansion uv[3];
+		cross(u, v, uv);
+
+		for(size_t i = 0; i < 3; i++)
+			accumulate(k_w, uv[i], gradient[i]);
+	}
+
+	// delta = (e, e^2, e^3): the x component dominates, then y, then z.
+	for(size_t i = 0; i < 3; i++)
+		if(0 != gradient[i].sign())
+			return gradient[i].sign();
+
+	return 0;
+}
+
+int orient2d_yz(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const unsigned int moved)
+{
+	const double pa[2] = { a.y, a.z };
+	const double pb[2] = { b.y, b.z };
+	const double pc[2] = { c.y, c.z };
+
+	const int s = orient2d(pa, pb, pc);
+
+	if(0 != s)
+		return s;
+
+	// (U + k_U d) x (V + k_V d), with d = (e^2, e^3), U = b - a and V = c - a, is
+	// U x V + e^2 (k_U V_z - k_V U_z) + e^3 (k_V U_y - k_U V_y).
+	const int k_a = (moved >> 0) & 1;
+	const int k_u = static_cast<int>((moved >> 1) & 1) - k_a;
+	const int k_v = static_cast<int>((moved >> 2) & 1) - k_a;
+
+	if(0 == k_u && 0 == k_v)
+		return 0;
+
+	expansion u[2], v[2];
+	difference(b.y, a.y, u[0]);
+	difference(b.z, a.z, u[1]);
+	difference(c.y, a.y, v[0]);
+	difference(c.z, a.z, v[1]);
+
+	expansion e2, e3;
+	accumulate(k_u, v[1], e2);
+	accumulate(-k_v, u[1], e2);
+	accumulate(k_v, u[0], e3);
+	accumulate(-k_u, v[0], e3);
+
+	if(0 != e2.sign())
+		return e2.sign();
+
+	return e3.sign();
+}
+
+
+// A rounded value and a bound on its distance from the exact one. Each operation adds
+// twice the unit roundoff of its result, which also covers the rounding of the bounds.
+class bounded
+{
+public:
+	bounded(void) : value(0.0), error(0.0) { /* default constructor */ }
+	bounded(const double src_value, const double src_error) : value(src_value), error(src_error) { /* custom constructor */ }
+
+	double value;
+	double error;
+};
+
+static inline bounded operator+(const bounded &a, const bounded &b)
+{
+	const double v = a.value + b.value;
+	return bounded(v, a.error + b.error + 2.0*epsilon*fabs(v));
+}
+
+static inline bounded operator-(const bounded &a, const bounded &b)
+{
+	const double v = a.value - b.value;
+	return bounded(v, a.error + b.error + 2.0*epsilon*fabs(v));
+}
+
+static inline bounded operator*(const bounded &a, const bounded &b)
+{
+	const double v = a.value*b.value;
+	return bounded(v, fabs(a.value)*b.error + fabs(b.value)*a.error + a.error*b.error + 2.0*epsilon*fabs(v));
+}
+
+static inline bounded operator/(const bounded &a, const bounded &b)
+{
+	if(fabs(b.value) <= b.error)
+		return bounded(0.0, numeric_limits<double>::infinity());
+
+	const double v = a.value/b.value;
+	return bounded(v, (a.error + fabs(v)*b.error)/(fabs(b.value) - b.error) + 2.0*epsilon*fabs(v));
+}
+
+static inline double coordinate(const vertex_3 &p, const size_t axis)
+{
+	return (0 == axis) ? p.x : ((1 == axis) ? p.y : p.z);
+}
+
+void implicit_point::set(const vertex_3 &p)
+{
+	made = false;
+	line[0] = p;
+	line_shift = plane_shift = 0;
+
+	position[0] = p.x;
+	position[1] = p.y;
+	position[2] = p.z;
+	error = 0.0;
+}
+
+void implicit_point::set(const vertex_3 &line_start, const vertex_3 &line_end, const int src_line_shift, const vertex_3 &plane_a, const vertex_3 &plane_b, const vertex_3 &plane_c, const int src_plane_shift)
+{
+	made = true;
+	line[0] = line_start;
+	line[1] = line_end;
+	plane[0] = plane_a;
+	plane[1] = plane_b;
+	plane[2] = plane_c;
+	line_shift = src_line_shift;
+	plane_shift = src_plane_shift;
+
+	// position = l0 + t (l1 - l0), t = n.(p0 - l0) / n.(l1 - l0), n = (p1 - p0) x (p2 - p0).
+	bounded e[3], u[3], v[3], w[3];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		const bounded l0(coordinate(line[0], i), 0.0), l1(coordinate(line[1], i), 0.0);
+		const bounded p0(coordinate(plane[0], i), 0.0), p1(coordinate(plane[1], i), 0.0), p2(coordinate(plane[2], i), 0.0);
+
+		e[i] = l1 - l0;
+		u[i] = p1 - p0;
+		v[i] = p2 - p0;
+		w[i] = p0 - l0;
+	}
+
+	const bounded n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+	const bounded t = (n[0]*w[0] + n[1]*w[1] + n[2]*w[2]) / (n[0]*e[0] + n[1]*e[1] + n[2]*e[2]);
+
+	error = 0.0;
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		const bounded x = bounded(coordinate(line[0], i), 0.0) + t*e[i];
+
+		position[i] = x.value;
+
+		if(x.error > error)
+			error = x.error;
+	}
+}
+
+// The exact homogeneous coordinates of an implicit point, as a polynomial in e:
+// h[k][i] is coordinate i of the term in e^k, and h[0][3] is the denominator.
+class exact_point
+{
+public:
+	expansion h[4][4];
+	bool zero[4];  // Whether the whole term in e^k is zero
+};
+
+static void product(const expansion &a, const expansion &b, expansion &h)
+{
+	multiply(a, b, h);
+	compress(h);
+}
+
+static void sum(const expansion &a, const expansion &b, expansion &h)
+{
+	add(a, b, h);
+	compress(h);
+}
+
+static void dot(const expansion a[3], const expansion b[3], expansion &h)
+{
+	expansion x, y, z, xy;
+	product(a[0], b[0], x);
+	product(a[1], b[1], y);
+	product(a[2], b[2], z);
+	sum(x, y, xy);
+	sum(xy, z, h);
+}
+
+static void make_exact(const implicit_point &p, exact_point &x)
+{
+	for(size_t k = 0; k < 4; k++)
+	{
+		x.zero[k] = true;
+
+		for(size_t i = 0; i < 4; i++)
+			x.h[k][i] = expansion(0.0);
+	}
+
+	x.zero[0] = false;
+
+	if(false == p.made)
+	{
+		x.h[0][0] = expansion(p.line[0].x);
+		x.h[0][1] = expansion(p.line[0].y);
+		x.h[0][2] = expansion(p.line[0].z);
+		x.h[0][3] = expansion(1.0);
+		return;
+	}
+
+	// With n the plane's normal, E = l1 - l0 and D = n.E, the point is
+	//   (l0 + s_l d) + (n.(p0 - l0) + (s_p - s_l) n.d) E / D
+	// for the translation d = (e, e^2, e^3), so its numerator is
+	//   l0 D + n.(p0 - l0) E  +  sum over k of e^k (s_l D [axis k - 1] + (s_p - s_l) n[k - 1] E).
+	expansion e[3], u[3], v[3], w[3], n[3];
+	differences(p.line[1], p.line[0], e);
+	differences(p.plane[1], p.plane[0], u);
+	differences(p.plane[2], p.plane[0], v);
+	differences(p.plane[0], p.line[0], w);
+	cross(u, v, n);
+
+	for(size_t i = 0; i < 3; i++)
+		compress(n[i]);
+
+	expansion distance, denominator;
+	dot(n, w, distance);
+	dot(n, e, denominator);
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		expansion start, along;
+		scale(denominator, coordinate(p.line[0], i), start);
+		compress(start);
+		product(distance, e[i], along);
+		sum(start, along, x.h[0][i]);
+	}
+
+	x.h[0][3] = denominator;
+
+	const int relative_shift = p.plane_shift - p.line_shift;
+
+	for(size_t k = 1; k < 4; k++)
+	{
+		for(size_t i = 0; i < 3; i++)
+		{
+			expansion along;
+
+			if(0 != relative_shift)
+			{
+				product(n[k - 1], e[i], along);
+
+				if(relative_shift < 0)
+					negate_terms(along);
+			}
+
+			if(0 != p.line_shift && k - 1 == i)
+			{
+				expansion shifted = denominator;
+
+				if(p.line_shift < 0)
+					negate_terms(shifted);
+
+				sum(along, shifted, x.h[k][i]);
+			}
+			else
+				x.h[k][i] = along;
+
+			if(0 != x.h[k][i].sign())
+				x.zero[k] = false;
+		}
+	}
+}
+
+// The determinant of three rows (h[u], h[v], h[3]).
+static void determinant(const expansion *a, const expansion *b, const expansion *c, const size_t u, const size_t v, expansion &h)
+{
+	expansion bv_cw, bw_cv, bu_cw, bw_cu, bu_cv, bv_cu;
+	product(b[v], c[3], bv_cw);
+	product(b[3], c[v], bw_cv);
+	product(b[u], c[3], bu_cw);
+	product(b[3], c[u], bw_cu);
+	product(b[u], c[v], bu_cv);
+	product(b[v], c[u], bv_cu);
+
+	expansion minor_u, minor_v, minor_w;
+	subtract(bv_cw, bw_cv, minor_u);
+	subtract(bu_cw, bw_cu, minor_v);
+	subtract(bu_cv, bv_cu, minor_w);
+	compress(minor_u);
+	compress(minor_v);
+	compress(minor_w);
+
+	expansion x, y, z, xy;
+	product(a[u], minor_u, x);
+	product(a[v], minor_v, y);
+	product(a[3], minor_w, z);
+	subtract(x, y, xy);
+	compress(xy);
+	sum(xy, z, h);
+}
+
+int orient2d(const implicit_point &a, const implicit_point &b, const implicit_point &c, const size_t u, const size_t v)
+{
+	const bounded au(a.position[u], a.error), av(a.position[v], a.error);
+	const bounded bu(b.position[u], b.error), bv(b.position[v], b.error);
+	const bounded cu(c.position[u], c.error), cv(c.position[v], c.error);
+
+	const bounded det = (bu - au)*(cv - av) - (bv - av)*(cu - au);
+
+	if(det.value > det.error)
+		return 1;
+	else if(-det.value > det.error)
+		return -1;
+
+	if(false == a.made && false == b.made && false == c.made)
+	{
+		const double pa[2] = { a.position[u], a.position[v] };
+		const double pb[2] = { b.position[u], b.position[v] };
+		const double pc[2] = { c.position[u], c.position[v] };
+
+		return orient2d(pa, pb, pc);
+	}
+
+	exact_point x[3];
+	make_exact(a, x[0]);
+	make_exact(b, x[1]);
+	make_exact(c, x[2]);
+
+	const int denominators = x[0].h[0][3].sign()*x[1].h[0][3].sign()*x[2].h[0][3].sign();
+
+	// The term in e^order gathers every choice of one term from each row with those powers.
+	for(size_t order = 0; order <= 9; order++)
+	{
+		expansion total;
+
+		for(size_t i = 0; i < 4 && i <= order; i++)
+		{
+			if(true == x[0].zero[i])
+				continue;
+
+			for(size_t j = 0; j < 4 && i + j <= order; j++)
+			{
+				const size_t k = order - i - j;
+
+				if(k > 3 || true == x[1].zero[j] || true == x[2].zero[k])
+					continue;
+
+				expansion d, next;
+				determinant(x[0].h[i], x[1].h[j], x[2].h[k], u, v, d);
+				sum(total, d, next);
+				total = next;
+			}
+		}
+
+		if(0 != total.sign())
+			return total.sign()*denominators;
+	}
+
+	return 0;
+}
+
+int compare(const implicit_point &a, const implicit_point &b, const size_t axis)
+{
+	const bounded difference_bound = bounded(a.position[axis], a.error) - bounded(b.position[axis], b.error);
+
+	if(difference_bound.value > difference_bound.error)
+		return 1;
+	else if(-difference_bound.value > difference_bound.error)
+		return -1;
+
+	if(false == a.made && false == b.made)
+	{
+		if(a.position[axis] > b.position[axis])
+			return 1;
+		else if(a.position[axis] < b.position[axis])
+			return -1;
+
+		return 0;
+	}
+
+	exact_point x[2];
+	make_exact(a, x[0]);
+	make_exact(b, x[1]);
+
+	const int denominators = x[0].h[0][3].sign()*x[1].h[0][3].sign();
+
+	// a/Da - b/Db has the sign of a Db - b Da, times that of Da Db.
+	for(size_t k = 0; k < 4; k++)
+	{
+		expansion left, right, d;
+		product(x[0].h[k][axis], x[1].h[0][3], left);
+		product(x[1].h[k][axis], x[0].h[0][3], right);
+		subtract(left, right, d);
+
+		if(0 != d.sign())
+			return d.sign()*denominators;
+	}
+
+	return 0;
+}
+
+void plane_3::set(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c)
+{
+	points[0] = a;
+	points[1] = b;
+	points[2] = c;
+
+	bounded u[3], v[3], p[3];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		p[i] = bounded(coordinate(a, i), 0.0);
+		u[i] = bounded(coordinate(b, i), 0.0) - p[i];
+		v[i] = bounded(coordinate(c, i), 0.0) - p[i];
+	}
+
+	const bounded n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+	const bounded d = bounded(0.0, 0.0) - (n[0]*p[0] + n[1]*p[1] + n[2]*p[2]);
+
+	normal_error = 0.0;
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		normal[i] = n[i].value;
+
+		if(n[i].error > normal_error)
+			normal_error = n[i].error;
+	}
+
+	offset = d.value;
+	offset_error = d.error;
+}
+
+static inline void bounded_plane(const plane_3 &p, bounded n[3], bounded &d)
+{
+	for(size_t i = 0; i < 3; i++)
+		n[i] = bounded(p.normal[i], p.normal_error);
+
+	d = bounded(p.offset, p.offset_error);
+}
+
+static inline void bounded_cross(const bounded x[3], const bounded y[3], bounded out[3])
+{
+	out[0] = x[1]*y[2] - x[2]*y[1];
+	out[1] = x[2]*y[0] - x[0]*y[2];
+	out[2] = x[0]*y[1] - x[1]*y[0];
+}
+
+static void exact_plane(const plane_3 &p, expansion n[3], expansion &d)
+{
+	expansion u[3], v[3];
+	differences(p.points[1], p.points[0], u);
+	differences(p.points[2], p.points[0], v);
+	cross(u, v, n);
+
+	for(size_t i = 0; i < 3; i++)
+		compress(n[i]);
+
+	const expansion origin[3] = { expansion(p.points[0].x), expansion(p.points[0].y), expansion(p.points[0].z) };
+	dot(n, origin, d);
+	negate_terms(d);
+}
+
+static inline double estimate(const expansion &e)
+{
+	double value = 0.0;
+
+	for(int i = 0; i < e.length; i++)
+		value += e.terms[i];
+
+	return value;
+}
+
+// The point where p, q and r meet, in homogeneous coordinates: numerator / denominator, with
+//   denominator = n_p.(n_q x n_r)
+//   numerator = -(d_p (n_q x n_r) + d_q (n_r x n_p) + d_r (n_p x n_q))
+static void exact_intersection(const plane_3 &p, const plane_3 &q, const plane_3 &r, expansion numerator[3], expansion &denominator)
+{
+	expansion n[3][3], d[3];
+	exact_plane(p, n[0], d[0]);
+	exact_plane(q, n[1], d[1]);
+	exact_plane(r, n[2], d[2]);
+
+	expansion crosses[3][3];
+	cross(n[1], n[2], crosses[0]);
+	cross(n[2], n[0], crosses[1]);
+	cross(n[0], n[1], crosses[2]);
+
+	for(size_t j = 0; j < 3; j++)
+		for(size_t i = 0; i < 3; i++)
+			compress(crosses[j][i]);
+
+	dot(n[0], crosses[0], denominator);
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		expansion x, y, z, xy;
+		product(d[0], crosses[0][i], x);
+		product(d[1], crosses[1][i], y);
+		product(d[2], crosses[2][i], z);
+		sum(x, y, xy);
+		sum(xy, z, numerator[i]);
+		negate_terms(numerator[i]);
+	}
+}
+
+bool intersect_planes(const plane_3 &p, const plane_3 &q, const plane_3 &r, double position[3], double &error)
+{
+	bounded n[3][3], d[3];
+	bounded_plane(p, n[0], d[0]);
+	bounded_plane(q, n[1], d[1]);
+	bounded_plane(r, n[2], d[2]);
+
+	bounded crosses[3][3];
+	bounded_cross(n[1], n[2], crosses[0]);
+	bounded_cross(n[2], n[0], crosses[1]);
+	bounded_cross(n[0], n[1], crosses[2]);
+
+	const bounded denominator = n[0][0]*crosses[0][0] + n[0][1]*crosses[0][1] + n[0][2]*crosses[0][2];
+
+	if(fabs(denominator.value) > denominator.error)
+	{
+		error = 0.0;
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			const bounded x = (bounded(0.0, 0.0) - (d[0]*crosses[0][i] + d[1]*crosses[1][i] + d[2]*crosses[2][i])) / denominator;
+
+			position[i] = x.value;
+
+			if(x.error > error)
+				error = x.error;
+		}
+
+		return true;
+	}
+
+	// Too close to parallel to tell in double.
+	expansion numerator[3], exact_denominator;
+	exact_intersection(p, q, r, numerator, exact_denominator);
+
+	if(0 == exact_denominator.sign())
+		return false;
+
+	for(size_t i = 0; i < 3; i++)
+		position[i] = estimate(numerator[i]) / estimate(exact_denominator);
+
+	// Rounded well enough to place the point, but not to classify it.
+	error = numeric_limits<double>::infinity();
+
+	return true;
+}
+
+int classify_point(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double position[3], const double error, const plane_3 &h)
+{
+	bounded n[3], d;
+	bounded_plane(h, n, d);
+
+	const bounded side = n[0]*bounded(position[0], error) + n[1]*bounded(position[1], error) + n[2]*bounded(position[2], error) + d;
+
+	if(side.value > side.error)
+		return 1;
+	else if(-side.value > side.error)
+		return -1;
+
+	// A corner of the input mesh is held exactly, and is a float; orient3d() has the sign
+	// of h there, for much less work.
+	const vertex_3 corner(static_cast<float>(position[0]), static_cast<float>(position[1]), static_cast<float>(position[2]));
+
+	if(0.0 == error && corner.x == position[0] && corner.y == position[1] && corner.z == position[2])
+		return orient3d(h.points[0], h.points[1], h.points[2], corner);
+
+	// h(x) = (n_h.numerator + d_h denominator) / denominator.
+	expansion numerator[3], denominator;
+	exact_intersection(p, q, r, numerator, denominator);
+
+	expansion exact_n[3], exact_d;
+	exact_plane(h, exact_n, exact_d);
+
+	expansion along, shift, total;
+	dot(exact_n, numerator, along);
+	product(exact_d, denominator, shift);
+	sum(along, shift, total);
+
+	return total.sign()*denominator.sign();
+}
+
+int compare_points(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double a_position[3], const double a_error, const plane_3 &s, const plane_3 &t, const plane_3 &u, const double b_position[3], const double b_error, const size_t axis)
+{
+	const bounded difference_bound = bounded(a_position[axis], a_error) - bounded(b_position[axis], b_error);
+
+	if(difference_bound.value > difference_bound.error)
+		return 1;
+	else if(-difference_bound.value > difference_bound.error)
+		return -1;
+
+	if(0.0 == a_error && 0.0 == b_error)
+		return 0;
+
+	expansion a_numerator[3], a_denominator, b_numerator[3], b_denominator;
+	exact_intersection(p, q, r, a_numerator, a_denominator);
+	exact_intersection(s, t, u, b_numerator, b_denominator);
+
+	// a/Da - b/Db has the sign of a Db - b Da, times that of Da Db.
+	expansion left, right, d;
+	product(a_numerator[axis], b_denominator, left);
+	product(b_numerator[axis], a_denominator, right);
+	subtract(left, right, d);
+
+	return d.sign()*a_denominator.sign()*b_denominator.sign();
+}
+
+// The sign of numerator/denominator - m.
+static int compare_quotient(const expansion &numerator, const expansion &denominator, const double m)
+{
+	expansion shifted, difference_of;
+	scale(denominator, m, shifted);
+	subtract(numerator, shifted, difference_of);
+
+	return difference_of.sign()*denominator.sign();
+}
+
+static inline bool is_even(const float f)
+{
+	uint32_t bits;
+	memcpy(&bits, &f, sizeof(bits));
+
+	return 0 == (bits & 1);
+}
+
+vertex_3 round_point(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double position[3], const double error)
+{
+	float rounded[3];
+	bool settled[3];
+	bool all_settled = true;
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		// Rounding to float keeps order, so if both ends of the interval round to the same
+		// float, so does the point. The ends are rounded too, hence the extra ulp.
+		rounded[i] = static_cast<float>(position[i]);
+
+		const float low = static_cast<float>(nextafter(position[i] - error, -HUGE_VAL));
+		const float high = static_cast<float>(nextafter(position[i] + error, HUGE_VAL));
+
+		settled[i] = (low == rounded[i] && high == rounded[i]);
+		all_settled = all_settled && settled[i];
+	}
+
+	if(true == all_settled)
+		return vertex_3(rounded[0], rounded[1], rounded[2]);
+
+	expansion numerator[3], denominator;
+	exact_intersection(p, q, r, numerator, denominator);
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		if(true == settled[i])
+			continue;
+
+		float f = static_cast<float>(estimate(numerator[i]) / estimate(denominator));
+
+		// Step to the neighbour while the point is past the midpoint towards it. Midpoints
+		// of adjacent floats are exact in double.
+		for(;;)
+		{
+			const float below = nextafterf(f, -HUGE_VALF), above = nextafterf(f, HUGE_VALF);
+			const int above_side = compare_quotient(numerator[i], denominator, 0.5*(double(f) + double(above)));
+			const int below_side = compare_quotient(numerator[i], denominator, 0.5*(double(below) + double(f)));
+
+			if(above_side > 0 || (0 == above_side && true == is_even(above)))
+				f = above;
+			else if(below_side < 0 || (0 == below_side && true == is_even(below)))
+				f = below;
+			else
+				break;
+		}
+
+		rounded[i] = f;
+	}
+
+	return vertex_3(rounded[0], rounded[1], rounded[2]);
+}
@@ -0,0 +1,114 @@
+#ifndef EXACT_PREDICATES_H
+#define EXACT_PREDICATES_H
+
+#include "../common/primitives.h"
+
+
+// See: Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates by J. R. Shewchuk
+//
+// Each predicate first evaluates its determinant in double and compares it with a bound
+// on the rounding error. Only when the result is too close to zero to trust is it worked
+// out again exactly, as a sum of non-overlapping doubles (an expansion). Nearly every
+// call takes the fast path; the answer is the exact sign either way.
+//
+// The sign conventions are those of a right-handed frame:
+//
+//   orient3d(a, b, c, d) = ((b - a) x (c - a)).(d - a)
+//   orient2d(a, b, c)    = (b - a) x (c - a)
+//
+// so orient3d() is positive when d is on the side that the normal of triangle abc points
+// to, and orient2d() is positive when abc turns counter-clockwise.
+//
+// The error-free transformations assume that a*b - c is not contracted into a fused
+// multiply-add; where the compiler does fuse (FP_FAST_FMA), products are split with fma().
+
+// Returns +1, -1 or 0.
+int orient3d(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const vertex_3 &d);
+int orient2d(const double a[2], const double b[2], const double c[2]);
+
+// Whether the three points lie on one line (or coincide).
+bool collinear(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c);
+
+// Simulation of simplicity for two meshes, one of which is translated by (e, e^2, e^3)
+// for an infinitely small e > 0. Bit i of moved is set if point i belongs to the moved mesh.
+//
+// When the determinant is exactly zero, the sign comes from the first non-zero term of its
+// expansion in e. A point of one mesh then never lies exactly on a face of the other, and
+// an edge of one never exactly meets an edge of the other, so coplanar and touching
+// configurations get the same treatment as any other. A result of zero means the points
+// are degenerate among themselves (e.g. a triangle with no area), whatever the translation.
+int orient3d(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const vertex_3 &d, const unsigned int moved);
+
+// The same translation seen down the x axis: the sign of orient2d() on the (y, z) coordinates,
+// with the points flagged in moved translated by (e^2, e^3).
+int orient2d_yz(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c, const unsigned int moved);
+
+// A point made rather than given: where the line through line[0] and line[1] meets the
+// plane through plane[0], plane[1] and plane[2], with the line translated by line_shift
+// times (e, e^2, e^3) and the plane by plane_shift times the same, each shift being -1, 0
+// or 1. The predicates below never round such a point. They try its rounded coordinates
+// first, with a bound on their error; if that cannot settle the sign, they work with its
+// exact homogeneous coordinates, which are polynomials in e, and take the sign of the
+// first term that is not zero, as above.
+class implicit_point
+{
+public:
+	// An input point, with no translation.
+	void set(const vertex_3 &p);
+	void set(const vertex_3 &line_start, const vertex_3 &line_end, const int src_line_shift, const vertex_3 &plane_a, const vertex_3 &plane_b, const vertex_3 &plane_c, const int src_plane_shift);
+
+	double position[3]; // Rounded, as e goes to zero
+	double error;       // A bound on how far each coordinate of position is from the exact one
+
+	bool made;
+	vertex_3 line[2];   // line[0] alone, for an input point
+	vertex_3 plane[3];
+	int line_shift;
+	int plane_shift;
+};
+
+// orient2d() on coordinates u and v of the points (with u, v = 1, 2 being the y, z of orient2d_yz()).
+int orient2d(const implicit_point &a, const implicit_point &b, const implicit_point &c, const size_t u, const size_t v);
+
+// The sign of a's coordinate along the axis, minus b's.
+int compare(const implicit_point &a, const implicit_point &b, const size_t axis);
+
+// See: Fast, Exact, Linear Booleans by G. Bernstein and D. Fussell
+//
+// A plane through three input points, with normal (b - a) x (c - a), so that a point d is
+// on its positive side when orient3d(a, b, c, d) > 0. A point where three such planes meet
+// is never rounded by the predicates below, however many times it has been cut out of
+// something else: it stays the three planes.
+class plane_3
+{
+public:
+	void set(const vertex_3 &a, const vertex_3 &b, const vertex_3 &c);
+
+	vertex_3 points[3];
+	double normal[3];    // Rounded
+	double offset;       // -normal.a, rounded
+	double normal_error; // Bounds on how far each coefficient is from the exact one
+	double offset_error;
+};
+
+// Sets position to where the three planes meet, and error to a bound on how far each
+// coordinate is from the exact one. Returns false if they do not meet in one point.
+bool intersect_planes(const plane_3 &p, const plane_3 &q, const plane_3 &r, double position[3], double &error);
+
+// The side of h that the point where p, q and r meet lies on: +1 for h's positive side,
+// -1 for its negative side, 0 if on h. position and error are those intersect_planes()
+// gave for the point, which settle nearly every call without exact arithmetic.
+int classify_point(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double position[3], const double error, const plane_3 &h);
+
+// Compares the points where p, q and r and where s, t and u meet along one axis: +1 if
+// the first is further along it, -1 if the second is, 0 if they are level. Positions and
+// errors are as for classify_point().
+int compare_points(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double a_position[3], const double a_error, const plane_3 &s, const plane_3 &t, const plane_3 &u, const double b_position[3], const double b_error, const size_t axis);
+
+// The point where p, q and r meet, each coordinate rounded to the nearest float (ties to
+// even), so that a point comes out the same whichever three planes it was cut out by.
+// position and error are as for classify_point().
+vertex_3 round_point(const plane_3 &p, const plane_3 &q, const plane_3 &r, const double position[3], const double error);
+
+
+#endif
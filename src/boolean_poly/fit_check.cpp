@@ -0,0 +1,97 @@
+// Checks whether an implant mesh intersects a bone mesh, and reports where.
+//
+// Example usage: fit_check bone.stl implant.stl [contacts.txt]
+// Each line of contacts.txt holds the bone triangle, the implant triangle, and the
+// end points of the segment along which they cross.
+
+#include "mesh_intersection.h"
+#include "test_support.h"
+#include "../common/mesh.h"
+
+#include <chrono>
+
+
+static bool load_mesh_and_tree(const char *const file_name, indexed_mesh &mesh, triangle_bvh &tree)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if(false == mesh.load_from_mapped_binary_stereo_lithography_file(file_name, false, WELD_EXACT_HASH, 0.0f, thread::hardware_concurrency()))
+	{
+		cout << "Error: Could not properly read file " << file_name << endl;
+		return false;
+	}
+
+	cout << "Loaded " << file_name << ": " << mesh.triangles.size() << " triangles in " << seconds_since(start) << " s" << endl;
+
+	start = std::chrono::steady_clock::now();
+
+	if(false == tree.build(mesh.vertices, mesh.triangles))
+	{
+		cout << "Error: " << file_name << " has no triangles" << endl;
+		return false;
+	}
+
+	cout << "Built its tree: " << tree.nodes.size() << " nodes, " << tree.memory_usage()/(1024*1024) << " MB, in " << seconds_since(start) << " s" << endl;
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	if(argc < 3)
+	{
+		cout << "Example usage: " << argv[0] << " bone.stl implant.stl [contacts.txt]" << endl;
+		return 1;
+	}
+
+	indexed_mesh bone, implant;
+	triangle_bvh bone_tree, implant_tree;
+
+	if(false == load_mesh_and_tree(argv[1], bone, bone_tree) || false == load_mesh_and_tree(argv[2], implant, implant_tree))
+		return 2;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const bool touching = meshes_intersect(bone_tree, implant_tree);
+
+	cout << (touching ? "The meshes intersect" : "The meshes do not intersect") << " (" << seconds_since(start)*1000.0 << " ms to the first contact)" << endl;
+
+	start = std::chrono::steady_clock::now();
+	vector<triangle_contact> contacts;
+	intersect_meshes(bone_tree, implant_tree, contacts, thread::hardware_concurrency());
+
+	size_t num_coplanar = 0;
+
+	for(size_t i = 0; i < contacts.size(); i++)
+		if(true == contacts[i].coplanar)
+			num_coplanar++;
+
+	cout << contacts.size() << " intersecting triangle pairs (" << num_coplanar << " coplanar) found in " << seconds_since(start)*1000.0 << " ms" << endl;
+
+	if(argc > 3)
+	{
+		ofstream out(argv[3]);
+
+		if(out.fail())
+		{
+			cout << "Error: Could not properly write file " << argv[3] << endl;
+			return 2;
+		}
+
+		for(size_t i = 0; i < contacts.size(); i++)
+		{
+			const triangle_contact &c = contacts[i];
+
+			out << c.triangle_a << ' ' << c.triangle_b;
+
+			if(false == c.coplanar)
+			{
+				out << ' ' << c.segment_start.x << ' ' << c.segment_start.y << ' ' << c.segment_start.z;
+				out << ' ' << c.segment_end.x << ' ' << c.segment_end.y << ' ' << c.segment_end.z;
+			}
+
+			out << '\n';
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,955 @@
+#include "mesh_boolean.h"
+#include "mesh_intersection.h"
+#include "exact_predicates.h"
+#include "test_support.h" // for seconds_since()
+#include "../common/vertex_welder.h"
+
+#include <algorithm>
+using std::sort;
+using std::unique;
+using std::lower_bound;
+
+#include <atomic>
+using std::atomic;
+
+#include <thread>
+using std::thread;
+
+#include <functional>
+using std::ref;
+using std::cref;
+
+#include <chrono>
+
+
+// The second operand is the one translated by the simulation of simplicity. In the masks
+// below, bit i is set if argument i of the predicate is one of its points.
+static const unsigned int moved_triangle = 0x7;  // orient3d(b, b, b, a)
+static const unsigned int moved_point = 0x8;     // orient3d(a, a, a, b)
+static const unsigned int moved_face_edge = 0xC; // orient3d(a, a, b, b)
+static const unsigned int moved_edge = 0x3;      // orient3d(b, b, a, a)
+
+static const size_t narrow_phase_chunk_size = 1024;
+
+
+// A point where an edge of one operand passes through a triangle of the other.
+// kind 0: edge (lo, hi) of a through triangle face of b. kind 1: edge of b through a triangle of a.
+class cut_key
+{
+public:
+	mesh_index face;
+	mesh_index lo;
+	mesh_index hi;
+	uint32_t kind;
+
+	inline bool operator<(const cut_key &right) const
+	{
+		if(face != right.face)
+			return face < right.face;
+
+		if(lo != right.lo)
+			return lo < right.lo;
+
+		if(hi != right.hi)
+			return hi < right.hi;
+
+		return kind < right.kind;
+	}
+
+	inline bool operator==(const cut_key &right) const
+	{
+		return face == right.face && lo == right.lo && hi == right.hi && kind == right.kind;
+	}
+};
+
+// The segment along which a triangle of a and a triangle of b cross.
+class pair_cut
+{
+public:
+	mesh_index triangle_a;
+	mesh_index triangle_b;
+	cut_key ends[2];
+	mesh_index ids[2];     // Indices of the ends among all the cut points
+	int8_t edge_in_a[2];   // Which edge of triangle_a each end lies on, or -1 if inside it
+	int8_t edge_in_b[2];
+};
+
+// A piece of a cut triangle.
+class fragment
+{
+public:
+	indexed_triangle triangle;
+	uint8_t cut_edges;
+};
+
+class edge_record
+{
+public:
+	mesh_index lo;
+	mesh_index hi;
+	mesh_index node;
+
+	inline bool operator<(const edge_record &right) const
+	{
+		if(lo != right.lo)
+			return lo < right.lo;
+
+		if(hi != right.hi)
+			return hi < right.hi;
+
+		return node < right.node;
+	}
+};
+
+class split_job
+{
+public:
+	bool second;       // A triangle of b, rather than of a
+	size_t first;      // Range in the order of cuts for that operand
+	size_t last;
+	size_t thread_index; // Where the pieces went
+	size_t begin;
+	size_t end;
+};
+
+
+bool boolean_operand::init(const indexed_mesh &mesh)
+{
+	clear();
+
+	vertex_welder welder(mesh.vertices.size());
+	vector<mesh_index> remap(mesh.vertices.size());
+
+	for(size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const size_t index = welder.weld(mesh.vertices[i]);
+
+		if(index == vertices.size())
+			vertices.push_back(mesh.vertices[i]);
+
+		remap[i] = static_cast<mesh_index>(index);
+	}
+
+	triangles.reserve(mesh.triangles.size());
+	collinear.reserve(mesh.triangles.size());
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		indexed_triangle t;
+
+		for(size_t j = 0; j < 3; j++)
+			t.vertex_indices[j] = remap[mesh.triangles[i].vertex_indices[j]];
+
+		if(t.vertex_indices[0] == t.vertex_indices[1] || t.vertex_indices[1] == t.vertex_indices[2] || t.vertex_indices[2] == t.vertex_indices[0])
+			continue;
+
+		triangles.push_back(t);
+		collinear.push_back(::collinear(vertices[t.vertex_indices[0]], vertices[t.vertex_indices[1]], vertices[t.vertex_indices[2]]) ? 1 : 0);
+	}
+
+	return tree.build(vertices, triangles);
+}
+
+void boolean_operand::clear(void)
+{
+	vertices.clear();
+	triangles.clear();
+	collinear.clear();
+	tree.clear();
+}
+
+
+// The narrow phase for one pair. Returns true, with the segment in cut, if the triangles cross.
+// irregular is set if they seem to cross but not along one segment.
+static bool cut_triangle_pair(const boolean_operand &a, const boolean_operand &b, const mesh_index triangle_a, const mesh_index triangle_b, pair_cut &cut, bool &irregular)
+{
+	const bool a_flat = (0 != a.collinear[triangle_a]);
+	const bool b_flat = (0 != b.collinear[triangle_b]);
+
+	if(true == a_flat && true == b_flat)
+		return false;
+
+	const mesh_index *ia = a.triangles[triangle_a].vertex_indices;
+	const mesh_index *ib = b.triangles[triangle_b].vertex_indices;
+	const vertex_3 *pa[3] = { &a.vertices[ia[0]], &a.vertices[ia[1]], &a.vertices[ia[2]] };
+	const vertex_3 *pb[3] = { &b.vertices[ib[0]], &b.vertices[ib[1]], &b.vertices[ib[2]] };
+
+	// Which side of the other's plane each corner is on. Never zero, unless the plane is not defined.
+	int side_a[3] = { 0, 0, 0 }, side_b[3] = { 0, 0, 0 };
+
+	if(false == b_flat)
+	{
+		for(size_t i = 0; i < 3; i++)
+			side_a[i] = orient3d(*pb[0], *pb[1], *pb[2], *pa[i], moved_triangle);
+
+		if(side_a[0] == side_a[1] && side_a[1] == side_a[2])
+			return false;
+	}
+
+	if(false == a_flat)
+	{
+		for(size_t i = 0; i < 3; i++)
+			side_b[i] = orient3d(*pa[0], *pa[1], *pa[2], *pb[i], moved_point);
+
+		if(side_b[0] == side_b[1] && side_b[1] == side_b[2])
+			return false;
+	}
+
+	size_t count = 0;
+
+	// Edges of the triangle of a that pass through the triangle of b...
+	if(false == b_flat)
+	{
+		for(int m = 0; m < 3; m++)
+		{
+			const int n = (m + 1) % 3;
+
+			if(side_a[m] == side_a[n])
+				continue;
+
+			const int lo = (ia[m] < ia[n]) ? m : n, hi = (lo == m) ? n : m;
+
+			const int o0 = orient3d(*pa[lo], *pa[hi], *pb[0], *pb[1], moved_face_edge);
+			const int o1 = orient3d(*pa[lo], *pa[hi], *pb[1], *pb[2], moved_face_edge);
+			const int o2 = orient3d(*pa[lo], *pa[hi], *pb[2], *pb[0], moved_face_edge);
+
+			if(o0 != o1 || o1 != o2)
+				continue;
+
+			if(count < 2)
+			{
+				cut.ends[count].kind = 0;
+				cut.ends[count].face = triangle_b;
+				cut.ends[count].lo = ia[lo];
+				cut.ends[count].hi = ia[hi];
+				cut.edge_in_a[count] = static_cast<int8_t>(m);
+				cut.edge_in_b[count] = -1;
+			}
+
+			count++;
+		}
+	}
+
+	// ... and the other way around.
+	if(false == a_flat)
+	{
+		for(int m = 0; m < 3; m++)
+		{
+			const int n = (m + 1) % 3;
+
+			if(side_b[m] == side_b[n])
+				continue;
+
+			const int lo = (ib[m] < ib[n]) ? m : n, hi = (lo == m) ? n : m;
+
+			const int o0 = orient3d(*pb[lo], *pb[hi], *pa[0], *pa[1], moved_edge);
+			const int o1 = orient3d(*pb[lo], *pb[hi], *pa[1], *pa[2], moved_edge);
+			const int o2 = orient3d(*pb[lo], *pb[hi], *pa[2], *pa[0], moved_edge);
+
+			if(o0 != o1 || o1 != o2)
+				continue;
+
+			if(count < 2)
+			{
+				cut.ends[count].kind = 1;
+				cut.ends[count].face = triangle_a;
+				cut.ends[count].lo = ib[lo];
+				cut.ends[count].hi = ib[hi];
+				cut.edge_in_a[count] = -1;
+				cut.edge_in_b[count] = static_cast<int8_t>(m);
+			}
+
+			count++;
+		}
+	}
+
+	if(0 == count)
+		return false;
+
+	if(2 != count)
+	{
+		irregular = true;
+		return false;
+	}
+
+	cut.triangle_a = triangle_a;
+	cut.triangle_b = triangle_b;
+
+	return true;
+}
+
+static void narrow_phase(const boolean_operand &a, const boolean_operand &b, const vector<triangle_pair> &pairs, vector< vector<pair_cut> > &chunk_cuts, vector<size_t> &chunk_irregular, atomic<size_t> &next_chunk)
+{
+	for(size_t c = next_chunk++; c < chunk_cuts.size(); c = next_chunk++)
+	{
+		const size_t first = c*narrow_phase_chunk_size;
+		const size_t last = (first + narrow_phase_chunk_size < pairs.size()) ? first + narrow_phase_chunk_size : pairs.size();
+
+		for(size_t i = first; i < last; i++)
+		{
+			pair_cut cut;
+			bool irregular = false;
+
+			if(true == cut_triangle_pair(a, b, pairs[i].triangle_a, pairs[i].triangle_b, cut, irregular))
+				chunk_cuts[c].push_back(cut);
+			else if(true == irregular)
+				chunk_irregular[c]++;
+		}
+	}
+}
+
+// The point where a cut key's edge passes through its triangle. In the frame of a, b is the
+// one translated; in the frame of b, a is translated the opposite way.
+static void make_cut_point(const boolean_operand &a, const boolean_operand &b, const cut_key &key, const bool frame_of_b, implicit_point &point)
+{
+	if(0 == key.kind)
+	{
+		const mesh_index *f = b.triangles[key.face].vertex_indices;
+		point.set(a.vertices[key.lo], a.vertices[key.hi], frame_of_b ? -1 : 0, b.vertices[f[0]], b.vertices[f[1]], b.vertices[f[2]], frame_of_b ? 0 : 1);
+	}
+	else
+	{
+		const mesh_index *f = a.triangles[key.face].vertex_indices;
+		point.set(b.vertices[key.lo], b.vertices[key.hi], frame_of_b ? 0 : 1, a.vertices[f[0]], a.vertices[f[1]], a.vertices[f[2]], frame_of_b ? -1 : 0);
+	}
+}
+
+class pair_cut_by_b
+{
+public:
+	pair_cut_by_b(const vector<pair_cut> &src_cuts) : cuts(src_cuts) { /* custom constructor */ }
+
+	inline bool operator()(const size_t left, const size_t right) const
+	{
+		if(cuts[left].triangle_b != cuts[right].triangle_b)
+			return cuts[left].triangle_b < cuts[right].triangle_b;
+
+		return left < right;
+	}
+
+	const vector<pair_cut> &cuts;
+};
+
+class cut_id_less
+{
+public:
+	inline bool operator()(const cut_point &left, const cut_point &right) const
+	{
+		return left.id < right.id;
+	}
+};
+
+class cut_id_equal
+{
+public:
+	inline bool operator()(const cut_point &left, const cut_point &right) const
+	{
+		return left.id == right.id;
+	}
+};
+
+// Splits cut triangles, taking the next unclaimed one each time, and appends the pieces to
+// this thread's own list.
+static void split_triangles(const boolean_operand &a, const boolean_operand &b, const vector<pair_cut> &cuts, const vector<size_t> &order_b, const mesh_index first_cut_id, vector<split_job> &jobs, const size_t thread_index, vector<fragment> &fragments, atomic<size_t> &next_job, atomic<size_t> &unrecovered)
+{
+	cut_triangulator triangulator;
+	vector<cut_point> points;
+	vector<size_t> segments;
+	vector<indexed_triangle> pieces;
+	vector<uint8_t> cut_edges;
+
+	for(size_t j = next_job++; j < jobs.size(); j = next_job++)
+	{
+		split_job &job = jobs[j];
+		const boolean_operand &operand = (true == job.second) ? b : a;
+		const mesh_index id_offset = (true == job.second) ? static_cast<mesh_index>(a.vertices.size()) : 0;
+
+		points.clear();
+
+		for(size_t i = job.first; i < job.last; i++)
+		{
+			const pair_cut &cut = (true == job.second) ? cuts[order_b[i]] : cuts[i];
+
+			for(size_t k = 0; k < 2; k++)
+			{
+				cut_point p;
+				p.id = first_cut_id + cut.ids[k];
+				p.edge = (true == job.second) ? cut.edge_in_b[k] : cut.edge_in_a[k];
+				make_cut_point(a, b, cut.ends[k], job.second, p.point);
+				points.push_back(p);
+			}
+		}
+
+		sort(points.begin(), points.end(), cut_id_less());
+		points.erase(unique(points.begin(), points.end(), cut_id_equal()), points.end());
+
+		segments.clear();
+
+		for(size_t i = job.first; i < job.last; i++)
+		{
+			const pair_cut &cut = (true == job.second) ? cuts[order_b[i]] : cuts[i];
+
+			for(size_t k = 0; k < 2; k++)
+			{
+				cut_point key;
+				key.id = first_cut_id + cut.ids[k];
+				segments.push_back(lower_bound(points.begin(), points.end(), key, cut_id_less()) - points.begin());
+			}
+		}
+
+		const pair_cut &first_cut = (true == job.second) ? cuts[order_b[job.first]] : cuts[job.first];
+		const mesh_index source = (true == job.second) ? first_cut.triangle_b : first_cut.triangle_a;
+		const mesh_index *corner_indices = operand.triangles[source].vertex_indices;
+
+		const vertex_3 corners[3] = { operand.vertices[corner_indices[0]], operand.vertices[corner_indices[1]], operand.vertices[corner_indices[2]] };
+		const mesh_index corner_ids[3] = { id_offset + corner_indices[0], id_offset + corner_indices[1], id_offset + corner_indices[2] };
+
+		pieces.clear();
+		cut_edges.clear();
+
+		if(false == triangulator.triangulate(corners, corner_ids, 0 != operand.collinear[source], points, segments, pieces, cut_edges))
+			unrecovered++;
+
+		job.thread_index = thread_index;
+		job.begin = fragments.size();
+
+		for(size_t i = 0; i < pieces.size(); i++)
+		{
+			fragment f;
+			f.triangle = pieces[i];
+			f.cut_edges = cut_edges[i];
+			fragments.push_back(f);
+		}
+
+		job.end = fragments.size();
+	}
+}
+
+static inline mesh_index find_root(vector<mesh_index> &parent, mesh_index i)
+{
+	while(parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+
+	return i;
+}
+
+static inline void join(vector<mesh_index> &parent, const mesh_index i, const mesh_index j)
+{
+	const mesh_index ri = find_root(parent, i), rj = find_root(parent, j);
+
+	if(ri < rj)
+		parent[rj] = ri;
+	else if(rj < ri)
+		parent[ri] = rj;
+}
+
+// The winding number of the mesh under tree around point o, counted along the ray from o in +x.
+// tree_moved says whether the tree's mesh or the point's is the translated one.
+static int winding_number(const triangle_bvh &tree, const vertex_3 &o, const bool tree_moved, vector<uint32_t> &stack)
+{
+	const unsigned int edge_mask = (true == tree_moved) ? 0x3 : 0x4;
+	const unsigned int side_mask = (true == tree_moved) ? moved_triangle : moved_point;
+
+	int winding = 0;
+
+	stack.clear();
+	stack.push_back(0);
+
+	while(0 != stack.size())
+	{
+		const bvh_node &node = tree.nodes[stack.back()];
+		const uint32_t node_index = stack.back();
+		stack.pop_back();
+
+		if(node.max[0] < o.x || node.min[1] > o.y || node.max[1] < o.y || node.min[2] > o.z || node.max[2] < o.z)
+			continue;
+
+		if(false == node.is_leaf())
+		{
+			stack.push_back(node.offset);
+			stack.push_back(node_index + 1);
+			continue;
+		}
+
+		for(size_t slot = node.offset; slot < node.offset + node.count; slot++)
+		{
+			const vertex_3 *v = tree.slot_vertices(slot);
+
+			// The sign of the triangle's normal along x; zero if the ray runs along it.
+			const int facing = orient2d_yz(v[0], v[1], v[2], 0);
+
+			if(0 == facing)
+				continue;
+
+			if(facing != orient2d_yz(v[0], v[1], o, edge_mask) ||
+			   facing != orient2d_yz(v[1], v[2], o, edge_mask) ||
+			   facing != orient2d_yz(v[2], v[0], o, edge_mask))
+				continue;
+
+			// Crossed ahead of o, rather than behind it.
+			if(facing != orient3d(v[0], v[1], v[2], o, side_mask))
+				winding += facing;
+		}
+	}
+
+	return winding;
+}
+
+class ray_seed
+{
+public:
+	mesh_index root;
+	mesh_index vertex;
+	uint8_t inside;
+};
+
+static void cast_rays(const boolean_operand &self, const triangle_bvh &other_tree, const bool other_moved, vector<ray_seed> &seeds, atomic<size_t> &next_seed)
+{
+	vector<uint32_t> stack;
+
+	for(size_t i = next_seed++; i < seeds.size(); i = next_seed++)
+		seeds[i].inside = (winding_number(other_tree, self.vertices[seeds[i].vertex], other_moved, stack) > 0) ? 1 : 0;
+}
+
+// Whether each triangle (and piece of a cut triangle) of self is inside the other operand.
+static void classify(const boolean_operand &self, const triangle_bvh &other_tree, const bool self_is_second, const vector<uint8_t> &is_cut, const vector<fragment> &fragments, const mesh_index id_offset, const mesh_index first_cut_id, vector<uint8_t> &triangle_inside, vector<uint8_t> &fragment_inside, const size_t num_threads)
+{
+	const mesh_index num_vertices = static_cast<mesh_index>(self.vertices.size());
+	vector<mesh_index> parent(num_vertices + fragments.size());
+
+	for(size_t i = 0; i < parent.size(); i++)
+		parent[i] = static_cast<mesh_index>(i);
+
+	vector<uint8_t> used(num_vertices, 0);
+
+	// No cut passes through one of the mesh's own vertices, so each vertex is on one patch
+	// with every triangle around it.
+	for(size_t i = 0; i < self.triangles.size(); i++)
+	{
+		if(0 != is_cut[i])
+			continue;
+
+		const mesh_index *v = self.triangles[i].vertex_indices;
+		join(parent, v[0], v[1]);
+		join(parent, v[0], v[2]);
+		used[v[0]] = used[v[1]] = used[v[2]] = 1;
+	}
+
+	vector<edge_record> open_edges, cut_edges;
+
+	for(size_t i = 0; i < fragments.size(); i++)
+	{
+		const mesh_index node = static_cast<mesh_index>(num_vertices + i);
+		const mesh_index *v = fragments[i].triangle.vertex_indices;
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			if(v[k] < first_cut_id)
+			{
+				join(parent, node, v[k] - id_offset);
+				used[v[k] - id_offset] = 1;
+				continue;
+			}
+
+			const mesh_index w = v[(k + 1) % 3];
+
+			if(w < first_cut_id)
+				continue;
+
+			edge_record e;
+			e.lo = (v[k] < w) ? v[k] : w;
+			e.hi = (v[k] < w) ? w : v[k];
+			e.node = node;
+
+			if(0 != (fragments[i].cut_edges & (1 << k)))
+				cut_edges.push_back(e);
+			else
+				open_edges.push_back(e);
+		}
+	}
+
+	// Pieces that meet along an edge between two new points, which is not a cut, are on one patch.
+	sort(open_edges.begin(), open_edges.end());
+
+	for(size_t i = 1; i < open_edges.size(); i++)
+		if(open_edges[i].lo == open_edges[i - 1].lo && open_edges[i].hi == open_edges[i - 1].hi)
+			join(parent, open_edges[i].node, open_edges[i - 1].node);
+
+	// One ray per patch that has a vertex of its own.
+	vector<int> label(parent.size(), -1);
+	vector<ray_seed> seeds;
+
+	for(mesh_index i = 0; i < num_vertices; i++)
+	{
+		if(0 == used[i])
+			continue;
+
+		const mesh_index root = find_root(parent, i);
+
+		if(-1 != label[root])
+			continue;
+
+		label[root] = 0;
+
+		ray_seed s;
+		s.root = root;
+		s.vertex = i;
+		s.inside = 0;
+		seeds.push_back(s);
+	}
+
+	atomic<size_t> next_seed(0);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < num_threads && t < seeds.size(); t++)
+		threads.push_back(thread(cast_rays, cref(self), cref(other_tree), !self_is_second, ref(seeds), ref(next_seed)));
+
+	cast_rays(self, other_tree, !self_is_second, seeds, next_seed);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	for(size_t i = 0; i < seeds.size(); i++)
+		label[seeds[i].root] = seeds[i].inside;
+
+	// The rest are across a cut from a patch that is classified, and so on the other side.
+	sort(cut_edges.begin(), cut_edges.end());
+
+	vector<mesh_index> neighbours;
+
+	for(size_t i = 1; i < cut_edges.size(); i++)
+	{
+		if(cut_edges[i].lo == cut_edges[i - 1].lo && cut_edges[i].hi == cut_edges[i - 1].hi)
+		{
+			neighbours.push_back(find_root(parent, cut_edges[i - 1].node));
+			neighbours.push_back(find_root(parent, cut_edges[i].node));
+		}
+	}
+
+	for(bool changed = true; true == changed; )
+	{
+		changed = false;
+
+		for(size_t i = 0; i < neighbours.size(); i += 2)
+		{
+			const mesh_index p = neighbours[i], q = neighbours[i + 1];
+
+			if(-1 == label[p] && -1 != label[q])
+			{
+				label[p] = 1 - label[q];
+				changed = true;
+			}
+			else if(-1 == label[q] && -1 != label[p])
+			{
+				label[q] = 1 - label[p];
+				changed = true;
+			}
+		}
+	}
+
+	triangle_inside.assign(self.triangles.size(), 0);
+	fragment_inside.assign(fragments.size(), 0);
+
+	for(size_t i = 0; i < self.triangles.size(); i++)
+		if(0 == is_cut[i])
+			triangle_inside[i] = (1 == label[find_root(parent, self.triangles[i].vertex_indices[0])]) ? 1 : 0;
+
+	for(size_t i = 0; i < fragments.size(); i++)
+		fragment_inside[i] = (1 == label[find_root(parent, static_cast<mesh_index>(num_vertices + i))]) ? 1 : 0;
+}
+
+static void prepare_operand(boolean_operand &operand, const indexed_mesh &mesh, bool &success)
+{
+	success = operand.init(mesh);
+}
+
+
+mesh_boolean::mesh_boolean(void)
+{
+	candidate_pair_count = intersecting_pair_count = cut_point_count = cut_triangle_count = 0;
+	unrecovered_segment_count = irregular_pair_count = 0;
+	broad_phase_time = narrow_phase_time = split_time = classify_time = assemble_time = 0.0;
+}
+
+bool mesh_boolean::compute(const indexed_mesh &a, const indexed_mesh &b, const boolean_operation operation, indexed_mesh &result, const size_t num_threads)
+{
+	boolean_operand operand_a, operand_b;
+	bool success_a = false, success_b = false;
+
+	if(num_threads > 1)
+	{
+		thread t(prepare_operand, ref(operand_a), cref(a), ref(success_a));
+		prepare_operand(operand_b, b, success_b);
+		t.join();
+	}
+	else
+	{
+		prepare_operand(operand_a, a, success_a);
+		prepare_operand(operand_b, b, success_b);
+	}
+
+	if(false == success_a || false == success_b)
+	{
+		cout << "Error: A boolean operand has no triangles" << endl;
+		return false;
+	}
+
+	return compute(operand_a, operand_b, operation, result, num_threads);
+}
+
+bool mesh_boolean::compute(const boolean_operand &a, const boolean_operand &b, const boolean_operation operation, indexed_mesh &result, const size_t num_threads)
+{
+	candidate_pair_count = intersecting_pair_count = cut_point_count = cut_triangle_count = 0;
+	unrecovered_segment_count = irregular_pair_count = 0;
+	broad_phase_time = narrow_phase_time = split_time = classify_time = assemble_time = 0.0;
+
+	result.clear();
+
+	if(true == a.tree.empty() || true == b.tree.empty())
+		return false;
+
+	const size_t thread_count = (num_threads > 1) ? num_threads : 1;
+
+	// Broad phase.
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	vector<triangle_pair> pairs;
+	overlapping_triangle_pairs(a.tree, b.tree, pairs, thread_count);
+	candidate_pair_count = pairs.size();
+
+	broad_phase_time = seconds_since(start);
+
+	// Narrow phase, in chunks that the threads take in turn. Concatenated in chunk order,
+	// the cuts stay sorted by triangle_a, then triangle_b.
+	start = std::chrono::steady_clock::now();
+
+	const size_t num_chunks = (pairs.size() + narrow_phase_chunk_size - 1) / narrow_phase_chunk_size;
+	vector< vector<pair_cut> > chunk_cuts(num_chunks);
+	vector<size_t> chunk_irregular(num_chunks, 0);
+	atomic<size_t> next_chunk(0);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < thread_count && t < num_chunks; t++)
+		threads.push_back(thread(narrow_phase, cref(a), cref(b), cref(pairs), ref(chunk_cuts), ref(chunk_irregular), ref(next_chunk)));
+
+	narrow_phase(a, b, pairs, chunk_cuts, chunk_irregular, next_chunk);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	vector<pair_cut> cuts;
+
+	for(size_t c = 0; c < num_chunks; c++)
+	{
+		cuts.insert(cuts.end(), chunk_cuts[c].begin(), chunk_cuts[c].end());
+		irregular_pair_count += chunk_irregular[c];
+		vector<pair_cut>().swap(chunk_cuts[c]);
+	}
+
+	vector<triangle_pair>().swap(pairs);
+	intersecting_pair_count = cuts.size();
+
+	// Number the cut points, and work out where they are.
+	vector<cut_key> keys;
+	keys.reserve(2*cuts.size());
+
+	for(size_t i = 0; i < cuts.size(); i++)
+	{
+		keys.push_back(cuts[i].ends[0]);
+		keys.push_back(cuts[i].ends[1]);
+	}
+
+	sort(keys.begin(), keys.end());
+	keys.erase(unique(keys.begin(), keys.end()), keys.end());
+	cut_point_count = keys.size();
+
+	for(size_t i = 0; i < cuts.size(); i++)
+		for(size_t k = 0; k < 2; k++)
+			cuts[i].ids[k] = static_cast<mesh_index>(lower_bound(keys.begin(), keys.end(), cuts[i].ends[k]) - keys.begin());
+
+	// Rounded, where the output needs them.
+	vector<vertex_3> positions(keys.size());
+
+	for(size_t i = 0; i < keys.size(); i++)
+	{
+		implicit_point p;
+		make_cut_point(a, b, keys[i], false, p);
+		positions[i] = vertex_3(static_cast<float>(p.position[0]), static_cast<float>(p.position[1]), static_cast<float>(p.position[2]));
+	}
+
+	vector<cut_key>().swap(keys);
+
+	narrow_phase_time = seconds_since(start);
+
+	// Split every cut triangle.
+	start = std::chrono::steady_clock::now();
+
+	const mesh_index first_cut_id = static_cast<mesh_index>(a.vertices.size() + b.vertices.size());
+
+	vector<size_t> order_b(cuts.size());
+
+	for(size_t i = 0; i < order_b.size(); i++)
+		order_b[i] = i;
+
+	sort(order_b.begin(), order_b.end(), pair_cut_by_b(cuts));
+
+	vector<uint8_t> is_cut_a(a.triangles.size(), 0), is_cut_b(b.triangles.size(), 0);
+	vector<split_job> jobs;
+
+	for(size_t i = 0; i < cuts.size(); )
+	{
+		split_job job;
+		job.second = false;
+		job.first = i;
+
+		while(i < cuts.size() && cuts[i].triangle_a == cuts[job.first].triangle_a)
+			i++;
+
+		job.last = i;
+		job.thread_index = job.begin = job.end = 0;
+		jobs.push_back(job);
+		is_cut_a[cuts[job.first].triangle_a] = 1;
+	}
+
+	const size_t num_jobs_a = jobs.size();
+
+	for(size_t i = 0; i < order_b.size(); )
+	{
+		split_job job;
+		job.second = true;
+		job.first = i;
+
+		while(i < order_b.size() && cuts[order_b[i]].triangle_b == cuts[order_b[job.first]].triangle_b)
+			i++;
+
+		job.last = i;
+		job.thread_index = job.begin = job.end = 0;
+		jobs.push_back(job);
+		is_cut_b[cuts[order_b[job.first]].triangle_b] = 1;
+	}
+
+	cut_triangle_count = jobs.size();
+
+	vector< vector<fragment> > thread_fragments(thread_count);
+	atomic<size_t> next_job(0), unrecovered(0);
+
+	for(size_t t = 1; t < thread_count && t < jobs.size(); t++)
+		threads.push_back(thread(split_triangles, cref(a), cref(b), cref(cuts), cref(order_b), first_cut_id, ref(jobs), t, ref(thread_fragments[t]), ref(next_job), ref(unrecovered)));
+
+	split_triangles(a, b, cuts, order_b, first_cut_id, jobs, 0, thread_fragments[0], next_job, unrecovered);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	unrecovered_segment_count = unrecovered;
+
+	// Gathered in job order, so the output does not depend on which thread split what.
+	vector<fragment> fragments_a, fragments_b;
+
+	for(size_t j = 0; j < jobs.size(); j++)
+	{
+		const vector<fragment> &from = thread_fragments[jobs[j].thread_index];
+		vector<fragment> &to = (j < num_jobs_a) ? fragments_a : fragments_b;
+
+		to.insert(to.end(), from.begin() + jobs[j].begin, from.begin() + jobs[j].end);
+	}
+
+	vector< vector<fragment> >().swap(thread_fragments);
+	vector<split_job>().swap(jobs);
+	vector<size_t>().swap(order_b);
+	vector<pair_cut>().swap(cuts);
+
+	split_time = seconds_since(start);
+
+	if(0 != unrecovered_segment_count)
+		cout << "Warning: " << unrecovered_segment_count << " cut triangles could not be split along every cut; the result may not be closed" << endl;
+
+	// Inside or outside.
+	start = std::chrono::steady_clock::now();
+
+	vector<uint8_t> inside_a, fragment_inside_a, inside_b, fragment_inside_b;
+
+	classify(a, b.tree, false, is_cut_a, fragments_a, 0, first_cut_id, inside_a, fragment_inside_a, thread_count);
+	classify(b, a.tree, true, is_cut_b, fragments_b, static_cast<mesh_index>(a.vertices.size()), first_cut_id, inside_b, fragment_inside_b, thread_count);
+
+	classify_time = seconds_since(start);
+
+	// Keep what the operation keeps, and number the vertices that are used.
+	start = std::chrono::steady_clock::now();
+
+	const uint8_t keep_a = (BOOLEAN_INTERSECTION == operation) ? 1 : 0;
+	const uint8_t keep_b = (BOOLEAN_UNION == operation) ? 0 : 1;
+	const bool flip_b = (BOOLEAN_DIFFERENCE == operation);
+	const mesh_index offset_b = static_cast<mesh_index>(a.vertices.size());
+
+	vector<indexed_triangle> &out = result.triangles;
+
+	for(size_t i = 0; i < a.triangles.size(); i++)
+		if(0 == is_cut_a[i] && keep_a == inside_a[i])
+			out.push_back(a.triangles[i]);
+
+	for(size_t i = 0; i < fragments_a.size(); i++)
+		if(keep_a == fragment_inside_a[i])
+			out.push_back(fragments_a[i].triangle);
+
+	const size_t first_b = out.size();
+
+	for(size_t i = 0; i < b.triangles.size(); i++)
+	{
+		if(0 != is_cut_b[i] || keep_b != inside_b[i])
+			continue;
+
+		indexed_triangle t = b.triangles[i];
+
+		for(size_t k = 0; k < 3; k++)
+			t.vertex_indices[k] += offset_b;
+
+		out.push_back(t);
+	}
+
+	for(size_t i = 0; i < fragments_b.size(); i++)
+		if(keep_b == fragment_inside_b[i])
+			out.push_back(fragments_b[i].triangle);
+
+	if(true == flip_b)
+		for(size_t i = first_b; i < out.size(); i++)
+			swap(out[i].vertex_indices[1], out[i].vertex_indices[2]);
+
+	vector<mesh_index> new_index(first_cut_id + cut_point_count, 0);
+
+	for(size_t i = 0; i < out.size(); i++)
+		for(size_t k = 0; k < 3; k++)
+			new_index[out[i].vertex_indices[k]] = 1;
+
+	for(size_t i = 0; i < new_index.size(); i++)
+	{
+		if(0 == new_index[i])
+			continue;
+
+		new_index[i] = static_cast<mesh_index>(result.vertices.size() + 1);
+
+		if(i < a.vertices.size())
+			result.vertices.push_back(a.vertices[i]);
+		else if(i < first_cut_id)
+			result.vertices.push_back(b.vertices[i - a.vertices.size()]);
+		else
+			result.vertices.push_back(positions[i - first_cut_id]);
+	}
+
+	for(size_t i = 0; i < out.size(); i++)
+		for(size_t k = 0; k < 3; k++)
+			out[i].vertex_indices[k] = new_index[out[i].vertex_indices[k]] - 1;
+
+	result.generate_adjacency(thread_count);
+
+	assemble_time = seconds_since(start);
+
+	return true;
+}
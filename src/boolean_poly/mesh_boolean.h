@@ -0,0 +1,84 @@
+#ifndef MESH_BOOLEAN_H
+#define MESH_BOOLEAN_H
+
+#include "triangle_bvh.h"
+#include "cut_triangulator.h"
+#include "../common/mesh.h"
+
+#include <vector>
+using std::vector;
+
+
+enum boolean_operation
+{
+	BOOLEAN_UNION,
+	BOOLEAN_INTERSECTION,
+	BOOLEAN_DIFFERENCE   // The first operand minus the second
+};
+
+// One side of a boolean: a closed, consistently wound mesh with its vertices welded
+// exactly, its tree, and which of its triangles have no area. Preparing an operand costs
+// about as much as the boolean itself, so a mesh that takes part in several booleans
+// (e.g. a bone that several implants are tried against) should be prepared once.
+class boolean_operand
+{
+public:
+	// Returns false if the mesh has no triangles with three distinct corners.
+	bool init(const indexed_mesh &mesh);
+	void clear(void);
+
+	vector<vertex_3> vertices;
+	vector<indexed_triangle> triangles;
+	vector<uint8_t> collinear;   // Per triangle: its corners lie on one line
+	triangle_bvh tree;
+};
+
+// Union, intersection and difference of two closed meshes.
+//
+// The broad phase is the parallel tree walk of overlapping_triangle_pairs(). For each pair
+// of triangles whose boxes overlap, exact predicates (see exact_predicates.h) decide which
+// edges of one pass through the other, and so where the segment that the two triangles
+// cross along begins and ends. Each end is named combinatorially -- an edge of one mesh and
+// a triangle of the other -- so the triangles on both sides of an edge agree on every point
+// they share without comparing coordinates. Each cut triangle is then split along its
+// segments by a cut_triangulator, in parallel.
+//
+// The cuts divide each mesh into patches. Every patch that keeps one of the mesh's own
+// vertices is classified by the winding number of the other mesh around that vertex,
+// counted exactly along a ray in +x; the rest take the opposite side to the patch across a
+// cut from them. The result is the patches the operation keeps, with the second mesh's
+// triangles turned over for a difference.
+//
+// Every decision is exact, with the second mesh treated as if translated by an infinitely
+// small amount (simulation of simplicity). Faces that coincide, or nearly do, as on two
+// marching cubes surfaces taken from the same grid, therefore never meet edge on or face to
+// face: the result is the one that a tiny nudge of the second mesh would give, and it is
+// closed whenever the inputs are. Only the positions of the new vertices are rounded.
+class mesh_boolean
+{
+public:
+	mesh_boolean(void);
+
+	bool compute(const boolean_operand &a, const boolean_operand &b, const boolean_operation operation, indexed_mesh &result, const size_t num_threads = 1);
+
+	// Prepares both operands (in parallel, given two or more threads), then computes.
+	bool compute(const indexed_mesh &a, const indexed_mesh &b, const boolean_operation operation, indexed_mesh &result, const size_t num_threads = 1);
+
+	// Counts from the last compute().
+	size_t candidate_pair_count;     // Pairs of triangles with overlapping boxes
+	size_t intersecting_pair_count;  // Pairs that cross
+	size_t cut_point_count;          // New vertices where edges of one mesh pass through the other
+	size_t cut_triangle_count;       // Triangles of either mesh that were split
+	size_t unrecovered_segment_count; // Cuts that could not be made edges; non-zero means the result may leak
+	size_t irregular_pair_count;     // Pairs whose cut did not come out as one segment (the inputs are not closed)
+
+	// Seconds spent in each phase of the last compute().
+	double broad_phase_time;
+	double narrow_phase_time;
+	double split_time;
+	double classify_time;
+	double assemble_time;
+};
+
+
+#endif
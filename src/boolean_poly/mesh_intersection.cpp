@@ -0,0 +1,345 @@
+#include "mesh_intersection.h"
+#include "triangle_batch.h"
+
+#include <algorithm>
+using std::sort;
+
+#include <atomic>
+using std::atomic;
+
+#include <thread>
+using std::thread;
+
+#include <functional>
+using std::ref;
+using std::cref;
+
+
+class node_pair
+{
+public:
+	node_pair(const uint32_t src_a, const uint32_t src_b) : a(src_a), b(src_b) { /* custom constructor */ }
+
+	uint32_t a;
+	uint32_t b;
+};
+
+// The two pairs that replace an overlapping pair of nodes, at least one of which is interior:
+// the children of whichever is interior and larger, each paired with the other node.
+static inline void split_pair(const triangle_bvh &tree_a, const triangle_bvh &tree_b, const node_pair &p, node_pair &first, node_pair &second)
+{
+	const bvh_node &a = tree_a.nodes[p.a];
+	const bvh_node &b = tree_b.nodes[p.b];
+
+	if(true == b.is_leaf() || (false == a.is_leaf() && a.half_area() >= b.half_area()))
+	{
+		first = node_pair(p.a + 1, p.b);
+		second = node_pair(a.offset, p.b);
+	}
+	else
+	{
+		first = node_pair(p.a, p.b + 1);
+		second = node_pair(p.a, b.offset);
+	}
+}
+
+static inline void triangle_bounds(const vertex_3 *v, float min[3], float max[3])
+{
+	min[0] = max[0] = v[0].x;
+	min[1] = max[1] = v[0].y;
+	min[2] = max[2] = v[0].z;
+
+	for(size_t i = 1; i < 3; i++)
+	{
+		const float c[3] = { v[i].x, v[i].y, v[i].z };
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			if(c[k] < min[k])
+				min[k] = c[k];
+
+			if(c[k] > max[k])
+				max[k] = c[k];
+		}
+	}
+}
+
+// Pairs of triangles whose boxes overlap, waiting for the narrow phase, which
+// classify_triangle_pairs() runs a packet at a time. Only the pairs it does not find
+// apart are then tested one by one, for their segments.
+class pending_pairs
+{
+public:
+	pending_pairs(void) : count(0) { /* custom constructor */ }
+
+	triangle_pair_packet packet;
+	mesh_index triangles_a[triangle_pair_packet::size];
+	mesh_index triangles_b[triangle_pair_packet::size];
+	const vertex_3 *vertices_a[triangle_pair_packet::size];
+	const vertex_3 *vertices_b[triangle_pair_packet::size];
+	size_t count;
+};
+
+// Runs the narrow phase on the pending pairs, and records those that pass. With
+// stop_at_first nothing is recorded. Returns true if any pair passed.
+static bool flush_pairs(pending_pairs &pending, vector<triangle_contact> &contacts, const bool stop_at_first)
+{
+	triangle_intersection results[triangle_pair_packet::size];
+	classify_triangle_pairs(pending.packet, pending.count, results);
+
+	const size_t count = pending.count;
+	pending.count = 0;
+
+	bool found = false;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		if(TRIANGLES_DISJOINT == results[i])
+			continue;
+
+		found = true;
+
+		if(true == stop_at_first)
+			return true;
+
+		triangle_contact c;
+		c.triangle_a = pending.triangles_a[i];
+		c.triangle_b = pending.triangles_b[i];
+		c.coplanar = (TRIANGLES_COPLANAR == intersect_triangles(pending.vertices_a[i], pending.vertices_b[i], c.segment_start, c.segment_end));
+		contacts.push_back(c);
+	}
+
+	return found;
+}
+
+// The broad phase only: nothing is ever pending.
+static inline bool flush_pairs(pending_pairs &, vector<triangle_pair> &, const bool)
+{
+	return false;
+}
+
+// Queues a pair whose boxes overlap, running the narrow phase once a packet is full.
+// Returns true if any pair passed.
+static inline bool add_pair(pending_pairs &pending, const vertex_3 *va, const vertex_3 *vb, const mesh_index triangle_a, const mesh_index triangle_b, vector<triangle_contact> &contacts, const bool stop_at_first)
+{
+	pending.packet.set(pending.count, va, vb);
+	pending.triangles_a[pending.count] = triangle_a;
+	pending.triangles_b[pending.count] = triangle_b;
+	pending.vertices_a[pending.count] = va;
+	pending.vertices_b[pending.count] = vb;
+	pending.count++;
+
+	if(triangle_pair_packet::size == pending.count)
+		return flush_pairs(pending, contacts, stop_at_first);
+
+	return false;
+}
+
+// The broad phase only: overlapping boxes are enough.
+static inline bool add_pair(pending_pairs &, const vertex_3 *, const vertex_3 *, const mesh_index triangle_a, const mesh_index triangle_b, vector<triangle_pair> &pairs, const bool stop_at_first)
+{
+	if(false == stop_at_first)
+	{
+		triangle_pair p;
+		p.triangle_a = triangle_a;
+		p.triangle_b = triangle_b;
+		pairs.push_back(p);
+	}
+
+	return true;
+}
+
+// Queues the pairs of triangles of two leaves whose bounding boxes overlap. Returns true
+// if any pair was recorded.
+template<class T>
+static bool intersect_leaves(const triangle_bvh &tree_a, const triangle_bvh &tree_b, const bvh_node &a, const bvh_node &b, pending_pairs &pending, vector<T> &found_pairs, const bool stop_at_first)
+{
+	bool found = false;
+
+	float b_min[triangle_bvh::max_leaf_size][3], b_max[triangle_bvh::max_leaf_size][3];
+
+	for(size_t j = 0; j < b.count; j++)
+		triangle_bounds(tree_b.slot_vertices(b.offset + j), b_min[j], b_max[j]);
+
+	for(size_t i = a.offset; i < a.offset + a.count; i++)
+	{
+		const vertex_3 *va = tree_a.slot_vertices(i);
+
+		float a_min[3], a_max[3];
+		triangle_bounds(va, a_min, a_max);
+
+		for(size_t j = 0; j < b.count; j++)
+		{
+			if(a_min[0] > b_max[j][0] || b_min[j][0] > a_max[0] ||
+			   a_min[1] > b_max[j][1] || b_min[j][1] > a_max[1] ||
+			   a_min[2] > b_max[j][2] || b_min[j][2] > a_max[2])
+				continue;
+
+			if(false == add_pair(pending, va, tree_b.slot_vertices(b.offset + j), tree_a.triangle_indices[i], tree_b.triangle_indices[b.offset + j], found_pairs, stop_at_first))
+				continue;
+
+			found = true;
+
+			if(true == stop_at_first)
+				return true;
+		}
+	}
+
+	return found;
+}
+
+// Walks the two subtrees under a pair of nodes, depth first, with an explicit stack.
+template<class T>
+static bool intersect_subtrees(const triangle_bvh &tree_a, const triangle_bvh &tree_b, const node_pair &start, vector<node_pair> &stack, vector<T> &found_pairs, const bool stop_at_first)
+{
+	bool found = false;
+	pending_pairs pending;
+
+	stack.clear();
+	stack.push_back(start);
+
+	while(0 != stack.size())
+	{
+		const node_pair p = stack.back();
+		stack.pop_back();
+
+		const bvh_node &a = tree_a.nodes[p.a];
+		const bvh_node &b = tree_b.nodes[p.b];
+
+		if(false == a.overlaps(b))
+			continue;
+
+		if(true == a.is_leaf() && true == b.is_leaf())
+		{
+			if(true == intersect_leaves(tree_a, tree_b, a, b, pending, found_pairs, stop_at_first))
+			{
+				found = true;
+
+				if(true == stop_at_first)
+					return true;
+			}
+
+			continue;
+		}
+
+		node_pair first(0, 0), second(0, 0);
+		split_pair(tree_a, tree_b, p, first, second);
+
+		// Pushed in reverse, so that the first child is walked first.
+		stack.push_back(second);
+		stack.push_back(first);
+	}
+
+	if(0 != pending.count && true == flush_pairs(pending, found_pairs, stop_at_first))
+		found = true;
+
+	return found;
+}
+
+// Walks node pairs, taking the next unclaimed one each time, until there are none left.
+template<class T>
+static void intersect_node_pairs(const triangle_bvh &tree_a, const triangle_bvh &tree_b, const vector<node_pair> &pairs, vector< vector<T> > &pair_results, atomic<size_t> &next_pair)
+{
+	vector<node_pair> stack;
+
+	for(size_t i = next_pair++; i < pairs.size(); i = next_pair++)
+		intersect_subtrees(tree_a, tree_b, pairs[i], stack, pair_results[i], false);
+}
+
+// The whole walk, shared by intersect_meshes() and overlapping_triangle_pairs().
+template<class T>
+static void walk_trees(const triangle_bvh &a, const triangle_bvh &b, vector<T> &found_pairs, const size_t num_threads)
+{
+	found_pairs.clear();
+
+	if(true == a.empty() || true == b.empty())
+		return;
+
+	if(num_threads <= 1)
+	{
+		vector<node_pair> stack;
+		intersect_subtrees(a, b, node_pair(0, 0), stack, found_pairs, false);
+	}
+	else
+	{
+		// Unroll the top of the walk until there is enough work to share out.
+		// Pairs that are already two leaves are carried along as they are.
+		vector<node_pair> pairs(1, node_pair(0, 0));
+		const size_t wanted_pairs = 32*num_threads;
+		bool split_any = true;
+
+		while(pairs.size() < wanted_pairs && true == split_any)
+		{
+			vector<node_pair> next_pairs;
+			split_any = false;
+
+			for(size_t i = 0; i < pairs.size(); i++)
+			{
+				const bvh_node &na = a.nodes[pairs[i].a];
+				const bvh_node &nb = b.nodes[pairs[i].b];
+
+				if(false == na.overlaps(nb))
+					continue;
+
+				if(true == na.is_leaf() && true == nb.is_leaf())
+				{
+					next_pairs.push_back(pairs[i]);
+					continue;
+				}
+
+				node_pair first(0, 0), second(0, 0);
+				split_pair(a, b, pairs[i], first, second);
+				next_pairs.push_back(first);
+				next_pairs.push_back(second);
+				split_any = true;
+			}
+
+			pairs.swap(next_pairs);
+		}
+
+		vector< vector<T> > pair_results(pairs.size());
+		atomic<size_t> next_pair(0);
+		vector<thread> threads;
+
+		for(size_t t = 1; t < num_threads && t < pairs.size(); t++)
+			threads.push_back(thread(intersect_node_pairs<T>, cref(a), cref(b), cref(pairs), ref(pair_results), ref(next_pair)));
+
+		intersect_node_pairs(a, b, pairs, pair_results, next_pair);
+
+		for(size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+
+		size_t total = 0;
+
+		for(size_t i = 0; i < pair_results.size(); i++)
+			total += pair_results[i].size();
+
+		found_pairs.reserve(total);
+
+		for(size_t i = 0; i < pair_results.size(); i++)
+			found_pairs.insert(found_pairs.end(), pair_results[i].begin(), pair_results[i].end());
+	}
+
+	sort(found_pairs.begin(), found_pairs.end());
+}
+
+void intersect_meshes(const triangle_bvh &a, const triangle_bvh &b, vector<triangle_contact> &contacts, const size_t num_threads)
+{
+	walk_trees(a, b, contacts, num_threads);
+}
+
+void overlapping_triangle_pairs(const triangle_bvh &a, const triangle_bvh &b, vector<triangle_pair> &pairs, const size_t num_threads)
+{
+	walk_trees(a, b, pairs, num_threads);
+}
+
+bool meshes_intersect(const triangle_bvh &a, const triangle_bvh &b)
+{
+	if(true == a.empty() || true == b.empty())
+		return false;
+
+	vector<node_pair> stack;
+	vector<triangle_contact> unused;
+
+	return intersect_subtrees(a, b, node_pair(0, 0), stack, unused, true);
+}
@@ -0,0 +1,69 @@
+#ifndef MESH_INTERSECTION_H
+#define MESH_INTERSECTION_H
+
+#include "triangle_bvh.h"
+#include "triangle_intersection.h"
+
+#include <vector>
+using std::vector;
+
+
+class triangle_contact
+{
+public:
+	mesh_index triangle_a; // Index into the triangles of the mesh under the first tree
+	mesh_index triangle_b; // ... and of the mesh under the second
+	bool coplanar;         // The triangles overlap within one plane; the segment is not set
+	vertex_3 segment_start;
+	vertex_3 segment_end;
+
+	inline bool operator<(const triangle_contact &right) const
+	{
+		if(triangle_a < right.triangle_a)
+			return true;
+		else if(triangle_a > right.triangle_a)
+			return false;
+
+		return triangle_b < right.triangle_b;
+	}
+};
+
+class triangle_pair
+{
+public:
+	mesh_index triangle_a;
+	mesh_index triangle_b;
+
+	inline bool operator<(const triangle_pair &right) const
+	{
+		if(triangle_a < right.triangle_a)
+			return true;
+		else if(triangle_a > right.triangle_a)
+			return false;
+
+		return triangle_b < right.triangle_b;
+	}
+};
+
+// Every pair of intersecting triangles between two meshes, found by walking their trees
+// together: a pair of nodes whose boxes overlap is replaced by the larger node's
+// children paired with the other node, until both are leaves, whose triangles are then
+// tested against each other: a packet at a time with classify_triangle_pairs(), then with
+// intersect_triangles() for the segments of the pairs that meet.
+//
+// With num_threads > 1 the walk is first unrolled breadth first into a few dozen node
+// pairs per thread, which the threads then take one at a time. The contacts come out
+// sorted by triangle_a, then triangle_b, whatever the number of threads.
+void intersect_meshes(const triangle_bvh &a, const triangle_bvh &b, vector<triangle_contact> &contacts, const size_t num_threads = 1);
+
+// Whether any triangle of a intersects any triangle of b. Stops at the first contact,
+// which makes it the cheaper call for a yes-or-no fit check.
+bool meshes_intersect(const triangle_bvh &a, const triangle_bvh &b);
+
+// The broad phase on its own: every pair of triangles whose bounding boxes overlap, found by
+// the same walk as intersect_meshes() and sorted the same way, for callers that bring their
+// own triangle test.
+void overlapping_triangle_pairs(const triangle_bvh &a, const triangle_bvh &b, vector<triangle_pair> &pairs, const size_t num_threads = 1);
+
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include "../common/mesh.h"
+
+#include <algorithm>
+using std::sort;
+using std::binary_search;
+
+#include <chrono>
+#include <cmath>
+
+
+// What the benchmarks and checks share: timing, the closed meshes they run on, and the
+// tests they put the results through.
+
+inline double seconds_since(const std::chrono::steady_clock::time_point &start)
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+// A torus of about num_triangles triangles around the z axis, then turned by 90 degrees
+// about the x axis if upright, and moved by offset.
+inline void make_torus(indexed_mesh &mesh, const size_t num_triangles, const double major_radius, const double minor_radius, const bool upright, const double offset[3])
+{
+	const double pi = 4.0*atan(1.0);
+	const size_t minor_steps = static_cast<size_t>(sqrt(0.5*num_triangles*minor_radius/major_radius)) + 3;
+	const size_t major_steps = num_triangles/(2*minor_steps) + 3;
+
+	mesh.clear();
+	mesh.vertices.resize(major_steps*minor_steps);
+
+	for(size_t i = 0; i < major_steps; i++)
+	{
+		const double u = 2.0*pi*i/major_steps;
+
+		for(size_t j = 0; j < minor_steps; j++)
+		{
+			const double v = 2.0*pi*j/minor_steps;
+			const double ring = major_radius + minor_radius*cos(v);
+
+			double p[3] = { ring*cos(u), ring*sin(u), minor_radius*sin(v) };
+
+			if(true == upright)
+			{
+				const double y = p[1];
+				p[1] = -p[2];
+				p[2] = y;
+			}
+
+			mesh.vertices[i*minor_steps + j] = vertex_3(static_cast<float>(p[0] + offset[0]), static_cast<float>(p[1] + offset[1]), static_cast<float>(p[2] + offset[2]));
+		}
+	}
+
+	for(size_t i = 0; i < major_steps; i++)
+	{
+		for(size_t j = 0; j < minor_steps; j++)
+		{
+			const mesh_index v00 = static_cast<mesh_index>(i*minor_steps + j);
+			const mesh_index v10 = static_cast<mesh_index>(((i + 1) % major_steps)*minor_steps + j);
+			const mesh_index v01 = static_cast<mesh_index>(i*minor_steps + (j + 1) % minor_steps);
+			const mesh_index v11 = static_cast<mesh_index>(((i + 1) % major_steps)*minor_steps + (j + 1) % minor_steps);
+
+			indexed_triangle t;
+			t.vertex_indices[0] = v00;
+			t.vertex_indices[1] = v10;
+			t.vertex_indices[2] = v11;
+			mesh.triangles.push_back(t);
+
+			t.vertex_indices[1] = v11;
+			t.vertex_indices[2] = v01;
+			mesh.triangles.push_back(t);
+		}
+	}
+}
+
+// The box from min to max, each face cut into steps by steps squares of two triangles.
+inline void make_box(indexed_mesh &mesh, const float min[3], const float max[3], const size_t steps)
+{
+	mesh.clear();
+
+	vector<mesh_index> grid((steps + 1)*(steps + 1));
+
+	for(size_t axis = 0; axis < 3; axis++)
+	{
+		for(size_t end = 0; end < 2; end++)
+		{
+			const size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+			for(size_t i = 0; i <= steps; i++)
+			{
+				for(size_t j = 0; j <= steps; j++)
+				{
+					float p[3];
+					p[axis] = (0 == end) ? min[axis] : max[axis];
+					p[u] = (steps == i) ? max[u] : min[u] + (max[u] - min[u])*i/steps;
+					p[v] = (steps == j) ? max[v] : min[v] + (max[v] - min[v])*j/steps;
+
+					grid[i*(steps + 1) + j] = static_cast<mesh_index>(mesh.vertices.size());
+					mesh.vertices.push_back(vertex_3(p[0], p[1], p[2]));
+				}
+			}
+
+			for(size_t i = 0; i < steps; i++)
+			{
+				for(size_t j = 0; j < steps; j++)
+				{
+					const mesh_index v00 = grid[i*(steps + 1) + j], v10 = grid[(i + 1)*(steps + 1) + j];
+					const mesh_index v01 = grid[i*(steps + 1) + j + 1], v11 = grid[(i + 1)*(steps + 1) + j + 1];
+
+					// (u, v) turns counter-clockwise about +axis, so the far face keeps that
+					// order and the near face is reversed.
+					indexed_triangle t0, t1;
+					t0.vertex_indices[0] = v00;
+					t0.vertex_indices[1] = (1 == end) ? v10 : v11;
+					t0.vertex_indices[2] = (1 == end) ? v11 : v10;
+					t1.vertex_indices[0] = v00;
+					t1.vertex_indices[1] = (1 == end) ? v11 : v01;
+					t1.vertex_indices[2] = (1 == end) ? v01 : v11;
+
+					mesh.triangles.push_back(t0);
+					mesh.triangles.push_back(t1);
+				}
+			}
+		}
+	}
+
+	// The faces' borders are made once per face, so they must be welded before use.
+}
+
+inline double mesh_volume(const indexed_mesh &mesh)
+{
+	double volume = 0.0;
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		const vertex_3 &a = mesh.vertices[mesh.triangles[i].vertex_indices[0]];
+		const vertex_3 &b = mesh.vertices[mesh.triangles[i].vertex_indices[1]];
+		const vertex_3 &c = mesh.vertices[mesh.triangles[i].vertex_indices[2]];
+
+		volume += a.x*(double(b.y)*c.z - double(b.z)*c.y) - a.y*(double(b.x)*c.z - double(b.z)*c.x) + a.z*(double(b.x)*c.y - double(b.y)*c.x);
+	}
+
+	return volume/6.0;
+}
+
+// Whether every edge is used exactly twice, once in each direction.
+inline bool is_closed(const indexed_mesh &mesh)
+{
+	vector< pair<mesh_index, mesh_index> > edges;
+	edges.reserve(3*mesh.triangles.size());
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+		for(size_t k = 0; k < 3; k++)
+			edges.push_back(make_pair(mesh.triangles[i].vertex_indices[k], mesh.triangles[i].vertex_indices[(k + 1) % 3]));
+
+	sort(edges.begin(), edges.end());
+
+	for(size_t i = 0; i < edges.size(); i++)
+	{
+		if(i > 0 && edges[i] == edges[i - 1])
+			return false;
+
+		if(false == binary_search(edges.begin(), edges.end(), make_pair(edges[i].second, edges[i].first)))
+			return false;
+	}
+
+	return true;
+}
+
+// A sphere of about num_triangles triangles around the origin.
+inline void make_sphere(indexed_mesh &mesh, const size_t num_triangles, const double radius)
+{
+	const double pi = 4.0*atan(1.0);
+	const size_t minor_steps = static_cast<size_t>(sqrt(0.5*num_triangles)) + 3;
+	const size_t major_steps = num_triangles/(2*minor_steps) + 3;
+
+	mesh.clear();
+
+	// Rings of latitude between the poles, which are the last two vertices.
+	for(size_t j = 1; j < minor_steps; j++)
+	{
+		const double v = pi*j/minor_steps;
+
+		for(size_t i = 0; i < major_steps; i++)
+		{
+			const double u = 2.0*pi*i/major_steps;
+			mesh.vertices.push_back(vertex_3(static_cast<float>(radius*sin(v)*cos(u)), static_cast<float>(radius*sin(v)*sin(u)), static_cast<float>(radius*cos(v))));
+		}
+	}
+
+	const mesh_index north = static_cast<mesh_index>(mesh.vertices.size()), south = north + 1;
+	mesh.vertices.push_back(vertex_3(0.0f, 0.0f, static_cast<float>(radius)));
+	mesh.vertices.push_back(vertex_3(0.0f, 0.0f, static_cast<float>(-radius)));
+
+	for(size_t i = 0; i < major_steps; i++)
+	{
+		const size_t next = (i + 1) % major_steps;
+		indexed_triangle t;
+
+		t.vertex_indices[0] = north;
+		t.vertex_indices[1] = static_cast<mesh_index>(i);
+		t.vertex_indices[2] = static_cast<mesh_index>(next);
+		mesh.triangles.push_back(t);
+
+		const size_t last_ring = (minor_steps - 2)*major_steps;
+		t.vertex_indices[0] = south;
+		t.vertex_indices[1] = static_cast<mesh_index>(last_ring + next);
+		t.vertex_indices[2] = static_cast<mesh_index>(last_ring + i);
+		mesh.triangles.push_back(t);
+
+		for(size_t j = 0; j + 2 < minor_steps; j++)
+		{
+			const mesh_index v00 = static_cast<mesh_index>(j*major_steps + i), v01 = static_cast<mesh_index>(j*major_steps + next);
+			const mesh_index v10 = static_cast<mesh_index>((j + 1)*major_steps + i), v11 = static_cast<mesh_index>((j + 1)*major_steps + next);
+
+			t.vertex_indices[0] = v00;
+			t.vertex_indices[1] = v10;
+			t.vertex_indices[2] = v11;
+			mesh.triangles.push_back(t);
+
+			t.vertex_indices[1] = v11;
+			t.vertex_indices[2] = v01;
+			mesh.triangles.push_back(t);
+		}
+	}
+}
+
+// Whether no two vertices are in the same place.
+inline bool is_welded(const indexed_mesh &mesh)
+{
+	vector<vertex_3> sorted = mesh.vertices;
+	sort(sorted.begin(), sorted.end());
+
+	for(size_t i = 1; i < sorted.size(); i++)
+		if(sorted[i] == sorted[i - 1])
+			return false;
+
+	return true;
+}
+
+
+#endif
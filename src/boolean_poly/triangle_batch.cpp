@@ -0,0 +1,362 @@
+#include "triangle_batch.h"
+
+#include <cfloat> // for DBL_EPSILON
+#include <cstring> // for memset()
+
+#include <limits>
+using std::numeric_limits;
+
+#if !defined(TRIANGLE_BATCH_SCALAR) && defined(__AVX512F__)
+	#define TRIANGLE_BATCH_AVX512
+	#include <immintrin.h>
+#elif !defined(TRIANGLE_BATCH_SCALAR) && defined(__AVX2__)
+	#define TRIANGLE_BATCH_AVX2
+	#include <immintrin.h>
+#endif
+
+
+triangle_pair_packet::triangle_pair_packet(void)
+{
+	// The lanes past the pairs in use are still computed, then ignored; zeros keep them quick.
+	memset(a, 0, sizeof(a));
+	memset(b, 0, sizeof(b));
+}
+
+void triangle_pair_packet::set(const size_t lane, const vertex_3 first[3], const vertex_3 second[3])
+{
+	for(size_t i = 0; i < 3; i++)
+	{
+		a[i][0][lane] = first[i].x;
+		a[i][1][lane] = first[i].y;
+		a[i][2][lane] = first[i].z;
+		b[i][0][lane] = second[i].x;
+		b[i][1][lane] = second[i].y;
+		b[i][2][lane] = second[i].z;
+	}
+}
+
+void triangle_pair_packet::get(const size_t lane, vertex_3 first[3], vertex_3 second[3]) const
+{
+	for(size_t i = 0; i < 3; i++)
+	{
+		first[i] = vertex_3(a[i][0][lane], a[i][1][lane], a[i][2][lane]);
+		second[i] = vertex_3(b[i][0][lane], b[i][1][lane], b[i][2][lane]);
+	}
+}
+
+static inline triangle_intersection test_pair(const triangle_pair_packet &packet, const size_t lane)
+{
+	vertex_3 a[3], b[3], segment_start, segment_end;
+	packet.get(lane, a, b);
+
+	return intersect_triangles(a, b, segment_start, segment_end);
+}
+
+#if defined(TRIANGLE_BATCH_AVX512) || defined(TRIANGLE_BATCH_AVX2)
+
+#if defined(TRIANGLE_BATCH_AVX512)
+
+// One double per pair, for eight pairs.
+class lanes
+{
+public:
+	static const size_t width = 8;
+
+	lanes(void) { /* uninitialized */ }
+	lanes(const __m512d src) : v(src) { /* custom constructor */ }
+	explicit lanes(const double value) : v(_mm512_set1_pd(value)) { /* custom constructor */ }
+
+	__m512d v;
+};
+
+class lane_mask
+{
+public:
+	lane_mask(void) { /* uninitialized */ }
+	lane_mask(const __mmask8 src) : m(src) { /* custom constructor */ }
+
+	__mmask8 m;
+};
+
+static inline lanes load_lanes(const float *source) { return _mm512_cvtps_pd(_mm256_loadu_ps(source)); }
+
+static inline lanes operator+(const lanes &l, const lanes &r) { return _mm512_add_pd(l.v, r.v); }
+static inline lanes operator-(const lanes &l, const lanes &r) { return _mm512_sub_pd(l.v, r.v); }
+static inline lanes operator*(const lanes &l, const lanes &r) { return _mm512_mul_pd(l.v, r.v); }
+static inline lanes operator/(const lanes &l, const lanes &r) { return _mm512_div_pd(l.v, r.v); }
+static inline lanes lanes_sqrt(const lanes &l) { return _mm512_sqrt_pd(l.v); }
+static inline lanes lanes_abs(const lanes &l) { return _mm512_abs_pd(l.v); }
+static inline lanes lanes_min(const lanes &l, const lanes &r) { return _mm512_min_pd(l.v, r.v); }
+static inline lanes lanes_max(const lanes &l, const lanes &r) { return _mm512_max_pd(l.v, r.v); }
+
+static inline lane_mask operator<(const lanes &l, const lanes &r) { return _mm512_cmp_pd_mask(l.v, r.v, _CMP_LT_OQ); }
+static inline lane_mask operator>(const lanes &l, const lanes &r) { return _mm512_cmp_pd_mask(l.v, r.v, _CMP_GT_OQ); }
+
+static inline lane_mask operator&(const lane_mask &l, const lane_mask &r) { return static_cast<__mmask8>(l.m & r.m); }
+static inline lane_mask operator|(const lane_mask &l, const lane_mask &r) { return static_cast<__mmask8>(l.m | r.m); }
+static inline lane_mask operator^(const lane_mask &l, const lane_mask &r) { return static_cast<__mmask8>(l.m ^ r.m); }
+static inline lane_mask operator~(const lane_mask &l) { return static_cast<__mmask8>(~l.m); }
+
+static inline lanes select(const lane_mask &m, const lanes &if_set, const lanes &if_clear) { return _mm512_mask_blend_pd(m.m, if_clear.v, if_set.v); }
+static inline int mask_bits(const lane_mask &m) { return static_cast<int>(m.m); }
+
+#else
+
+// One double per pair, for four pairs.
+class lanes
+{
+public:
+	static const size_t width = 4;
+
+	lanes(void) { /* uninitialized */ }
+	lanes(const __m256d src) : v(src) { /* custom constructor */ }
+	explicit lanes(const double value) : v(_mm256_set1_pd(value)) { /* custom constructor */ }
+
+	__m256d v;
+};
+
+class lane_mask
+{
+public:
+	lane_mask(void) { /* uninitialized */ }
+	lane_mask(const __m256d src) : m(src) { /* custom constructor */ }
+
+	__m256d m;
+};
+
+static inline lanes load_lanes(const float *source) { return _mm256_cvtps_pd(_mm_loadu_ps(source)); }
+
+static inline lanes operator+(const lanes &l, const lanes &r) { return _mm256_add_pd(l.v, r.v); }
+static inline lanes operator-(const lanes &l, const lanes &r) { return _mm256_sub_pd(l.v, r.v); }
+static inline lanes operator*(const lanes &l, const lanes &r) { return _mm256_mul_pd(l.v, r.v); }
+static inline lanes operator/(const lanes &l, const lanes &r) { return _mm256_div_pd(l.v, r.v); }
+static inline lanes lanes_sqrt(const lanes &l) { return _mm256_sqrt_pd(l.v); }
+static inline lanes lanes_abs(const lanes &l) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), l.v); }
+static inline lanes lanes_min(const lanes &l, const lanes &r) { return _mm256_min_pd(l.v, r.v); }
+static inline lanes lanes_max(const lanes &l, const lanes &r) { return _mm256_max_pd(l.v, r.v); }
+
+static inline lane_mask operator<(const lanes &l, const lanes &r) { return _mm256_cmp_pd(l.v, r.v, _CMP_LT_OQ); }
+static inline lane_mask operator>(const lanes &l, const lanes &r) { return _mm256_cmp_pd(l.v, r.v, _CMP_GT_OQ); }
+
+static inline lane_mask operator&(const lane_mask &l, const lane_mask &r) { return _mm256_and_pd(l.m, r.m); }
+static inline lane_mask operator|(const lane_mask &l, const lane_mask &r) { return _mm256_or_pd(l.m, r.m); }
+static inline lane_mask operator^(const lane_mask &l, const lane_mask &r) { return _mm256_xor_pd(l.m, r.m); }
+static inline lane_mask operator~(const lane_mask &l) { return _mm256_xor_pd(l.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))); }
+
+static inline lanes select(const lane_mask &m, const lanes &if_set, const lanes &if_clear) { return _mm256_blendv_pd(if_clear.v, if_set.v, m.m); }
+static inline int mask_bits(const lane_mask &m) { return _mm256_movemask_pd(m.m); }
+
+#endif
+
+static inline void cross(const lanes a[3], const lanes b[3], lanes out[3])
+{
+	out[0] = a[1]*b[2] - a[2]*b[1];
+	out[1] = a[2]*b[0] - a[0]*b[2];
+	out[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+static inline lanes dot(const lanes a[3], const lanes b[3])
+{
+	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// One triangle's plane, and the other triangle's corners measured against it.
+class plane_side
+{
+public:
+	lanes normal[3];
+	lanes normal_length;
+	lanes edge_product;   // |e1||e2|, which bounds the normal and its rounding
+	lanes distances[3];   // Scaled by the normal's length, as in plane_distances()
+	lanes nearest;        // The smallest of the distances' magnitudes
+	lanes error;          // Bound on how far each distance is from its exact value
+	lane_mask clear;      // No corner is within twice the scalar snapping threshold of the plane
+	lane_mask above;      // All corners are clearly on the positive side
+	lane_mask below;      // ... or all on the negative side
+};
+
+// The plane of p, and the corners of q against it.
+//
+// plane_distances() in triangle_intersection.cpp snaps a distance to zero when it is within
+// 16 ulps of |e1||e2||v|, v being the corner less p[0]. The normal is off by at most 5 ulps
+// of |e1||e2| and the dot product by at most 3 ulps of |n||v|, whichever way either is
+// rounded, so that computation and this one can differ by less than the threshold itself.
+// A distance beyond twice the threshold here is therefore beyond it there too, and of the
+// same sign.
+static inline void measure_plane(const lanes p[3][3], const lanes q[3][3], plane_side &side)
+{
+	lanes e1[3], e2[3];
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		e1[k] = p[1][k] - p[0][k];
+		e2[k] = p[2][k] - p[0][k];
+	}
+
+	cross(e1, e2, side.normal);
+	side.normal_length = lanes_sqrt(dot(side.normal, side.normal));
+	side.edge_product = lanes_sqrt(dot(e1, e1)*dot(e2, e2));
+
+	const lanes threshold = lanes(2.0*16.0*DBL_EPSILON)*side.edge_product;
+	const lanes zero(0.0);
+
+	lanes offset_lengths[3];
+	lane_mask clear[3];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		lanes v[3];
+
+		for(size_t k = 0; k < 3; k++)
+			v[k] = q[i][k] - p[0][k];
+
+		side.distances[i] = dot(side.normal, v);
+		offset_lengths[i] = lanes_sqrt(dot(v, v));
+		clear[i] = lanes_abs(side.distances[i]) > threshold*offset_lengths[i];
+	}
+
+	side.nearest = lanes_min(lanes_min(lanes_abs(side.distances[0]), lanes_abs(side.distances[1])), lanes_abs(side.distances[2]));
+	side.error = lanes(8.0*DBL_EPSILON)*side.edge_product*lanes_max(lanes_max(offset_lengths[0], offset_lengths[1]), offset_lengths[2]);
+
+	side.clear = clear[0] & clear[1] & clear[2];
+	side.above = side.clear & (side.distances[0] > zero) & (side.distances[1] > zero) & (side.distances[2] > zero);
+	side.below = side.clear & (side.distances[0] < zero) & (side.distances[1] < zero) & (side.distances[2] < zero);
+}
+
+// The interval along direction where a triangle that straddles a plane crosses it,
+// given its corners' distances from the plane.
+static inline void crossing_interval(const lanes corners[3][3], const lanes distances[3], const lanes direction[3], lanes &low, lanes &high)
+{
+	const lanes zero(0.0);
+	lanes t[3];
+
+	for(size_t i = 0; i < 3; i++)
+		t[i] = dot(direction, corners[i]);
+
+	low = lanes(numeric_limits<double>::infinity());
+	high = lanes(-numeric_limits<double>::infinity());
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		const size_t j = (i + 1) % 3;
+
+		const lane_mask crosses = (distances[i] < zero) ^ (distances[j] < zero);
+		const lanes position = t[i] + (t[j] - t[i])*(distances[i] / (distances[i] - distances[j]));
+
+		low = select(crosses, lanes_min(low, position), low);
+		high = select(crosses, lanes_max(high, position), high);
+	}
+}
+
+// Bound on how far an end of a crossing interval, as intersect_triangles() or
+// crossing_interval() computes it, is from its exact value. Each end is a position along
+// the edge at d_i / (d_i - d_j), whose rounding the distances' errors dominate, projected
+// onto the direction, whose own rounding the normals' errors dominate. largest bounds
+// every coordinate, so 2 largest bounds every corner's length.
+static inline lanes interval_error(const plane_side &side, const lanes &largest, const lanes &direction_length, const lanes &direction_error)
+{
+	const lanes eps(DBL_EPSILON);
+	const lanes reach = lanes(2.0)*largest*direction_length;
+	const lanes projection_error = lanes(2.0)*largest*(direction_error + lanes(3.0)*eps*direction_length);
+	const lanes ratio_error = side.error / side.nearest + lanes(4.0)*eps;
+
+	return lanes(3.0)*projection_error + lanes(2.0)*reach*ratio_error + lanes(9.0)*eps*reach;
+}
+
+// Classifies the pairs in lanes [first, first + lanes::width) of the packet. Sets a bit in
+// decided for each pair whose result is certain, and in crossing for each of those that cross.
+static inline void classify_lanes(const triangle_pair_packet &packet, const size_t first, int &decided, int &crossing)
+{
+	lanes a[3][3], b[3][3];
+	lanes largest(0.0);
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		for(size_t k = 0; k < 3; k++)
+		{
+			a[i][k] = load_lanes(&packet.a[i][k][first]);
+			b[i][k] = load_lanes(&packet.b[i][k][first]);
+			largest = lanes_max(largest, lanes_max(lanes_abs(a[i][k]), lanes_abs(b[i][k])));
+		}
+	}
+
+	plane_side side_a, side_b;
+	measure_plane(b, a, side_b); // a against the plane of b
+	measure_plane(a, b, side_a); // b against the plane of a
+
+	const lane_mask apart = side_b.above | side_b.below | side_a.above | side_a.below;
+	const lane_mask straddling = side_a.clear & side_b.clear & ~apart;
+
+	decided = mask_bits(apart);
+	crossing = 0;
+
+	if(0 == mask_bits(straddling))
+		return;
+
+	// As in intersect_triangles(), the direction is n_a x n_b.
+	lanes direction[3];
+	cross(side_a.normal, side_b.normal, direction);
+
+	const lanes direction_length = lanes_sqrt(dot(direction, direction));
+	const lanes direction_error = lanes(8.0*DBL_EPSILON)*(side_a.edge_product*side_b.normal_length + side_b.edge_product*side_a.normal_length);
+
+	lanes low_a, high_a, low_b, high_b;
+	crossing_interval(a, side_b.distances, direction, low_a, high_a);
+	crossing_interval(b, side_a.distances, direction, low_b, high_b);
+
+	// Each end may be off by its bound in either computation.
+	const lanes margin = lanes(2.0)*(interval_error(side_b, largest, direction_length, direction_error) + interval_error(side_a, largest, direction_length, direction_error));
+
+	const lane_mask disjoint = straddling & ((low_a - high_b > margin) | (low_b - high_a > margin));
+	const lane_mask overlapping = straddling & (high_b - low_a > margin) & (high_a - low_b > margin);
+
+	decided |= mask_bits(disjoint | overlapping);
+	crossing = mask_bits(overlapping);
+}
+
+#endif
+
+size_t classify_triangle_pairs(const triangle_pair_packet &packet, const size_t count, triangle_intersection results[triangle_pair_packet::size])
+{
+	size_t scalar_count = 0;
+
+#if defined(TRIANGLE_BATCH_AVX512) || defined(TRIANGLE_BATCH_AVX2)
+	for(size_t first = 0; first < count; first += lanes::width)
+	{
+		int decided = 0, crossing = 0;
+		classify_lanes(packet, first, decided, crossing);
+
+		for(size_t i = first; i < first + lanes::width && i < count; i++)
+		{
+			const int bit = 1 << (i - first);
+
+			if(0 != (decided & bit))
+			{
+				results[i] = (0 != (crossing & bit)) ? TRIANGLES_CROSSING : TRIANGLES_DISJOINT;
+				continue;
+			}
+
+			results[i] = test_pair(packet, i);
+			scalar_count++;
+		}
+	}
+#else
+	for(size_t i = 0; i < count; i++)
+		results[i] = test_pair(packet, i);
+
+	scalar_count = count;
+#endif
+
+	return scalar_count;
+}
+
+const char *triangle_batch_instruction_set(void)
+{
+#if defined(TRIANGLE_BATCH_AVX512)
+	return "AVX-512";
+#elif defined(TRIANGLE_BATCH_AVX2)
+	return "AVX2";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef TRIANGLE_BATCH_H
+#define TRIANGLE_BATCH_H
+
+#include "triangle_intersection.h"
+
+#include <stddef.h>
+
+
+// Eight pairs of triangles, stored by coordinate rather than by pair, so that the same
+// coordinate of every pair is loaded into a vector at once.
+class triangle_pair_packet
+{
+public:
+	static const size_t size = 8;
+
+	triangle_pair_packet(void);
+
+	void set(const size_t lane, const vertex_3 first[3], const vertex_3 second[3]);
+	void get(const size_t lane, vertex_3 first[3], vertex_3 second[3]) const;
+
+	float a[3][3][size]; // a[corner][axis][lane]
+	float b[3][3][size];
+};
+
+// The classification of intersect_triangles(), for up to eight pairs at once.
+//
+// All pairs of a packet go through the same steps of Moller's test side by side: each
+// triangle against the plane of the other, then, where both straddle, the overlap of
+// the two intervals on the line where the planes meet. The arithmetic is done in double,
+// as in intersect_triangles(), but the vector code neither rounds nor snaps as the scalar
+// code does. So each step also bounds how far the two can differ, and a pair is only
+// decided there if its answer holds across that whole range: every vertex is clearly off
+// the other plane, and the intervals clearly apart or clearly overlapping. The rest --
+// pairs that touch, pairs that lie in one plane, degenerate triangles -- are handed to
+// intersect_triangles() one by one. Either way the results are the ones it would give.
+//
+// AVX-512 or AVX2 is used when the compiler targets it (e.g. -mavx512f, -mavx2 or
+// -march=native); define TRIANGLE_BATCH_SCALAR to force the scalar code, which tests
+// every pair with intersect_triangles().
+//
+// Sets results[i] for i in [0, count). Returns the number of pairs that were tested by
+// intersect_triangles(). Callers that need the segments of crossing pairs still get them
+// from intersect_triangles(); crossing pairs are far fewer than candidates.
+size_t classify_triangle_pairs(const triangle_pair_packet &packet, const size_t count, triangle_intersection results[triangle_pair_packet::size]);
+
+const char *triangle_batch_instruction_set(void);
+
+
+#endif
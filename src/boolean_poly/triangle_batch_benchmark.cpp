@@ -0,0 +1,285 @@
+// Checks the batched triangle test against intersect_triangles() on pairs of every kind
+// it has to get right -- crossing and apart, touching, nearly touching, coplanar, sharing
+// a corner or an edge, degenerate -- and times both on pairs like the ones a tree walk
+// hands over, whose boxes overlap.
+//
+// Example usage: triangle_batch_benchmark [num_pairs]
+// Build with -mavx2 or -mavx512f (or -march=native) to time the vectorized test.
+
+#include "triangle_batch.h"
+#include "test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <vector>
+using std::vector;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+class test_pair
+{
+public:
+	vertex_3 a[3];
+	vertex_3 b[3];
+};
+
+static inline float random_float(const float min, const float max)
+{
+	return min + (max - min)*static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+}
+
+static inline vertex_3 random_point(const vertex_3 &centre, const float radius)
+{
+	return vertex_3(centre.x + random_float(-radius, radius), centre.y + random_float(-radius, radius), centre.z + random_float(-radius, radius));
+}
+
+// A point on the triangle, at the given barycentric weights, rounded to float.
+static inline vertex_3 point_on(const vertex_3 t[3], const float u, const float v)
+{
+	const float w = 1.0f - u - v;
+
+	return vertex_3(w*t[0].x + u*t[1].x + v*t[2].x, w*t[0].y + u*t[1].y + v*t[2].y, w*t[0].z + u*t[1].z + v*t[2].z);
+}
+
+// Two small triangles near each other somewhere in [0, 100]^3: about as often apart as
+// crossing, as for triangles whose boxes overlap.
+static void make_nearby(test_pair &p)
+{
+	const vertex_3 centre(random_float(0.0f, 100.0f), random_float(0.0f, 100.0f), random_float(0.0f, 100.0f));
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		p.a[i] = random_point(centre, 0.1f);
+		p.b[i] = random_point(centre, 0.1f);
+	}
+}
+
+// One corner of b on a's face, on one of a's edges, or at one of a's corners, and b's
+// other corners on one side of a's plane or on both.
+static void make_touching(test_pair &p)
+{
+	make_nearby(p);
+
+	switch(rand() % 3)
+	{
+	case 0:
+		p.b[0] = point_on(p.a, random_float(0.0f, 0.5f), random_float(0.0f, 0.5f));
+		break;
+	case 1:
+		p.b[0] = point_on(p.a, random_float(0.0f, 1.0f), 0.0f);
+		break;
+	default:
+		p.b[0] = p.a[rand() % 3];
+		break;
+	}
+}
+
+// As make_touching(), but with b moved off the point of contact by a few ulps.
+static void make_nearly_touching(test_pair &p)
+{
+	make_touching(p);
+
+	const float step = (0 == rand() % 2) ? 1e-6f : -1e-6f;
+
+	for(size_t i = 0; i < 3; i++)
+		p.b[i] = vertex_3(p.b[i].x + step, p.b[i].y + step*0.5f, p.b[i].z - step*0.25f);
+}
+
+// Both triangles in one plane: a plane of constant coordinate, in which they are exactly
+// coplanar, or a tilted one, in which they are up to rounding.
+static void make_coplanar(test_pair &p)
+{
+	make_nearby(p);
+
+	if(0 == rand() % 2)
+	{
+		const size_t axis = rand() % 3;
+		const float level = random_float(0.0f, 100.0f);
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			float a[3] = { p.a[i].x, p.a[i].y, p.a[i].z }, b[3] = { p.b[i].x, p.b[i].y, p.b[i].z };
+			a[axis] = b[axis] = level;
+			p.a[i] = vertex_3(a[0], a[1], a[2]);
+			p.b[i] = vertex_3(b[0], b[1], b[2]);
+		}
+	}
+	else
+	{
+		const vertex_3 plane[3] = { p.a[0], p.a[1], p.a[2] };
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			p.a[i] = point_on(plane, random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+			p.b[i] = point_on(plane, random_float(-1.0f, 1.0f), random_float(-1.0f, 1.0f));
+		}
+	}
+}
+
+// Neighbours from a mesh: b shares a corner with a, or an edge, which b runs along the
+// other way.
+static void make_neighbours(test_pair &p)
+{
+	make_nearby(p);
+
+	const size_t k = rand() % 3;
+
+	p.b[0] = p.a[(k + 1) % 3];
+
+	if(0 == rand() % 2)
+		p.b[1] = p.a[k];
+}
+
+// a has no area: a repeated corner, three corners on a line along an axis, or a corner
+// rounded onto the line through the others.
+static void make_degenerate(test_pair &p)
+{
+	make_nearby(p);
+
+	switch(rand() % 3)
+	{
+	case 0:
+		p.a[2] = p.a[rand() % 2];
+		break;
+	case 1:
+		p.a[1] = vertex_3(p.a[1].x, p.a[0].y, p.a[0].z);
+		p.a[2] = vertex_3(p.a[2].x, p.a[0].y, p.a[0].z);
+		break;
+	default:
+		p.a[2] = point_on(p.a, random_float(-1.0f, 2.0f), 0.0f);
+		break;
+	}
+
+	if(0 == rand() % 2)
+	{
+		for(size_t i = 0; i < 3; i++)
+		{
+			const vertex_3 swap = p.a[i];
+			p.a[i] = p.b[i];
+			p.b[i] = swap;
+		}
+	}
+}
+
+// Returns the number of pairs whose results differ.
+static size_t check_pairs(const char *const name, const vector<test_pair> &pairs)
+{
+	triangle_pair_packet packet;
+	triangle_intersection results[triangle_pair_packet::size];
+	size_t differences = 0, scalar_count = 0;
+	size_t counts[3] = { 0, 0, 0 };
+
+	for(size_t first = 0; first < pairs.size(); first += triangle_pair_packet::size)
+	{
+		const size_t count = (pairs.size() - first < triangle_pair_packet::size) ? pairs.size() - first : triangle_pair_packet::size;
+
+		for(size_t i = 0; i < count; i++)
+			packet.set(i, pairs[first + i].a, pairs[first + i].b);
+
+		scalar_count += classify_triangle_pairs(packet, count, results);
+
+		for(size_t i = 0; i < count; i++)
+		{
+			vertex_3 segment_start, segment_end;
+			const triangle_intersection expected = intersect_triangles(pairs[first + i].a, pairs[first + i].b, segment_start, segment_end);
+
+			counts[expected]++;
+
+			if(expected != results[i])
+				differences++;
+		}
+	}
+
+	cout << "  " << name << ": " << counts[TRIANGLES_DISJOINT] << " apart, " << counts[TRIANGLES_CROSSING] << " crossing, " << counts[TRIANGLES_COPLANAR]
+	     << " coplanar; " << 100.0*scalar_count/pairs.size() << "% left to the scalar test; "
+	     << ((0 == differences) ? "identical" : "DIFFERENT") << endl;
+
+	return differences;
+}
+
+int main(int argc, char **argv)
+{
+	size_t num_pairs = 4000000;
+
+	if(argc > 1)
+		num_pairs = strtoul(argv[1], 0, 10);
+
+	if(num_pairs < triangle_pair_packet::size)
+	{
+		cout << "Example usage: " << argv[0] << " [num_pairs]" << endl;
+		return 1;
+	}
+
+	cout << "Using the " << triangle_batch_instruction_set() << " batched test" << endl;
+
+	const char *const case_names[6] = { "nearby", "touching", "nearly touching", "coplanar", "neighbours", "degenerate" };
+	void (*const makers[6])(test_pair &) = { make_nearby, make_touching, make_nearly_touching, make_coplanar, make_neighbours, make_degenerate };
+	size_t differences = 0;
+
+	cout << "Checking:" << endl;
+
+	for(size_t c = 0; c < 6; c++)
+	{
+		vector<test_pair> pairs(100000);
+
+		for(size_t i = 0; i < pairs.size(); i++)
+			makers[c](pairs[i]);
+
+		differences += check_pairs(case_names[c], pairs);
+	}
+
+	// Mostly nearby pairs, with a few of every other kind, as from a walk over two meshes.
+	vector<test_pair> pairs(num_pairs);
+
+	for(size_t i = 0; i < num_pairs; i++)
+		makers[(0 == rand() % 8) ? 1 + rand() % 5 : 0](pairs[i]);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t scalar_found = 0;
+
+	for(size_t i = 0; i < num_pairs; i++)
+	{
+		vertex_3 segment_start, segment_end;
+
+		if(TRIANGLES_DISJOINT != intersect_triangles(pairs[i].a, pairs[i].b, segment_start, segment_end))
+			scalar_found++;
+	}
+
+	const double scalar_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	triangle_pair_packet packet;
+	triangle_intersection results[triangle_pair_packet::size];
+	size_t batch_found = 0;
+
+	for(size_t first = 0; first < num_pairs; first += triangle_pair_packet::size)
+	{
+		const size_t count = (num_pairs - first < triangle_pair_packet::size) ? num_pairs - first : triangle_pair_packet::size;
+
+		for(size_t i = 0; i < count; i++)
+			packet.set(i, pairs[first + i].a, pairs[first + i].b);
+
+		classify_triangle_pairs(packet, count, results);
+
+		for(size_t i = 0; i < count; i++)
+			if(TRIANGLES_DISJOINT != results[i])
+				batch_found++;
+	}
+
+	const double batch_time = seconds_since(start);
+
+	cout << "Timing " << num_pairs << " mixed pairs:" << endl;
+	cout << "  one by one: " << num_pairs / scalar_time / 1e6 << " M pairs/s, " << scalar_found << " meeting" << endl;
+	cout << "  batched:    " << num_pairs / batch_time / 1e6 << " M pairs/s (" << scalar_time / batch_time << "x), " << batch_found << " meeting" << endl;
+
+	const bool passed = (0 == differences && scalar_found == batch_found);
+
+	cout << (passed ? "All results identical" : "SOME RESULTS DIFFER") << endl;
+
+	return passed ? 0 : 2;
+}
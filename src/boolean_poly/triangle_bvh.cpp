@@ -0,0 +1,301 @@
+#include "triangle_bvh.h"
+
+
+bool triangle_bvh::build(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles)
+{
+	clear();
+
+	// Interior nodes store their second child's index in 32 bits; there are fewer than 2n nodes.
+	if(0 == triangles.size() || triangles.size() > 0x7fffffff)
+		return false;
+
+	vector<build_entry> entries(triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		build_entry &e = entries[i];
+		const vertex_3 &v0 = vertices[triangles[i].vertex_indices[0]];
+		const vertex_3 &v1 = vertices[triangles[i].vertex_indices[1]];
+		const vertex_3 &v2 = vertices[triangles[i].vertex_indices[2]];
+
+		e.min[0] = e.max[0] = v0.x;
+		e.min[1] = e.max[1] = v0.y;
+		e.min[2] = e.max[2] = v0.z;
+
+		const vertex_3 *rest[2] = { &v1, &v2 };
+
+		for(size_t j = 0; j < 2; j++)
+		{
+			const float c[3] = { rest[j]->x, rest[j]->y, rest[j]->z };
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(c[k] < e.min[k])
+					e.min[k] = c[k];
+
+				if(c[k] > e.max[k])
+					e.max[k] = c[k];
+			}
+		}
+
+		for(size_t k = 0; k < 3; k++)
+			e.centroid[k] = (e.min[k] + e.max[k])*0.5f;
+
+		e.triangle = static_cast<mesh_index>(i);
+	}
+
+	nodes.reserve(2*triangles.size()/max_leaf_size + 1);
+	build_node(entries, 0, entries.size());
+
+	triangle_indices.resize(entries.size());
+	triangle_vertices.resize(entries.size()*3);
+
+	for(size_t i = 0; i < entries.size(); i++)
+	{
+		const indexed_triangle &t = triangles[entries[i].triangle];
+
+		triangle_indices[i] = entries[i].triangle;
+		triangle_vertices[i*3 + 0] = vertices[t.vertex_indices[0]];
+		triangle_vertices[i*3 + 1] = vertices[t.vertex_indices[1]];
+		triangle_vertices[i*3 + 2] = vertices[t.vertex_indices[2]];
+	}
+
+	return true;
+}
+
+// Appends the subtree over entries [first, last), depth first.
+void triangle_bvh::build_node(vector<build_entry> &entries, const size_t first, const size_t last)
+{
+	const size_t node_index = nodes.size();
+	nodes.push_back(bvh_node());
+
+	float node_min[3], node_max[3], centroid_min[3], centroid_max[3];
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		node_min[k] = centroid_min[k] = numeric_limits<float>::max();
+		node_max[k] = centroid_max[k] = -numeric_limits<float>::max();
+	}
+
+	for(size_t i = first; i < last; i++)
+	{
+		for(size_t k = 0; k < 3; k++)
+		{
+			if(entries[i].min[k] < node_min[k])
+				node_min[k] = entries[i].min[k];
+
+			if(entries[i].max[k] > node_max[k])
+				node_max[k] = entries[i].max[k];
+
+			if(entries[i].centroid[k] < centroid_min[k])
+				centroid_min[k] = entries[i].centroid[k];
+
+			if(entries[i].centroid[k] > centroid_max[k])
+				centroid_max[k] = entries[i].centroid[k];
+		}
+	}
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		nodes[node_index].min[k] = node_min[k];
+		nodes[node_index].max[k] = node_max[k];
+	}
+
+	const size_t count = last - first;
+
+	if(count <= max_leaf_size)
+	{
+		nodes[node_index].offset = static_cast<uint32_t>(first);
+		nodes[node_index].count = static_cast<uint32_t>(count);
+		return;
+	}
+
+	size_t axis = 0;
+
+	for(size_t k = 1; k < 3; k++)
+		if(centroid_max[k] - centroid_min[k] > centroid_max[axis] - centroid_min[axis])
+			axis = k;
+
+	const float extent = centroid_max[axis] - centroid_min[axis];
+	size_t split = first + count/2;
+
+	if(extent > 0.0f)
+	{
+		// Bin the centroids along the axis, then sweep the bins from both ends to find
+		// the boundary where (count*half area) of the two sides adds up to the least.
+		const float bin_scale = bin_count / extent;
+
+		size_t bin_sizes[bin_count] = { 0 };
+		bvh_node bin_boxes[bin_count];
+
+		for(size_t b = 0; b < bin_count; b++)
+		{
+			for(size_t k = 0; k < 3; k++)
+			{
+				bin_boxes[b].min[k] = numeric_limits<float>::max();
+				bin_boxes[b].max[k] = -numeric_limits<float>::max();
+			}
+		}
+
+		for(size_t i = first; i < last; i++)
+		{
+			size_t b = static_cast<size_t>((entries[i].centroid[axis] - centroid_min[axis])*bin_scale);
+
+			if(b >= bin_count)
+				b = bin_count - 1;
+
+			bin_sizes[b]++;
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(entries[i].min[k] < bin_boxes[b].min[k])
+					bin_boxes[b].min[k] = entries[i].min[k];
+
+				if(entries[i].max[k] > bin_boxes[b].max[k])
+					bin_boxes[b].max[k] = entries[i].max[k];
+			}
+		}
+
+		// right_costs[b] is the cost of bins b and up.
+		float right_costs[bin_count];
+		bvh_node box = bin_boxes[bin_count - 1];
+		size_t right_size = 0;
+
+		for(size_t b = bin_count - 1; b > 0; b--)
+		{
+			right_size += bin_sizes[b];
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(bin_boxes[b].min[k] < box.min[k])
+					box.min[k] = bin_boxes[b].min[k];
+
+				if(bin_boxes[b].max[k] > box.max[k])
+					box.max[k] = bin_boxes[b].max[k];
+			}
+
+			right_costs[b] = (0 == right_size) ? 0.0f : right_size*box.half_area();
+		}
+
+		box = bin_boxes[0];
+		size_t left_size = 0;
+		size_t best_bin = 0;
+		float best_cost = numeric_limits<float>::max();
+
+		for(size_t b = 1; b < bin_count; b++)
+		{
+			left_size += bin_sizes[b - 1];
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(bin_boxes[b - 1].min[k] < box.min[k])
+					box.min[k] = bin_boxes[b - 1].min[k];
+
+				if(bin_boxes[b - 1].max[k] > box.max[k])
+					box.max[k] = bin_boxes[b - 1].max[k];
+			}
+
+			if(0 == left_size || left_size == count)
+				continue;
+
+			const float cost = left_size*box.half_area() + right_costs[b];
+
+			if(cost < best_cost)
+			{
+				best_cost = cost;
+				best_bin = b;
+			}
+		}
+
+		// The lowest and highest centroids land in the first and last bins, so there is
+		// always a boundary with entries on both sides.
+		size_t i = first, j = last;
+
+		while(i < j)
+		{
+			size_t b = static_cast<size_t>((entries[i].centroid[axis] - centroid_min[axis])*bin_scale);
+
+			if(b >= bin_count)
+				b = bin_count - 1;
+
+			if(b < best_bin)
+				i++;
+			else
+				swap(entries[i], entries[--j]);
+		}
+
+		split = i;
+	}
+
+	build_node(entries, first, split);
+	nodes[node_index].offset = static_cast<uint32_t>(nodes.size());
+	nodes[node_index].count = 0;
+	build_node(entries, split, last);
+}
+
+void triangle_bvh::refit(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles)
+{
+	for(size_t i = 0; i < triangle_indices.size(); i++)
+	{
+		const indexed_triangle &t = triangles[triangle_indices[i]];
+
+		triangle_vertices[i*3 + 0] = vertices[t.vertex_indices[0]];
+		triangle_vertices[i*3 + 1] = vertices[t.vertex_indices[1]];
+		triangle_vertices[i*3 + 2] = vertices[t.vertex_indices[2]];
+	}
+
+	// Children come after their parent, so going backwards fits them first.
+	for(size_t i = nodes.size(); i > 0; i--)
+		fit_node(i - 1);
+}
+
+void triangle_bvh::fit_node(const size_t node_index)
+{
+	bvh_node &n = nodes[node_index];
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		n.min[k] = numeric_limits<float>::max();
+		n.max[k] = -numeric_limits<float>::max();
+	}
+
+	if(true == n.is_leaf())
+	{
+		for(size_t i = n.offset*3; i < (n.offset + n.count)*3; i++)
+		{
+			const float c[3] = { triangle_vertices[i].x, triangle_vertices[i].y, triangle_vertices[i].z };
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(c[k] < n.min[k])
+					n.min[k] = c[k];
+
+				if(c[k] > n.max[k])
+					n.max[k] = c[k];
+			}
+		}
+	}
+	else
+	{
+		const bvh_node &left = nodes[node_index + 1];
+		const bvh_node &right = nodes[n.offset];
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			n.min[k] = (left.min[k] < right.min[k]) ? left.min[k] : right.min[k];
+			n.max[k] = (left.max[k] > right.max[k]) ? left.max[k] : right.max[k];
+		}
+	}
+}
+
+void triangle_bvh::clear(void)
+{
+	nodes.clear();
+	triangle_indices.clear();
+	triangle_vertices.clear();
+}
+
+size_t triangle_bvh::memory_usage(void) const
+{
+	return nodes.capacity()*sizeof(bvh_node) + triangle_indices.capacity()*sizeof(mesh_index) + triangle_vertices.capacity()*sizeof(vertex_3);
+}
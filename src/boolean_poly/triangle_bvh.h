@@ -0,0 +1,101 @@
+#ifndef TRIANGLE_BVH_H
+#define TRIANGLE_BVH_H
+
+#include "../common/primitives.h"
+
+#include <vector>
+using std::vector;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <algorithm>
+using std::swap;
+
+
+// 32 bytes, so that two nodes share a cache line.
+class bvh_node
+{
+public:
+	float min[3];
+	uint32_t offset; // Interior: index of the second child (the first is the next node). Leaf: first triangle slot.
+	float max[3];
+	uint32_t count;  // Leaf: number of triangle slots. Interior: zero.
+
+	inline bool is_leaf(void) const
+	{
+		return 0 != count;
+	}
+
+	inline bool overlaps(const bvh_node &right) const
+	{
+		return min[0] <= right.max[0] && right.min[0] <= max[0] &&
+		       min[1] <= right.max[1] && right.min[1] <= max[1] &&
+		       min[2] <= right.max[2] && right.min[2] <= max[2];
+	}
+
+	inline float half_area(void) const
+	{
+		const float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+
+		return dx*dy + dy*dz + dz*dx;
+	}
+};
+
+// A bounding volume hierarchy over a mesh's triangles.
+//
+// The boxes are axis aligned, and each interior node is split where a binned surface
+// area heuristic says the two halves are cheapest to search. The nodes are stored
+// depth first in one array, so a node's first child is the node after it, and
+// the leaves hold slots in one array of triangles, copied out of the mesh in leaf
+// order. A traversal that reaches a leaf reads its triangles' corners from
+// consecutive memory, without going through the mesh's vertex indices.
+//
+// After a rigid move (e.g. an implant being positioned against a bone) the tree can be
+// refitted to the moved vertices, which keeps its shape and only recomputes the boxes.
+class triangle_bvh
+{
+public:
+	// Returns false if there are no triangles, or more than the node offsets can address.
+	bool build(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles);
+
+	// The triangles must be the ones the tree was built over.
+	void refit(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles);
+
+	void clear(void);
+	size_t memory_usage(void) const;
+
+	inline bool empty(void) const
+	{
+		return 0 == nodes.size();
+	}
+
+	// The corners of the triangle in a slot.
+	inline const vertex_3 *slot_vertices(const size_t slot) const
+	{
+		return &triangle_vertices[slot*3];
+	}
+
+	static const size_t max_leaf_size = 4;
+	static const size_t bin_count = 16;
+
+	vector<bvh_node> nodes;
+	vector<mesh_index> triangle_indices; // The mesh triangle in each slot.
+	vector<vertex_3> triangle_vertices;  // Three corners per slot.
+
+private:
+	class build_entry
+	{
+	public:
+		float min[3];
+		float max[3];
+		float centroid[3];
+		mesh_index triangle;
+	};
+
+	void build_node(vector<build_entry> &entries, const size_t first, const size_t last);
+	void fit_node(const size_t node_index);
+};
+
+
+#endif
@@ -0,0 +1,266 @@
+#include "triangle_intersection.h"
+
+#include <cfloat> // for DBL_EPSILON
+
+
+static inline void subtract(const double a[3], const double b[3], double out[3])
+{
+	out[0] = a[0] - b[0];
+	out[1] = a[1] - b[1];
+	out[2] = a[2] - b[2];
+}
+
+static inline void cross(const double a[3], const double b[3], double out[3])
+{
+	out[0] = a[1]*b[2] - a[2]*b[1];
+	out[1] = a[2]*b[0] - a[0]*b[2];
+	out[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+static inline double dot(const double a[3], const double b[3])
+{
+	return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+// Signed distances (scaled by the normal's length) of the points p from the plane of
+// triangle t, snapped to zero where they are within rounding error of it.
+// Returns false if t is degenerate.
+static bool plane_distances(const double t[3][3], const double p[3][3], double normal[3], double distances[3])
+{
+	double e1[3], e2[3];
+	subtract(t[1], t[0], e1);
+	subtract(t[2], t[0], e2);
+	cross(e1, e2, normal);
+
+	if(0.0 == dot(normal, normal))
+		return false;
+
+	// Rounding in the cross product and the dot product is at most a few ulps of
+	// |e1||e2||p - t0|; 16 ulps leaves a comfortable margin.
+	const double scale = 16.0*DBL_EPSILON*sqrt(dot(e1, e1)*dot(e2, e2));
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		double v[3];
+		subtract(p[i], t[0], v);
+
+		distances[i] = dot(normal, v);
+
+		if(fabs(distances[i]) <= scale*sqrt(dot(v, v)))
+			distances[i] = 0.0;
+	}
+
+	return true;
+}
+
+// The one or two points where a triangle meets a plane it straddles or touches,
+// given its vertices' distances from that plane. Returns the number of points.
+static size_t plane_crossings(const double p[3][3], const double distances[3], double points[2][3])
+{
+	size_t count = 0;
+
+	for(size_t i = 0; i < 3 && count < 2; i++)
+	{
+		const size_t j = (i + 1) % 3;
+
+		if(0.0 == distances[i])
+		{
+			points[count][0] = p[i][0];
+			points[count][1] = p[i][1];
+			points[count][2] = p[i][2];
+			count++;
+		}
+		else if((distances[i] < 0.0 && distances[j] > 0.0) || (distances[i] > 0.0 && distances[j] < 0.0))
+		{
+			const double t = distances[i] / (distances[i] - distances[j]);
+
+			points[count][0] = p[i][0] + (p[j][0] - p[i][0])*t;
+			points[count][1] = p[i][1] + (p[j][1] - p[i][1])*t;
+			points[count][2] = p[i][2] + (p[j][2] - p[i][2])*t;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static inline bool same_side(const double distances[3])
+{
+	if(distances[0] > 0.0 && distances[1] > 0.0 && distances[2] > 0.0)
+		return true;
+
+	if(distances[0] < 0.0 && distances[1] < 0.0 && distances[2] < 0.0)
+		return true;
+
+	return false;
+}
+
+static inline double orient_2d(const double a[2], const double b[2], const double c[2])
+{
+	return (b[0] - a[0])*(c[1] - a[1]) - (b[1] - a[1])*(c[0] - a[0]);
+}
+
+// Whether closed segments pq and rs meet.
+static bool segments_meet_2d(const double p[2], const double q[2], const double r[2], const double s[2])
+{
+	const double o1 = orient_2d(p, q, r);
+	const double o2 = orient_2d(p, q, s);
+	const double o3 = orient_2d(r, s, p);
+	const double o4 = orient_2d(r, s, q);
+
+	if(0.0 == o1 && 0.0 == o2)
+	{
+		// Collinear: compare their extents along whichever axis the segments span more of.
+		const size_t axis = (fabs(q[0] - p[0]) + fabs(s[0] - r[0]) >= fabs(q[1] - p[1]) + fabs(s[1] - r[1])) ? 0 : 1;
+
+		const double pq_min = (p[axis] < q[axis]) ? p[axis] : q[axis];
+		const double pq_max = (p[axis] < q[axis]) ? q[axis] : p[axis];
+		const double rs_min = (r[axis] < s[axis]) ? r[axis] : s[axis];
+		const double rs_max = (r[axis] < s[axis]) ? s[axis] : r[axis];
+
+		return pq_min <= rs_max && rs_min <= pq_max;
+	}
+
+	if((o1 > 0.0 && o2 > 0.0) || (o1 < 0.0 && o2 < 0.0))
+		return false;
+
+	if((o3 > 0.0 && o4 > 0.0) || (o3 < 0.0 && o4 < 0.0))
+		return false;
+
+	return true;
+}
+
+static bool point_in_triangle_2d(const double p[2], const double t[3][2])
+{
+	const double o0 = orient_2d(t[0], t[1], p);
+	const double o1 = orient_2d(t[1], t[2], p);
+	const double o2 = orient_2d(t[2], t[0], p);
+
+	if(o0 >= 0.0 && o1 >= 0.0 && o2 >= 0.0)
+		return true;
+
+	if(o0 <= 0.0 && o1 <= 0.0 && o2 <= 0.0)
+		return true;
+
+	return false;
+}
+
+// Both triangles lie in the plane with the given normal. Projects them onto the
+// coordinate plane that the normal is closest to, and tests them for overlap there.
+static bool coplanar_triangles_overlap(const double a[3][3], const double b[3][3], const double normal[3])
+{
+	size_t u = 1, v = 2;
+
+	if(fabs(normal[1]) > fabs(normal[0]) && fabs(normal[1]) >= fabs(normal[2]))
+		u = 0;
+	else if(fabs(normal[2]) > fabs(normal[0]) && fabs(normal[2]) > fabs(normal[1]))
+	{
+		u = 0;
+		v = 1;
+	}
+
+	double a_2d[3][2], b_2d[3][2];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		a_2d[i][0] = a[i][u];
+		a_2d[i][1] = a[i][v];
+		b_2d[i][0] = b[i][u];
+		b_2d[i][1] = b[i][v];
+	}
+
+	for(size_t i = 0; i < 3; i++)
+		for(size_t j = 0; j < 3; j++)
+			if(true == segments_meet_2d(a_2d[i], a_2d[(i + 1) % 3], b_2d[j], b_2d[(j + 1) % 3]))
+				return true;
+
+	// No edges cross, so either one triangle holds the other or they are apart.
+	if(true == point_in_triangle_2d(a_2d[0], b_2d) || true == point_in_triangle_2d(b_2d[0], a_2d))
+		return true;
+
+	return false;
+}
+
+triangle_intersection intersect_triangles(const vertex_3 a[3], const vertex_3 b[3], vertex_3 &segment_start, vertex_3 &segment_end)
+{
+	double pa[3][3], pb[3][3];
+
+	for(size_t i = 0; i < 3; i++)
+	{
+		pa[i][0] = a[i].x;
+		pa[i][1] = a[i].y;
+		pa[i][2] = a[i].z;
+		pb[i][0] = b[i].x;
+		pb[i][1] = b[i].y;
+		pb[i][2] = b[i].z;
+	}
+
+	double normal_b[3], distances_a[3];
+
+	if(false == plane_distances(pb, pa, normal_b, distances_a))
+		return TRIANGLES_DISJOINT;
+
+	if(true == same_side(distances_a))
+		return TRIANGLES_DISJOINT;
+
+	double normal_a[3], distances_b[3];
+
+	if(false == plane_distances(pa, pb, normal_a, distances_b))
+		return TRIANGLES_DISJOINT;
+
+	if(true == same_side(distances_b))
+		return TRIANGLES_DISJOINT;
+
+	if((0.0 == distances_a[0] && 0.0 == distances_a[1] && 0.0 == distances_a[2]) ||
+	   (0.0 == distances_b[0] && 0.0 == distances_b[1] && 0.0 == distances_b[2]))
+	{
+		if(true == coplanar_triangles_overlap(pa, pb, normal_b))
+			return TRIANGLES_COPLANAR;
+
+		return TRIANGLES_DISJOINT;
+	}
+
+	// Both triangles meet the line where the planes cross; compare where, along its direction.
+	double points_a[2][3], points_b[2][3];
+	const size_t count_a = plane_crossings(pa, distances_a, points_a);
+	const size_t count_b = plane_crossings(pb, distances_b, points_b);
+
+	if(0 == count_a || 0 == count_b)
+		return TRIANGLES_DISJOINT;
+
+	double direction[3];
+	cross(normal_a, normal_b, direction);
+
+	double t_a[2], t_b[2];
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		t_a[i] = dot(direction, points_a[i < count_a ? i : 0]);
+		t_b[i] = dot(direction, points_b[i < count_b ? i : 0]);
+	}
+
+	// Order each interval so that index 0 is its low end.
+	size_t lo_a = 0, lo_b = 0;
+
+	if(2 == count_a && t_a[1] < t_a[0])
+		lo_a = 1;
+
+	if(2 == count_b && t_b[1] < t_b[0])
+		lo_b = 1;
+
+	const size_t hi_a = (2 == count_a) ? 1 - lo_a : 0;
+	const size_t hi_b = (2 == count_b) ? 1 - lo_b : 0;
+
+	const double *start = (t_a[lo_a] >= t_b[lo_b]) ? points_a[lo_a] : points_b[lo_b];
+	const double *end = (t_a[hi_a] <= t_b[hi_b]) ? points_a[hi_a] : points_b[hi_b];
+	const double start_t = (t_a[lo_a] >= t_b[lo_b]) ? t_a[lo_a] : t_b[lo_b];
+	const double end_t = (t_a[hi_a] <= t_b[hi_b]) ? t_a[hi_a] : t_b[hi_b];
+
+	if(start_t > end_t)
+		return TRIANGLES_DISJOINT;
+
+	segment_start = vertex_3(static_cast<float>(start[0]), static_cast<float>(start[1]), static_cast<float>(start[2]));
+	segment_end = vertex_3(static_cast<float>(end[0]), static_cast<float>(end[1]), static_cast<float>(end[2]));
+
+	return TRIANGLES_CROSSING;
+}
@@ -0,0 +1,32 @@
+#ifndef TRIANGLE_INTERSECTION_H
+#define TRIANGLE_INTERSECTION_H
+
+#include "../common/primitives.h"
+
+
+enum triangle_intersection
+{
+	TRIANGLES_DISJOINT,
+	TRIANGLES_CROSSING, // The triangles meet along a segment (or at a point, where they only touch)
+	TRIANGLES_COPLANAR  // The triangles lie in one plane and overlap
+};
+
+// See: A Fast Triangle-Triangle Intersection Test by T. Moller
+//
+// Each triangle is tested against the plane of the other; if both straddle (or touch)
+// the other's plane, the two cut the line where the planes meet in an interval each,
+// and the triangles intersect where those intervals overlap. That overlap is the
+// intersection segment, which is returned in segment_start and segment_end.
+//
+// The arithmetic is done in double. A vertex whose distance from the other plane is
+// within the rounding error of computing it counts as lying on the plane, so contacts
+// that are too close to call come out as touching, never as a miss. If all three
+// vertices of a lie on b's plane, the triangles are tested for overlap in that plane
+// instead, and the segment is left as it is.
+//
+// Degenerate (zero area) triangles intersect nothing; their edges belong to the
+// triangles around them.
+triangle_intersection intersect_triangles(const vertex_3 a[3], const vertex_3 b[3], vertex_3 &segment_start, vertex_3 &segment_end);
+
+
+#endif
@@ -0,0 +1,138 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+
+mapped_file::mapped_file(void)
+{
+	map_data = 0;
+	map_size = 0;
+
+#ifdef _WIN32
+	file_handle = INVALID_HANDLE_VALUE;
+	mapping_handle = 0;
+#else
+	file_descriptor = -1;
+#endif
+}
+
+mapped_file::~mapped_file(void)
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const char *const file_name)
+{
+	close();
+
+	file_handle = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+
+	if(INVALID_HANDLE_VALUE == file_handle)
+		return false;
+
+	LARGE_INTEGER file_size;
+
+	if(0 == GetFileSizeEx(file_handle, &file_size) || 0 == file_size.QuadPart)
+	{
+		close();
+		return false;
+	}
+
+	mapping_handle = CreateFileMappingA(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+
+	if(0 == mapping_handle)
+	{
+		close();
+		return false;
+	}
+
+	map_data = static_cast<const char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+	if(0 == map_data)
+	{
+		close();
+		return false;
+	}
+
+	map_size = static_cast<size_t>(file_size.QuadPart);
+
+	return true;
+}
+
+void mapped_file::close(void)
+{
+	if(0 != map_data)
+		UnmapViewOfFile(map_data);
+
+	if(0 != mapping_handle)
+		CloseHandle(mapping_handle);
+
+	if(INVALID_HANDLE_VALUE != file_handle)
+		CloseHandle(file_handle);
+
+	map_data = 0;
+	map_size = 0;
+	mapping_handle = 0;
+	file_handle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool mapped_file::open(const char *const file_name)
+{
+	close();
+
+	file_descriptor = ::open(file_name, O_RDONLY);
+
+	if(-1 == file_descriptor)
+		return false;
+
+	struct stat file_status;
+
+	// mmap() refuses zero-length mappings.
+	if(-1 == fstat(file_descriptor, &file_status) || 0 == file_status.st_size)
+	{
+		close();
+		return false;
+	}
+
+	void *p = mmap(0, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+	if(MAP_FAILED == p)
+	{
+		close();
+		return false;
+	}
+
+	map_data = static_cast<const char *>(p);
+	map_size = static_cast<size_t>(file_status.st_size);
+
+	// The file is parsed front to back exactly once, so ask for aggressive read-ahead.
+	madvise(p, map_size, MADV_SEQUENTIAL);
+
+	return true;
+}
+
+void mapped_file::close(void)
+{
+	if(0 != map_data)
+		munmap(const_cast<char *>(map_data), map_size);
+
+	if(-1 != file_descriptor)
+		::close(file_descriptor);
+
+	map_data = 0;
+	map_size = 0;
+	file_descriptor = -1;
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+
+// Read-only memory mapping of a whole file.
+// The mapping is released by close() or by the destructor.
+class mapped_file
+{
+public:
+	mapped_file(void);
+	~mapped_file(void);
+
+	bool open(const char *const file_name);
+	void close(void);
+
+	inline const char *data(void) const { return map_data; }
+	inline size_t size(void) const { return map_size; }
+
+private:
+	// Non-copyable.
+	mapped_file(const mapped_file &);
+	mapped_file &operator=(const mapped_file &);
+
+	const char *map_data;
+	size_t map_size;
+
+#ifdef _WIN32
+	void *file_handle;
+	void *mapping_handle;
+#else
+	int file_descriptor;
+#endif
+};
+
+
+#endif
@@ -0,0 +1,1579 @@
+#include "mesh.h"
+
+static const size_t stl_header_size = 80;
+
+// Enough bytes for twelve 4-byte floats plus one 2-byte integer, per triangle.
+static const size_t stl_per_triangle_data_size = (12*sizeof(float) + sizeof(short unsigned int));
+
+static bool is_ascii_stereo_lithography_header(const char *const header)
+{
+	if( 's' == tolower(header[0]) &&
+		'o' == tolower(header[1]) && 
+		'l' == tolower(header[2]) && 
+		'i' == tolower(header[3]) && 
+		'd' == tolower(header[4]) )
+	{
+		cout << "Encountered ASCII STL file header -- aborting." << endl;
+		return true;
+	}
+
+	return false;
+}
+
+bool indexed_mesh::load_from_binary_stereo_lithography_file(const char *const file_name, const bool generate_normals, const size_t buffer_width, const weld_mode mode, const float weld_epsilon)
+{
+	clear();
+
+	if(WELD_EPSILON_GRID == mode && !(weld_epsilon > 0.0f))
+	{
+		cout << "Error -- epsilon grid welding needs a positive epsilon. Aborting." << endl;
+		return false;
+	}
+
+	cout << "Reading file: " << file_name << endl;
+
+	ifstream in(file_name, ios_base::binary);
+
+	if(in.fail())
+		return false;
+
+	const size_t header_size = stl_header_size;
+	vector<char> buffer(header_size, 0);
+	unsigned int num_triangles = 0; // Must be 4-byte unsigned int.
+
+	// Read header.
+	in.read(reinterpret_cast<char *>(&(buffer[0])), header_size);
+
+	if(header_size != in.gcount())
+		return false;
+
+	if(true == is_ascii_stereo_lithography_header(&buffer[0]))
+		return false;
+
+	// Read number of triangles.
+	in.read(reinterpret_cast<char *>(&num_triangles), sizeof(unsigned int));
+
+	if(sizeof(unsigned int) != in.gcount())
+		return false;
+
+	triangles.resize(num_triangles);
+
+	cout << "Triangles:    " << triangles.size() << endl;
+
+	const size_t per_triangle_data_size = stl_per_triangle_data_size;
+	const size_t buffer_size = per_triangle_data_size * buffer_width;
+	buffer.resize(buffer_size, 0);
+
+	size_t num_triangles_remaining = triangles.size();
+	size_t tri_index = 0;
+	set<indexed_vertex_3> vertex_set;
+	vertex_welder welder(0, (WELD_EPSILON_GRID == mode) ? weld_epsilon : 0.0f);
+
+	// A closed mesh has roughly half as many vertices as triangles.
+	if(WELD_EXACT_SET != mode)
+		welder.reserve(triangles.size()/2 + 1);
+
+	while(num_triangles_remaining > 0)
+	{
+		size_t num_triangles_to_read = buffer_width;
+
+		if(num_triangles_remaining < buffer_width)
+			num_triangles_to_read = num_triangles_remaining;
+
+		size_t data_size = per_triangle_data_size*num_triangles_to_read;
+
+		in.read(reinterpret_cast<char *>(&buffer[0]), data_size);
+
+		if(data_size != in.gcount() || in.fail())
+			return false;
+
+		num_triangles_remaining -= num_triangles_to_read;
+
+		if(false == weld_facets(&buffer[0], num_triangles_to_read, tri_index, mode, welder, vertex_set))
+			return false;
+
+		tri_index += num_triangles_to_read;
+	}
+
+	generate_adjacency();
+
+	cout << "Vertices:     " << triangles.size()*3 << " (of which " << vertices.size() << " are unique)" << endl;
+	print_memory_usage();
+
+	in.close();
+
+	if(true == generate_normals)
+	{
+		cout << "Generating normals" << endl;
+		generate_vertex_and_triangle_normals();
+	}
+
+	return true;
+} 
+
+bool indexed_mesh::load_from_mapped_binary_stereo_lithography_file(const char *const file_name, const bool generate_normals, const weld_mode mode, const float weld_epsilon, const size_t num_threads)
+{
+	clear();
+
+	if(WELD_EPSILON_GRID == mode && !(weld_epsilon > 0.0f))
+	{
+		cout << "Error -- epsilon grid welding needs a positive epsilon. Aborting." << endl;
+		return false;
+	}
+
+	cout << "Mapping file: " << file_name << endl;
+
+	mapped_file file;
+
+	if(false == file.open(file_name))
+		return false;
+
+	if(file.size() < stl_header_size + sizeof(unsigned int))
+		return false;
+
+	const char *const data = file.data();
+
+	if(true == is_ascii_stereo_lithography_header(data))
+		return false;
+
+	unsigned int num_triangles = 0; // Must be 4-byte unsigned int.
+	memcpy(&num_triangles, data + stl_header_size, sizeof(unsigned int));
+
+	// Check the whole file up front, so that the parser never has to.
+	const size_t expected_size = stl_header_size + sizeof(unsigned int) + stl_per_triangle_data_size*num_triangles;
+
+	if(file.size() < expected_size)
+	{
+		cout << "Error -- file holds " << file.size() << " bytes, but " << num_triangles << " triangles need " << expected_size << ". Aborting." << endl;
+		return false;
+	}
+
+	if(file.size() > expected_size)
+		cout << "Ignoring " << file.size() - expected_size << " trailing bytes" << endl;
+
+	triangles.resize(num_triangles);
+
+	cout << "Triangles:    " << triangles.size() << endl;
+
+	// Parse the facet records straight out of the mapping.
+	const char *const facet_data = data + stl_header_size + sizeof(unsigned int);
+
+	if(num_threads > 1 && WELD_EXACT_SET != mode)
+	{
+		if(false == weld_facets_in_parallel(facet_data, triangles.size(), (WELD_EPSILON_GRID == mode) ? weld_epsilon : 0.0f, num_threads))
+			return false;
+	}
+	else
+	{
+		set<indexed_vertex_3> vertex_set;
+		vertex_welder welder(0, (WELD_EPSILON_GRID == mode) ? weld_epsilon : 0.0f);
+
+		// A closed mesh has roughly half as many vertices as triangles.
+		if(WELD_EXACT_SET != mode)
+			welder.reserve(triangles.size()/2 + 1);
+
+		if(false == weld_facets(facet_data, triangles.size(), 0, mode, welder, vertex_set))
+			return false;
+	}
+
+	file.close();
+
+	generate_adjacency(num_threads);
+
+	cout << "Vertices:     " << triangles.size()*3 << " (of which " << vertices.size() << " are unique)" << endl;
+	print_memory_usage();
+
+	if(true == generate_normals)
+	{
+		cout << "Generating normals" << endl;
+		generate_vertex_and_triangle_normals();
+	}
+
+	return true;
+}
+
+bool indexed_mesh::weld_facets(const char *facet_data, const size_t num_facets, const size_t first_tri_index, const weld_mode mode, vertex_welder &welder, set<indexed_vertex_3> &vertex_set)
+{
+	const char *cp = facet_data;
+	size_t tri_index = first_tri_index;
+
+	for(size_t i = 0; i < num_facets; i++)
+	{
+		// Skip face normal. We will calculate them manually later.
+		cp += 3*sizeof(float);
+
+		// For each of the three vertices in the triangle.
+		for(short unsigned int j = 0; j < 3; j++)
+		{
+			vertex_3 v;
+
+			// Get vertex components.
+			memcpy(&v.x, cp, sizeof(float)); cp += sizeof(float);
+			memcpy(&v.y, cp, sizeof(float)); cp += sizeof(float);
+			memcpy(&v.z, cp, sizeof(float)); cp += sizeof(float);
+
+			if(vertex_welder::max_vertex_count == vertices.size())
+			{
+				cout << "Error -- too many unique vertices for " << 8*sizeof(mesh_index) << "-bit indices. Aborting." << endl;
+				return false;
+			}
+
+			if(WELD_EXACT_SET == mode)
+			{
+				weld_vertex_using_set(vertex_set, v, tri_index, j);
+				continue;
+			}
+
+			const size_t index = welder.weld(v);
+
+			// If vertex is new, add it to vector
+			if(index == vertices.size())
+				vertices.push_back(v);
+
+			// Assign vertex index to triangle
+			triangles[tri_index].vertex_indices[j] = static_cast<mesh_index>(index);
+		}
+
+		// Skip attribute.
+		cp += sizeof(short unsigned int);
+
+		tri_index++;
+	}
+
+	return true;
+}
+
+size_t indexed_mesh::memory_usage(void) const
+{
+	return triangles.capacity()*sizeof(indexed_triangle) +
+		vertices.capacity()*sizeof(vertex_3) +
+		vertex_to_triangle_indices.memory_usage() +
+		vertex_to_vertex_indices.memory_usage() +
+		vertex_normals.capacity()*sizeof(vertex_3) +
+		triangle_normals.capacity()*sizeof(vertex_3);
+}
+
+void indexed_mesh::print_memory_usage(void) const
+{
+	const size_t adjacency_size = vertex_to_triangle_indices.memory_usage() + vertex_to_vertex_indices.memory_usage();
+
+	cout << "Memory:       " << memory_usage() / 1048576 << " MB using " << 8*sizeof(mesh_index) << "-bit indices";
+	cout << " (triangles " << triangles.capacity()*sizeof(indexed_triangle) / 1048576 << " MB, adjacency " << adjacency_size / 1048576 << " MB)" << endl;
+}
+
+void indexed_mesh::generate_adjacency(const size_t num_threads)
+{
+	generate_vertex_to_triangle_indices();
+	generate_vertex_to_vertex_indices(num_threads);
+}
+
+void indexed_mesh::generate_vertex_to_triangle_indices(void)
+{
+	csr_adjacency &adj = vertex_to_triangle_indices;
+
+	adj.clear();
+	adj.offsets.resize(vertices.size() + 1, 0);
+
+	// Counting pass.
+	for(size_t i = 0; i < triangles.size(); i++)
+		for(size_t j = 0; j < 3; j++)
+			adj.offsets[triangles[i].vertex_indices[j] + 1]++;
+
+	for(size_t i = 0; i < vertices.size(); i++)
+		adj.offsets[i + 1] += adj.offsets[i];
+
+	adj.neighbours.resize(adj.offsets[vertices.size()]);
+
+	// Filling pass. Triangle indices go in in increasing order, so each row comes out sorted.
+	vector<size_t> fill(adj.offsets.begin(), adj.offsets.end() - 1);
+
+	for(size_t i = 0; i < triangles.size(); i++)
+		for(size_t j = 0; j < 3; j++)
+			adj.neighbours[fill[triangles[i].vertex_indices[j]]++] = static_cast<mesh_index>(i);
+}
+
+// Collects the sorted, unique neighbours of vertex i into scratch.
+static void gather_vertex_neighbours(const vector<indexed_triangle> &triangles, const csr_adjacency &vertex_to_triangle_indices, const size_t i, vector<mesh_index> &scratch)
+{
+	scratch.clear();
+
+	const mesh_index *tris = vertex_to_triangle_indices.row(i);
+
+	for(size_t j = 0; j < vertex_to_triangle_indices.count(i); j++)
+		for(size_t k = 0; k < 3; k++)
+			if(i != triangles[tris[j]].vertex_indices[k]) // Don't add current vertex index to its own adjacency list.
+				scratch.push_back(triangles[tris[j]].vertex_indices[k]);
+
+	sort(scratch.begin(), scratch.end());
+	scratch.erase(unique(scratch.begin(), scratch.end()), scratch.end());
+}
+
+// Counting pass for vertices [first_vertex, last_vertex): offsets[i + 1] = neighbour count of i.
+static void count_vertex_neighbours(const vector<indexed_triangle> &triangles, const csr_adjacency &vertex_to_triangle_indices, csr_adjacency &vertex_to_vertex_indices, const size_t first_vertex, const size_t last_vertex)
+{
+	vector<mesh_index> scratch;
+
+	for(size_t i = first_vertex; i < last_vertex; i++)
+	{
+		gather_vertex_neighbours(triangles, vertex_to_triangle_indices, i, scratch);
+		vertex_to_vertex_indices.offsets[i + 1] = scratch.size();
+	}
+}
+
+// Filling pass for vertices [first_vertex, last_vertex).
+static void fill_vertex_neighbours(const vector<indexed_triangle> &triangles, const csr_adjacency &vertex_to_triangle_indices, csr_adjacency &vertex_to_vertex_indices, const size_t first_vertex, const size_t last_vertex)
+{
+	vector<mesh_index> scratch;
+
+	for(size_t i = first_vertex; i < last_vertex; i++)
+	{
+		gather_vertex_neighbours(triangles, vertex_to_triangle_indices, i, scratch);
+		copy(scratch.begin(), scratch.end(), vertex_to_vertex_indices.row(i));
+	}
+}
+
+void indexed_mesh::generate_vertex_to_vertex_indices(const size_t num_threads)
+{
+	csr_adjacency &adj = vertex_to_vertex_indices;
+
+	adj.clear();
+	adj.offsets.resize(vertices.size() + 1, 0);
+
+	// Every vertex's row depends only on its own triangles, so the vertices can simply be split up.
+	const size_t num_ranges = (num_threads > 1) ? num_threads : 1;
+	vector<thread> threads;
+
+	for(size_t t = 0; t < num_ranges; t++)
+		threads.push_back(thread(count_vertex_neighbours, cref(triangles), cref(vertex_to_triangle_indices), ref(adj), vertices.size()*t / num_ranges, vertices.size()*(t + 1) / num_ranges));
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	for(size_t i = 0; i < vertices.size(); i++)
+		adj.offsets[i + 1] += adj.offsets[i];
+
+	adj.neighbours.resize(adj.offsets[vertices.size()]);
+
+	for(size_t t = 0; t < num_ranges; t++)
+		threads.push_back(thread(fill_vertex_neighbours, cref(triangles), cref(vertex_to_triangle_indices), ref(adj), vertices.size()*t / num_ranges, vertices.size()*(t + 1) / num_ranges));
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+}
+
+// Welding state of one contiguous range of facets, for the parallel loader.
+class facet_range_weld
+{
+public:
+	size_t first_facet;
+	size_t num_facets;
+
+	// Unique vertices of this range, in order of first appearance within the range.
+	vector<vertex_3> local_vertices;
+
+	// Local vertex indices, bucketed by the partition of the key space they hash to.
+	vector< vector<uint32_t> > partition_members;
+
+	// For each local vertex, the range and local index of its first appearance in the whole file.
+	vector<uint32_t> first_range;
+	vector<uint32_t> first_local;
+
+	vector<mesh_index> local_to_global;
+	size_t num_new_vertices;
+};
+
+// Pass 1: weld a range of facets on its own, storing range-local indices in the triangles.
+static void weld_facet_range(const char *const facet_data, const float weld_epsilon, const size_t num_partitions, vector<indexed_triangle> &triangles, facet_range_weld &range)
+{
+	const char *cp = facet_data + range.first_facet*stl_per_triangle_data_size;
+	vertex_welder welder(range.num_facets/2 + 1, weld_epsilon);
+
+	for(size_t i = 0; i < range.num_facets; i++)
+	{
+		// Skip face normal.
+		cp += 3*sizeof(float);
+
+		for(size_t j = 0; j < 3; j++)
+		{
+			vertex_3 v;
+
+			memcpy(&v.x, cp, sizeof(float)); cp += sizeof(float);
+			memcpy(&v.y, cp, sizeof(float)); cp += sizeof(float);
+			memcpy(&v.z, cp, sizeof(float)); cp += sizeof(float);
+
+			const size_t index = welder.weld(v);
+
+			if(index == range.local_vertices.size())
+				range.local_vertices.push_back(v);
+
+			triangles[range.first_facet + i].vertex_indices[j] = static_cast<mesh_index>(index);
+		}
+
+		// Skip attribute.
+		cp += sizeof(short unsigned int);
+	}
+
+	// Use the high bits of the hash for the partition; the low bits pick the table slot.
+	range.partition_members.resize(num_partitions);
+
+	for(size_t i = 0; i < range.local_vertices.size(); i++)
+		range.partition_members[static_cast<size_t>((welder.key_hash(range.local_vertices[i]) >> 32) % num_partitions)].push_back(static_cast<uint32_t>(i));
+
+	range.first_range.resize(range.local_vertices.size());
+	range.first_local.resize(range.local_vertices.size());
+}
+
+// Pass 2: find where in the file each vertex of one key space partition first appears.
+// Ranges are visited in file order, so the first hit is the first appearance.
+static void find_first_appearances(const float weld_epsilon, const size_t partition, vector<facet_range_weld> &ranges)
+{
+	vertex_welder welder(0, weld_epsilon);
+	vector<uint32_t> first_range;
+	vector<uint32_t> first_local;
+
+	for(size_t r = 0; r < ranges.size(); r++)
+	{
+		const vector<uint32_t> &members = ranges[r].partition_members[partition];
+
+		for(size_t i = 0; i < members.size(); i++)
+		{
+			const uint32_t local = members[i];
+			const size_t id = welder.weld(ranges[r].local_vertices[local]);
+
+			if(id == first_range.size())
+			{
+				first_range.push_back(static_cast<uint32_t>(r));
+				first_local.push_back(local);
+			}
+
+			ranges[r].first_range[local] = first_range[id];
+			ranges[r].first_local[local] = first_local[id];
+		}
+	}
+}
+
+// Pass 3: give the range's first appearances their global indices, starting at first_global_index.
+static void number_new_vertices(const size_t range_index, const size_t first_global_index, vector<vertex_3> &vertices, vector<facet_range_weld> &ranges)
+{
+	facet_range_weld &range = ranges[range_index];
+	size_t global_index = first_global_index;
+
+	range.local_to_global.resize(range.local_vertices.size());
+
+	for(size_t i = 0; i < range.local_vertices.size(); i++)
+	{
+		if(range_index != range.first_range[i] || i != range.first_local[i])
+			continue;
+
+		vertices[global_index] = range.local_vertices[i];
+		range.local_to_global[i] = static_cast<mesh_index>(global_index++);
+	}
+}
+
+// Pass 4: resolve the remaining vertices through their first appearance, and renumber the range's triangles.
+static void remap_facet_range(const size_t range_index, vector<indexed_triangle> &triangles, vector<facet_range_weld> &ranges)
+{
+	facet_range_weld &range = ranges[range_index];
+
+	for(size_t i = 0; i < range.local_vertices.size(); i++)
+		if(range_index != range.first_range[i] || i != range.first_local[i])
+			range.local_to_global[i] = ranges[range.first_range[i]].local_to_global[range.first_local[i]];
+
+	for(size_t i = range.first_facet; i < range.first_facet + range.num_facets; i++)
+		for(size_t j = 0; j < 3; j++)
+			triangles[i].vertex_indices[j] = range.local_to_global[triangles[i].vertex_indices[j]];
+}
+
+bool indexed_mesh::weld_facets_in_parallel(const char *facet_data, const size_t num_facets, const float weld_epsilon, const size_t num_threads)
+{
+	vector<facet_range_weld> ranges(num_threads);
+	vector<thread> threads;
+
+	for(size_t t = 0; t < num_threads; t++)
+	{
+		ranges[t].first_facet = num_facets*t / num_threads;
+		ranges[t].num_facets = num_facets*(t + 1) / num_threads - ranges[t].first_facet;
+		ranges[t].num_new_vertices = 0;
+
+		threads.push_back(thread(weld_facet_range, facet_data, weld_epsilon, num_threads, ref(triangles), ref(ranges[t])));
+	}
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	for(size_t p = 0; p < num_threads; p++)
+		threads.push_back(thread(find_first_appearances, weld_epsilon, p, ref(ranges)));
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	// Vertices are numbered in order of first appearance, just like the serial loader does,
+	// so each range's new vertices follow those of all earlier ranges.
+	size_t num_vertices = 0;
+	vector<size_t> first_global_indices(num_threads);
+
+	for(size_t r = 0; r < ranges.size(); r++)
+	{
+		for(size_t i = 0; i < ranges[r].local_vertices.size(); i++)
+			if(r == ranges[r].first_range[i] && i == ranges[r].first_local[i])
+				ranges[r].num_new_vertices++;
+
+		first_global_indices[r] = num_vertices;
+		num_vertices += ranges[r].num_new_vertices;
+	}
+
+	if(num_vertices > vertex_welder::max_vertex_count)
+	{
+		cout << "Error -- too many unique vertices for " << 8*sizeof(mesh_index) << "-bit indices. Aborting." << endl;
+		return false;
+	}
+
+	vertices.resize(num_vertices);
+
+	for(size_t r = 0; r < ranges.size(); r++)
+		threads.push_back(thread(number_new_vertices, r, first_global_indices[r], ref(vertices), ref(ranges)));
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	threads.clear();
+
+	for(size_t r = 0; r < ranges.size(); r++)
+		threads.push_back(thread(remap_facet_range, r, ref(triangles), ref(ranges)));
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	return true;
+}
+
+void indexed_mesh::weld_vertex_using_set(set<indexed_vertex_3> &vertex_set, const vertex_3 &src_v, const size_t tri_index, const size_t j)
+{
+	indexed_vertex_3 v(src_v.x, src_v.y, src_v.z);
+
+	// Look for vertex in set.
+	set<indexed_vertex_3>::const_iterator find_iter = vertex_set.find(v);
+
+	// If vertex not found in set...
+	if(vertex_set.end() == find_iter)
+	{
+		// Assign new vertices index
+		v.index = vertices.size();
+
+		// Add vertex to set
+		vertex_set.insert(v);
+
+		// Add vertex to vector
+		vertex_3 indexless_vertex;
+		indexless_vertex.x = v.x;
+		indexless_vertex.y = v.y;
+		indexless_vertex.z = v.z;
+		vertices.push_back(indexless_vertex);
+
+		// Assign vertex index to triangle
+		triangles[tri_index].vertex_indices[j] = static_cast<mesh_index>(v.index);
+	}
+	else
+	{
+		// Assign existing vertex index to triangle
+		triangles[tri_index].vertex_indices[j] = static_cast<mesh_index>(find_iter->index);
+	}
+}
+
+bool indexed_mesh::save_to_binary_stereo_lithography_file(const char *const file_name, const size_t buffer_width)
+{
+	cout << "Writing file: " << file_name << endl;
+	cout << "Triangles:    " << triangles.size() << endl;
+	cout << "Vertices:     " << triangles.size()*3 << endl;
+
+	if(0 == triangles.size())
+		return false;
+
+	// Write to file.
+	ofstream out(file_name, ios_base::binary);
+
+	if(out.fail())
+		return false;
+
+	const size_t header_size = 80;
+	vector<char> buffer(header_size, 0);
+	const unsigned int num_triangles = triangles.size(); // Must be 4-byte unsigned int.
+	vertex_3 normal;
+
+	// Write blank header.
+	out.write(reinterpret_cast<const char *>(&(buffer[0])), header_size);
+
+	// Write number of triangles.
+	out.write(reinterpret_cast<const char *>(&num_triangles), sizeof(unsigned int));
+
+	// Enough bytes for twelve 4-byte floats plus one 2-byte integer, per triangle.
+	const size_t per_triangle_data_size = (12*sizeof(float) + sizeof(short unsigned int));
+	const size_t buffer_size = per_triangle_data_size * buffer_width;
+	buffer.resize(buffer_size, 0);
+
+	// Use a pointer to assist with the copying.
+	// Should probably use std::copy() instead, but memcpy() does the trick, so whatever...
+	char *cp = &buffer[0];
+	size_t buffer_count = 0;
+
+	cout << "Writing " << per_triangle_data_size*triangles.size() / 1048576 << " MB of data to disk" << endl;
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		// Copy face normal if it's been calculated, otherwise manually calculate it.
+		if(triangle_normals.size() == triangles.size())
+		{
+			normal = triangle_normals[i];
+		}
+		else
+		{
+			vertex_3 v0 = vertices[triangles[i].vertex_indices[1]] - vertices[triangles[i].vertex_indices[0]];
+			vertex_3 v1 = vertices[triangles[i].vertex_indices[2]] - vertices[triangles[i].vertex_indices[0]];
+			normal = v0.cross(v1);
+			normal.normalize();
+		}
+
+		memcpy(cp, &normal.x, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &normal.y, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &normal.z, sizeof(float)); cp += sizeof(float);
+
+		memcpy(cp, &vertices[triangles[i].vertex_indices[0]].x, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[0]].y, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[0]].z, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[1]].x, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[1]].y, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[1]].z, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[2]].x, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[2]].y, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &vertices[triangles[i].vertex_indices[2]].z, sizeof(float)); cp += sizeof(float);
+
+		cp += sizeof(short unsigned int);
+
+		buffer_count++;
+
+		// If buffer is full, write triangles in buffer to disk.
+		if(buffer_count == buffer_width)
+		{
+			out.write(reinterpret_cast<const char *>(&buffer[0]), buffer_size);
+
+			if(out.fail())
+				return false;
+
+			buffer_count = 0;
+			cp = &buffer[0];
+		}
+	}
+
+	// Write any remaining triangles in buffer to disk.
+	// This will occur whenever triangles.size() % buffer_width != 0
+	// (ie. when triangle count is not a multiple of buffer_width, which should happen almost all of the time).
+	if(buffer_count > 0)
+	{
+		out.write(reinterpret_cast<const char *>(&buffer[0]), per_triangle_data_size*buffer_count);
+
+		if(out.fail())
+			return false;
+	}
+
+	out.close();
+
+	return true;
+} 
+
+// This produces results that are practically identical to Meshlab
+void indexed_mesh::laplace_smooth(const float scale)
+{
+	vector<vertex_3> displacements(vertices.size(), vertex_3(0, 0, 0));
+
+	// Get per-vertex displacement.
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		// Skip rogue vertices (which are not referenced by any triangle).
+		const size_t neighbour_count = vertex_to_vertex_indices.count(i);
+
+		if(0 == neighbour_count)
+			continue;
+
+		const float weight = 1.0f / static_cast<float>(neighbour_count);
+		const mesh_index *neighbours = vertex_to_vertex_indices.row(i);
+
+		for(size_t j = 0; j < neighbour_count; j++)
+		{
+			size_t neighbour_j = neighbours[j];
+			displacements[i] += (vertices[neighbour_j] - vertices[i])*weight;
+		}
+	}
+
+	// Apply per-vertex displacement.
+	for(size_t i = 0; i < vertices.size(); i++)
+		vertices[i] += displacements[i]*scale;
+}
+
+void indexed_mesh::taubin_smooth(const float lambda, const float mu, const size_t steps, const size_t num_threads, const smoothing_weights weights)
+{
+	cout << "Smoothing mesh using Taubin lambda|mu algorithm ";
+
+	if(SMOOTH_COTANGENT == weights)
+		cout << "(cotangent weighting)" << endl;
+	else
+		cout << "(inverse neighbour count weighting)" << endl;
+
+	smoothing_engine engine;
+
+	if(false == engine.init(vertices, vertex_to_vertex_indices, weights, triangles))
+	{
+		// Too large for the engine's 32-bit gathers, so fall back to the plain sweeps.
+		if(SMOOTH_COTANGENT == weights)
+			cout << "Mesh too large for cotangent weighting, using inverse neighbour count weighting" << endl;
+
+		for(size_t s = 0; s < steps; s++)
+		{
+			cout << "Step " << s + 1 << " of " << steps << endl;
+
+			laplace_smooth(lambda);
+			laplace_smooth(mu);
+		}
+	}
+	else
+	{
+		cout << "Running " << steps << " steps on " << num_threads << " thread(s) using the " << engine.instruction_set() << " kernel" << endl;
+
+		engine.taubin_smooth(lambda, mu, steps, num_threads);
+		engine.get_positions(vertices);
+	}
+
+	// Recalculate normals, if necessary.
+	regenerate_vertex_and_triangle_normals_if_exists();
+}
+
+void indexed_mesh::hc_smooth(const float alpha, const float beta, const size_t steps, const size_t num_threads, const smoothing_weights weights)
+{
+	cout << "Smoothing mesh using HC algorithm ";
+
+	if(SMOOTH_COTANGENT == weights)
+		cout << "(cotangent weighting)" << endl;
+	else
+		cout << "(inverse neighbour count weighting)" << endl;
+
+	smoothing_engine engine;
+
+	if(false == engine.init(vertices, vertex_to_vertex_indices, weights, triangles))
+	{
+		cout << "Error: Mesh too large for HC smoothing" << endl;
+		return;
+	}
+
+	cout << "Running " << steps << " steps on " << num_threads << " thread(s) using the " << engine.instruction_set() << " kernel" << endl;
+
+	engine.hc_smooth(alpha, beta, steps, num_threads);
+	engine.get_positions(vertices);
+
+	// Recalculate normals, if necessary.
+	regenerate_vertex_and_triangle_normals_if_exists();
+}
+
+void indexed_mesh::decimate(const size_t target_triangle_count, const float max_error, const float crease_angle)
+{
+	cout << "Decimating mesh using quadric error metrics" << endl;
+
+	if(vertex_to_triangle_indices.size() != vertices.size())
+		generate_vertex_to_triangle_indices();
+
+	quadric_decimator decimator;
+	decimator.init(vertices, triangles, vertex_to_triangle_indices, crease_angle);
+
+	const size_t num_collapses = decimator.decimate(target_triangle_count, max_error);
+
+	cout << "Collapsed " << num_collapses << " edges, leaving " << decimator.triangle_count() << " of " << triangles.size() << " triangles" << endl;
+
+	decimator.get_mesh(vertices, triangles);
+
+	generate_adjacency();
+
+	// Recalculate normals, if necessary.
+	regenerate_vertex_and_triangle_normals_if_exists();
+}
+
+void indexed_mesh::set_max_extent(float max_extent)
+{
+	float curr_x_min = numeric_limits<float>::max();
+	float curr_y_min = numeric_limits<float>::max();
+	float curr_z_min = numeric_limits<float>::max();
+	float curr_x_max = numeric_limits<float>::min();
+	float curr_y_max = numeric_limits<float>::min();
+	float curr_z_max = numeric_limits<float>::min();
+
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		if(vertices[i].x < curr_x_min)
+			curr_x_min = vertices[i].x;
+
+		if(vertices[i].x > curr_x_max)
+			curr_x_max = vertices[i].x;
+
+		if(vertices[i].y < curr_y_min)
+			curr_y_min = vertices[i].y;
+
+		if(vertices[i].y > curr_y_max)
+			curr_y_max = vertices[i].y;
+
+		if(vertices[i].z < curr_z_min)
+			curr_z_min = vertices[i].z;
+
+		if(vertices[i].z > curr_z_max)
+			curr_z_max = vertices[i].z;
+	}
+
+	float curr_x_extent = fabsf(curr_x_min - curr_x_max);
+	float curr_y_extent = fabsf(curr_y_min - curr_y_max);
+	float curr_z_extent = fabsf(curr_z_min - curr_z_max);
+
+	float curr_max_extent = curr_x_extent;
+
+	if(curr_y_extent > curr_max_extent)
+		curr_max_extent = curr_y_extent;
+
+	if(curr_z_extent > curr_max_extent)
+		curr_max_extent = curr_z_extent;
+
+	float scale_value = max_extent / curr_max_extent;
+
+	cout << "Original max extent: " << curr_max_extent << endl;
+	cout << "Scaling all vertices by a factor of: " << scale_value << endl;
+	cout << "New max extent: " << max_extent << endl;
+
+	for(size_t i = 0; i < vertices.size(); i++)
+		vertices[i] *= scale_value;
+}
+
+bool indexed_mesh::save_to_povray_mesh2_file(const char *const file_name, const bool write_vertex_normals)
+{
+	cout << "Triangle count: " << triangles.size() << endl;
+
+	if(0 == triangles.size())
+		return false;
+
+	if(true == write_vertex_normals && vertex_normals.size() != vertices.size())
+		generate_vertex_normals();
+
+	// Write to file.
+	ofstream out(file_name);
+
+	if(out.fail())
+		return false;
+
+	out << setiosflags(ios_base::fixed);
+
+	cout << "Writing data to " << file_name << endl;
+
+	// Bump up output precision to help keep very small triangles from becoming degenerate.
+	//out << setprecision(18);
+
+	out << " vertex_vectors" << endl;
+	out << " {" << endl;
+	out << "  " << vertices.size() << ',' << endl;
+
+	for(size_t i = 0; i < vertices.size() - 1; i++)
+		out << "  <" << vertices[i].x << ',' << vertices[i].y << ',' << vertices[i].z << ">," << endl;
+
+	out << "  <" << vertices[vertices.size() - 1].x << ',' << vertices[vertices.size() - 1].y << ',' << vertices[vertices.size() - 1].z << '>' << endl;
+	out << " }" << endl;
+
+	if(true == write_vertex_normals)
+	{
+		out << " normal_vectors" << endl;
+		out << " {" << endl;
+		out << "  " << vertex_normals.size() << ',' << endl;
+
+		for(size_t i = 0; i < vertex_normals.size() - 1; i++)
+			out << "  <" << vertex_normals[i].x << ',' << vertex_normals[i].y << ',' << vertex_normals[i].z << ">," << endl;
+
+		out << "  <" << vertex_normals[vertex_normals.size() - 1].x << ',' << vertex_normals[vertex_normals.size() - 1].y << ',' << vertex_normals[vertex_normals.size() - 1].z << '>' << endl;
+		out << " }" << endl;
+	}
+
+	out << " face_indices" << endl;
+	out << " {" << endl;
+	out << "  " << triangles.size() << ',' << endl;
+
+	for(size_t i = 0; i < triangles.size() - 1; i++)
+		out << "  <" << triangles[i].vertex_indices[0] << ',' << triangles[i].vertex_indices[1] << ',' << triangles[i].vertex_indices[2] << ">," << endl;
+
+	out << "  <" << triangles[triangles.size() - 1].vertex_indices[0] << ',' << triangles[triangles.size() - 1].vertex_indices[1] << ',' << triangles[triangles.size() - 1].vertex_indices[2]<< ">" << endl;
+	out << " }" << endl;
+
+	out.close();
+
+	return true;
+}
+
+void indexed_mesh::generate_vertex_normals(void)
+{
+	if(triangles.size() == 0 || vertices.size() == 0)
+		return;
+
+	if(vertex_to_triangle_indices.size() != vertices.size())
+		generate_vertex_to_triangle_indices();
+
+	// Unnormalized, so that larger triangles weigh more.
+	vector<vertex_3> face_normals(triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		vertex_3 v0 = vertices[triangles[i].vertex_indices[1]] - vertices[triangles[i].vertex_indices[0]];
+		vertex_3 v1 = vertices[triangles[i].vertex_indices[2]] - vertices[triangles[i].vertex_indices[0]];
+		face_normals[i] = v0.cross(v1);
+	}
+
+	vertex_normals.clear();
+	vertex_normals.resize(vertices.size());
+
+	// Gather each vertex's triangles through the adjacency, rather than scattering to three vertices per triangle.
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		const mesh_index *tris = vertex_to_triangle_indices.row(i);
+
+		for(size_t j = 0; j < vertex_to_triangle_indices.count(i); j++)
+			vertex_normals[i] = vertex_normals[i] + face_normals[tris[j]];
+
+		vertex_normals[i].normalize();
+	}
+}
+
+void indexed_mesh::generate_triangle_normals(void)
+{
+	if(triangles.size() == 0)
+		return;
+
+	triangle_normals.clear();
+	triangle_normals.resize(triangles.size());
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		vertex_3 v0 = vertices[triangles[i].vertex_indices[1]] - vertices[triangles[i].vertex_indices[0]];
+		vertex_3 v1 = vertices[triangles[i].vertex_indices[2]] - vertices[triangles[i].vertex_indices[0]];
+		triangle_normals[i] = v0.cross(v1);
+		triangle_normals[i].normalize();
+	}
+}
+
+void indexed_mesh::generate_vertex_and_triangle_normals(void)
+{
+	generate_vertex_normals();
+	generate_triangle_normals();
+}
+
+void indexed_mesh::regenerate_vertex_and_triangle_normals_if_exists(void)
+{
+	if(triangle_normals.size() > 0)
+		generate_triangle_normals();
+
+	if(vertex_normals.size() > 0)
+		generate_vertex_normals();
+}
+
+// Uniform grid over the problem edges' centre points, with the cell size set to the mean
+// problem edge length, so that a cell holds a handful of edges wherever the cracks run.
+// The entries are sorted by cell and then by edge, so a cell is a contiguous run,
+// found by binary search. A search stops widening once its rings span more cells than
+// there are edges, and scans the edges instead, so no search costs more than a scan.
+class edge_centre_grid
+{
+public:
+	edge_centre_grid(const vector<ordered_indexed_edge> &edges, const vector<vertex_3> &vertices) : edges(edges)
+	{
+		float length_sum = 0;
+
+		for(size_t i = 0; i < edges.size(); i++)
+			length_sum += sqrt(vertices[edges[i].indices[0]].distance_sq(vertices[edges[i].indices[1]]));
+
+		cell_size = length_sum / static_cast<float>(edges.size());
+
+		if(!(cell_size > 0.0f))
+			cell_size = 1.0f;
+
+		entries.resize(edges.size());
+
+		for(size_t i = 0; i < edges.size(); i++)
+		{
+			get_cell(edges[i].centre_point, entries[i].cell);
+			entries[i].edge = i;
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(0 == i || entries[i].cell[k] < min_cell[k])
+					min_cell[k] = entries[i].cell[k];
+
+				if(0 == i || entries[i].cell[k] > max_cell[k])
+					max_cell[k] = entries[i].cell[k];
+			}
+		}
+
+		sort(entries.begin(), entries.end());
+
+		max_search_ring = 0;
+
+		while(static_cast<size_t>((2*max_search_ring + 3)*(2*max_search_ring + 3)*(2*max_search_ring + 3)) <= entries.size())
+			max_search_ring++;
+	}
+
+	// Returns the j > i whose centre point is nearest to that of edge i, the smallest such j on
+	// a tie, or 0 if there is none -- the same answer as a linear scan over j = i + 1 onwards.
+	size_t find_closest_following_edge(const size_t i) const
+	{
+		const vertex_3 &centre = edges[i].centre_point;
+		int64_t cell[3];
+		get_cell(centre, cell);
+
+		float closest_dist_sq = numeric_limits<float>::max();
+		size_t closest_index = 0;
+
+		int64_t max_ring = 0;
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			if(max_cell[k] - cell[k] > max_ring)
+				max_ring = max_cell[k] - cell[k];
+
+			if(cell[k] - min_cell[k] > max_ring)
+				max_ring = cell[k] - min_cell[k];
+		}
+
+		for(int64_t r = 0; r <= max_ring; r++)
+		{
+			// Anything outside rings 0 through r - 1 is at least (r - 1)*cell_size away.
+			// Stop only on a strictly closer match, so that ties still go to the smallest index.
+			const float ring_dist = static_cast<float>(r - 1)*cell_size;
+
+			if(r > 1 && closest_dist_sq < ring_dist*ring_dist)
+				break;
+
+			if(r > max_search_ring)
+				return scan_following_edges(i);
+
+			for(int64_t x = cell[0] - r; x <= cell[0] + r; x++)
+			{
+				if(x < min_cell[0] || x > max_cell[0])
+					continue;
+
+				for(int64_t y = cell[1] - r; y <= cell[1] + r; y++)
+				{
+					if(y < min_cell[1] || y > max_cell[1])
+						continue;
+
+					// Only the shell of the ring is new; inside it, just the two z faces are.
+					const bool on_shell = (x == cell[0] - r || x == cell[0] + r || y == cell[1] - r || y == cell[1] + r);
+					const int64_t z_step = (true == on_shell || 0 == r) ? 1 : 2*r;
+
+					for(int64_t z = cell[2] - r; z <= cell[2] + r; z += z_step)
+					{
+						if(z < min_cell[2] || z > max_cell[2])
+							continue;
+
+						search_cell(x, y, z, i, closest_dist_sq, closest_index);
+					}
+				}
+			}
+		}
+
+		return closest_index;
+	}
+
+private:
+	class entry
+	{
+	public:
+		int64_t cell[3];
+		size_t edge;
+
+		inline bool operator<(const entry &right) const
+		{
+			for(size_t k = 0; k < 3; k++)
+			{
+				if(cell[k] < right.cell[k])
+					return true;
+				else if(cell[k] > right.cell[k])
+					return false;
+			}
+
+			return edge < right.edge;
+		}
+	};
+
+	void get_cell(const vertex_3 &v, int64_t cell[3]) const
+	{
+		cell[0] = static_cast<int64_t>(floor(v.x / cell_size));
+		cell[1] = static_cast<int64_t>(floor(v.y / cell_size));
+		cell[2] = static_cast<int64_t>(floor(v.z / cell_size));
+	}
+
+	// The linear scan the grid stands in for.
+	size_t scan_following_edges(const size_t i) const
+	{
+		float closest_dist_sq = numeric_limits<float>::max();
+		size_t closest_index = 0;
+
+		for(size_t j = i + 1; j < edges.size(); j++)
+		{
+			const float dist_sq = edges[i].centre_point.distance_sq(edges[j].centre_point);
+
+			if(dist_sq < closest_dist_sq)
+			{
+				closest_dist_sq = dist_sq;
+				closest_index = j;
+			}
+		}
+
+		return closest_index;
+	}
+
+	void search_cell(const int64_t x, const int64_t y, const int64_t z, const size_t i, float &closest_dist_sq, size_t &closest_index) const
+	{
+		entry key;
+		key.cell[0] = x;
+		key.cell[1] = y;
+		key.cell[2] = z;
+		key.edge = i + 1;
+
+		// Skip straight past the cell's edges up to and including i.
+		vector<entry>::const_iterator ci = lower_bound(entries.begin(), entries.end(), key);
+
+		for( ; ci != entries.end() && ci->cell[0] == x && ci->cell[1] == y && ci->cell[2] == z; ci++)
+		{
+			const float dist_sq = edges[i].centre_point.distance_sq(edges[ci->edge].centre_point);
+
+			if(dist_sq < closest_dist_sq || (dist_sq == closest_dist_sq && ci->edge < closest_index))
+			{
+				closest_dist_sq = dist_sq;
+				closest_index = ci->edge;
+			}
+		}
+	}
+
+	const vector<ordered_indexed_edge> &edges;
+	vector<entry> entries;
+	float cell_size;
+	int64_t min_cell[3];
+	int64_t max_cell[3];
+	int64_t max_search_ring;
+};
+
+void indexed_mesh::fix_cracks(void)
+{
+	cout << "Finding cracks" << endl;
+
+	// The counting below walks the adjacency, so it must be that of the current triangles.
+	if(vertex_to_triangle_indices.size() != vertices.size() || vertex_to_vertex_indices.size() != vertices.size())
+		generate_adjacency();
+
+	// Find edges that do not belong to exactly two triangles. Each edge is visited once, from
+	// its lower vertex, so the edges come out in vertex index order, which is the order the
+	// pairing has always used.
+	vector<ordered_indexed_edge> problem_edges_vec;
+
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		const mesh_index *neighbours = vertex_to_vertex_indices.row(i);
+		const mesh_index *tris0 = vertex_to_triangle_indices.row(i);
+		const size_t tris0_count = vertex_to_triangle_indices.count(i);
+
+		for(size_t j = 0; j < vertex_to_vertex_indices.count(i); j++)
+		{
+			const size_t neighbour_j = neighbours[j];
+
+			if(neighbour_j < i)
+				continue;
+
+			const mesh_index *tris1 = vertex_to_triangle_indices.row(neighbour_j);
+			const size_t tris1_count = vertex_to_triangle_indices.count(neighbour_j);
+			size_t triangle_count = 0;
+
+			// Both triangle lists are sorted, so walk them in step. A triangle with a repeated
+			// vertex is listed once per corner, but has only the one edge; count it once.
+			for(size_t k = 0, l = 0; k < tris0_count && l < tris1_count; )
+			{
+				if(tris0[k] < tris1[l])
+				{
+					k++;
+				}
+				else if(tris1[l] < tris0[k])
+				{
+					l++;
+				}
+				else
+				{
+					const mesh_index shared = tris0[k];
+					triangle_count++;
+
+					while(k < tris0_count && shared == tris0[k])
+						k++;
+
+					while(l < tris1_count && shared == tris1[l])
+						l++;
+				}
+			}
+
+			if(2 == triangle_count)
+				continue;
+
+			indexed_vertex_3 v0;
+			v0.index = i;
+			v0.x = vertices[i].x;
+			v0.y = vertices[i].y;
+			v0.z = vertices[i].z;
+
+			indexed_vertex_3 v1;
+			v1.index = neighbour_j;
+			v1.x = vertices[neighbour_j].x;
+			v1.y = vertices[neighbour_j].y;
+			v1.z = vertices[neighbour_j].z;
+
+			ordered_indexed_edge problem_edge(v0, v1);
+			problem_edge.id = problem_edges_vec.size();
+			problem_edges_vec.push_back(problem_edge);
+		}
+	}
+
+	if(0 == problem_edges_vec.size())
+	{
+		cout << "No cracks found -- the mesh seems to be in good condition" << endl;
+		return;
+	}
+
+	cout << "Found " << problem_edges_vec.size() << " problem edges" << endl;
+
+	if(0 != problem_edges_vec.size() % 2)
+	{
+		cout << "Error -- the number of problem edges must be an even number (perhaps the mesh has holes?). Aborting." << endl;
+		return;
+	}
+
+	vector<bool> processed_problem_edges(problem_edges_vec.size(), false);
+
+	set<ordered_size_t_pair> merge_vertices;
+
+	cout << "Pairing problem edges" << endl;
+
+	const edge_centre_grid grid(problem_edges_vec, vertices);
+
+	// Each problem edge is practically a duplicate of some other, but not quite exactly.
+	// So, find the closest match for each problem edge.
+	for(size_t i = 0; i < problem_edges_vec.size(); i++)
+	{
+		// This edge has already been matched up previously, so skip it.
+		if(true == processed_problem_edges[problem_edges_vec[i].id])
+			continue;
+
+		// Note: Already processed edges are still candidates, as they always have been.
+		const size_t closest_problem_edges_vec_index = grid.find_closest_following_edge(i);
+
+		processed_problem_edges[problem_edges_vec[i].id] = true;
+		processed_problem_edges[problem_edges_vec[closest_problem_edges_vec_index].id] = true;
+
+		// If edge 0 vertex 0 is further in space from edge 1 vertex 0 than from edge 1 vertex 1,
+		// then swap the indices on the edge 1 -- this makes sure that the edges are not pointing
+		// in opposing directions.
+		if(vertices[problem_edges_vec[i].indices[0]].distance_sq(vertices[problem_edges_vec[closest_problem_edges_vec_index].indices[0]]) > vertices[problem_edges_vec[i].indices[0]].distance_sq(vertices[problem_edges_vec[closest_problem_edges_vec_index].indices[1]]))
+		{
+			size_t temp = problem_edges_vec[closest_problem_edges_vec_index].indices[0];
+			problem_edges_vec[closest_problem_edges_vec_index].indices[0] = problem_edges_vec[closest_problem_edges_vec_index].indices[1];
+			problem_edges_vec[closest_problem_edges_vec_index].indices[1] = temp;
+		}
+
+		// If the first indices aren't already the same, then merge them.
+		if(problem_edges_vec[i].indices[0] != problem_edges_vec[closest_problem_edges_vec_index].indices[0])
+			merge_vertices.insert(ordered_size_t_pair(problem_edges_vec[i].indices[0], problem_edges_vec[closest_problem_edges_vec_index].indices[0]));
+
+		// If the second indices aren't already the same, then merge them.
+		if(problem_edges_vec[i].indices[1] != problem_edges_vec[closest_problem_edges_vec_index].indices[1])
+			merge_vertices.insert(ordered_size_t_pair(problem_edges_vec[i].indices[1], problem_edges_vec[closest_problem_edges_vec_index].indices[1]));
+	}
+
+	cout << "Merging " << merge_vertices.size() << " vertex pairs" << endl;
+
+	merge_vertex_pairs(vector<ordered_size_t_pair>(merge_vertices.begin(), merge_vertices.end()));
+}
+
+// Root of v's set, halving the path on the way up.
+static size_t find_merge_root(vector<size_t> &parents, size_t v)
+{
+	while(parents[v] != v)
+	{
+		parents[v] = parents[parents[v]];
+		v = parents[v];
+	}
+
+	return v;
+}
+
+// One neighbour in an adjacency row, for rows that are put together out of order.
+class row_entry
+{
+public:
+	row_entry(const size_t src_row, const size_t src_index) : row(src_row), index(src_index) { /* custom constructor */ }
+
+	inline bool operator<(const row_entry &right) const
+	{
+		if(row != right.row)
+			return row < right.row;
+
+		return index < right.index;
+	}
+
+	inline bool operator==(const row_entry &right) const
+	{
+		return row == right.row && index == right.index;
+	}
+
+	size_t row;
+	size_t index;
+};
+
+// Carries the adjacency of the mesh before a merge over to the merged and compacted one.
+// The rows of vertices that the merge did not touch hold the same triangles and neighbours
+// as before, so they are only renumbered; the touched ones (the merged vertices, their
+// neighbours and the corners of dropped triangles) are gathered afresh. Either way each row
+// comes out as generate_adjacency() would make it.
+static void remap_adjacency(const vector<indexed_triangle> &triangles, const vector<size_t> &roots, const vector<bool> &touched, const vector<size_t> &vertex_remap, const vector<size_t> &triangle_remap, const size_t num_vertices, csr_adjacency &vertex_to_triangle_indices, csr_adjacency &vertex_to_vertex_indices)
+{
+	const size_t unreferenced = static_cast<size_t>(-1);
+	const csr_adjacency &old_triangle_rows = vertex_to_triangle_indices;
+	const csr_adjacency &old_vertex_rows = vertex_to_vertex_indices;
+
+	// The touched rows' triangles. A merged group's triangles all go to its root.
+	vector<row_entry> touched_entries;
+
+	for(size_t v = 0; v < touched.size(); v++)
+	{
+		if(false == touched[v])
+			continue;
+
+		const mesh_index *tris = old_triangle_rows.row(v);
+
+		for(size_t j = 0; j < old_triangle_rows.count(v); j++)
+		{
+			if(unreferenced == triangle_remap[tris[j]])
+				continue;
+
+			touched_entries.push_back(row_entry(vertex_remap[roots[v]], triangle_remap[tris[j]]));
+		}
+	}
+
+	sort(touched_entries.begin(), touched_entries.end());
+	touched_entries.erase(unique(touched_entries.begin(), touched_entries.end()), touched_entries.end());
+
+	csr_adjacency triangle_rows;
+	triangle_rows.offsets.resize(num_vertices + 1, 0);
+
+	for(size_t i = 0; i < touched_entries.size(); i++)
+		triangle_rows.offsets[touched_entries[i].row + 1]++;
+
+	for(size_t v = 0; v < touched.size(); v++)
+		if(unreferenced != vertex_remap[v] && false == touched[v])
+			triangle_rows.offsets[vertex_remap[v] + 1] = old_triangle_rows.count(v);
+
+	for(size_t i = 0; i < num_vertices; i++)
+		triangle_rows.offsets[i + 1] += triangle_rows.offsets[i];
+
+	triangle_rows.neighbours.resize(triangle_rows.offsets[num_vertices]);
+
+	// The entries are sorted, and each touched row is exactly as long as its run of them.
+	mesh_index *touched_row_entry = triangle_rows.neighbours.data();
+
+	for(size_t i = 0; i < touched_entries.size(); i++)
+	{
+		if(0 == i || touched_entries[i].row != touched_entries[i - 1].row)
+			touched_row_entry = triangle_rows.row(touched_entries[i].row);
+
+		*touched_row_entry++ = static_cast<mesh_index>(touched_entries[i].index);
+	}
+
+	for(size_t v = 0; v < touched.size(); v++)
+	{
+		if(unreferenced == vertex_remap[v] || true == touched[v])
+			continue;
+
+		const mesh_index *tris = old_triangle_rows.row(v);
+		mesh_index *row = triangle_rows.row(vertex_remap[v]);
+
+		for(size_t j = 0; j < old_triangle_rows.count(v); j++)
+			row[j] = static_cast<mesh_index>(triangle_remap[tris[j]]);
+	}
+
+	// The same for the neighbours, now that the triangle rows are in place.
+	csr_adjacency vertex_rows;
+	vertex_rows.offsets.resize(num_vertices + 1, 0);
+	vector<mesh_index> scratch;
+
+	for(size_t v = 0; v < touched.size(); v++)
+	{
+		if(unreferenced == vertex_remap[v])
+			continue;
+
+		if(true == touched[v])
+		{
+			gather_vertex_neighbours(triangles, triangle_rows, vertex_remap[v], scratch);
+			vertex_rows.offsets[vertex_remap[v] + 1] = scratch.size();
+		}
+		else
+		{
+			vertex_rows.offsets[vertex_remap[v] + 1] = old_vertex_rows.count(v);
+		}
+	}
+
+	for(size_t i = 0; i < num_vertices; i++)
+		vertex_rows.offsets[i + 1] += vertex_rows.offsets[i];
+
+	vertex_rows.neighbours.resize(vertex_rows.offsets[num_vertices]);
+
+	for(size_t v = 0; v < touched.size(); v++)
+	{
+		if(unreferenced == vertex_remap[v])
+			continue;
+
+		mesh_index *row = vertex_rows.row(vertex_remap[v]);
+
+		if(true == touched[v])
+		{
+			gather_vertex_neighbours(triangles, triangle_rows, vertex_remap[v], scratch);
+			copy(scratch.begin(), scratch.end(), row);
+		}
+		else
+		{
+			// The renumbering keeps the order, so the row stays sorted.
+			const mesh_index *neighbours = old_vertex_rows.row(v);
+
+			for(size_t j = 0; j < old_vertex_rows.count(v); j++)
+				row[j] = static_cast<mesh_index>(vertex_remap[neighbours[j]]);
+		}
+	}
+
+	vertex_to_triangle_indices.offsets.swap(triangle_rows.offsets);
+	vertex_to_triangle_indices.neighbours.swap(triangle_rows.neighbours);
+	vertex_to_vertex_indices.offsets.swap(vertex_rows.offsets);
+	vertex_to_vertex_indices.neighbours.swap(vertex_rows.neighbours);
+}
+
+void indexed_mesh::merge_vertex_pairs(const vector<ordered_size_t_pair> &pairs)
+{
+	// The adjacency is carried over, rather than rebuilt, if it is that of the current triangles.
+	const bool carry_adjacency = (vertex_to_triangle_indices.size() == vertices.size() && vertex_to_triangle_indices.neighbours.size() == 3*triangles.size() && vertex_to_vertex_indices.size() == vertices.size());
+
+	// Union-find over all pairs at once. Each set's root is its lowest index,
+	// so the vertex that is kept is the same one a pair-by-pair merge would keep.
+	vector<size_t> parents(vertices.size());
+
+	for(size_t i = 0; i < parents.size(); i++)
+		parents[i] = i;
+
+	for(size_t i = 0; i < pairs.size(); i++)
+	{
+		if(pairs[i].indices[0] >= vertices.size() || pairs[i].indices[1] >= vertices.size())
+			continue;
+
+		const size_t root0 = find_merge_root(parents, pairs[i].indices[0]);
+		const size_t root1 = find_merge_root(parents, pairs[i].indices[1]);
+
+		if(root0 < root1)
+			parents[root1] = root0;
+		else if(root1 < root0)
+			parents[root0] = root1;
+	}
+
+	for(size_t i = 0; i < parents.size(); i++)
+		find_merge_root(parents, i);
+
+	const size_t unreferenced = static_cast<size_t>(-1);
+	vector<bool> touched;
+	vector<size_t> triangle_remap;
+
+	if(true == carry_adjacency)
+	{
+		touched.resize(vertices.size(), false);
+		triangle_remap.resize(triangles.size(), unreferenced);
+
+		for(size_t i = 0; i < parents.size(); i++)
+		{
+			if(parents[i] == i)
+				continue;
+
+			touched[i] = true;
+			touched[parents[i]] = true;
+
+			const mesh_index *neighbours = vertex_to_vertex_indices.row(i);
+
+			for(size_t j = 0; j < vertex_to_vertex_indices.count(i); j++)
+				touched[neighbours[j]] = true;
+		}
+	}
+
+	// Point the triangles at the roots, dropping any that collapse to a line or a point.
+	size_t num_kept_triangles = 0;
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		indexed_triangle t;
+
+		for(size_t j = 0; j < 3; j++)
+			t.vertex_indices[j] = static_cast<mesh_index>(parents[triangles[i].vertex_indices[j]]);
+
+		if(t.vertex_indices[0] == t.vertex_indices[1] || t.vertex_indices[1] == t.vertex_indices[2] || t.vertex_indices[0] == t.vertex_indices[2])
+		{
+			if(true == carry_adjacency)
+				for(size_t j = 0; j < 3; j++)
+					touched[triangles[i].vertex_indices[j]] = true;
+
+			continue;
+		}
+
+		if(true == carry_adjacency)
+			triangle_remap[i] = num_kept_triangles;
+
+		triangles[num_kept_triangles++] = t;
+	}
+
+	const size_t num_degenerate_triangles = triangles.size() - num_kept_triangles;
+	triangles.resize(num_kept_triangles);
+
+	// Compact the vertices that are still referenced, keeping their order.
+	// New indices never exceed old ones, so the vertices can be moved down in place.
+	vector<size_t> remap(vertices.size(), unreferenced);
+
+	for(size_t i = 0; i < triangles.size(); i++)
+		for(size_t j = 0; j < 3; j++)
+			remap[triangles[i].vertex_indices[j]] = 0;
+
+	size_t num_kept_vertices = 0;
+
+	for(size_t i = 0; i < vertices.size(); i++)
+	{
+		if(unreferenced == remap[i])
+			continue;
+
+		remap[i] = num_kept_vertices;
+		vertices[num_kept_vertices++] = vertices[i];
+	}
+
+	const size_t num_removed_vertices = vertices.size() - num_kept_vertices;
+	vertices.resize(num_kept_vertices);
+
+	for(size_t i = 0; i < triangles.size(); i++)
+		for(size_t j = 0; j < 3; j++)
+			triangles[i].vertex_indices[j] = static_cast<mesh_index>(remap[triangles[i].vertex_indices[j]]);
+
+	cout << "Removed " << num_degenerate_triangles << " degenerate triangles and " << num_removed_vertices << " unused vertices" << endl;
+
+	if(true == carry_adjacency)
+		remap_adjacency(triangles, parents, touched, remap, triangle_remap, vertices.size(), vertex_to_triangle_indices, vertex_to_vertex_indices);
+	else
+		generate_adjacency();
+
+	// Recalculate normals, if necessary.
+	regenerate_vertex_and_triangle_normals_if_exists();
+}
@@ -0,0 +1,122 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "primitives.h"
+#include "vertex_welder.h"
+#include "mapped_file.h"
+#include "smoothing_engine.h"
+#include "quadric_decimator.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <fstream>
+using std::ifstream;
+using std::ofstream;
+
+#include <iomanip>
+using std::setiosflags;
+
+#include <ios>
+using std::ios_base;
+using std::ios;
+
+#include <set>
+using std::set;
+
+#include <vector>
+using std::vector;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <algorithm>
+using std::sort;
+using std::unique;
+
+#include <thread>
+using std::thread;
+
+#include <functional>
+using std::ref;
+using std::cref;
+
+#include <stdint.h>
+#include <cstring> // for memcpy()
+#include <cctype>
+
+
+class indexed_mesh
+{
+public:
+	void clear(void)
+	{
+		triangles.clear();
+		vertices.clear();
+		vertex_to_triangle_indices.clear();
+		vertex_to_vertex_indices.clear();
+		vertex_normals.clear();
+		triangle_normals.clear();
+	}
+
+	vector<indexed_triangle> triangles;
+	vector<vertex_3> vertices;
+	csr_adjacency vertex_to_triangle_indices;
+	csr_adjacency vertex_to_vertex_indices;
+	vector<vertex_3> vertex_normals;
+	vector<vertex_3> triangle_normals;
+
+	bool load_from_binary_stereo_lithography_file(const char *const file_name, const bool generate_normals = true, const size_t buffer_width = 65536, const weld_mode mode = WELD_EXACT_HASH, const float weld_epsilon = 0.0f);
+	// Same as above, but parses the facet records straight out of a memory-mapped file.
+	// With num_threads > 1 the facets are welded in parallel ranges; vertex indices come out
+	// identical to those of a serial load (the set-based weld mode always runs serially).
+	bool load_from_mapped_binary_stereo_lithography_file(const char *const file_name, const bool generate_normals = true, const weld_mode mode = WELD_EXACT_HASH, const float weld_epsilon = 0.0f, const size_t num_threads = 1);
+	bool save_to_binary_stereo_lithography_file(const char *const file_name, const size_t buffer_width = 65536);
+	bool save_to_povray_mesh2_file(const char *const file_name, const bool write_vertex_normals = false);
+
+	// Bytes held by the mesh's arrays, and a breakdown of them on cout.
+	size_t memory_usage(void) const;
+	void print_memory_usage(void) const;
+
+	// Rebuilds vertex_to_triangle_indices and vertex_to_vertex_indices from the triangles.
+	void generate_adjacency(const size_t num_threads = 1);
+
+	void set_max_extent(float max_extent);
+
+	// See: Geometric Signal Processing on Polygonal Meshes by G. Taubin
+	void laplace_smooth(const float scale);
+	void taubin_smooth(const float lambda, const float mu, const size_t steps, const size_t num_threads = 1, const smoothing_weights weights = SMOOTH_UNIFORM);
+
+	// See: Improved Laplacian Smoothing of Noisy Surface Meshes by J. Vollmer, R. Mencl and H. Mueller
+	// Typical values are alpha = 0.1 (or 0, to ignore the original positions) and beta = 0.5.
+	void hc_smooth(const float alpha, const float beta, const size_t steps, const size_t num_threads = 1, const smoothing_weights weights = SMOOTH_UNIFORM);
+
+	void fix_cracks(void);
+
+	// See: Surface Simplification Using Quadric Error Metrics by M. Garland and P. Heckbert
+	// Collapses edges, cheapest first, until at most target_triangle_count triangles are left or the
+	// next collapse would move the surface by more than about max_error. Boundary edges, and edges
+	// where the surface bends by more than crease_angle degrees, are held in place.
+	void decimate(const size_t target_triangle_count, const float max_error = numeric_limits<float>::max(), const float crease_angle = 45.0f);
+
+	// Merges every pair of vertices in one pass, keeping the lower index of each merged group.
+	// Triangles that collapse are dropped, then the vertices that no triangle uses are removed
+	// and the rest renumbered in order. The adjacency is carried over, with only the rows around
+	// merged vertices and dropped triangles gathered afresh, and any normals are rebuilt.
+	void merge_vertex_pairs(const vector<ordered_size_t_pair> &pairs);
+
+private:
+	bool weld_facets(const char *facet_data, const size_t num_facets, const size_t first_tri_index, const weld_mode mode, vertex_welder &welder, set<indexed_vertex_3> &vertex_set);
+	void weld_vertex_using_set(set<indexed_vertex_3> &vertex_set, const vertex_3 &src_v, const size_t tri_index, const size_t j);
+	bool weld_facets_in_parallel(const char *facet_data, const size_t num_facets, const float weld_epsilon, const size_t num_threads);
+	void generate_vertex_to_triangle_indices(void);
+	void generate_vertex_to_vertex_indices(const size_t num_threads);
+	void generate_vertex_normals(void);
+	void generate_triangle_normals(void);
+	void generate_vertex_and_triangle_normals(void);
+	void regenerate_vertex_and_triangle_normals_if_exists(void);
+};
+
+
+#endif
@@ -14,6 +14,18 @@ using std::vector;
 #include <iostream>
 using namespace std;
 
+#include <stdint.h>
+
+
+// Vertex and triangle indices are 32 bits wide, which is plenty for any mesh that fits
+// in a workstation's memory and halves the size of triangles and adjacency lists.
+// Define MESH_64_BIT_INDICES to build with 64-bit indices instead.
+#ifdef MESH_64_BIT_INDICES
+	typedef uint64_t mesh_index;
+#else
+	typedef uint32_t mesh_index;
+#endif
+
 
 class vertex_3
 {
@@ -269,7 +281,7 @@ public:
 class indexed_triangle
 {
 public:
-	size_t vertex_indices[3];
+	mesh_index vertex_indices[3];
 
 	inline bool operator==(const indexed_triangle &right) const
 	{
@@ -362,5 +374,51 @@ public:
 	size_t id;
 };
 
+// Compressed sparse row adjacency: the neighbours of element i are
+// neighbours[offsets[i]] through neighbours[offsets[i + 1] - 1].
+// Offsets stay size_t, since a vertex-to-triangle table holds three entries per triangle.
+// One flat allocation replaces a vector per element.
+class csr_adjacency
+{
+public:
+	inline void clear(void)
+	{
+		offsets.clear();
+		neighbours.clear();
+	}
+
+	// Number of elements (not neighbours).
+	inline size_t size(void) const
+	{
+		if(0 == offsets.size())
+			return 0;
+
+		return offsets.size() - 1;
+	}
+
+	inline size_t count(const size_t i) const
+	{
+		return offsets[i + 1] - offsets[i];
+	}
+
+	inline const mesh_index *row(const size_t i) const
+	{
+		return neighbours.data() + offsets[i];
+	}
+
+	inline mesh_index *row(const size_t i)
+	{
+		return neighbours.data() + offsets[i];
+	}
+
+	inline size_t memory_usage(void) const
+	{
+		return offsets.capacity()*sizeof(size_t) + neighbours.capacity()*sizeof(mesh_index);
+	}
+
+	vector<size_t> offsets;
+	vector<mesh_index> neighbours;
+};
+
 
 #endif
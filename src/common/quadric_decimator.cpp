@@ -0,0 +1,517 @@
+#include "quadric_decimator.h"
+
+#include <algorithm>
+using std::sort;
+using std::unique;
+using std::find;
+
+#include <cmath>
+
+
+// How much a boundary or crease edge's constraint planes count, against a triangle's plane.
+static const double constraint_weight = 1000.0;
+
+void quadric::add_plane(const double n[3], const double d, const double weight)
+{
+	a00 += weight*n[0]*n[0];
+	a01 += weight*n[0]*n[1];
+	a02 += weight*n[0]*n[2];
+	a11 += weight*n[1]*n[1];
+	a12 += weight*n[1]*n[2];
+	a22 += weight*n[2]*n[2];
+	b0 += weight*n[0]*d;
+	b1 += weight*n[1]*d;
+	b2 += weight*n[2]*d;
+	c += weight*d*d;
+}
+
+quadric &quadric::operator+=(const quadric &rhs)
+{
+	a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+	a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+	b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+	c += rhs.c;
+
+	return *this;
+}
+
+double quadric::evaluate(const double p[3]) const
+{
+	return a00*p[0]*p[0] + 2*a01*p[0]*p[1] + 2*a02*p[0]*p[2]
+		 + a11*p[1]*p[1] + 2*a12*p[1]*p[2] + a22*p[2]*p[2]
+		 + 2*(b0*p[0] + b1*p[1] + b2*p[2]) + c;
+}
+
+bool quadric::minimum(double p[3]) const
+{
+	// Solve A p = -b by Cramer's rule.
+	const double c00 = a11*a22 - a12*a12;
+	const double c01 = a02*a12 - a01*a22;
+	const double c02 = a01*a12 - a02*a11;
+	const double det = a00*c00 + a01*c01 + a02*c02;
+
+	// Planes that are (nearly) parallel leave a line or plane of minima; let the caller choose.
+	const double scale = a00 + a11 + a22;
+
+	if(fabs(det) <= 1e-9*scale*scale*scale)
+		return false;
+
+	const double c11 = a00*a22 - a02*a02;
+	const double c12 = a01*a02 - a00*a12;
+	const double c22 = a00*a11 - a01*a01;
+
+	p[0] = -(c00*b0 + c01*b1 + c02*b2) / det;
+	p[1] = -(c01*b0 + c11*b1 + c12*b2) / det;
+	p[2] = -(c02*b0 + c12*b1 + c22*b2) / det;
+
+	return true;
+}
+
+
+quadric_decimator::quadric_decimator(void)
+{
+	num_live_triangles = 0;
+}
+
+// Unit normal and length of the cross product of triangle (a, b, c), in doubles.
+static double triangle_normal(const double a[3], const double b[3], const double c[3], double n[3])
+{
+	const double e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+	const double e1[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+	n[0] = e0[1]*e1[2] - e0[2]*e1[1];
+	n[1] = e0[2]*e1[0] - e0[0]*e1[2];
+	n[2] = e0[0]*e1[1] - e0[1]*e1[0];
+
+	const double len = sqrt(n[0]*n[0] + n[1]*n[1] + n[2]*n[2]);
+
+	if(len > 0)
+	{
+		n[0] /= len;
+		n[1] /= len;
+		n[2] /= len;
+	}
+
+	return len;
+}
+
+void quadric_decimator::init(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles, const csr_adjacency &vertex_to_triangle_indices, const float crease_angle)
+{
+	const size_t num_vertices = vertices.size();
+
+	xs.resize(num_vertices);
+	ys.resize(num_vertices);
+	zs.resize(num_vertices);
+
+	for(size_t i = 0; i < num_vertices; i++)
+	{
+		xs[i] = vertices[i].x;
+		ys[i] = vertices[i].y;
+		zs[i] = vertices[i].z;
+	}
+
+	tris = triangles;
+	live_triangles.assign(tris.size(), true);
+	num_live_triangles = tris.size();
+
+	vertex_triangles.assign(num_vertices, vector<mesh_index>());
+
+	for(size_t i = 0; i < num_vertices && i < vertex_to_triangle_indices.size(); i++)
+		vertex_triangles[i].assign(vertex_to_triangle_indices.row(i), vertex_to_triangle_indices.row(i) + vertex_to_triangle_indices.count(i));
+
+	quadrics.assign(num_vertices, quadric());
+	boundary_vertices.assign(num_vertices, false);
+	versions.assign(num_vertices, 0);
+	heap = priority_queue<collapse>();
+
+	// Each triangle's plane goes to its three corners.
+	vector<double> normals(3*tris.size());
+
+	for(size_t t = 0; t < tris.size(); t++)
+	{
+		const mesh_index *v = tris[t].vertex_indices;
+		const double p[3][3] =
+		{
+			{ xs[v[0]], ys[v[0]], zs[v[0]] },
+			{ xs[v[1]], ys[v[1]], zs[v[1]] },
+			{ xs[v[2]], ys[v[2]], zs[v[2]] }
+		};
+
+		double *n = &normals[3*t];
+
+		if(0 == triangle_normal(p[0], p[1], p[2], n))
+			continue;
+
+		const double d = -(n[0]*p[0][0] + n[1]*p[0][1] + n[2]*p[0][2]);
+
+		for(size_t j = 0; j < 3; j++)
+			quadrics[v[j]].add_plane(n, d, 1.0);
+	}
+
+	// Boundary and crease edges. Each edge is visited from the triangles around its lower vertex.
+	const double crease_cos = cos(static_cast<double>(crease_angle)*3.14159265358979323846/180.0);
+
+	for(size_t u = 0; u < num_vertices; u++)
+	{
+		gather_neighbours(static_cast<mesh_index>(u), scratch0);
+
+		for(size_t k = 0; k < scratch0.size(); k++)
+		{
+			const mesh_index w = scratch0[k];
+
+			if(w < u)
+				continue;
+
+			// The triangles on edge u-w.
+			size_t edge_tris[2] = { 0, 0 };
+			size_t count = 0;
+
+			for(size_t i = 0; i < vertex_triangles[u].size(); i++)
+			{
+				const mesh_index *v = tris[vertex_triangles[u][i]].vertex_indices;
+
+				if(v[0] == w || v[1] == w || v[2] == w)
+				{
+					if(count < 2)
+						edge_tris[count] = vertex_triangles[u][i];
+
+					count++;
+				}
+			}
+
+			bool constrained = false;
+
+			if(1 == count)
+			{
+				constrained = true;
+				boundary_vertices[u] = boundary_vertices[w] = true;
+			}
+			else if(2 == count)
+			{
+				const double *n0 = &normals[3*edge_tris[0]];
+				const double *n1 = &normals[3*edge_tris[1]];
+
+				if(n0[0]*n1[0] + n0[1]*n1[1] + n0[2]*n1[2] < crease_cos)
+					constrained = true;
+			}
+
+			if(false == constrained)
+				continue;
+
+			const double pu[3] = { xs[u], ys[u], zs[u] };
+			const double pw[3] = { xs[w], ys[w], zs[w] };
+			const double e[3] = { pw[0] - pu[0], pw[1] - pu[1], pw[2] - pu[2] };
+
+			for(size_t i = 0; i < count && i < 2; i++)
+			{
+				const double *n = &normals[3*edge_tris[i]];
+
+				// The plane through the edge, at right angles to the triangle.
+				double m[3] = { e[1]*n[2] - e[2]*n[1], e[2]*n[0] - e[0]*n[2], e[0]*n[1] - e[1]*n[0] };
+				const double len = sqrt(m[0]*m[0] + m[1]*m[1] + m[2]*m[2]);
+
+				if(0 == len)
+					continue;
+
+				m[0] /= len;
+				m[1] /= len;
+				m[2] /= len;
+
+				const double d = -(m[0]*pu[0] + m[1]*pu[1] + m[2]*pu[2]);
+
+				quadrics[u].add_plane(m, d, constraint_weight);
+				quadrics[w].add_plane(m, d, constraint_weight);
+			}
+		}
+	}
+
+	for(size_t u = 0; u < num_vertices; u++)
+	{
+		gather_neighbours(static_cast<mesh_index>(u), scratch0);
+
+		for(size_t k = 0; k < scratch0.size(); k++)
+			if(scratch0[k] > u)
+				push_collapse(static_cast<mesh_index>(u), scratch0[k]);
+	}
+}
+
+// The sorted, unique vertices that share a live triangle with v.
+void quadric_decimator::gather_neighbours(const mesh_index v, vector<mesh_index> &neighbours) const
+{
+	neighbours.clear();
+
+	for(size_t i = 0; i < vertex_triangles[v].size(); i++)
+	{
+		const mesh_index *t = tris[vertex_triangles[v][i]].vertex_indices;
+
+		for(size_t j = 0; j < 3; j++)
+			if(v != t[j])
+				neighbours.push_back(t[j]);
+	}
+
+	sort(neighbours.begin(), neighbours.end());
+	neighbours.erase(unique(neighbours.begin(), neighbours.end()), neighbours.end());
+}
+
+void quadric_decimator::push_collapse(const mesh_index v0, const mesh_index v1)
+{
+	quadric q = quadrics[v0];
+	q += quadrics[v1];
+
+	collapse c;
+	c.v0 = v0;
+	c.v1 = v1;
+	c.version0 = versions[v0];
+	c.version1 = versions[v1];
+
+	if(true == q.minimum(c.position))
+	{
+		c.cost = q.evaluate(c.position);
+	}
+	else
+	{
+		// Take the best of the ends and the middle.
+		const double candidates[3][3] =
+		{
+			{ xs[v0], ys[v0], zs[v0] },
+			{ xs[v1], ys[v1], zs[v1] },
+			{ 0.5*(xs[v0] + xs[v1]), 0.5*(ys[v0] + ys[v1]), 0.5*(zs[v0] + zs[v1]) }
+		};
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			const double cost = q.evaluate(candidates[i]);
+
+			if(0 == i || cost < c.cost)
+			{
+				c.cost = cost;
+				c.position[0] = candidates[i][0];
+				c.position[1] = candidates[i][1];
+				c.position[2] = candidates[i][2];
+			}
+		}
+	}
+
+	// Rounding can take the error a little below zero.
+	if(c.cost < 0)
+		c.cost = 0;
+
+	heap.push(c);
+}
+
+bool quadric_decimator::collapse_is_valid(const collapse &c) const
+{
+	const mesh_index v0 = c.v0;
+	const mesh_index v1 = c.v1;
+
+	// The triangles on the edge, and their third vertices.
+	mesh_index opposite[2] = { 0, 0 };
+	size_t count = 0;
+
+	for(size_t i = 0; i < vertex_triangles[v0].size(); i++)
+	{
+		const mesh_index *t = tris[vertex_triangles[v0][i]].vertex_indices;
+
+		if(t[0] != v1 && t[1] != v1 && t[2] != v1)
+			continue;
+
+		if(2 == count)
+			return false; // A non-manifold edge.
+
+		for(size_t j = 0; j < 3; j++)
+			if(t[j] != v0 && t[j] != v1)
+				opposite[count] = t[j];
+
+		count++;
+	}
+
+	if(0 == count)
+		return false;
+
+	// An interior edge between two boundary vertices would join the boundaries.
+	if(2 == count && true == boundary_vertices[v0] && true == boundary_vertices[v1])
+		return false;
+
+	// Link condition: the ends may only share the neighbours across the edge's triangles.
+	gather_neighbours(v0, scratch0);
+	gather_neighbours(v1, scratch1);
+
+	size_t shared = 0;
+
+	for(size_t i = 0, j = 0; i < scratch0.size() && j < scratch1.size(); )
+	{
+		if(scratch0[i] < scratch1[j])
+			i++;
+		else if(scratch1[j] < scratch0[i])
+			j++;
+		else
+		{
+			if(scratch0[i] != opposite[0] && (count < 2 || scratch0[i] != opposite[1]))
+				return false;
+
+			shared++;
+			i++;
+			j++;
+		}
+	}
+
+	if(shared != count)
+		return false;
+
+	// No triangle that stays may turn over, or collapse to nothing.
+	const mesh_index ends[2] = { v0, v1 };
+
+	for(size_t e = 0; e < 2; e++)
+	{
+		for(size_t i = 0; i < vertex_triangles[ends[e]].size(); i++)
+		{
+			const mesh_index *t = tris[vertex_triangles[ends[e]][i]].vertex_indices;
+
+			if((t[0] == v0 || t[1] == v0 || t[2] == v0) && (t[0] == v1 || t[1] == v1 || t[2] == v1))
+				continue;
+
+			double before[3][3], after[3][3];
+
+			for(size_t j = 0; j < 3; j++)
+			{
+				before[j][0] = after[j][0] = xs[t[j]];
+				before[j][1] = after[j][1] = ys[t[j]];
+				before[j][2] = after[j][2] = zs[t[j]];
+
+				if(t[j] == ends[e])
+				{
+					after[j][0] = c.position[0];
+					after[j][1] = c.position[1];
+					after[j][2] = c.position[2];
+				}
+			}
+
+			double n_before[3], n_after[3];
+
+			if(0 == triangle_normal(after[0], after[1], after[2], n_after))
+				return false;
+
+			if(0 == triangle_normal(before[0], before[1], before[2], n_before))
+				continue;
+
+			if(n_before[0]*n_after[0] + n_before[1]*n_after[1] + n_before[2]*n_after[2] < 0.2)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void quadric_decimator::apply_collapse(const collapse &c)
+{
+	const mesh_index v0 = c.v0;
+	const mesh_index v1 = c.v1;
+
+	xs[v0] = c.position[0];
+	ys[v0] = c.position[1];
+	zs[v0] = c.position[2];
+
+	quadrics[v0] += quadrics[v1];
+	boundary_vertices[v0] = boundary_vertices[v0] || boundary_vertices[v1];
+
+	// Drop the edge's triangles, and point v1's others at v0.
+	for(size_t i = 0; i < vertex_triangles[v1].size(); i++)
+	{
+		const mesh_index t = vertex_triangles[v1][i];
+		mesh_index *v = tris[t].vertex_indices;
+
+		if(v[0] == v0 || v[1] == v0 || v[2] == v0)
+		{
+			live_triangles[t] = false;
+			num_live_triangles--;
+
+			// Take it off the lists of the edge's other vertex.
+			for(size_t j = 0; j < 3; j++)
+			{
+				if(v[j] == v1)
+					continue;
+
+				vector<mesh_index> &list = vertex_triangles[v[j]];
+				list.erase(find(list.begin(), list.end(), t));
+			}
+		}
+		else
+		{
+			for(size_t j = 0; j < 3; j++)
+				if(v[j] == v1)
+					v[j] = v0;
+
+			vertex_triangles[v0].push_back(t);
+		}
+	}
+
+	vector<mesh_index>().swap(vertex_triangles[v1]);
+	versions[v0]++;
+	versions[v1]++;
+
+	gather_neighbours(v0, scratch0);
+
+	for(size_t k = 0; k < scratch0.size(); k++)
+		push_collapse(v0, scratch0[k]);
+}
+
+size_t quadric_decimator::decimate(const size_t target_triangle_count, const float max_error)
+{
+	const double max_cost = static_cast<double>(max_error)*static_cast<double>(max_error);
+	size_t num_collapses = 0;
+
+	while(num_live_triangles > target_triangle_count && false == heap.empty())
+	{
+		const collapse c = heap.top();
+		heap.pop();
+
+		// Either end has moved (or gone) since this entry was pushed.
+		if(c.version0 != versions[c.v0] || c.version1 != versions[c.v1])
+			continue;
+
+		if(c.cost > max_cost)
+			break;
+
+		if(false == collapse_is_valid(c))
+			continue;
+
+		apply_collapse(c);
+		num_collapses++;
+	}
+
+	return num_collapses;
+}
+
+void quadric_decimator::get_mesh(vector<vertex_3> &vertices, vector<indexed_triangle> &triangles) const
+{
+	const size_t unreferenced = static_cast<size_t>(-1);
+	vector<size_t> remap(xs.size(), unreferenced);
+
+	triangles.clear();
+
+	for(size_t t = 0; t < tris.size(); t++)
+	{
+		if(false == live_triangles[t])
+			continue;
+
+		triangles.push_back(tris[t]);
+
+		for(size_t j = 0; j < 3; j++)
+			remap[tris[t].vertex_indices[j]] = 0;
+	}
+
+	vertices.clear();
+
+	for(size_t i = 0; i < xs.size(); i++)
+	{
+		if(unreferenced == remap[i])
+			continue;
+
+		remap[i] = vertices.size();
+		vertices.push_back(vertex_3(static_cast<float>(xs[i]), static_cast<float>(ys[i]), static_cast<float>(zs[i])));
+	}
+
+	for(size_t t = 0; t < triangles.size(); t++)
+		for(size_t j = 0; j < 3; j++)
+			triangles[t].vertex_indices[j] = static_cast<mesh_index>(remap[triangles[t].vertex_indices[j]]);
+}
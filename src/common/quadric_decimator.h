@@ -0,0 +1,103 @@
+#ifndef QUADRIC_DECIMATOR_H
+#define QUADRIC_DECIMATOR_H
+
+#include "primitives.h"
+
+#include <vector>
+using std::vector;
+
+#include <queue>
+using std::priority_queue;
+
+
+// Sum of squared distances to a set of planes: Q(p) = p'Ap + 2b'p + c.
+class quadric
+{
+public:
+	quadric(void) : a00(0), a01(0), a02(0), a11(0), a12(0), a22(0), b0(0), b1(0), b2(0), c(0) { }
+
+	// The plane n.p + d = 0, with unit n, counted weight times.
+	void add_plane(const double n[3], const double d, const double weight);
+
+	quadric &operator+=(const quadric &rhs);
+
+	double evaluate(const double p[3]) const;
+
+	// The point where Q is smallest, if A is well conditioned enough to solve for it.
+	bool minimum(double p[3]) const;
+
+	double a00, a01, a02, a11, a12, a22;
+	double b0, b1, b2;
+	double c;
+};
+
+// Garland-Heckbert edge-collapse decimation.
+// See: Surface Simplification Using Quadric Error Metrics by M. Garland and P. Heckbert
+//
+// Each vertex starts with the quadric of the planes of its triangles. Edges that are on
+// the boundary, or on a crease (where the triangles on either side meet at more than
+// the crease angle), also add a heavily weighted plane through the edge, at right angles
+// to each triangle beside it, so that collapses which would move the edge cost a lot.
+//
+// Edges wait in a heap, cheapest collapse first. Collapsing an edge moves its first vertex
+// to where the sum of both quadrics is smallest, and points the second vertex's triangles
+// at it. A collapse is skipped if it would make the surface non-manifold (the edge's ends
+// share neighbours other than the triangles on the edge), join two boundaries through the
+// interior, or turn any triangle over. Heap entries go stale when either end moves, and
+// are skipped when popped; the edges around a moved vertex go back in with new costs.
+class quadric_decimator
+{
+public:
+	quadric_decimator(void);
+
+	// crease_angle is in degrees.
+	void init(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles, const csr_adjacency &vertex_to_triangle_indices, const float crease_angle = 45.0f);
+
+	// Collapses edges until at most target_triangle_count triangles are left, or the next collapse
+	// would move a vertex further than about max_error from the planes it started on.
+	// Returns the number of collapses.
+	size_t decimate(const size_t target_triangle_count, const float max_error);
+
+	// The decimated mesh, with the unused vertices removed and the rest renumbered in order.
+	void get_mesh(vector<vertex_3> &vertices, vector<indexed_triangle> &triangles) const;
+
+	inline size_t triangle_count(void) const { return num_live_triangles; }
+
+private:
+	class collapse
+	{
+	public:
+		// Cheapest first, so priority_queue (a max heap) needs the reverse order.
+		inline bool operator<(const collapse &right) const
+		{
+			return cost > right.cost;
+		}
+
+		double cost;
+		double position[3];
+		mesh_index v0, v1;
+		uint32_t version0, version1;
+	};
+
+	void push_collapse(const mesh_index v0, const mesh_index v1);
+	bool collapse_is_valid(const collapse &c) const;
+	void apply_collapse(const collapse &c);
+	void gather_neighbours(const mesh_index v, vector<mesh_index> &neighbours) const;
+
+	vector<double> xs, ys, zs;
+	vector<indexed_triangle> tris;
+	vector<bool> live_triangles;
+	size_t num_live_triangles;
+
+	vector<vector<mesh_index> > vertex_triangles;
+	vector<quadric> quadrics;
+	vector<bool> boundary_vertices;
+	vector<uint32_t> versions;
+
+	priority_queue<collapse> heap;
+
+	mutable vector<mesh_index> scratch0, scratch1;
+};
+
+
+#endif
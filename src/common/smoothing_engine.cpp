@@ -0,0 +1,684 @@
+#include "smoothing_engine.h"
+
+#if !defined(SMOOTHING_ENGINE_SCALAR) && (defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+	#include <immintrin.h>
+#endif
+
+#include <limits>
+using std::numeric_limits;
+
+#include <algorithm>
+using std::lower_bound;
+using std::sort;
+using std::unique;
+using std::copy;
+
+#include <atomic>
+using std::atomic;
+
+#include <thread>
+using std::thread;
+
+namespace this_thread = std::this_thread;
+
+
+smoothing_engine::smoothing_engine(void)
+{
+	num_vertices = 0;
+	num_blocks = 0;
+	current = 0;
+}
+
+smoothing_engine::smoothing_engine(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const smoothing_weights weights, const vector<indexed_triangle> &triangles)
+{
+	num_vertices = 0;
+	num_blocks = 0;
+	current = 0;
+
+	init(vertices, vertex_to_vertex_indices, weights, triangles);
+}
+
+bool smoothing_engine::init(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const smoothing_weights weights, const vector<indexed_triangle> &triangles)
+{
+	num_blocks = (vertices.size() + block_width - 1) / block_width;
+
+	// Gathers take signed 32-bit indices, and the zero entry needs one more.
+	if(num_blocks*block_width >= static_cast<size_t>(numeric_limits<int32_t>::max()))
+	{
+		num_vertices = num_blocks = 0;
+		return false;
+	}
+
+	num_vertices = vertices.size();
+	current = 0;
+
+	const size_t padded_size = num_blocks*block_width;
+	const int32_t zero_index = static_cast<int32_t>(padded_size);
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		xs[i].assign(padded_size + 1, 0.0f);
+		ys[i].assign(padded_size + 1, 0.0f);
+		zs[i].assign(padded_size + 1, 0.0f);
+	}
+
+	for(size_t i = 0; i < num_vertices; i++)
+	{
+		xs[0][i] = vertices[i].x;
+		ys[0][i] = vertices[i].y;
+		zs[0][i] = vertices[i].z;
+	}
+
+	inverse_valences.assign(padded_size, 0.0f);
+	block_offsets.assign(num_blocks + 1, 0);
+
+	// Size each block by its largest valence.
+	for(size_t b = 0; b < num_blocks; b++)
+	{
+		size_t max_valence = 1;
+
+		for(size_t i = b*block_width; i < (b + 1)*block_width && i < num_vertices; i++)
+			if(vertex_to_vertex_indices.count(i) > max_valence)
+				max_valence = vertex_to_vertex_indices.count(i);
+
+		block_offsets[b + 1] = block_offsets[b] + max_valence*block_width;
+	}
+
+	slots.assign(block_offsets[num_blocks], zero_index);
+
+	vector<float> edge_weights;
+	slot_weights.clear();
+
+	if(SMOOTH_COTANGENT == weights)
+	{
+		compute_cotangent_weights(vertices, vertex_to_vertex_indices, triangles, edge_weights);
+		slot_weights.assign(block_offsets[num_blocks], 0.0f);
+	}
+
+	for(size_t i = 0; i < num_vertices; i++)
+	{
+		const size_t base = block_offsets[i / block_width] + i % block_width;
+		const size_t valence = vertex_to_vertex_indices.count(i);
+		const mesh_index *neighbours = vertex_to_vertex_indices.row(i);
+
+		if(0 == valence)
+		{
+			// Rogue vertex: its own position, at full weight, cancels the update.
+			slots[base] = static_cast<int32_t>(i);
+			inverse_valences[i] = 1.0f;
+
+			if(0 != slot_weights.size())
+				slot_weights[base] = 1.0f;
+
+			continue;
+		}
+
+		for(size_t k = 0; k < valence; k++)
+			slots[base + k*block_width] = static_cast<int32_t>(neighbours[k]);
+
+		if(0 == slot_weights.size())
+		{
+			inverse_valences[i] = 1.0f / static_cast<float>(valence);
+			continue;
+		}
+
+		const float *row_weights = &edge_weights[vertex_to_vertex_indices.offsets[i]];
+		float weight_sum = 0;
+
+		for(size_t k = 0; k < valence; k++)
+			weight_sum += row_weights[k];
+
+		// Every edge collapsed (or lies on a sliver), so fall back to uniform weights.
+		const bool uniform = !(weight_sum > 0.0f);
+
+		for(size_t k = 0; k < valence; k++)
+			slot_weights[base + k*block_width] = (true == uniform) ? 1.0f : row_weights[k];
+
+		inverse_valences[i] = 1.0f / ((true == uniform) ? static_cast<float>(valence) : weight_sum);
+	}
+
+	return true;
+}
+
+// Weight of edge (i, j) = (cot alpha + cot beta) / 2, where alpha and beta are the angles
+// opposite the edge in its two triangles. The result is parallel to the CSR neighbour array.
+// Obtuse angles would give negative weights, which can make the sweep diverge, so each
+// cotangent is clamped to [0, max_cotangent]; the upper bound tames near-degenerate triangles,
+// and degenerate ones are skipped.
+void smoothing_engine::compute_cotangent_weights(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const vector<indexed_triangle> &triangles, vector<float> &edge_weights) const
+{
+	const float max_cotangent = 1000.0f;
+
+	edge_weights.assign(vertex_to_vertex_indices.neighbours.size(), 0.0f);
+
+	for(size_t t = 0; t < triangles.size(); t++)
+	{
+		for(size_t j = 0; j < 3; j++)
+		{
+			const size_t a = triangles[t].vertex_indices[j];
+			const size_t b = triangles[t].vertex_indices[(j + 1) % 3];
+			const size_t c = triangles[t].vertex_indices[(j + 2) % 3];
+
+			if(a == b)
+				continue;
+
+			const vertex_3 u = vertices[a] - vertices[c];
+			const vertex_3 v = vertices[b] - vertices[c];
+			const float sine_length = u.cross(v).length();
+
+			// A triangle with no area (e.g. from a corner that sat on the isolevel) has no
+			// angle to speak of, and gives the edge no weight.
+			if(0.0f == sine_length)
+				continue;
+
+			float cotangent = u.dot(v) / sine_length;
+
+			if(cotangent < 0.0f)
+				cotangent = 0.0f;
+			else if(cotangent > max_cotangent)
+				cotangent = max_cotangent;
+
+			// Rows are sorted, so the edge's entries can be found by binary search.
+			const mesh_index *row_a = vertex_to_vertex_indices.row(a);
+			const mesh_index *row_b = vertex_to_vertex_indices.row(b);
+			const size_t k_ab = lower_bound(row_a, row_a + vertex_to_vertex_indices.count(a), static_cast<mesh_index>(b)) - row_a;
+			const size_t k_ba = lower_bound(row_b, row_b + vertex_to_vertex_indices.count(b), static_cast<mesh_index>(a)) - row_b;
+
+			edge_weights[vertex_to_vertex_indices.offsets[a] + k_ab] += 0.5f*cotangent;
+			edge_weights[vertex_to_vertex_indices.offsets[b] + k_ba] += 0.5f*cotangent;
+		}
+	}
+}
+
+// Each kernel smooths lane_group_width consecutive lanes of one block. The neighbours are
+// gathered from (x, y, z) through lane_slots, which points at the first lane's first slot, and
+// weighted by lane_weights (if not null); the lanes' own positions are read from centre, and
+// centre, inverse_valences and out all point at the first lane.
+#if defined(SMOOTHING_ENGINE_SCALAR) || !(defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64))
+
+static const size_t lane_group_width = 1;
+
+static inline void smooth_lane_group(const float *x, const float *y, const float *z, const float *centre_x, const float *centre_y, const float *centre_z, float *out_x, float *out_y, float *out_z, const int32_t *lane_slots, const float *lane_weights, const size_t num_slots, const float *inverse_valences, const float scale)
+{
+	float sx = 0, sy = 0, sz = 0;
+
+	for(size_t k = 0; k < num_slots; k++)
+	{
+		const int32_t n = lane_slots[k*smoothing_engine::block_width];
+		const float w = (0 == lane_weights) ? 1.0f : lane_weights[k*smoothing_engine::block_width];
+		sx += w*x[n];
+		sy += w*y[n];
+		sz += w*z[n];
+	}
+
+	out_x[0] = centre_x[0] + scale*(sx*inverse_valences[0] - centre_x[0]);
+	out_y[0] = centre_y[0] + scale*(sy*inverse_valences[0] - centre_y[0]);
+	out_z[0] = centre_z[0] + scale*(sz*inverse_valences[0] - centre_z[0]);
+}
+
+#elif defined(__AVX512F__)
+
+static const size_t lane_group_width = 16;
+
+static inline void smooth_lane_group(const float *x, const float *y, const float *z, const float *centre_x, const float *centre_y, const float *centre_z, float *out_x, float *out_y, float *out_z, const int32_t *lane_slots, const float *lane_weights, const size_t num_slots, const float *inverse_valences, const float scale)
+{
+	__m512 sx = _mm512_setzero_ps(), sy = _mm512_setzero_ps(), sz = _mm512_setzero_ps();
+
+	if(0 == lane_weights)
+	{
+		for(size_t k = 0; k < num_slots; k++)
+		{
+			const __m512i idx = _mm512_loadu_si512(lane_slots + k*smoothing_engine::block_width);
+			sx = _mm512_add_ps(sx, _mm512_i32gather_ps(idx, x, 4));
+			sy = _mm512_add_ps(sy, _mm512_i32gather_ps(idx, y, 4));
+			sz = _mm512_add_ps(sz, _mm512_i32gather_ps(idx, z, 4));
+		}
+	}
+	else
+	{
+		for(size_t k = 0; k < num_slots; k++)
+		{
+			const __m512i idx = _mm512_loadu_si512(lane_slots + k*smoothing_engine::block_width);
+			const __m512 w = _mm512_loadu_ps(lane_weights + k*smoothing_engine::block_width);
+			sx = _mm512_add_ps(sx, _mm512_mul_ps(w, _mm512_i32gather_ps(idx, x, 4)));
+			sy = _mm512_add_ps(sy, _mm512_mul_ps(w, _mm512_i32gather_ps(idx, y, 4)));
+			sz = _mm512_add_ps(sz, _mm512_mul_ps(w, _mm512_i32gather_ps(idx, z, 4)));
+		}
+	}
+
+	const __m512 vscale = _mm512_set1_ps(scale);
+	const __m512 inv = _mm512_loadu_ps(inverse_valences);
+	const __m512 px = _mm512_loadu_ps(centre_x), py = _mm512_loadu_ps(centre_y), pz = _mm512_loadu_ps(centre_z);
+
+	_mm512_storeu_ps(out_x, _mm512_add_ps(px, _mm512_mul_ps(vscale, _mm512_sub_ps(_mm512_mul_ps(sx, inv), px))));
+	_mm512_storeu_ps(out_y, _mm512_add_ps(py, _mm512_mul_ps(vscale, _mm512_sub_ps(_mm512_mul_ps(sy, inv), py))));
+	_mm512_storeu_ps(out_z, _mm512_add_ps(pz, _mm512_mul_ps(vscale, _mm512_sub_ps(_mm512_mul_ps(sz, inv), pz))));
+}
+
+#elif defined(__AVX2__)
+
+static const size_t lane_group_width = 8;
+
+static inline void smooth_lane_group(const float *x, const float *y, const float *z, const float *centre_x, const float *centre_y, const float *centre_z, float *out_x, float *out_y, float *out_z, const int32_t *lane_slots, const float *lane_weights, const size_t num_slots, const float *inverse_valences, const float scale)
+{
+	__m256 sx = _mm256_setzero_ps(), sy = _mm256_setzero_ps(), sz = _mm256_setzero_ps();
+
+	if(0 == lane_weights)
+	{
+		for(size_t k = 0; k < num_slots; k++)
+		{
+			const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane_slots + k*smoothing_engine::block_width));
+			sx = _mm256_add_ps(sx, _mm256_i32gather_ps(x, idx, 4));
+			sy = _mm256_add_ps(sy, _mm256_i32gather_ps(y, idx, 4));
+			sz = _mm256_add_ps(sz, _mm256_i32gather_ps(z, idx, 4));
+		}
+	}
+	else
+	{
+		for(size_t k = 0; k < num_slots; k++)
+		{
+			const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lane_slots + k*smoothing_engine::block_width));
+			const __m256 w = _mm256_loadu_ps(lane_weights + k*smoothing_engine::block_width);
+			sx = _mm256_add_ps(sx, _mm256_mul_ps(w, _mm256_i32gather_ps(x, idx, 4)));
+			sy = _mm256_add_ps(sy, _mm256_mul_ps(w, _mm256_i32gather_ps(y, idx, 4)));
+			sz = _mm256_add_ps(sz, _mm256_mul_ps(w, _mm256_i32gather_ps(z, idx, 4)));
+		}
+	}
+
+	const __m256 vscale = _mm256_set1_ps(scale);
+	const __m256 inv = _mm256_loadu_ps(inverse_valences);
+	const __m256 px = _mm256_loadu_ps(centre_x), py = _mm256_loadu_ps(centre_y), pz = _mm256_loadu_ps(centre_z);
+
+	_mm256_storeu_ps(out_x, _mm256_add_ps(px, _mm256_mul_ps(vscale, _mm256_sub_ps(_mm256_mul_ps(sx, inv), px))));
+	_mm256_storeu_ps(out_y, _mm256_add_ps(py, _mm256_mul_ps(vscale, _mm256_sub_ps(_mm256_mul_ps(sy, inv), py))));
+	_mm256_storeu_ps(out_z, _mm256_add_ps(pz, _mm256_mul_ps(vscale, _mm256_sub_ps(_mm256_mul_ps(sz, inv), pz))));
+}
+
+#else
+
+// SSE has no gather instruction, so the four lanes are loaded one at a time.
+static const size_t lane_group_width = 4;
+
+static inline void smooth_lane_group(const float *x, const float *y, const float *z, const float *centre_x, const float *centre_y, const float *centre_z, float *out_x, float *out_y, float *out_z, const int32_t *lane_slots, const float *lane_weights, const size_t num_slots, const float *inverse_valences, const float scale)
+{
+	__m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+
+	for(size_t k = 0; k < num_slots; k++)
+	{
+		const int32_t *idx = lane_slots + k*smoothing_engine::block_width;
+		__m128 gx = _mm_set_ps(x[idx[3]], x[idx[2]], x[idx[1]], x[idx[0]]);
+		__m128 gy = _mm_set_ps(y[idx[3]], y[idx[2]], y[idx[1]], y[idx[0]]);
+		__m128 gz = _mm_set_ps(z[idx[3]], z[idx[2]], z[idx[1]], z[idx[0]]);
+
+		if(0 != lane_weights)
+		{
+			const __m128 w = _mm_loadu_ps(lane_weights + k*smoothing_engine::block_width);
+			gx = _mm_mul_ps(w, gx);
+			gy = _mm_mul_ps(w, gy);
+			gz = _mm_mul_ps(w, gz);
+		}
+
+		sx = _mm_add_ps(sx, gx);
+		sy = _mm_add_ps(sy, gy);
+		sz = _mm_add_ps(sz, gz);
+	}
+
+	const __m128 vscale = _mm_set1_ps(scale);
+	const __m128 inv = _mm_loadu_ps(inverse_valences);
+	const __m128 px = _mm_loadu_ps(centre_x), py = _mm_loadu_ps(centre_y), pz = _mm_loadu_ps(centre_z);
+
+	_mm_storeu_ps(out_x, _mm_add_ps(px, _mm_mul_ps(vscale, _mm_sub_ps(_mm_mul_ps(sx, inv), px))));
+	_mm_storeu_ps(out_y, _mm_add_ps(py, _mm_mul_ps(vscale, _mm_sub_ps(_mm_mul_ps(sy, inv), py))));
+	_mm_storeu_ps(out_z, _mm_add_ps(pz, _mm_mul_ps(vscale, _mm_sub_ps(_mm_mul_ps(sz, inv), pz))));
+}
+
+#endif
+
+// Smooths one block. Its neighbours are gathered from (x, y, z) through block_slots, its own
+// positions are read from centre and it is written to out; centre, inverse_valences and out
+// point at the block's first lane.
+static void smooth_block(const float *x, const float *y, const float *z, const float *centre_x, const float *centre_y, const float *centre_z, float *out_x, float *out_y, float *out_z, const int32_t *block_slots, const float *block_weights, const size_t num_slots, const float *inverse_valences, const float scale)
+{
+	for(size_t lane = 0; lane < smoothing_engine::block_width; lane += lane_group_width)
+		smooth_lane_group(x, y, z, centre_x + lane, centre_y + lane, centre_z + lane, out_x + lane, out_y + lane, out_z + lane, block_slots + lane, (0 == block_weights) ? 0 : block_weights + lane, num_slots, inverse_valences + lane, scale);
+}
+
+// Smooths blocks [first_block, last_block) from (x, y, z) into (out_x, out_y, out_z).
+static void smooth_blocks(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, const int32_t *slots, const float *slot_weights, const size_t *block_offsets, const float *inverse_valences, const size_t first_block, const size_t last_block, const float scale)
+{
+	const size_t block_width = smoothing_engine::block_width;
+
+	for(size_t b = first_block; b < last_block; b++)
+	{
+		const size_t num_slots = (block_offsets[b + 1] - block_offsets[b]) / block_width;
+
+		for(size_t lane = 0; lane < block_width; lane += lane_group_width)
+		{
+			const size_t i = b*block_width + lane;
+
+			smooth_lane_group(x, y, z, x + i, y + i, z + i, out_x + i, out_y + i, out_z + i, slots + block_offsets[b] + lane, (0 == slot_weights) ? 0 : slot_weights + block_offsets[b] + lane, num_slots, inverse_valences + i, scale);
+		}
+	}
+}
+
+void smoothing_engine::laplace_smooth(const float scale)
+{
+	const size_t next = 1 - current;
+
+	smooth_blocks(&xs[current][0], &ys[current][0], &zs[current][0], &xs[next][0], &ys[next][0], &zs[next][0], slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), 0, num_blocks, scale);
+
+	current = next;
+}
+
+// Blocks until all num_threads threads have arrived. Spins briefly, then yields,
+// since the sweeps between barriers are short but the threads may be oversubscribed.
+class spin_barrier
+{
+public:
+	spin_barrier(const size_t src_num_threads) : num_threads(src_num_threads), num_waiting(0), generation(0) { }
+
+	void wait(void)
+	{
+		const size_t arrival_generation = generation.load();
+
+		if(num_threads == ++num_waiting)
+		{
+			num_waiting = 0;
+			++generation;
+			return;
+		}
+
+		for(size_t spins = 0; arrival_generation == generation.load(); spins++)
+			if(spins > 1024)
+				this_thread::yield();
+	}
+
+private:
+	const size_t num_threads;
+	atomic<size_t> num_waiting;
+	atomic<size_t> generation;
+};
+
+// What one thread needs to run the mu sweep of its blocks [first_block, last_block) straight
+// after their lambda sweep, without waiting for the other threads' lambda sweeps.
+//
+// A boundary block, one with neighbours outside the thread's blocks, gathers its mu sweep
+// from local copies of every block its slots reach. The thread's own blocks are copied out of
+// its lambda sweep; the other threads' blocks have the lambda sweep redone on them, from the
+// same positions with the same kernel, so the copies hold the same values their owners compute.
+class sweep_halo
+{
+public:
+	sweep_halo(const vector<int32_t> &slots, const vector<size_t> &block_offsets, const size_t first_block, const size_t last_block, const int32_t zero_index)
+	{
+		const size_t block_width = smoothing_engine::block_width;
+
+		for(size_t b = first_block; b < last_block; b++)
+		{
+			bool boundary = false;
+
+			for(size_t k = block_offsets[b]; k < block_offsets[b + 1] && false == boundary; k++)
+				if(zero_index != slots[k] && (static_cast<size_t>(slots[k]) < first_block*block_width || static_cast<size_t>(slots[k]) >= last_block*block_width))
+					boundary = true;
+
+			if(false == boundary)
+				continue;
+
+			boundary_blocks.push_back(b);
+
+			for(size_t k = block_offsets[b]; k < block_offsets[b + 1]; k++)
+				if(zero_index != slots[k])
+					blocks.push_back(slots[k] / block_width);
+		}
+
+		sort(blocks.begin(), blocks.end());
+		blocks.erase(unique(blocks.begin(), blocks.end()), blocks.end());
+
+		// The slots of the boundary blocks, pointing into the copies instead.
+		const int32_t local_zero_index = static_cast<int32_t>(blocks.size()*block_width);
+		local_slot_offsets.push_back(0);
+
+		for(size_t i = 0; i < boundary_blocks.size(); i++)
+		{
+			const size_t b = boundary_blocks[i];
+
+			for(size_t k = block_offsets[b]; k < block_offsets[b + 1]; k++)
+			{
+				if(zero_index == slots[k])
+				{
+					local_slots.push_back(local_zero_index);
+					continue;
+				}
+
+				const size_t copy = lower_bound(blocks.begin(), blocks.end(), slots[k] / block_width) - blocks.begin();
+				local_slots.push_back(static_cast<int32_t>(copy*block_width + slots[k] % block_width));
+			}
+
+			local_slot_offsets.push_back(local_slots.size());
+		}
+
+		// The zero entry at the end, for the padding slots.
+		xs.assign(blocks.size()*block_width + 1, 0.0f);
+		ys.assign(blocks.size()*block_width + 1, 0.0f);
+		zs.assign(blocks.size()*block_width + 1, 0.0f);
+	}
+
+	vector<size_t> boundary_blocks;
+
+	// Boundary block i's slots are local_slots[local_slot_offsets[i]] onwards.
+	vector<size_t> local_slot_offsets;
+	vector<int32_t> local_slots;
+
+	// The blocks the boundary blocks reach, in order; the copy of blocks[i] is at entry
+	// i*block_width of xs, ys and zs.
+	vector<size_t> blocks;
+	vector<float> xs, ys, zs;
+};
+
+// Taubin steps (hc == false, a = lambda, b = mu) or HC steps (hc == true, a = alpha, b = beta)
+// over blocks [first_block, last_block).
+//
+// On one thread, a Taubin step's lambda sweep goes into the other position buffer, and its mu
+// sweep back again. On several, the lambda sweep goes into the sweep buffer instead, and the mu
+// sweep from there into the other position buffer, with the boundary blocks gathering from
+// their halo. Nothing a thread reads in a step is then written by another thread in the same
+// step, so the threads need to meet only once per step, before the positions they wrote are read.
+//
+// Each HC pass reads what the neighbouring blocks wrote in the previous pass, so the threads
+// meet at the barrier after each one.
+void smoothing_engine::run_steps_on_blocks(const bool hc, const float a, const float b, const size_t steps, const size_t first_block, const size_t last_block, spin_barrier *barrier)
+{
+	const size_t first = first_block*block_width;
+	const size_t last = last_block*block_width;
+	size_t cur = current;
+
+	// Only a Taubin step on several threads needs the halo.
+	sweep_halo halo(slots, block_offsets, (true == hc || 0 == barrier) ? last_block : first_block, last_block, static_cast<int32_t>(num_blocks*block_width));
+
+	for(size_t s = 0; s < steps; s++)
+	{
+		const size_t next = 1 - cur;
+
+		float *x = &xs[cur][0], *y = &ys[cur][0], *z = &zs[cur][0];
+		float *nx = &xs[next][0], *ny = &ys[next][0], *nz = &zs[next][0];
+
+		if(false == hc && 0 == barrier)
+		{
+			smooth_blocks(x, y, z, nx, ny, nz, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), first_block, last_block, a);
+			smooth_blocks(nx, ny, nz, x, y, z, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), first_block, last_block, b);
+			continue;
+		}
+
+		if(false == hc)
+		{
+			float *sx = &sweep_xs[0], *sy = &sweep_ys[0], *sz = &sweep_zs[0];
+
+			smooth_blocks(x, y, z, sx, sy, sz, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), first_block, last_block, a);
+
+			for(size_t i = 0; i < halo.blocks.size(); i++)
+			{
+				const size_t hb = halo.blocks[i];
+				const size_t src = hb*block_width, dst = i*block_width;
+
+				if(hb >= first_block && hb < last_block)
+				{
+					copy(sx + src, sx + src + block_width, &halo.xs[dst]);
+					copy(sy + src, sy + src + block_width, &halo.ys[dst]);
+					copy(sz + src, sz + src + block_width, &halo.zs[dst]);
+				}
+				else
+				{
+					smooth_block(x, y, z, x + src, y + src, z + src, &halo.xs[dst], &halo.ys[dst], &halo.zs[dst], slots.data() + block_offsets[hb], (0 == slot_weight_data()) ? 0 : slot_weight_data() + block_offsets[hb], (block_offsets[hb + 1] - block_offsets[hb]) / block_width, inverse_valences.data() + src, a);
+				}
+			}
+
+			// The blocks between boundary blocks gather straight from the sweep buffer.
+			size_t run_first = first_block;
+
+			for(size_t i = 0; i < halo.boundary_blocks.size(); i++)
+			{
+				const size_t bb = halo.boundary_blocks[i], j = bb*block_width;
+
+				smooth_blocks(sx, sy, sz, nx, ny, nz, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), run_first, bb, b);
+				smooth_block(&halo.xs[0], &halo.ys[0], &halo.zs[0], sx + j, sy + j, sz + j, nx + j, ny + j, nz + j, &halo.local_slots[halo.local_slot_offsets[i]], (0 == slot_weight_data()) ? 0 : slot_weight_data() + block_offsets[bb], (block_offsets[bb + 1] - block_offsets[bb]) / block_width, inverse_valences.data() + j, b);
+
+				run_first = bb + 1;
+			}
+
+			smooth_blocks(sx, sy, sz, nx, ny, nz, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), run_first, last_block, b);
+
+			if(0 != barrier)
+				barrier->wait();
+
+			cur = next;
+			continue;
+		}
+
+		// p = average of the neighbours of q, then the push-back d = p - (alpha*o + (1 - alpha)*q).
+		smooth_blocks(x, y, z, nx, ny, nz, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), first_block, last_block, 1.0f);
+
+		for(size_t i = first; i < last; i++)
+		{
+			push_xs[i] = nx[i] - (a*original_xs[i] + (1.0f - a)*x[i]);
+			push_ys[i] = ny[i] - (a*original_ys[i] + (1.0f - a)*y[i]);
+			push_zs[i] = nz[i] - (a*original_zs[i] + (1.0f - a)*z[i]);
+		}
+
+		if(0 != barrier)
+			barrier->wait();
+
+		// q is no longer needed, so it takes the average of the neighbours' push-backs.
+		smooth_blocks(&push_xs[0], &push_ys[0], &push_zs[0], x, y, z, slots.data(), slot_weight_data(), block_offsets.data(), inverse_valences.data(), first_block, last_block, 1.0f);
+
+		for(size_t i = first; i < last; i++)
+		{
+			nx[i] -= b*push_xs[i] + (1.0f - b)*x[i];
+			ny[i] -= b*push_ys[i] + (1.0f - b)*y[i];
+			nz[i] -= b*push_zs[i] + (1.0f - b)*z[i];
+		}
+
+		if(0 != barrier)
+			barrier->wait();
+
+		cur = next;
+	}
+}
+
+void smoothing_engine::run_steps(const bool hc, const float a, const float b, const size_t steps, const size_t num_threads)
+{
+	const bool threaded = (num_threads > 1 && num_blocks >= 2*num_threads);
+
+	if(false == threaded)
+	{
+		run_steps_on_blocks(hc, a, b, steps, 0, num_blocks, 0);
+	}
+	else
+	{
+		// The zero entry at the end must stay zero, since padding slots gather from it.
+		if(false == hc)
+		{
+			sweep_xs.assign(xs[current].size(), 0.0f);
+			sweep_ys.assign(ys[current].size(), 0.0f);
+			sweep_zs.assign(zs[current].size(), 0.0f);
+		}
+
+		// Split the blocks so that every thread gets about the same number of slots.
+		vector<size_t> first_blocks(num_threads + 1, num_blocks);
+
+		for(size_t t = 0; t < num_threads; t++)
+			first_blocks[t] = lower_bound(block_offsets.begin(), block_offsets.end(), block_offsets[num_blocks]*t / num_threads) - block_offsets.begin();
+
+		spin_barrier barrier(num_threads);
+		vector<thread> threads;
+
+		for(size_t t = 1; t < num_threads; t++)
+			threads.push_back(thread(&smoothing_engine::run_steps_on_blocks, this, hc, a, b, steps, first_blocks[t], first_blocks[t + 1], &barrier));
+
+		run_steps_on_blocks(hc, a, b, steps, first_blocks[0], first_blocks[1], &barrier);
+
+		for(size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+
+		vector<float>().swap(sweep_xs);
+		vector<float>().swap(sweep_ys);
+		vector<float>().swap(sweep_zs);
+	}
+
+	// An HC step, or a Taubin step on several threads, ends in the other buffer; a Taubin step
+	// on one thread ends where it started.
+	if((true == hc || true == threaded) && 1 == steps % 2)
+		current = 1 - current;
+}
+
+void smoothing_engine::taubin_smooth(const float lambda, const float mu, const size_t steps, const size_t num_threads)
+{
+	run_steps(false, lambda, mu, steps, num_threads);
+}
+
+void smoothing_engine::hc_smooth(const float alpha, const float beta, const size_t steps, const size_t num_threads)
+{
+	original_xs = xs[current];
+	original_ys = ys[current];
+	original_zs = zs[current];
+
+	// The zero entry at the end must stay zero, since padding slots gather from it.
+	push_xs.assign(xs[current].size(), 0.0f);
+	push_ys.assign(ys[current].size(), 0.0f);
+	push_zs.assign(zs[current].size(), 0.0f);
+
+	run_steps(true, alpha, beta, steps, num_threads);
+
+	vector<float>().swap(original_xs);
+	vector<float>().swap(original_ys);
+	vector<float>().swap(original_zs);
+	vector<float>().swap(push_xs);
+	vector<float>().swap(push_ys);
+	vector<float>().swap(push_zs);
+}
+
+void smoothing_engine::get_positions(vector<vertex_3> &vertices) const
+{
+	vertices.resize(num_vertices);
+
+	for(size_t i = 0; i < num_vertices; i++)
+	{
+		vertices[i].x = xs[current][i];
+		vertices[i].y = ys[current][i];
+		vertices[i].z = zs[current][i];
+	}
+}
+
+const char *smoothing_engine::instruction_set(void)
+{
+#if defined(SMOOTHING_ENGINE_SCALAR)
+	return "scalar";
+#elif defined(__AVX512F__)
+	return "AVX-512";
+#elif defined(__AVX2__)
+	return "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+	return "SSE";
+#else
+	return "scalar";
+#endif
+}
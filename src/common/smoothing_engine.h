@@ -0,0 +1,100 @@
+#ifndef SMOOTHING_ENGINE_H
+#define SMOOTHING_ENGINE_H
+
+#include "primitives.h"
+
+#include <vector>
+using std::vector;
+
+
+enum smoothing_weights
+{
+	SMOOTH_UNIFORM,   // Every neighbour counts the same (the original inverse neighbour count weighting)
+	SMOOTH_COTANGENT  // Neighbours weighted by the cotangents of the angles opposite their edge
+};
+
+class spin_barrier;
+
+// Laplacian smoothing on Structure-of-Arrays positions.
+//
+// Vertices are grouped into blocks of block_width. The neighbour indices of a block
+// are stored slot-major (slot k of every lane, then slot k + 1, ...), padded to the
+// largest valence in the block with the index of a position that is always zero.
+// That lets a whole block gather its neighbour sums with vector gathers (AVX-512,
+// AVX2) or plain loads (SSE, scalar), after which
+//
+//   p' = p + scale*(sum/valence - p)
+//
+// is the same update that indexed_mesh::laplace_smooth() applies. Rogue vertices
+// (no neighbours) get a single slot pointing at themselves, which makes them stay put.
+//
+// With cotangent weights, each slot also carries the weight of its edge, and the sum
+// becomes a weighted sum divided by the vertex's total weight. The weights are worked
+// out once, from the positions passed to init(), and reused by every sweep.
+//
+// The kernel is picked at compile time from the instruction sets the compiler targets
+// (e.g. -mavx2 or -march=native); define SMOOTHING_ENGINE_SCALAR to force the scalar one.
+class smoothing_engine
+{
+public:
+	smoothing_engine(void);
+	smoothing_engine(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const smoothing_weights weights = SMOOTH_UNIFORM, const vector<indexed_triangle> &triangles = vector<indexed_triangle>());
+
+	// Returns false if the mesh is too large for 32-bit gather indices.
+	// The triangles are only needed for SMOOTH_COTANGENT.
+	bool init(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const smoothing_weights weights = SMOOTH_UNIFORM, const vector<indexed_triangle> &triangles = vector<indexed_triangle>());
+
+	// One Jacobi sweep: every vertex moves towards the average of its neighbours' old positions.
+	void laplace_smooth(const float scale);
+
+	// Runs the lambda and mu sweeps of every step. With num_threads > 1 the blocks are split
+	// across that many threads, which meet at a barrier once per step: each thread redoes the
+	// lambda sweep on the other threads' blocks that its own blocks neighbour, rather than wait
+	// for them. The result is bit-identical to a single-threaded run.
+	void taubin_smooth(const float lambda, const float mu, const size_t steps, const size_t num_threads = 1);
+
+	// See: Improved Laplacian Smoothing of Noisy Surface Meshes by J. Vollmer, R. Mencl and H. Mueller
+	// Each step smooths, then pushes every vertex back towards a blend (alpha) of its original
+	// and previous positions, along with (1 - beta) of its neighbours' push-backs. Shrinkage is
+	// undone within the step, so there is no need for a mu sweep. The original positions are the
+	// ones held when this is called.
+	void hc_smooth(const float alpha, const float beta, const size_t steps, const size_t num_threads = 1);
+
+	void get_positions(vector<vertex_3> &vertices) const;
+
+	inline size_t size(void) const { return num_vertices; }
+	static const char *instruction_set(void);
+
+	static const size_t block_width = 16;
+
+private:
+	void compute_cotangent_weights(const vector<vertex_3> &vertices, const csr_adjacency &vertex_to_vertex_indices, const vector<indexed_triangle> &triangles, vector<float> &edge_weights) const;
+	inline const float *slot_weight_data(void) const { return slot_weights.empty() ? 0 : slot_weights.data(); }
+	void run_steps(const bool hc, const float a, const float b, const size_t steps, const size_t num_threads);
+	void run_steps_on_blocks(const bool hc, const float a, const float b, const size_t steps, const size_t first_block, const size_t last_block, spin_barrier *barrier);
+
+	size_t num_vertices;
+	size_t num_blocks;
+
+	// Two position buffers; the sweep reads one and writes the other.
+	// Each holds num_blocks*block_width entries, plus the always-zero entry at the end.
+	vector<float> xs[2];
+	vector<float> ys[2];
+	vector<float> zs[2];
+	size_t current;
+
+	vector<size_t> block_offsets; // Where block b's slots start; block b has (block_offsets[b + 1] - block_offsets[b]) / block_width slots per lane.
+	vector<int32_t> slots;
+	vector<float> slot_weights; // Parallel to slots; empty when every weight is one.
+	vector<float> inverse_valences; // One over the vertex's total slot weight.
+
+	// Scratch for taubin_smooth() on several threads: the lambda sweep's output.
+	vector<float> sweep_xs, sweep_ys, sweep_zs;
+
+	// Scratch for hc_smooth(): the original positions, and each vertex's push-back.
+	vector<float> original_xs, original_ys, original_zs;
+	vector<float> push_xs, push_ys, push_zs;
+};
+
+
+#endif
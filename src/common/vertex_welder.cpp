@@ -0,0 +1,127 @@
+#include "vertex_welder.h"
+
+#include <cstring> // for memcpy()
+
+
+vertex_welder::vertex_welder(const size_t expected_vertex_count, const float src_epsilon)
+{
+	mask = 0;
+	count = 0;
+	eps = src_epsilon;
+
+	if(eps > 0.0f)
+		inv_eps = 1.0f / eps;
+	else
+		inv_eps = 0.0f;
+
+	reserve(expected_vertex_count);
+}
+
+void vertex_welder::clear(void)
+{
+	slots.clear();
+	mask = 0;
+	count = 0;
+}
+
+void vertex_welder::reserve(const size_t expected_vertex_count)
+{
+	// Keep the load factor at or below one half.
+	size_t capacity = 16;
+
+	while(capacity < expected_vertex_count*2)
+		capacity *= 2;
+
+	if(capacity <= slots.size())
+		return;
+
+	vector<slot> old_slots(capacity);
+	old_slots.swap(slots);
+	mask = capacity - 1;
+
+	// Reinsert existing entries. Their keys are unique, so there is no need to compare.
+	for(size_t i = 0; i < old_slots.size(); i++)
+	{
+		if(0 == old_slots[i].value)
+			continue;
+
+		size_t pos = static_cast<size_t>(hash_key(old_slots[i].key) & mask);
+
+		while(0 != slots[pos].value)
+			pos = (pos + 1) & mask;
+
+		slots[pos] = old_slots[i];
+	}
+}
+
+void vertex_welder::grow(void)
+{
+	reserve(slots.size());
+}
+
+void vertex_welder::make_key(const vertex_3 &v, uint32_t key[3]) const
+{
+	if(eps > 0.0f)
+	{
+		const float c[3] = { v.x*inv_eps, v.y*inv_eps, v.z*inv_eps };
+
+		for(size_t i = 0; i < 3; i++)
+		{
+			float f = floor(c[i]);
+
+			// Keep the cast to int32_t well defined.
+			if(f < -2147483648.0f)
+				f = -2147483648.0f;
+			else if(f > 2147483520.0f)
+				f = 2147483520.0f;
+
+			key[i] = static_cast<uint32_t>(static_cast<int32_t>(f));
+		}
+	}
+	else
+	{
+		memcpy(&key[0], &v.x, sizeof(float));
+		memcpy(&key[1], &v.y, sizeof(float));
+		memcpy(&key[2], &v.z, sizeof(float));
+
+		// The set-based path compares with operator<, which treats -0.0f and 0.0f
+		// as equal -- so must we.
+		for(size_t i = 0; i < 3; i++)
+			if(0x80000000u == key[i])
+				key[i] = 0;
+	}
+}
+
+uint64_t vertex_welder::key_hash(const vertex_3 &v) const
+{
+	uint32_t key[3];
+	make_key(v, key);
+
+	return hash_key(key);
+}
+
+size_t vertex_welder::weld(const vertex_3 &v)
+{
+	if((count + 1)*2 > slots.size())
+		grow();
+
+	uint32_t key[3];
+	make_key(v, key);
+
+	size_t pos = static_cast<size_t>(hash_key(key) & mask);
+
+	while(0 != slots[pos].value)
+	{
+		if(slots[pos].key[0] == key[0] && slots[pos].key[1] == key[1] && slots[pos].key[2] == key[2])
+			return slots[pos].value - 1;
+
+		pos = (pos + 1) & mask;
+	}
+
+	slots[pos].key[0] = key[0];
+	slots[pos].key[1] = key[1];
+	slots[pos].key[2] = key[2];
+	slots[pos].value = static_cast<mesh_index>(count + 1);
+
+	return count++;
+}
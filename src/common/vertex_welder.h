@@ -0,0 +1,77 @@
+#ifndef VERTEX_WELDER_H
+#define VERTEX_WELDER_H
+
+#include "primitives.h"
+
+#include <vector>
+using std::vector;
+
+#include <stdint.h>
+
+
+enum weld_mode
+{
+	WELD_EXACT_SET,    // Original std::set<indexed_vertex_3> path, kept for comparison
+	WELD_EXACT_HASH,   // Open-addressing hash over the exact float bit patterns
+	WELD_EPSILON_GRID  // Snap vertices to a grid of cell size epsilon, then hash the cell
+};
+
+// Assigns sequential indices to vertex positions, in order of first appearance.
+//
+// Positions are keyed by three 32-bit words -- either the float bit patterns,
+// or the integer grid cell coordinates when an epsilon is given -- and stored
+// in a linearly probed, power-of-two sized table that never exceeds half full.
+// In epsilon mode every vertex that falls into the same cell gets the index of
+// the first vertex that landed there, so near-duplicates that straddle a cell
+// boundary are not merged.
+class vertex_welder
+{
+public:
+	vertex_welder(const size_t expected_vertex_count = 0, const float src_epsilon = 0.0f);
+
+	void clear(void);
+	void reserve(const size_t expected_vertex_count);
+
+	// Returns the index of the vertex. If the vertex has not been seen before,
+	// the returned index equals the previous value of size().
+	size_t weld(const vertex_3 &v);
+
+	// Hash of the key that v is welded by; equal for every vertex that weld() would merge.
+	// 64 bits wide on every platform, so callers can take its high half.
+	uint64_t key_hash(const vertex_3 &v) const;
+
+	inline size_t size(void) const { return count; }
+	inline float epsilon(void) const { return eps; }
+
+	// Indices are stored as mesh_index (with 0 marking an empty slot).
+	static const size_t max_vertex_count = static_cast<mesh_index>(~static_cast<mesh_index>(0)) - 1;
+
+private:
+	class slot
+	{
+	public:
+		uint32_t key[3];
+		mesh_index value; // Vertex index + 1; 0 means the slot is empty.
+	};
+
+	void make_key(const vertex_3 &v, uint32_t key[3]) const;
+	void grow(void);
+
+	static inline uint64_t hash_key(const uint32_t key[3])
+	{
+		uint64_t h = (static_cast<uint64_t>(key[0]) * 0x9e3779b97f4a7c15ULL) ^ key[1];
+		h = (h ^ (h >> 29)) * 0xbf58476d1ce4e5b9ULL ^ key[2];
+		h = (h ^ (h >> 32)) * 0x94d049bb133111ebULL;
+
+		return h ^ (h >> 31);
+	}
+
+	vector<slot> slots;
+	size_t mask;
+	size_t count;
+	float eps;
+	float inv_eps;
+};
+
+
+#endif
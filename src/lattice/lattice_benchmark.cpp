@@ -0,0 +1,143 @@
+// Fills parts with lattices and checks the results, then times a large one.
+//
+// Each cell type fills a torus, once uniform and once graded from a thin surface to a
+// dense core. Each lattice, as one mesh, must be closed (each edge used once in each
+// direction) and welded (no two vertices in the same place), and its triangles must be
+// the ones that were counted. Its solid fraction is measured against that of its cells.
+//
+// Last, a sphere is filled with about num_struts BCC struts, and the lattice streamed to
+// a binary STL file (the null device unless one is named), timing each step.
+//
+// Example usage: lattice_benchmark [num_struts [out.stl]]
+
+#include "lattice_generator.h"
+#include "../boolean_poly/test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+static bool run_case(const char *const name, const indexed_mesh &part, const lattice_settings &settings)
+{
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	lattice_generator generator;
+
+	if(false == generator.fill(part, settings))
+	{
+		cout << name << ": could not fill the part" << endl;
+		return false;
+	}
+
+	const double fill_time = seconds_since(start);
+
+	indexed_mesh mesh;
+
+	if(false == generator.get_mesh(mesh))
+	{
+		cout << name << ": could not make a mesh" << endl;
+		return false;
+	}
+
+	const bool closed = is_closed(mesh), welded = is_welded(mesh);
+	const bool counted = (mesh.triangles.size() == generator.triangle_count);
+
+	// Cells at the lattice's surface lose their outer half struts, so the lattice as a
+	// whole comes out a little under its cells' own fractions.
+	double cells_volume = 0.0;
+
+	for(size_t i = 0; i < generator.levels.size(); i++)
+		if(lattice_generator::empty_cell != generator.levels[i])
+			cells_volume += generator.unit_cells[generator.levels[i]].volume();
+
+	const double cube = double(settings.cell_size)*settings.cell_size*settings.cell_size;
+	const double fraction = mesh_volume(mesh)/(generator.cell_count*cube);
+
+	cout << name << ": " << generator.cell_count << " cells, " << generator.strut_count << " struts, " << mesh.triangles.size() << " triangles in " << fill_time << " s, "
+	     << generator.unit_cells.size() << " cell(s) of " << generator.unit_cells[0].triangles.size() << "+ triangles" << endl;
+	cout << "  solid fraction " << fraction << " (cells " << cells_volume/generator.cell_count << "), "
+	     << (closed ? "closed" : "NOT CLOSED") << ", " << (welded ? "welded" : "NOT WELDED") << ", " << (counted ? "counted" : "NOT COUNTED") << endl;
+
+	return closed && welded && counted && fraction > 0.0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t num_struts = 10000000;
+	const char *file_name = "/dev/null";
+
+	if(argc > 1)
+		num_struts = strtoul(argv[1], 0, 10);
+
+	if(argc > 2)
+		file_name = argv[2];
+
+	if(num_struts < 1000)
+	{
+		cout << "Example usage: " << argv[0] << " [num_struts [out.stl]]" << endl;
+		return 1;
+	}
+
+	bool passed = true;
+
+	const double no_offset[3] = { 0.0, 0.0, 0.0 };
+	indexed_mesh torus;
+	make_torus(torus, 20000, 15.0, 6.0, false, no_offset);
+
+	const lattice_cell_type types[4] = { LATTICE_BCC, LATTICE_FCC, LATTICE_OCTET, LATTICE_GYROID };
+	const char *const names[4] = { "BCC", "FCC", "Octet", "Gyroid" };
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		lattice_settings settings;
+		settings.type = types[i];
+		settings.cell_size = 2.0f;
+
+		passed = run_case(names[i], torus, settings) && passed;
+
+		settings.volume_fraction = 0.1;
+		settings.core_volume_fraction = 0.3;
+		settings.grading_depth = 4.0f;
+		settings.density_levels = 4;
+
+		passed = run_case((string(names[i]) + ", graded").c_str(), torus, settings) && passed;
+	}
+
+	// A sphere holding num_struts struts, at eight per cell.
+	const double pi = 4.0*atan(1.0);
+	lattice_settings settings;
+	const double radius = settings.cell_size*pow(3.0*(num_struts/8.0)/(4.0*pi), 1.0/3.0);
+
+	indexed_mesh sphere;
+	make_sphere(sphere, 100000, radius);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	lattice_generator generator;
+
+	if(false == generator.fill(sphere, settings))
+	{
+		cout << "Could not fill the sphere" << endl;
+		return 2;
+	}
+
+	const double fill_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	const bool written = generator.save_to_binary_stereo_lithography_file(file_name);
+	const double write_time = seconds_since(start);
+
+	passed = passed && written;
+
+	cout << "Sphere of radius " << radius << ": " << generator.cell_count << " cells, " << generator.strut_count << " struts, "
+	     << generator.triangle_count << " triangles, " << generator.memory_usage()/(1024*1024) << " MB" << endl;
+	cout << "  filled in " << fill_time << " s, written to " << file_name << " in " << write_time << " s ("
+	     << generator.triangle_count/write_time/1e6 << " million triangles per second)" << (written ? "" : ", WRITE FAILED") << endl;
+
+	cout << (passed ? "All lattices closed and consistent" : "SOME LATTICES FAILED") << endl;
+
+	return passed ? 0 : 2;
+}
@@ -0,0 +1,792 @@
+#include "lattice_cell.h"
+#include "../boolean_poly/exact_predicates.h"
+#include "../tomo_mesh/isosurface_extractor.h"
+
+#include <map>
+using std::map;
+
+#include <algorithm>
+using std::sort;
+using std::unique;
+using std::swap;
+using std::min;
+using std::max;
+using std::binary_search;
+using std::lower_bound;
+
+#include <utility>
+using std::pair;
+using std::make_pair;
+
+#include <cmath>
+
+
+// A strut from node a of a cell to node b of the cell at b_offset, running through the
+// cell at host (the one whose box holds it).
+class strut_description
+{
+public:
+	size_t a, b;
+	int b_offset[3];
+	int host[3];
+};
+
+static void add_strut(vector<strut_description> &struts, const size_t a, const int a_offset[3], const size_t b, const int b_offset[3])
+{
+	strut_description s;
+	s.a = a;
+	s.b = b;
+
+	for(size_t k = 0; k < 3; k++)
+	{
+		s.b_offset[k] = b_offset[k] - a_offset[k];
+		s.host[k] = -a_offset[k];
+	}
+
+	struts.push_back(s);
+}
+
+// The nodes of a strut cell, in cell widths, and its struts, each listed once.
+static void describe_struts(const lattice_cell_type type, vector<vertex_3> &nodes, vector<strut_description> &struts)
+{
+	nodes.clear();
+	struts.clear();
+
+	const int zero[3] = { 0, 0, 0 };
+
+	if(LATTICE_BCC == type)
+	{
+		nodes.push_back(vertex_3(0.0f, 0.0f, 0.0f));
+		nodes.push_back(vertex_3(0.5f, 0.5f, 0.5f));
+
+		for(int i = 0; i < 8; i++)
+		{
+			const int corner[3] = { i & 1, (i >> 1) & 1, (i >> 2) & 1 };
+			add_strut(struts, 1, zero, 0, corner);
+		}
+
+		return;
+	}
+
+	// The corner, then the centres of the faces at z = 0, y = 0 and x = 0.
+	nodes.push_back(vertex_3(0.0f, 0.0f, 0.0f));
+	nodes.push_back(vertex_3(0.5f, 0.5f, 0.0f));
+	nodes.push_back(vertex_3(0.5f, 0.0f, 0.5f));
+	nodes.push_back(vertex_3(0.0f, 0.5f, 0.5f));
+
+	// Each face centre to the four corners of its face.
+	for(size_t face = 0; face < 3; face++)
+	{
+		const size_t normal = 2 - face; // z, y, x
+		const size_t u = (normal + 1) % 3, v = (normal + 2) % 3;
+
+		for(int i = 0; i < 4; i++)
+		{
+			int corner[3] = { 0, 0, 0 };
+			corner[u] = i & 1;
+			corner[v] = (i >> 1) & 1;
+			add_strut(struts, 1 + face, zero, 0, corner);
+		}
+	}
+
+	if(LATTICE_OCTET == type)
+	{
+		// The octahedron's corners are the centres of the six faces, three of which belong
+		// to the next cells up; each pair that is not opposite is a strut.
+		for(size_t face_i = 0; face_i < 3; face_i++)
+		{
+			for(size_t face_j = face_i + 1; face_j < 3; face_j++)
+			{
+				for(int i = 0; i < 2; i++)
+				{
+					for(int j = 0; j < 2; j++)
+					{
+						int a_offset[3] = { 0, 0, 0 }, b_offset[3] = { 0, 0, 0 };
+						a_offset[2 - face_i] = i;
+						b_offset[2 - face_j] = j;
+						add_strut(struts, 1 + face_i, a_offset, 1 + face_j, b_offset);
+					}
+				}
+			}
+		}
+	}
+}
+
+static void normalise(double v[3])
+{
+	const double length = sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+
+	v[0] /= length;
+	v[1] /= length;
+	v[2] /= length;
+}
+
+static void cross(const double a[3], const double b[3], double c[3])
+{
+	c[0] = a[1]*b[2] - a[2]*b[1];
+	c[1] = a[2]*b[0] - a[0]*b[2];
+	c[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+// Incremental convex hull, wound outwards, with exact orientation tests. Points that are
+// not strictly outside the hull so far are left out. Returns false if the points do not
+// span a volume.
+static bool convex_hull(const vector<vertex_3> &points, vector<indexed_triangle> &hull)
+{
+	hull.clear();
+
+	if(points.size() < 4)
+		return false;
+
+	size_t first[4] = { 0, 0, 0, 0 };
+	size_t found = 1;
+
+	for(size_t i = 1; i < points.size() && found < 4; i++)
+	{
+		if(1 == found && !(points[i] == points[first[0]]))
+			first[found++] = i;
+		else if(2 == found && false == collinear(points[first[0]], points[first[1]], points[i]))
+			first[found++] = i;
+		else if(3 == found && 0 != orient3d(points[first[0]], points[first[1]], points[first[2]], points[i]))
+			first[found++] = i;
+	}
+
+	if(found < 4)
+		return false;
+
+	// With the fourth point behind the first face, all four faces point out.
+	if(orient3d(points[first[0]], points[first[1]], points[first[2]], points[first[3]]) > 0)
+		swap(first[1], first[2]);
+
+	const size_t faces[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 1, 3, 2 }, { 2, 3, 0 } };
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		indexed_triangle t;
+
+		for(size_t k = 0; k < 3; k++)
+			t.vertex_indices[k] = static_cast<mesh_index>(first[faces[i][k]]);
+
+		hull.push_back(t);
+	}
+
+	vector<indexed_triangle> kept;
+	vector< pair<mesh_index, mesh_index> > edges;
+
+	for(size_t i = 0; i < points.size(); i++)
+	{
+		if(i == first[0] || i == first[1] || i == first[2] || i == first[3])
+			continue;
+
+		kept.clear();
+		edges.clear();
+
+		for(size_t j = 0; j < hull.size(); j++)
+		{
+			const indexed_triangle &t = hull[j];
+
+			if(orient3d(points[t.vertex_indices[0]], points[t.vertex_indices[1]], points[t.vertex_indices[2]], points[i]) > 0)
+			{
+				for(size_t k = 0; k < 3; k++)
+					edges.push_back(make_pair(t.vertex_indices[k], t.vertex_indices[(k + 1) % 3]));
+			}
+			else
+			{
+				kept.push_back(t);
+			}
+		}
+
+		if(edges.empty())
+			continue;
+
+		// The horizon is the edges of the visible faces whose twin is not visible.
+		sort(edges.begin(), edges.end());
+
+		for(size_t j = 0; j < edges.size(); j++)
+		{
+			if(binary_search(edges.begin(), edges.end(), make_pair(edges[j].second, edges[j].first)))
+				continue;
+
+			indexed_triangle t;
+			t.vertex_indices[0] = edges[j].first;
+			t.vertex_indices[1] = edges[j].second;
+			t.vertex_indices[2] = static_cast<mesh_index>(i);
+			kept.push_back(t);
+		}
+
+		hull.swap(kept);
+	}
+
+	return true;
+}
+
+static void add_triangle(vector<indexed_triangle> &triangles, const mesh_index a, const mesh_index b, const mesh_index c, const bool reverse)
+{
+	indexed_triangle t;
+	t.vertex_indices[0] = a;
+	t.vertex_indices[1] = reverse ? c : b;
+	t.vertex_indices[2] = reverse ? b : c;
+	triangles.push_back(t);
+}
+
+static void add_vertex(lattice_cell &cell, const vertex_3 &v, const uint32_t shared_id, const int offset[3])
+{
+	cell.vertices.push_back(v);
+	cell.shared_ids.push_back(shared_id);
+
+	for(size_t k = 0; k < 3; k++)
+		cell.shared_offsets.push_back(static_cast<int8_t>(offset[k]));
+}
+
+// One end of a strut, seen from the node it leaves.
+class half_strut
+{
+public:
+	size_t strut;
+	bool at_a;
+	double direction[3]; // Unit length, towards the other end
+	double half_length;
+};
+
+static bool build_struts(lattice_cell &cell, const size_t sides)
+{
+	vector<vertex_3> nodes;
+	vector<strut_description> struts;
+	describe_struts(cell.type, nodes, struts);
+
+	const double pi = 4.0*atan(1.0);
+	const double radius = cell.thickness, port_radius = cell.port_thickness;
+
+	if(sides < 3 || radius <= 0.0 || port_radius <= 0.0)
+		return false;
+
+	cell.strut_count = struts.size();
+
+	// Each strut's ring frame, and the ring at its middle, in its first node's cell.
+	vector<double> frames(6*struts.size());
+
+	for(size_t s = 0; s < struts.size(); s++)
+	{
+		const vertex_3 &a = nodes[struts[s].a], &b = nodes[struts[s].b];
+		double d[3] = { b.x + struts[s].b_offset[0] - a.x, b.y + struts[s].b_offset[1] - a.y, b.z + struts[s].b_offset[2] - a.z };
+		const double middle[3] = { a.x + 0.5*d[0], a.y + 0.5*d[1], a.z + 0.5*d[2] };
+		normalise(d);
+
+		// Across the strut from the axis it is least along.
+		double axis[3] = { 0.0, 0.0, 0.0 };
+		size_t least = 0;
+
+		for(size_t k = 1; k < 3; k++)
+			if(fabs(d[k]) < fabs(d[least]))
+				least = k;
+
+		axis[least] = 1.0;
+
+		double *u = &frames[6*s], *v = &frames[6*s + 3];
+		cross(d, axis, u);
+		normalise(u);
+		cross(d, u, v);
+		normalise(v);
+
+		for(size_t i = 0; i < sides; i++)
+		{
+			const double c = cos(2.0*pi*i/sides), sn = sin(2.0*pi*i/sides);
+
+			cell.shared_vertices.push_back(vertex_3(
+				static_cast<float>(middle[0] + port_radius*(c*u[0] + sn*v[0])),
+				static_cast<float>(middle[1] + port_radius*(c*u[1] + sn*v[1])),
+				static_cast<float>(middle[2] + port_radius*(c*u[2] + sn*v[2]))));
+		}
+	}
+
+	const int zero[3] = { 0, 0, 0 };
+	vector<half_strut> halves;
+	vector<vertex_3> points;
+	vector<indexed_triangle> hull;
+	vector<size_t> ring_of;
+
+	for(size_t n = 0; n < nodes.size(); n++)
+	{
+		const vertex_3 &p = nodes[n];
+
+		halves.clear();
+
+		for(size_t s = 0; s < struts.size(); s++)
+		{
+			for(int end = 0; end < 2; end++)
+			{
+				const bool at_a = (0 == end);
+
+				if((at_a ? struts[s].a : struts[s].b) != n)
+					continue;
+
+				const vertex_3 &q = at_a ? nodes[struts[s].b] : nodes[struts[s].a];
+				const double sign = at_a ? 1.0 : -1.0;
+
+				half_strut h;
+				h.strut = s;
+				h.at_a = at_a;
+				h.direction[0] = q.x + sign*struts[s].b_offset[0] - p.x;
+				h.direction[1] = q.y + sign*struts[s].b_offset[1] - p.y;
+				h.direction[2] = q.z + sign*struts[s].b_offset[2] - p.z;
+				h.half_length = 0.5*sqrt(h.direction[0]*h.direction[0] + h.direction[1]*h.direction[1] + h.direction[2]*h.direction[2]);
+				normalise(h.direction);
+				halves.push_back(h);
+			}
+		}
+
+		// The rings sit far enough out that those of the two closest struts just miss.
+		double max_cosine = -1.0;
+
+		for(size_t i = 0; i < halves.size(); i++)
+			for(size_t j = i + 1; j < halves.size(); j++)
+				max_cosine = max(max_cosine, halves[i].direction[0]*halves[j].direction[0] + halves[i].direction[1]*halves[j].direction[1] + halves[i].direction[2]*halves[j].direction[2]);
+
+		const double half_angle = 0.5*acos(min(1.0, max(-1.0, max_cosine)));
+		const double ring_distance = 1.1*radius/tan(half_angle);
+
+		points.clear();
+		ring_of.clear();
+
+		for(size_t h = 0; h < halves.size(); h++)
+		{
+			if(ring_distance > 0.8*halves[h].half_length)
+				return false;
+
+			const double *u = &frames[6*halves[h].strut], *v = &frames[6*halves[h].strut + 3];
+			const double *d = halves[h].direction;
+
+			for(size_t i = 0; i < sides; i++)
+			{
+				const double c = cos(2.0*pi*i/sides), sn = sin(2.0*pi*i/sides);
+
+				points.push_back(vertex_3(
+					static_cast<float>(p.x + ring_distance*d[0] + radius*(c*u[0] + sn*v[0])),
+					static_cast<float>(p.y + ring_distance*d[1] + radius*(c*u[1] + sn*v[1])),
+					static_cast<float>(p.z + ring_distance*d[2] + radius*(c*u[2] + sn*v[2]))));
+
+				ring_of.push_back(h);
+			}
+		}
+
+		if(false == convex_hull(points, hull))
+			return false;
+
+		// Faces with all three corners on one ring cover the ring's opening.
+		const mesh_index base = static_cast<mesh_index>(cell.vertices.size());
+		const size_t first_port = cell.ports.size();
+
+		for(size_t i = 0; i < points.size(); i++)
+			add_vertex(cell, points[i], lattice_cell::none, zero);
+
+		cell.ports.resize(first_port + halves.size());
+
+		vector<size_t> rim_edge_counts(points.size(), 0);
+		vector<size_t> forward_counts(halves.size(), 0);
+
+		for(size_t i = 0; i < hull.size(); i++)
+		{
+			indexed_triangle t = hull[i];
+			const size_t h = ring_of[t.vertex_indices[0]];
+			const bool on_ring = (ring_of[t.vertex_indices[1]] == h && ring_of[t.vertex_indices[2]] == h);
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				const mesh_index from = t.vertex_indices[k], to = t.vertex_indices[(k + 1) % 3];
+
+				if(true == on_ring || ring_of[from] != ring_of[to])
+					continue;
+
+				// Within one ring, only its rim may be shared with the rest of the node.
+				const size_t i_from = from % sides, i_to = to % sides;
+
+				if(i_to == (i_from + 1) % sides)
+				{
+					rim_edge_counts[from]++;
+					forward_counts[ring_of[from]]++;
+				}
+				else if(i_from == (i_to + 1) % sides)
+				{
+					rim_edge_counts[to]++;
+				}
+				else
+				{
+					return false;
+				}
+			}
+
+			for(size_t k = 0; k < 3; k++)
+				t.vertex_indices[k] += base;
+
+			if(true == on_ring)
+				cell.ports[first_port + h].capped_triangles.push_back(t);
+			else
+				cell.triangles.push_back(t);
+		}
+
+		for(size_t i = 0; i < points.size(); i++)
+			if(1 != rim_edge_counts[i])
+				return false;
+
+		for(size_t h = 0; h < halves.size(); h++)
+			if(0 != forward_counts[h] && sides != forward_counts[h])
+				return false;
+
+		for(size_t h = 0; h < halves.size(); h++)
+		{
+			const strut_description &s = struts[halves[h].strut];
+			lattice_port &port = cell.ports[first_port + h];
+
+			// The other end's cell, and the cell the strut runs through.
+			int other[3], host[3];
+
+			for(size_t k = 0; k < 3; k++)
+			{
+				other[k] = halves[h].at_a ? s.b_offset[k] : -s.b_offset[k];
+				host[k] = halves[h].at_a ? s.host[k] : s.host[k] - s.b_offset[k];
+			}
+
+			port.neighbour_count = 0;
+
+			if(0 != other[0] || 0 != other[1] || 0 != other[2])
+			{
+				for(size_t k = 0; k < 3; k++)
+					port.neighbours[port.neighbour_count][k] = other[k];
+
+				port.neighbour_count++;
+			}
+
+			if((0 != host[0] || 0 != host[1] || 0 != host[2]) && (host[0] != other[0] || host[1] != other[1] || host[2] != other[2]))
+			{
+				for(size_t k = 0; k < 3; k++)
+					port.neighbours[port.neighbour_count][k] = host[k];
+
+				port.neighbour_count++;
+			}
+
+			// The middle ring, taken from the first node's cell.
+			const mesh_index middle = static_cast<mesh_index>(cell.vertices.size());
+			const int owner[3] = { halves[h].at_a ? 0 : -s.b_offset[0], halves[h].at_a ? 0 : -s.b_offset[1], halves[h].at_a ? 0 : -s.b_offset[2] };
+
+			for(size_t i = 0; i < sides; i++)
+			{
+				const uint32_t id = static_cast<uint32_t>(halves[h].strut*sides + i);
+				const vertex_3 &v = cell.shared_vertices[id];
+
+				add_vertex(cell, vertex_3(v.x + owner[0], v.y + owner[1], v.z + owner[2]), id, owner);
+			}
+
+			// The tube takes the node's rim edges the other way round, and the middle ring's
+			// edges the way round that the cut closes them again.
+			const mesh_index ring = static_cast<mesh_index>(base + h*sides);
+			const bool reverse = (0 == forward_counts[h]);
+
+			for(size_t i = 0; i < sides; i++)
+			{
+				const mesh_index n0 = ring + static_cast<mesh_index>(i), n1 = ring + static_cast<mesh_index>((i + 1) % sides);
+				const mesh_index m0 = middle + static_cast<mesh_index>(i), m1 = middle + static_cast<mesh_index>((i + 1) % sides);
+
+				add_triangle(port.joined_triangles, n1, n0, m0, reverse);
+				add_triangle(port.joined_triangles, n1, m0, m1, reverse);
+			}
+
+			for(size_t i = 1; i + 1 < sides; i++)
+				add_triangle(port.cut_triangles, middle, middle + static_cast<mesh_index>(i + 1), middle + static_cast<mesh_index>(i), reverse);
+		}
+	}
+
+	return true;
+}
+
+// The sign of the field, k - g, at sample (x, y, z) of a cell of n samples a side.
+// Samples are kept clear of zero, so that no vertex lands on one.
+static float gyroid_sample(const size_t x, const size_t y, const size_t z, const size_t n, const double k_middle, const double k_face)
+{
+	const double pi = 4.0*atan(1.0);
+	const double px = 2.0*pi*(x % n)/n, py = 2.0*pi*(y % n)/n, pz = 2.0*pi*(z % n)/n;
+	const double g = sin(px)*cos(py) + sin(py)*cos(pz) + sin(pz)*cos(px);
+
+	// 0 on the faces, rising to 1 an eighth of the way in.
+	const size_t face_distance = min(min(min(x, n - x), min(y, n - y)), min(z, n - z));
+	const double s = min(1.0, 8.0*face_distance/n);
+	const double w = s*s*(3.0 - 2.0*s);
+
+	float value = static_cast<float>(k_face + (k_middle - k_face)*w - g);
+
+	if(fabs(value) < 1e-4f)
+		value = (value < 0.0f) ? -1e-4f : 1e-4f;
+
+	return value;
+}
+
+static mesh_index find_or_add_vertex(lattice_cell &cell, map<vertex_3, mesh_index> &boundary_vertices, const vertex_3 &v)
+{
+	map<vertex_3, mesh_index>::const_iterator i = boundary_vertices.find(v);
+
+	if(boundary_vertices.end() != i)
+		return i->second;
+
+	const int zero[3] = { 0, 0, 0 };
+	const mesh_index index = static_cast<mesh_index>(cell.vertices.size());
+
+	add_vertex(cell, v, lattice_cell::none, zero);
+	boundary_vertices[v] = index;
+
+	return index;
+}
+
+static bool build_gyroid(lattice_cell &cell, const size_t n)
+{
+	if(n < 2 || 0 != (n & (n - 1)))
+		return false;
+
+	float_voxel_volume volume;
+	volume.resize(n + 1, n + 1, n + 1);
+
+	for(size_t z = 0; z <= n; z++)
+		for(size_t y = 0; y <= n; y++)
+			for(size_t x = 0; x <= n; x++)
+				volume(x, y, z) = gyroid_sample(x, y, z, n, cell.thickness, cell.port_thickness);
+
+	// Inside (k - g >= 0) is the solid, so the normals point out of it.
+	isosurface_extractor extractor;
+	indexed_mesh mesh;
+
+	if(false == extractor.extract(volume, 0.0, mesh, 1, 0, ISOSURFACE_MARCHING_TETRAHEDRA))
+		return false;
+
+	const int zero[3] = { 0, 0, 0 };
+	const float side = static_cast<float>(n);
+	map<vertex_3, mesh_index> boundary_vertices;
+
+	for(size_t i = 0; i < mesh.vertices.size(); i++)
+	{
+		const vertex_3 &v = mesh.vertices[i];
+
+		add_vertex(cell, v, lattice_cell::none, zero);
+
+		if(0.0f == v.x || 0.0f == v.y || 0.0f == v.z || side == v.x || side == v.y || side == v.z)
+			boundary_vertices[v] = static_cast<mesh_index>(i);
+	}
+
+	cell.triangles = mesh.triangles;
+
+	// Each face is capped where the solid meets it, cut into triangles along the same
+	// diagonals (low corner to high corner) as marching tetrahedra cuts the cells' faces,
+	// with the same interpolation, so that the caps' edges are the surface's.
+	cell.ports.resize(6);
+
+	for(size_t axis = 0; axis < 3; axis++)
+	{
+		const size_t u = (axis + 1) % 3, v = (axis + 2) % 3;
+
+		for(size_t end = 0; end < 2; end++)
+		{
+			lattice_port &port = cell.ports[2*axis + end];
+
+			port.neighbour_count = 1;
+			port.neighbours[0][0] = port.neighbours[0][1] = port.neighbours[0][2] = 0;
+			port.neighbours[0][axis] = (0 == end) ? -1 : 1;
+
+			for(size_t i = 0; i < n; i++)
+			{
+				for(size_t j = 0; j < n; j++)
+				{
+					size_t corners[4][3];
+
+					for(size_t c = 0; c < 4; c++)
+					{
+						corners[c][axis] = (0 == end) ? 0 : n;
+						corners[c][u] = i + ((1 == c || 2 == c) ? 1 : 0);
+						corners[c][v] = j + ((2 == c || 3 == c) ? 1 : 0);
+					}
+
+					const size_t triangle_corners[2][3] = { { 0, 1, 2 }, { 0, 2, 3 } };
+
+					for(size_t t = 0; t < 2; t++)
+					{
+						mesh_index polygon[4];
+						size_t count = 0;
+
+						for(size_t c = 0; c < 3; c++)
+						{
+							const size_t *p = corners[triangle_corners[t][c]];
+							const size_t *q = corners[triangle_corners[t][(c + 1) % 3]];
+							const double value_p = volume(p[0], p[1], p[2]), value_q = volume(q[0], q[1], q[2]);
+
+							if(value_p >= 0.0)
+								polygon[count++] = find_or_add_vertex(cell, boundary_vertices, vertex_3(static_cast<float>(p[0]), static_cast<float>(p[1]), static_cast<float>(p[2])));
+
+							if((value_p >= 0.0) == (value_q >= 0.0))
+								continue;
+
+							// Lower voxel first, as the extractor has it.
+							const bool p_lower = (p[0] <= q[0] && p[1] <= q[1] && p[2] <= q[2]);
+							const size_t *lower = p_lower ? p : q, *upper = p_lower ? q : p;
+							const double p1[3] = { double(lower[0]), double(lower[1]), double(lower[2]) };
+							const double p2[3] = { double(upper[0]), double(upper[1]), double(upper[2]) };
+
+							const vertex_3 crossing = interpolate_edge(0.0, p1, p2, p_lower ? value_p : value_q, p_lower ? value_q : value_p);
+							map<vertex_3, mesh_index>::const_iterator found = boundary_vertices.find(crossing);
+
+							if(boundary_vertices.end() == found)
+								return false;
+
+							polygon[count++] = found->second;
+						}
+
+						for(size_t c = 1; c + 1 < count; c++)
+						{
+							// (u, v) turns counter-clockwise about +axis.
+							const vertex_3 &a = cell.vertices[polygon[0]], &b = cell.vertices[polygon[c]], &d = cell.vertices[polygon[c + 1]];
+							const double ab[3] = { b.x - a.x, b.y - a.y, b.z - a.z }, ad[3] = { d.x - a.x, d.y - a.y, d.z - a.z };
+							const double normal = ab[u]*ad[v] - ab[v]*ad[u];
+
+							if(0.0 == normal)
+								continue;
+
+							add_triangle(port.capped_triangles, polygon[0], polygon[c], polygon[c + 1], (normal > 0.0) != (1 == end));
+						}
+					}
+				}
+			}
+
+			port.cut_triangles = port.capped_triangles;
+		}
+	}
+
+	// Vertices on a face at the far side belong to the next cell; shared ids number the
+	// faces' vertices in order of their position in the owning cell.
+	const float scale = 1.0f/side;
+	vector<vertex_3> owned;
+
+	for(size_t i = 0; i < cell.vertices.size(); i++)
+	{
+		vertex_3 &v = cell.vertices[i];
+		const bool on_face = (0.0f == v.x || 0.0f == v.y || 0.0f == v.z || side == v.x || side == v.y || side == v.z);
+
+		v = v*scale;
+
+		if(true == on_face)
+			owned.push_back(vertex_3((1.0f == v.x) ? 0.0f : v.x, (1.0f == v.y) ? 0.0f : v.y, (1.0f == v.z) ? 0.0f : v.z));
+	}
+
+	sort(owned.begin(), owned.end());
+	owned.erase(unique(owned.begin(), owned.end()), owned.end());
+	cell.shared_vertices = owned;
+
+	for(size_t i = 0; i < cell.vertices.size(); i++)
+	{
+		const vertex_3 &v = cell.vertices[i];
+		const float p[3] = { v.x, v.y, v.z };
+
+		if(false == (0.0f == v.x || 0.0f == v.y || 0.0f == v.z || 1.0f == v.x || 1.0f == v.y || 1.0f == v.z))
+			continue;
+
+		const vertex_3 key((1.0f == p[0]) ? 0.0f : p[0], (1.0f == p[1]) ? 0.0f : p[1], (1.0f == p[2]) ? 0.0f : p[2]);
+
+		cell.shared_ids[i] = static_cast<uint32_t>(lower_bound(owned.begin(), owned.end(), key) - owned.begin());
+
+		for(size_t k = 0; k < 3; k++)
+			cell.shared_offsets[3*i + k] = (1.0f == p[k]) ? 1 : 0;
+	}
+
+	return true;
+}
+
+// Six times the signed volume under the triangles, as seen from the origin.
+static double add_volume(const vector<vertex_3> &vertices, const vector<indexed_triangle> &triangles)
+{
+	double sum = 0.0;
+
+	for(size_t i = 0; i < triangles.size(); i++)
+	{
+		const vertex_3 &a = vertices[triangles[i].vertex_indices[0]];
+		const vertex_3 &b = vertices[triangles[i].vertex_indices[1]];
+		const vertex_3 &c = vertices[triangles[i].vertex_indices[2]];
+
+		sum += a.x*(double(b.y)*c.z - double(b.z)*c.y) - a.y*(double(b.x)*c.z - double(b.z)*c.x) + a.z*(double(b.x)*c.y - double(b.y)*c.x);
+	}
+
+	return sum;
+}
+
+
+lattice_cell::lattice_cell(void)
+{
+	type = LATTICE_BCC;
+	thickness = port_thickness = 0.0;
+	strut_count = 0;
+}
+
+void lattice_cell::clear(void)
+{
+	strut_count = 0;
+	vertices.clear();
+	shared_ids.clear();
+	shared_offsets.clear();
+	shared_vertices.clear();
+	triangles.clear();
+	ports.clear();
+}
+
+bool lattice_cell::build(const lattice_cell_type src_type, const double src_thickness, const double src_port_thickness, const size_t strut_sides, const size_t resolution)
+{
+	clear();
+
+	type = src_type;
+	thickness = src_thickness;
+	port_thickness = src_port_thickness;
+
+	const bool built = (LATTICE_GYROID == type) ? build_gyroid(*this, resolution) : build_struts(*this, strut_sides);
+
+	if(false == built)
+		clear();
+
+	return built;
+}
+
+bool lattice_cell::fit(const lattice_cell_type src_type, const double volume_fraction, const lattice_cell *const neighbour, const size_t strut_sides, const size_t resolution)
+{
+	// Struts are too thick for their nodes well before a radius of half a cell; the
+	// gyroid's field runs from -1.5 to 1.5.
+	double low = (LATTICE_GYROID == src_type) ? -1.5 : 0.001;
+	double high = (LATTICE_GYROID == src_type) ? 1.5 : 0.5;
+
+	for(size_t i = 0; i < 40; i++)
+	{
+		const double middle = 0.5*(low + high);
+
+		if(true == build(src_type, middle, (0 == neighbour) ? middle : neighbour->port_thickness, strut_sides, resolution) && volume() < volume_fraction)
+			low = middle;
+		else
+			high = middle;
+	}
+
+	if(false == build(src_type, low, (0 == neighbour) ? low : neighbour->port_thickness, strut_sides, resolution))
+		return false;
+
+	return fabs(volume() - volume_fraction) < 0.01 && (0 == neighbour || true == fits_with(*neighbour));
+}
+
+double lattice_cell::volume(void) const
+{
+	double sum = add_volume(vertices, triangles);
+
+	for(size_t i = 0; i < ports.size(); i++)
+		sum += add_volume(vertices, ports[i].joined_triangles) + add_volume(vertices, ports[i].cut_triangles);
+
+	return sum/6.0;
+}
+
+bool lattice_cell::fits_with(const lattice_cell &other) const
+{
+	if(type != other.type || shared_vertices.size() != other.shared_vertices.size())
+		return false;
+
+	for(size_t i = 0; i < shared_vertices.size(); i++)
+		if(!(shared_vertices[i] == other.shared_vertices[i]))
+			return false;
+
+	return true;
+}
@@ -0,0 +1,99 @@
+#ifndef LATTICE_CELL_H
+#define LATTICE_CELL_H
+
+#include "../common/primitives.h"
+
+#include <vector>
+using std::vector;
+
+#include <stdint.h>
+
+
+enum lattice_cell_type
+{
+	LATTICE_BCC,   // Struts from the middle of the cell to its eight corners
+	LATTICE_FCC,   // Struts along both diagonals of each face
+	LATTICE_OCTET, // FCC's struts, plus an octahedron of struts joining the face centres
+	LATTICE_GYROID // The solid side of Schoen's gyroid, sin x cos y + sin y cos z + sin z cos x <= k
+};
+
+// The part of a cell's surface that depends on its neighbours: one half of a strut, or, for
+// the gyroid, one face of the cell.
+class lattice_port
+{
+public:
+	// The cells, as offsets from this one, that must be in the lattice for the port to be
+	// joined: the cell at the strut's other end, and the cell it runs through.
+	int neighbours[2][3];
+	size_t neighbour_count;
+
+	vector<indexed_triangle> joined_triangles; // Used when all the neighbours are there (the half strut)
+	vector<indexed_triangle> capped_triangles; // Used when any is missing (the cap that closes the node)
+
+	// Close the surface where this cell's share of the lattice meets the next cell's, so that
+	// the share has a volume: the disc across the strut's middle, or the solid's cross
+	// section on the face. Never written out.
+	vector<indexed_triangle> cut_triangles;
+};
+
+// The geometry of one unit cell, built once and then instanced across the lattice by
+// translation and scale.
+//
+// A strut cell (BCC, FCC, octet) is a set of nodes, each the convex hull of rings of
+// strut_sides points around its struts, a little way out from the node, so that the
+// struts meet without intersecting each other. From each ring a tube runs halfway along
+// the strut, to a ring that the cell at the strut's other end shares: each strut is
+// listed once, in the cell of its first node, and both halves take that cell's copy of
+// the ring. The tubes taper from thickness at the node to port_thickness at the middle, so
+// that cells of different density still share their rings.
+//
+// A gyroid cell is marching tetrahedra over resolution^3 samples of the field, which is
+// periodic, so the vertices on opposite faces line up. Its vertices on a face at 1 are
+// shared with the next cell's face at 0. The gyroid's k is thickness in the middle of the
+// cell and port_thickness on its faces, blended over the outer eighth, for the same
+// reason as the strut cells' taper.
+//
+// A vertex on a cut between cells has a shared id, the same in every cell of the type,
+// and an offset to the cell that owns it; the lattice gives it one position and one
+// index, whichever cell it is reached through.
+class lattice_cell
+{
+public:
+	lattice_cell(void);
+
+	// Thicknesses are in cell widths: strut radii, or the gyroid's k. Returns false if
+	// the struts are too thick for their nodes, or resolution is not a power of two.
+	bool build(const lattice_cell_type src_type, const double src_thickness, const double src_port_thickness, const size_t strut_sides = 6, const size_t resolution = 16);
+
+	// Builds the cell whose volume fraction is volume_fraction, by bisection on the
+	// thickness at the nodes (or the middle, for the gyroid). Given neighbour, the ports
+	// keep its port thickness, so that the two can be neighbours; otherwise they follow
+	// the nodes, for a uniform lattice.
+	bool fit(const lattice_cell_type src_type, const double volume_fraction, const lattice_cell *const neighbour = 0, const size_t strut_sides = 6, const size_t resolution = 16);
+
+	// The volume of the cell's share of the lattice, in cubic cell widths, with every port joined.
+	double volume(void) const;
+
+	// Whether the shared vertices of the two cells are the same, so that they can be neighbours.
+	bool fits_with(const lattice_cell &other) const;
+
+	void clear(void);
+
+	static const uint32_t none = 0xFFFFFFFF;
+
+	lattice_cell_type type;
+	double thickness;
+	double port_thickness;
+	size_t strut_count; // Per cell
+
+	vector<vertex_3> vertices; // In cell widths, from the cell's low corner
+	vector<uint32_t> shared_ids; // For each vertex, an index into shared_vertices, or none
+	vector<int8_t> shared_offsets; // Three per vertex: the cell that owns the shared vertex, relative to this one
+	vector<vertex_3> shared_vertices; // In the owning cell's coordinates
+
+	vector<indexed_triangle> triangles; // Used whatever the neighbours
+	vector<lattice_port> ports;
+};
+
+
+#endif
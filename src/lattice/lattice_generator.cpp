@@ -0,0 +1,618 @@
+#include "lattice_generator.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <algorithm>
+using std::sort;
+using std::min;
+using std::max;
+using std::swap;
+using std::lower_bound;
+using std::upper_bound;
+
+#include <utility>
+using std::pair;
+using std::make_pair;
+
+#include <unordered_map>
+using std::unordered_map;
+
+#include <deque>
+using std::deque;
+
+#include <cmath>
+#include <limits>
+
+
+lattice_settings::lattice_settings(void)
+{
+	type = LATTICE_BCC;
+	cell_size = 2.0f;
+	volume_fraction = 0.15;
+	core_volume_fraction = 0.15;
+	grading_depth = 0.0f;
+	density_levels = 1;
+	strut_sides = 6;
+	resolution = 16;
+}
+
+// Twice the signed area of abc in the (x, y) plane at p's side of edge ab: positive when p
+// is to the left. The differences and products of floats are exact in double, so the sign is too.
+static double edge_function(const vertex_3 &a, const vertex_3 &b, const double px, const double py)
+{
+	return (double(b.x) - a.x)*(py - a.y) - (double(b.y) - a.y)*(px - a.x);
+}
+
+// For a counter-clockwise triangle, points on its left and top edges count as inside it and
+// points on its right and bottom edges do not, so a point on an edge shared by two
+// triangles of a surface is counted once.
+static bool edge_owns_boundary(const vertex_3 &a, const vertex_3 &b)
+{
+	return (b.y < a.y) || (b.y == a.y && b.x < a.x);
+}
+
+// Which corners of the grid (x fastest) are inside the closed mesh.
+static void classify_corners(const indexed_mesh &part, const vertex_3 &origin, const float cell_size, const size_t x_corners, const size_t y_corners, const size_t z_corners, vector<bool> &inside)
+{
+	vector<float> xs(x_corners), ys(y_corners), zs(z_corners);
+
+	for(size_t i = 0; i < x_corners; i++)
+		xs[i] = static_cast<float>(origin.x + double(cell_size)*i);
+
+	for(size_t i = 0; i < y_corners; i++)
+		ys[i] = static_cast<float>(origin.y + double(cell_size)*i);
+
+	for(size_t i = 0; i < z_corners; i++)
+		zs[i] = static_cast<float>(origin.z + double(cell_size)*i);
+
+	// Where each column crosses the surface.
+	vector< pair<size_t, float> > crossings;
+
+	for(size_t t = 0; t < part.triangles.size(); t++)
+	{
+		const vertex_3 &a = part.vertices[part.triangles[t].vertex_indices[0]];
+		const vertex_3 *b = &part.vertices[part.triangles[t].vertex_indices[1]];
+		const vertex_3 *c = &part.vertices[part.triangles[t].vertex_indices[2]];
+
+		const double area = edge_function(a, *b, c->x, c->y);
+
+		if(0.0 == area)
+			continue;
+
+		if(area < 0.0)
+			swap(b, c);
+
+		const float min_x = min(a.x, min(b->x, c->x)), max_x = max(a.x, max(b->x, c->x));
+		const float min_y = min(a.y, min(b->y, c->y)), max_y = max(a.y, max(b->y, c->y));
+
+		const size_t first_i = lower_bound(xs.begin(), xs.end(), min_x) - xs.begin();
+		const size_t last_i = upper_bound(xs.begin(), xs.end(), max_x) - xs.begin();
+		const size_t first_j = lower_bound(ys.begin(), ys.end(), min_y) - ys.begin();
+		const size_t last_j = upper_bound(ys.begin(), ys.end(), max_y) - ys.begin();
+
+		for(size_t j = first_j; j < last_j; j++)
+		{
+			for(size_t i = first_i; i < last_i; i++)
+			{
+				const double w[3] = { edge_function(*b, *c, xs[i], ys[j]), edge_function(*c, a, xs[i], ys[j]), edge_function(a, *b, xs[i], ys[j]) };
+
+				if(w[0] < 0.0 || w[1] < 0.0 || w[2] < 0.0)
+					continue;
+
+				if((0.0 == w[0] && false == edge_owns_boundary(*b, *c)) || (0.0 == w[1] && false == edge_owns_boundary(*c, a)) || (0.0 == w[2] && false == edge_owns_boundary(a, *b)))
+					continue;
+
+				const double w_sum = w[0] + w[1] + w[2];
+				const float z = static_cast<float>((w[0]*a.z + w[1]*b->z + w[2]*c->z)/w_sum);
+
+				crossings.push_back(make_pair(j*x_corners + i, z));
+			}
+		}
+	}
+
+	sort(crossings.begin(), crossings.end());
+
+	inside.assign(x_corners*y_corners*z_corners, false);
+
+	for(size_t first = 0; first < crossings.size(); )
+	{
+		size_t last = first;
+
+		while(last < crossings.size() && crossings[last].first == crossings[first].first)
+			last++;
+
+		const size_t column = crossings[first].first;
+		size_t below = first;
+
+		for(size_t k = 0; k < z_corners; k++)
+		{
+			while(below < last && crossings[below].second < zs[k])
+				below++;
+
+			if(1 == (below - first) % 2)
+				inside[k*x_corners*y_corners + column] = true;
+		}
+
+		first = last;
+	}
+}
+
+
+lattice_generator::lattice_generator(void)
+{
+	clear();
+}
+
+void lattice_generator::clear(void)
+{
+	unit_cells.clear();
+	levels.clear();
+	x_cells = y_cells = z_cells = 0;
+	origin = vertex_3(0, 0, 0);
+	cell_count = strut_count = triangle_count = 0;
+}
+
+bool lattice_generator::fill(const indexed_mesh &part, const lattice_settings &src_settings)
+{
+	clear();
+	settings = src_settings;
+
+	if(part.vertices.empty() || settings.cell_size <= 0.0f)
+		return false;
+
+	// The cells, one per density level. All share the thickness at their ports: that of the
+	// uniform cell halfway between the two fractions.
+	size_t num_levels = max(static_cast<size_t>(1), min(settings.density_levels, static_cast<size_t>(empty_cell)));
+
+	if(settings.core_volume_fraction == settings.volume_fraction || settings.grading_depth <= 0.0f)
+		num_levels = 1;
+
+	unit_cells.resize(num_levels);
+
+	if(1 == num_levels)
+	{
+		if(false == unit_cells[0].fit(settings.type, settings.volume_fraction, 0, settings.strut_sides, settings.resolution))
+		{
+			cout << "Error: No " << settings.volume_fraction << " volume fraction cell" << endl;
+			clear();
+			return false;
+		}
+	}
+	else
+	{
+		lattice_cell uniform;
+
+		if(false == uniform.fit(settings.type, 0.5*(settings.volume_fraction + settings.core_volume_fraction), 0, settings.strut_sides, settings.resolution))
+		{
+			cout << "Error: No uniform cell between the volume fractions" << endl;
+			clear();
+			return false;
+		}
+
+		for(size_t i = 0; i < num_levels; i++)
+		{
+			const double fraction = settings.volume_fraction + (settings.core_volume_fraction - settings.volume_fraction)*i/(num_levels - 1);
+
+			if(false == unit_cells[i].fit(settings.type, fraction, &uniform, settings.strut_sides, settings.resolution))
+			{
+				cout << "Error: No " << fraction << " volume fraction cell that joins the others" << endl;
+				clear();
+				return false;
+			}
+		}
+	}
+
+	// The grid, centred on the part's box.
+	vertex_3 low = part.vertices[0], high = part.vertices[0];
+
+	for(size_t i = 1; i < part.vertices.size(); i++)
+	{
+		const vertex_3 &v = part.vertices[i];
+
+		low = vertex_3(min(low.x, v.x), min(low.y, v.y), min(low.z, v.z));
+		high = vertex_3(max(high.x, v.x), max(high.y, v.y), max(high.z, v.z));
+	}
+
+	const float size = settings.cell_size;
+
+	x_cells = static_cast<size_t>((high.x - low.x)/size);
+	y_cells = static_cast<size_t>((high.y - low.y)/size);
+	z_cells = static_cast<size_t>((high.z - low.z)/size);
+
+	if(0 == x_cells || 0 == y_cells || 0 == z_cells)
+	{
+		clear();
+		return false;
+	}
+
+	origin = vertex_3(
+		low.x + 0.5f*((high.x - low.x) - size*x_cells),
+		low.y + 0.5f*((high.y - low.y) - size*y_cells),
+		low.z + 0.5f*((high.z - low.z) - size*z_cells));
+
+	const size_t x_corners = x_cells + 1, y_corners = y_cells + 1, z_corners = z_cells + 1;
+	vector<bool> inside;
+	classify_corners(part, origin, size, x_corners, y_corners, z_corners, inside);
+
+	// Cells with all corners inside, and how many cells in from the lattice's surface each
+	// is, going across faces.
+	const size_t num_cells = x_cells*y_cells*z_cells;
+	const uint32_t unreached = 0xFFFFFFFF;
+	vector<uint32_t> depths(num_cells, unreached);
+	deque<size_t> queue;
+
+	for(size_t z = 0; z < z_cells; z++)
+	{
+		for(size_t y = 0; y < y_cells; y++)
+		{
+			for(size_t x = 0; x < x_cells; x++)
+			{
+				bool kept = true;
+
+				for(size_t c = 0; c < 8 && true == kept; c++)
+					kept = inside[((z + (c >> 2))*y_corners + y + ((c >> 1) & 1))*x_corners + x + (c & 1)];
+
+				if(true == kept)
+					depths[(z*y_cells + y)*x_cells + x] = 0;
+			}
+		}
+	}
+
+	for(size_t z = 0; z < z_cells; z++)
+	{
+		for(size_t y = 0; y < y_cells; y++)
+		{
+			for(size_t x = 0; x < x_cells; x++)
+			{
+				const size_t i = (z*y_cells + y)*x_cells + x;
+
+				if(0 != depths[i])
+					continue;
+
+				if(0 == x || 0 == y || 0 == z || x_cells - 1 == x || y_cells - 1 == y || z_cells - 1 == z
+				|| unreached == depths[i - 1] || unreached == depths[i + 1]
+				|| unreached == depths[i - x_cells] || unreached == depths[i + x_cells]
+				|| unreached == depths[i - x_cells*y_cells] || unreached == depths[i + x_cells*y_cells])
+				{
+					depths[i] = 1;
+					queue.push_back(i);
+				}
+			}
+		}
+	}
+
+	while(false == queue.empty())
+	{
+		const size_t i = queue.front();
+		queue.pop_front();
+
+		const size_t x = i % x_cells, y = (i / x_cells) % y_cells, z = i / (x_cells*y_cells);
+		const size_t neighbours[6] = { x > 0 ? i - 1 : i, x + 1 < x_cells ? i + 1 : i, y > 0 ? i - x_cells : i, y + 1 < y_cells ? i + x_cells : i, z > 0 ? i - x_cells*y_cells : i, z + 1 < z_cells ? i + x_cells*y_cells : i };
+
+		for(size_t k = 0; k < 6; k++)
+		{
+			if(0 == depths[neighbours[k]])
+			{
+				depths[neighbours[k]] = depths[i] + 1;
+				queue.push_back(neighbours[k]);
+			}
+		}
+	}
+
+	levels.assign(num_cells, static_cast<uint8_t>(empty_cell));
+
+	for(size_t i = 0; i < num_cells; i++)
+	{
+		if(unreached == depths[i])
+			continue;
+
+		// The depth of the cell's middle, from the surface of the outermost cells.
+		const double depth = (depths[i] - 0.5)*size;
+		const double grade = (1 == num_levels) ? 0.0 : min(1.0, depth/settings.grading_depth);
+
+		levels[i] = static_cast<uint8_t>(floor(grade*(num_levels - 1) + 0.5));
+		cell_count++;
+	}
+
+	if(0 == cell_count)
+	{
+		clear();
+		return false;
+	}
+
+	for(size_t z = 0; z < z_cells; z++)
+	{
+		for(size_t y = 0; y < y_cells; y++)
+		{
+			for(size_t x = 0; x < x_cells; x++)
+			{
+				const uint8_t level = levels[(z*y_cells + y)*x_cells + x];
+
+				if(empty_cell == level)
+					continue;
+
+				const lattice_cell &unit = unit_cells[level];
+				triangle_count += unit.triangles.size();
+
+				for(size_t p = 0; p < unit.ports.size(); p++)
+				{
+					if(true == port_is_joined(unit.ports[p], x, y, z))
+					{
+						triangle_count += unit.ports[p].joined_triangles.size();
+
+						if(LATTICE_GYROID != unit.type)
+							strut_count++;
+					}
+					else
+					{
+						triangle_count += unit.ports[p].capped_triangles.size();
+					}
+				}
+			}
+		}
+	}
+
+	// Each strut was counted from both ends.
+	strut_count /= 2;
+
+	return true;
+}
+
+bool lattice_generator::port_is_joined(const lattice_port &port, const size_t x, const size_t y, const size_t z) const
+{
+	for(size_t i = 0; i < port.neighbour_count; i++)
+	{
+		const int64_t nx = static_cast<int64_t>(x) + port.neighbours[i][0];
+		const int64_t ny = static_cast<int64_t>(y) + port.neighbours[i][1];
+		const int64_t nz = static_cast<int64_t>(z) + port.neighbours[i][2];
+
+		if(nx < 0 || ny < 0 || nz < 0 || nx >= static_cast<int64_t>(x_cells) || ny >= static_cast<int64_t>(y_cells) || nz >= static_cast<int64_t>(z_cells))
+			return false;
+
+		if(empty_cell == levels[(nz*y_cells + ny)*x_cells + nx])
+			return false;
+	}
+
+	return true;
+}
+
+vertex_3 lattice_generator::position(const int64_t x, const int64_t y, const int64_t z, const vertex_3 &v) const
+{
+	const double size = settings.cell_size;
+
+	return vertex_3(
+		static_cast<float>(origin.x + (x + double(v.x))*size),
+		static_cast<float>(origin.y + (y + double(v.y))*size),
+		static_cast<float>(origin.z + (z + double(v.z))*size));
+}
+
+void lattice_generator::write(stl_stream_writer &writer) const
+{
+	vector<vertex_3> positions;
+
+	for(size_t z = 0; z < z_cells; z++)
+	{
+		for(size_t y = 0; y < y_cells; y++)
+		{
+			for(size_t x = 0; x < x_cells; x++)
+			{
+				const uint8_t level = levels[(z*y_cells + y)*x_cells + x];
+
+				if(empty_cell == level)
+					continue;
+
+				const lattice_cell &unit = unit_cells[level];
+
+				positions.resize(unit.vertices.size());
+
+				for(size_t i = 0; i < unit.vertices.size(); i++)
+				{
+					const uint32_t id = unit.shared_ids[i];
+
+					if(lattice_cell::none == id)
+						positions[i] = position(x, y, z, unit.vertices[i]);
+					else
+						positions[i] = position(x + unit.shared_offsets[3*i], y + unit.shared_offsets[3*i + 1], z + unit.shared_offsets[3*i + 2], unit.shared_vertices[id]);
+				}
+
+				for(size_t p = 0; p <= unit.ports.size(); p++)
+				{
+					const vector<indexed_triangle> *triangles = &unit.triangles;
+
+					if(p < unit.ports.size())
+						triangles = port_is_joined(unit.ports[p], x, y, z) ? &unit.ports[p].joined_triangles : &unit.ports[p].capped_triangles;
+
+					for(size_t i = 0; i < triangles->size(); i++)
+					{
+						const indexed_triangle &t = (*triangles)[i];
+						writer.add_triangle(positions[t.vertex_indices[0]], positions[t.vertex_indices[1]], positions[t.vertex_indices[2]]);
+					}
+				}
+			}
+		}
+	}
+}
+
+bool lattice_generator::save_to_binary_stereo_lithography_file(const char *const file_name) const
+{
+	stl_stream_writer writer;
+
+	if(false == writer.open(file_name))
+		return false;
+
+	write(writer);
+
+	return writer.close();
+}
+
+bool lattice_generator::get_mesh(indexed_mesh &mesh) const
+{
+	mesh.clear();
+
+	// Each kept cell has a block of vertices: its level's own ones, then a slot for each
+	// shared id. A shared vertex whose owner is not kept gets a vertex the first time
+	// it is reached instead.
+	vector<vector<mesh_index> > own_indices(unit_cells.size());
+	vector<size_t> own_counts(unit_cells.size(), 0);
+
+	for(size_t l = 0; l < unit_cells.size(); l++)
+	{
+		own_indices[l].assign(unit_cells[l].vertices.size(), 0);
+
+		for(size_t i = 0; i < unit_cells[l].vertices.size(); i++)
+			if(lattice_cell::none == unit_cells[l].shared_ids[i])
+				own_indices[l][i] = static_cast<mesh_index>(own_counts[l]++);
+	}
+
+	const size_t num_shared = unit_cells.empty() ? 0 : unit_cells[0].shared_vertices.size();
+	const size_t num_cells = levels.size();
+	vector<size_t> first_vertices(num_cells, 0);
+	size_t num_slots = 0;
+
+	for(size_t i = 0; i < num_cells; i++)
+	{
+		if(empty_cell == levels[i])
+			continue;
+
+		first_vertices[i] = num_slots;
+		num_slots += own_counts[levels[i]] + num_shared;
+	}
+
+	if(num_slots >= static_cast<size_t>(std::numeric_limits<mesh_index>::max()))
+		return false;
+
+	vector<vertex_3> slots(num_slots);
+	vector<bool> used(num_slots, false);
+	unordered_map<uint64_t, mesh_index> orphans;
+	vector<mesh_index> indices;
+
+	for(size_t z = 0; z < z_cells; z++)
+	{
+		for(size_t y = 0; y < y_cells; y++)
+		{
+			for(size_t x = 0; x < x_cells; x++)
+			{
+				const size_t cell = (z*y_cells + y)*x_cells + x;
+
+				if(empty_cell == levels[cell])
+					continue;
+
+				const lattice_cell &unit = unit_cells[levels[cell]];
+
+				indices.resize(unit.vertices.size());
+
+				for(size_t i = 0; i < unit.vertices.size(); i++)
+				{
+					const uint32_t id = unit.shared_ids[i];
+
+					if(lattice_cell::none == id)
+					{
+						indices[i] = static_cast<mesh_index>(first_vertices[cell] + own_indices[levels[cell]][i]);
+						slots[indices[i]] = position(x, y, z, unit.vertices[i]);
+						continue;
+					}
+
+					const int64_t ox = static_cast<int64_t>(x) + unit.shared_offsets[3*i];
+					const int64_t oy = static_cast<int64_t>(y) + unit.shared_offsets[3*i + 1];
+					const int64_t oz = static_cast<int64_t>(z) + unit.shared_offsets[3*i + 2];
+
+					if(ox >= 0 && oy >= 0 && oz >= 0 && ox < static_cast<int64_t>(x_cells) && oy < static_cast<int64_t>(y_cells) && oz < static_cast<int64_t>(z_cells)
+					&& empty_cell != levels[(oz*y_cells + oy)*x_cells + ox])
+					{
+						const size_t owner = (oz*y_cells + oy)*x_cells + ox;
+						indices[i] = static_cast<mesh_index>(first_vertices[owner] + own_counts[levels[owner]] + id);
+					}
+					else
+					{
+						// Owners are at most one cell outside the grid.
+						const uint64_t key = ((static_cast<uint64_t>(oz + 1)*(y_cells + 2) + static_cast<uint64_t>(oy + 1))*(x_cells + 2) + static_cast<uint64_t>(ox + 1))*num_shared + id;
+						unordered_map<uint64_t, mesh_index>::const_iterator found = orphans.find(key);
+
+						if(orphans.end() != found)
+						{
+							indices[i] = found->second;
+						}
+						else
+						{
+							indices[i] = static_cast<mesh_index>(slots.size());
+							orphans[key] = indices[i];
+							slots.push_back(vertex_3());
+							used.push_back(false);
+						}
+					}
+
+					slots[indices[i]] = position(ox, oy, oz, unit.shared_vertices[id]);
+				}
+
+				for(size_t p = 0; p <= unit.ports.size(); p++)
+				{
+					const vector<indexed_triangle> *triangles = &unit.triangles;
+
+					if(p < unit.ports.size())
+						triangles = port_is_joined(unit.ports[p], x, y, z) ? &unit.ports[p].joined_triangles : &unit.ports[p].capped_triangles;
+
+					for(size_t i = 0; i < triangles->size(); i++)
+					{
+						indexed_triangle t;
+
+						for(size_t k = 0; k < 3; k++)
+						{
+							t.vertex_indices[k] = indices[(*triangles)[i].vertex_indices[k]];
+							used[t.vertex_indices[k]] = true;
+						}
+
+						mesh.triangles.push_back(t);
+					}
+				}
+			}
+		}
+	}
+
+	if(slots.size() >= static_cast<size_t>(std::numeric_limits<mesh_index>::max()))
+	{
+		mesh.clear();
+		return false;
+	}
+
+	// Drop the slots that no triangle took, such as the rings of struts that were capped.
+	vector<mesh_index> renumbered(slots.size(), 0);
+
+	for(size_t i = 0; i < slots.size(); i++)
+	{
+		if(false == used[i])
+			continue;
+
+		renumbered[i] = static_cast<mesh_index>(mesh.vertices.size());
+		mesh.vertices.push_back(slots[i]);
+	}
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+		for(size_t k = 0; k < 3; k++)
+			mesh.triangles[i].vertex_indices[k] = renumbered[mesh.triangles[i].vertex_indices[k]];
+
+	return true;
+}
+
+size_t lattice_generator::memory_usage(void) const
+{
+	size_t bytes = levels.capacity()*sizeof(uint8_t);
+
+	for(size_t i = 0; i < unit_cells.size(); i++)
+	{
+		const lattice_cell &unit = unit_cells[i];
+
+		bytes += unit.vertices.capacity()*sizeof(vertex_3) + unit.shared_vertices.capacity()*sizeof(vertex_3);
+		bytes += unit.shared_ids.capacity()*sizeof(uint32_t) + unit.shared_offsets.capacity()*sizeof(int8_t);
+		bytes += unit.triangles.capacity()*sizeof(indexed_triangle);
+
+		for(size_t p = 0; p < unit.ports.size(); p++)
+		{
+			const lattice_port &port = unit.ports[p];
+			bytes += sizeof(lattice_port) + (port.joined_triangles.capacity() + port.capped_triangles.capacity() + port.cut_triangles.capacity())*sizeof(indexed_triangle);
+		}
+	}
+
+	return bytes;
+}
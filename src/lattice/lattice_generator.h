@@ -0,0 +1,83 @@
+#ifndef LATTICE_GENERATOR_H
+#define LATTICE_GENERATOR_H
+
+#include "lattice_cell.h"
+#include "../tomo_mesh/stl_stream_writer.h"
+#include "../common/mesh.h"
+
+
+class lattice_settings
+{
+public:
+	lattice_settings(void);
+
+	lattice_cell_type type;
+	float cell_size; // In the part's units
+
+	// The fraction of a cell's volume that is solid, for cells at the lattice's surface,
+	// and for cells grading_depth or more in from it; the fractions in between are
+	// rounded to one of density_levels steps, each a cell of its own.
+	double volume_fraction;
+	double core_volume_fraction;
+	float grading_depth;
+	size_t density_levels;
+
+	size_t strut_sides; // Per strut ring
+	size_t resolution;  // Samples per cell width, for the gyroid; a power of two
+};
+
+// Fills a closed mesh with a lattice of unit cells.
+//
+// The cells are a grid over the part's box, and a cell is kept if all eight of its corners
+// are inside the part, so the lattice never reaches out through the part's surface by more
+// than a strut's radius. Corners are classified down columns along z: each triangle that
+// a column passes through (by exact tests on float coordinates, with a tie rule for
+// columns through an edge or vertex that counts them once) is a crossing, and a corner is
+// inside when an odd number of crossings lie below it.
+//
+// Only one lattice_cell per density level is ever built; the lattice itself is one byte
+// per grid cell, its level. Writing it out goes cell by cell, placing the level's
+// vertices by translation and scale and taking each port's tube if the cells across it
+// are kept, or its cap if not, so a lattice of millions of struts streams to a file
+// without a mesh of it being held anywhere. Vertices on a cut between cells are always
+// placed from the cell that owns them, so both sides of a cut get the same floats, and
+// get_mesh() welds them there, and only there, by index.
+class lattice_generator
+{
+public:
+	lattice_generator(void);
+
+	// Returns false if the cells cannot be built for the settings, or none fits in the part.
+	bool fill(const indexed_mesh &part, const lattice_settings &src_settings);
+
+	void clear(void);
+
+	bool save_to_binary_stereo_lithography_file(const char *const file_name) const;
+	void write(stl_stream_writer &writer) const;
+
+	// The lattice as one closed mesh. Returns false if it has more vertices than mesh_index can address.
+	bool get_mesh(indexed_mesh &mesh) const;
+
+	size_t memory_usage(void) const;
+
+	static const uint8_t empty_cell = 0xFF;
+
+	lattice_settings settings;
+	vector<lattice_cell> unit_cells; // One per density level
+
+	size_t x_cells, y_cells, z_cells;
+	vertex_3 origin; // The low corner of cell (0, 0, 0)
+	vector<uint8_t> levels; // Per cell, x fastest, then y, then z: its density level, or empty_cell
+
+	// Counts from the last fill().
+	size_t cell_count;
+	size_t strut_count;
+	size_t triangle_count;
+
+private:
+	bool port_is_joined(const lattice_port &port, const size_t x, const size_t y, const size_t z) const;
+	vertex_3 position(const int64_t x, const int64_t y, const int64_t z, const vertex_3 &v) const;
+};
+
+
+#endif
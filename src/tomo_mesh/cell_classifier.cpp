@@ -0,0 +1,215 @@
+#include "cell_classifier.h"
+
+#include <cmath>
+
+#include <limits>
+using std::numeric_limits;
+
+#if !defined(CELL_CLASSIFIER_SCALAR) && defined(__AVX2__)
+	#define CELL_CLASSIFIER_AVX2
+	#include <immintrin.h>
+#endif
+
+
+// Integer samples are below the isolevel exactly when they are below ceil(isolevel).
+// Sets all_below or none_below if the threshold falls outside of [min_value, max_value].
+static int32_t integer_threshold(const double isolevel, const int32_t min_value, const int32_t max_value, bool &all_below, bool &none_below)
+{
+	const double threshold = ceil(isolevel);
+
+	all_below = none_below = false;
+
+	// Note: This also catches a NaN isolevel, which nothing is below.
+	if(!(threshold > static_cast<double>(min_value)))
+	{
+		none_below = true;
+		return min_value;
+	}
+
+	if(threshold > static_cast<double>(max_value))
+	{
+		all_below = true;
+		return max_value;
+	}
+
+	return static_cast<int32_t>(threshold);
+}
+
+#if defined(CELL_CLASSIFIER_AVX2)
+
+// Spreads the 16 bits of a comparison mask out to 16 bytes of 0 or 1.
+static inline __m128i expand_mask(const int mask)
+{
+	const __m128i spread = _mm_shuffle_epi8(_mm_set1_epi16(static_cast<short>(mask)), _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1));
+	const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+
+	return _mm_min_epu8(_mm_and_si128(spread, bits), _mm_set1_epi8(1));
+}
+
+#endif
+
+void classify_voxels(const double *values, const size_t count, const double isolevel, uint8_t *below)
+{
+	size_t i = 0;
+
+#if defined(CELL_CLASSIFIER_AVX2)
+	const __m256d iso = _mm256_set1_pd(isolevel);
+
+	for( ; i + 16 <= count; i += 16)
+	{
+		const int m0 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i), iso, _CMP_LT_OQ));
+		const int m1 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i + 4), iso, _CMP_LT_OQ));
+		const int m2 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i + 8), iso, _CMP_LT_OQ));
+		const int m3 = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(values + i + 12), iso, _CMP_LT_OQ));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(below + i), expand_mask(m0 | (m1 << 4) | (m2 << 8) | (m3 << 12)));
+	}
+#endif
+
+	for( ; i < count; i++)
+		below[i] = (values[i] < isolevel) ? 1 : 0;
+}
+
+void classify_voxels(const float *values, const size_t count, const double isolevel, uint8_t *below)
+{
+	// A float is below the isolevel exactly when it is below the smallest float at or above it,
+	// so the comparisons can be done in single precision.
+	float threshold = numeric_limits<float>::infinity();
+
+	if(isolevel <= static_cast<double>(numeric_limits<float>::max()))
+	{
+		threshold = static_cast<float>(isolevel);
+
+		if(static_cast<double>(threshold) < isolevel)
+			threshold = nextafterf(threshold, numeric_limits<float>::infinity());
+	}
+	else if(isolevel != isolevel)
+	{
+		threshold = static_cast<float>(isolevel);
+	}
+
+	size_t i = 0;
+
+#if defined(CELL_CLASSIFIER_AVX2)
+	const __m256 t = _mm256_set1_ps(threshold);
+
+	for( ; i + 16 <= count; i += 16)
+	{
+		const int m0 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i), t, _CMP_LT_OQ));
+		const int m1 = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(values + i + 8), t, _CMP_LT_OQ));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(below + i), expand_mask(m0 | (m1 << 8)));
+	}
+#endif
+
+	for( ; i < count; i++)
+		below[i] = (values[i] < threshold) ? 1 : 0;
+}
+
+void classify_voxels(const int16_t *values, const size_t count, const double isolevel, uint8_t *below)
+{
+	bool all_below = false, none_below = false;
+	const int32_t threshold = integer_threshold(isolevel, -32768, 32767, all_below, none_below);
+
+	if(true == all_below || true == none_below)
+	{
+		for(size_t i = 0; i < count; i++)
+			below[i] = (true == all_below) ? 1 : 0;
+
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(CELL_CLASSIFIER_AVX2)
+	const __m256i t = _mm256_set1_epi16(static_cast<short>(threshold));
+
+	for( ; i + 16 <= count; i += 16)
+	{
+		const __m256i lt = _mm256_cmpgt_epi16(t, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)));
+		const __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(lt), _mm256_extracti128_si256(lt, 1));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(below + i), _mm_and_si128(bytes, _mm_set1_epi8(1)));
+	}
+#endif
+
+	for( ; i < count; i++)
+		below[i] = (values[i] < threshold) ? 1 : 0;
+}
+
+void classify_voxels(const uint16_t *values, const size_t count, const double isolevel, uint8_t *below)
+{
+	bool all_below = false, none_below = false;
+	const int32_t threshold = integer_threshold(isolevel, 0, 65535, all_below, none_below);
+
+	if(true == all_below || true == none_below)
+	{
+		for(size_t i = 0; i < count; i++)
+			below[i] = (true == all_below) ? 1 : 0;
+
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(CELL_CLASSIFIER_AVX2)
+	// There is no unsigned 16-bit compare, so flip the top bits and compare signed.
+	const __m256i flip = _mm256_set1_epi16(static_cast<short>(0x8000));
+	const __m256i t = _mm256_set1_epi16(static_cast<short>(threshold ^ 0x8000));
+
+	for( ; i + 16 <= count; i += 16)
+	{
+		const __m256i v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)), flip);
+		const __m256i lt = _mm256_cmpgt_epi16(t, v);
+		const __m128i bytes = _mm_packs_epi16(_mm256_castsi256_si128(lt), _mm256_extracti128_si256(lt, 1));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(below + i), _mm_and_si128(bytes, _mm_set1_epi8(1)));
+	}
+#endif
+
+	for( ; i < count; i++)
+		below[i] = (values[i] < threshold) ? 1 : 0;
+}
+
+void combine_cell_cases(const uint8_t *below_00, const uint8_t *below_10, const uint8_t *below_01, const uint8_t *below_11, const size_t count, uint8_t *cases)
+{
+	size_t x = 0;
+
+	// Corners 0 through 7 are (x, y, z), (x + 1, y, z), (x + 1, y + 1, z), (x, y + 1, z),
+	// then the same on z + 1. Each byte is 0 or 1, so the 16-bit shifts never carry
+	// into the next byte.
+#if defined(CELL_CLASSIFIER_AVX2)
+	for( ; x + 32 <= count; x += 32)
+	{
+		#define LOAD_BELOW(row, offset) _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x + offset))
+
+		__m256i c = LOAD_BELOW(below_00, 0);
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_00, 1), 1));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_10, 1), 2));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_10, 0), 3));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_01, 0), 4));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_01, 1), 5));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_11, 1), 6));
+		c = _mm256_or_si256(c, _mm256_slli_epi16(LOAD_BELOW(below_11, 0), 7));
+
+		#undef LOAD_BELOW
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(cases + x), c);
+	}
+#endif
+
+	for( ; x < count; x++)
+	{
+		cases[x] = static_cast<uint8_t>(below_00[x] | (below_00[x + 1] << 1) | (below_10[x + 1] << 2) | (below_10[x] << 3) |
+					(below_01[x] << 4) | (below_01[x + 1] << 5) | (below_11[x + 1] << 6) | (below_11[x] << 7));
+	}
+}
+
+const char *cell_classifier_instruction_set(void)
+{
+#if defined(CELL_CLASSIFIER_AVX2)
+	return "AVX2";
+#else
+	return "scalar";
+#endif
+}
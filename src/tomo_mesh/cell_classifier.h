@@ -0,0 +1,54 @@
+#ifndef CELL_CLASSIFIER_H
+#define CELL_CLASSIFIER_H
+
+#include <vector>
+using std::vector;
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Case indices for whole rows of cells at once, rather than eight comparisons per cell.
+//
+// First each voxel row is compared against the isolevel, a vector at a time, giving one
+// byte (0 or 1) per voxel: 1 when the sample is below the isolevel. Then the bytes of the
+// four voxel rows around a row of cells -- (y, z), (y + 1, z), (y, z + 1), (y + 1, z + 1) --
+// are shifted into place and or'ed together, 32 cells at a time, giving each cell's 8-bit
+// case index with the corner numbering of Polygonise() (see marching_cubes_tables.h).
+//
+// AVX2 is used when the compiler targets it (e.g. -mavx2 or -march=native); define
+// CELL_CLASSIFIER_SCALAR to force the scalar code.
+
+// Sets below[i] to 1 if values[i] < isolevel, and to 0 otherwise, for i in [0, count).
+void classify_voxels(const double *values, const size_t count, const double isolevel, uint8_t *below);
+void classify_voxels(const float *values, const size_t count, const double isolevel, uint8_t *below);
+void classify_voxels(const int16_t *values, const size_t count, const double isolevel, uint8_t *below);
+void classify_voxels(const uint16_t *values, const size_t count, const double isolevel, uint8_t *below);
+
+// Case indices of count cells, from the classified voxel rows around them (count + 1 entries each).
+void combine_cell_cases(const uint8_t *below_00, const uint8_t *below_10, const uint8_t *below_01, const uint8_t *below_11, const size_t count, uint8_t *cases);
+
+// Both steps for one row of count cells. row_yz points at the first voxel of the voxel row
+// offset by (y, z) from the cells' own. scratch is reused between calls.
+template<class T>
+void classify_cell_row(const T *row_00, const T *row_10, const T *row_01, const T *row_11, const size_t count, const double isolevel, uint8_t *cases, vector<uint8_t> &scratch)
+{
+	const size_t width = count + 1;
+
+	if(scratch.size() < 4*width)
+		scratch.resize(4*width);
+
+	uint8_t *below = &scratch[0];
+
+	classify_voxels(row_00, width, isolevel, below);
+	classify_voxels(row_10, width, isolevel, below + width);
+	classify_voxels(row_01, width, isolevel, below + 2*width);
+	classify_voxels(row_11, width, isolevel, below + 3*width);
+
+	combine_cell_cases(below, below + width, below + 2*width, below + 3*width, count, cases);
+}
+
+const char *cell_classifier_instruction_set(void);
+
+
+#endif
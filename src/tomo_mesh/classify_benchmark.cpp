@@ -0,0 +1,147 @@
+// Times cube-index classification of every cell in a synthetic volume, once cell by cell
+// (the eight comparisons of Polygonise()) and once a row at a time with the cell classifier,
+// for each sample type. Also checks that both give the same case indices.
+//
+// Example usage: classify_benchmark [x_res y_res z_res]
+// Build with -mavx2 (or -march=native) to time the vectorized classifier.
+
+#include "cell_classifier.h"
+#include "../boolean_poly/test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <limits>
+using std::numeric_limits;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+// Case indices of all cells, x fastest, eight comparisons per cell.
+template<class T>
+void classify_cells_one_by_one(const vector<T> &values, const size_t x_res, const size_t y_res, const size_t z_res, const double isolevel, vector<uint8_t> &cases)
+{
+	size_t i = 0;
+
+	for(size_t z = 0; z < z_res - 1; z++)
+	{
+		for(size_t y = 0; y < y_res - 1; y++)
+		{
+			const T *r00 = &values[(z*y_res + y)*x_res];
+			const T *r10 = r00 + x_res;
+			const T *r01 = r00 + x_res*y_res;
+			const T *r11 = r01 + x_res;
+
+			for(size_t x = 0; x < x_res - 1; x++)
+			{
+				int cube_index = 0;
+
+				if(r00[x] < isolevel) cube_index |= 1;
+				if(r00[x + 1] < isolevel) cube_index |= 2;
+				if(r10[x + 1] < isolevel) cube_index |= 4;
+				if(r10[x] < isolevel) cube_index |= 8;
+				if(r01[x] < isolevel) cube_index |= 16;
+				if(r01[x + 1] < isolevel) cube_index |= 32;
+				if(r11[x + 1] < isolevel) cube_index |= 64;
+				if(r11[x] < isolevel) cube_index |= 128;
+
+				cases[i++] = static_cast<uint8_t>(cube_index);
+			}
+		}
+	}
+}
+
+template<class T>
+void classify_cells_by_row(const vector<T> &values, const size_t x_res, const size_t y_res, const size_t z_res, const double isolevel, vector<uint8_t> &cases)
+{
+	vector<uint8_t> scratch;
+	size_t i = 0;
+
+	for(size_t z = 0; z < z_res - 1; z++)
+	{
+		for(size_t y = 0; y < y_res - 1; y++)
+		{
+			const T *r00 = &values[(z*y_res + y)*x_res];
+
+			classify_cell_row(r00, r00 + x_res, r00 + x_res*y_res, r00 + x_res*y_res + x_res, x_res - 1, isolevel, &cases[i], scratch);
+			i += x_res - 1;
+		}
+	}
+}
+
+template<class T>
+void run_benchmark(const char *const type_name, const size_t x_res, const size_t y_res, const size_t z_res)
+{
+	// A noisy sphere, in the range of CT numbers, so that about half the cells are mixed
+	// and the comparisons do not predict well.
+	vector<T> values(x_res*y_res*z_res);
+
+	for(size_t z = 0; z < z_res; z++)
+	{
+		for(size_t y = 0; y < y_res; y++)
+		{
+			for(size_t x = 0; x < x_res; x++)
+			{
+				const double dx = x - 0.5*x_res, dy = y - 0.5*y_res, dz = z - 0.5*z_res;
+				const double r = sqrt(dx*dx + dy*dy + dz*dz) / (0.4*x_res);
+
+				// Clamped to the type's range first, since the corners fall below zero.
+				double value = 1000.0*(1.0 - r) + static_cast<double>(rand() % 400);
+
+				if(value < static_cast<double>(numeric_limits<T>::lowest()))
+					value = static_cast<double>(numeric_limits<T>::lowest());
+				else if(value > static_cast<double>(numeric_limits<T>::max()))
+					value = static_cast<double>(numeric_limits<T>::max());
+
+				values[(z*y_res + y)*x_res + x] = static_cast<T>(value);
+			}
+		}
+	}
+
+	const double isolevel = 300.5;
+	const size_t num_cells = (x_res - 1)*(y_res - 1)*(z_res - 1);
+	vector<uint8_t> scalar_cases(num_cells), row_cases(num_cells);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	classify_cells_one_by_one(values, x_res, y_res, z_res, isolevel, scalar_cases);
+	const double scalar_time = seconds_since(start);
+
+	start = std::chrono::steady_clock::now();
+	classify_cells_by_row(values, x_res, y_res, z_res, isolevel, row_cases);
+	const double row_time = seconds_since(start);
+
+	cout << type_name << ':' << endl;
+	cout << "  cell by cell: " << num_cells / scalar_time / 1e6 << " M cells/s" << endl;
+	cout << "  by row:       " << num_cells / row_time / 1e6 << " M cells/s (" << scalar_time / row_time << "x)" << endl;
+	cout << "  case indices: " << ((scalar_cases == row_cases) ? "identical" : "DIFFERENT") << endl;
+}
+
+int main(int argc, char **argv)
+{
+	size_t x_res = 512, y_res = 512, z_res = 128;
+
+	if(4 == argc)
+	{
+		x_res = strtoul(argv[1], 0, 10);
+		y_res = strtoul(argv[2], 0, 10);
+		z_res = strtoul(argv[3], 0, 10);
+	}
+
+	if(x_res < 2 || y_res < 2 || z_res < 2)
+	{
+		cout << "Example usage: " << argv[0] << " [x_res y_res z_res]" << endl;
+		return 1;
+	}
+
+	cout << "Classifying " << (x_res - 1)*(y_res - 1)*(z_res - 1) << " cells using the " << cell_classifier_instruction_set() << " classifier" << endl;
+
+	run_benchmark<double>("double", x_res, y_res, z_res);
+	run_benchmark<float>("float", x_res, y_res, z_res);
+	run_benchmark<int16_t>("int16", x_res, y_res, z_res);
+	run_benchmark<uint16_t>("uint16", x_res, y_res, z_res);
+
+	return 0;
+}
@@ -0,0 +1,232 @@
+// Checks incremental_extractor against fresh extractions: a volume is meshed once, then
+// edited again and again, and after each update the mesh must hold the same triangles,
+// vertex for vertex, as marching cubes run afresh on the edited volume, and use as many
+// vertices.
+//
+// The volume is a sphere of CT-like whole numbers with noise on it, so that some samples
+// sit on the isolevel. Each edit fills or empties a ball of random size and place, or sets
+// it to the isolevel, and the time of each update is reported.
+//
+// Example usage: incremental_check [resolution [num_edits]]
+
+#include "incremental_extractor.h"
+#include "isosurface_extractor.h"
+#include "../boolean_poly/test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <algorithm>
+using std::sort;
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+// A fixed sequence, so that every run makes the same edits.
+static uint32_t next_random(uint32_t &state)
+{
+	state = state*1664525u + 1013904223u;
+	return state >> 8;
+}
+
+static bool vertex_less(const vertex_3 &a, const vertex_3 &b)
+{
+	if(a.x != b.x)
+		return a.x < b.x;
+
+	if(a.y != b.y)
+		return a.y < b.y;
+
+	return a.z < b.z;
+}
+
+class triangle_key
+{
+public:
+	vertex_3 corners[3];
+
+	bool operator<(const triangle_key &other) const
+	{
+		for(size_t i = 0; i < 3; i++)
+		{
+			if(vertex_less(corners[i], other.corners[i]))
+				return true;
+
+			if(vertex_less(other.corners[i], corners[i]))
+				return false;
+		}
+
+		return false;
+	}
+
+	bool operator!=(const triangle_key &other) const
+	{
+		return (*this < other) || (other < *this);
+	}
+};
+
+// The mesh's triangles by corner position, each turned to start at its least corner so
+// that the winding is kept, in order; and the number of vertices they use.
+static size_t triangle_keys(const indexed_mesh &mesh, vector<triangle_key> &keys)
+{
+	vector<bool> used(mesh.vertices.size(), false);
+	size_t used_count = 0;
+
+	keys.resize(mesh.triangles.size());
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		size_t first = 0;
+
+		for(size_t j = 0; j < 3; j++)
+		{
+			const mesh_index v = mesh.triangles[i].vertex_indices[j];
+
+			if(false == used[v])
+			{
+				used[v] = true;
+				used_count++;
+			}
+
+			if(vertex_less(mesh.vertices[v], mesh.vertices[mesh.triangles[i].vertex_indices[first]]))
+				first = j;
+		}
+
+		for(size_t j = 0; j < 3; j++)
+			keys[i].corners[j] = mesh.vertices[mesh.triangles[i].vertex_indices[(first + j) % 3]];
+	}
+
+	sort(keys.begin(), keys.end());
+
+	return used_count;
+}
+
+static bool same_surface(const indexed_mesh &updated, const indexed_mesh &fresh)
+{
+	vector<triangle_key> updated_keys, fresh_keys;
+
+	if(triangle_keys(updated, updated_keys) != triangle_keys(fresh, fresh_keys) || updated_keys.size() != fresh_keys.size())
+		return false;
+
+	for(size_t i = 0; i < updated_keys.size(); i++)
+		if(updated_keys[i] != fresh_keys[i])
+			return false;
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	size_t resolution = 128;
+	size_t num_edits = 20;
+
+	if(argc > 1)
+		resolution = strtoul(argv[1], 0, 10);
+
+	if(argc > 2)
+		num_edits = strtoul(argv[2], 0, 10);
+
+	if(resolution < 16)
+	{
+		cout << "Example usage: " << argv[0] << " [resolution [num_edits]]" << endl;
+		return 1;
+	}
+
+	const double isolevel = 500.0;
+	const double middle = 0.5*(resolution - 1);
+	uint32_t state = 1;
+
+	uint16_voxel_volume volume;
+	volume.resize(resolution, resolution, resolution);
+
+	for(size_t z = 0; z < resolution; z++)
+	{
+		for(size_t y = 0; y < resolution; y++)
+		{
+			for(size_t x = 0; x < resolution; x++)
+			{
+				const double r = sqrt((x - middle)*(x - middle) + (y - middle)*(y - middle) + (z - middle)*(z - middle));
+				const double value = 1000.0 - 1200.0*r/resolution + static_cast<double>(next_random(state) % 41) - 20.0;
+
+				volume(x, y, z) = static_cast<uint16_t>((value < 0.0) ? 0.0 : ((value > 1000.0) ? 1000.0 : floor(value + 0.5)));
+			}
+		}
+	}
+
+	incremental_extractor extractor;
+	isosurface_extractor fresh_extractor;
+	indexed_mesh mesh, fresh;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	if(false == extractor.extract(volume, isolevel, mesh))
+	{
+		cout << "Could not extract the volume" << endl;
+		return 2;
+	}
+
+	const double extract_time = seconds_since(start);
+
+	fresh_extractor.extract(volume, isolevel, fresh);
+	bool passed = same_surface(mesh, fresh);
+
+	cout << resolution << "^3 samples: " << mesh.triangles.size() << " triangles in " << extract_time << " s, "
+	     << (passed ? "same as marching cubes" : "NOT THE SAME AS MARCHING CUBES") << endl;
+
+	const uint16_t fills[3] = { 0, 1000, static_cast<uint16_t>(isolevel) };
+
+	for(size_t e = 0; e < num_edits; e++)
+	{
+		const double radius = 2.0 + static_cast<double>(next_random(state) % 1000)/1000.0*0.15*resolution;
+		double centre[3];
+
+		for(size_t k = 0; k < 3; k++)
+			centre[k] = static_cast<double>(next_random(state) % resolution);
+
+		const uint16_t fill = fills[next_random(state) % 3];
+
+		size_t first[3], last[3];
+
+		for(size_t k = 0; k < 3; k++)
+		{
+			first[k] = (centre[k] > radius) ? static_cast<size_t>(ceil(centre[k] - radius)) : 0;
+			last[k] = static_cast<size_t>(floor(centre[k] + radius));
+
+			if(last[k] > resolution - 1)
+				last[k] = resolution - 1;
+		}
+
+		for(size_t z = first[2]; z <= last[2]; z++)
+			for(size_t y = first[1]; y <= last[1]; y++)
+				for(size_t x = first[0]; x <= last[0]; x++)
+					if((x - centre[0])*(x - centre[0]) + (y - centre[1])*(y - centre[1]) + (z - centre[2])*(z - centre[2]) <= radius*radius)
+						volume(x, y, z) = fill;
+
+		start = std::chrono::steady_clock::now();
+
+		extractor.mark_dirty(first[0], first[1], first[2], last[0], last[1], last[2]);
+		const size_t dirty_count = extractor.dirty_brick_count();
+
+		if(false == extractor.update(volume, mesh))
+		{
+			cout << "Could not update after edit " << e << endl;
+			return 2;
+		}
+
+		const double update_time = seconds_since(start);
+
+		fresh_extractor.extract(volume, isolevel, fresh);
+		const bool same = same_surface(mesh, fresh);
+		passed = passed && same;
+
+		cout << "  edit " << e << ": ball of radius " << radius << " set to " << fill << ", " << dirty_count << " bricks in "
+		     << 1000.0*update_time << " ms, " << fresh.triangles.size() << " triangles, " << (same ? "same" : "NOT THE SAME") << endl;
+	}
+
+	cout << (passed ? "Every update matched a fresh extraction" : "SOME UPDATES DID NOT MATCH") << endl;
+
+	return passed ? 0 : 2;
+}
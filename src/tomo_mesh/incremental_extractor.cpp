@@ -0,0 +1,325 @@
+#include "incremental_extractor.h"
+#include "isosurface_extractor.h" // for interpolate_edge()
+
+#include <algorithm>
+using std::sort;
+
+#include <utility>
+using std::make_pair;
+
+
+const size_t incremental_extractor::brick_width;
+
+template<class T>
+bool incremental_extractor::extract(const basic_voxel_volume<T> &volume, const double src_isolevel, indexed_mesh &mesh)
+{
+	fail(mesh);
+
+	if(volume.x_res < 2 || volume.y_res < 2 || volume.z_res < 2)
+		return false;
+
+	isolevel = src_isolevel;
+	x_res = volume.x_res;
+	y_res = volume.y_res;
+	z_res = volume.z_res;
+	bricks_x = (x_res - 1 + brick_width - 1) / brick_width;
+	bricks_y = (y_res - 1 + brick_width - 1) / brick_width;
+	bricks_z = (z_res - 1 + brick_width - 1) / brick_width;
+
+	const size_t num_bricks = bricks_x*bricks_y*bricks_z;
+
+	brick_first_triangles.assign(num_bricks + 1, 0);
+	brick_edge_keys.assign(num_bricks, vector<uint64_t>());
+	dirty.assign(num_bricks, false);
+
+	vector<indexed_triangle> brick_triangles;
+
+	for(size_t b = 0; b < num_bricks; b++)
+	{
+		brick_triangles.clear();
+
+		if(false == extract_brick(volume, b, mesh, brick_triangles))
+		{
+			fail(mesh);
+			return false;
+		}
+
+		mesh.triangles.insert(mesh.triangles.end(), brick_triangles.begin(), brick_triangles.end());
+		brick_first_triangles[b + 1] = mesh.triangles.size();
+	}
+
+	return true;
+}
+
+void incremental_extractor::mark_dirty(const size_t first_x, const size_t first_y, const size_t first_z, const size_t last_x, const size_t last_y, const size_t last_z)
+{
+	if(0 == dirty.size() || first_x > last_x || first_y > last_y || first_z > last_z || first_x >= x_res || first_y >= y_res || first_z >= z_res)
+		return;
+
+	// Voxel v is a corner of cells v - 1 and v.
+	const size_t first_cell[3] = { first_x > 0 ? first_x - 1 : 0, first_y > 0 ? first_y - 1 : 0, first_z > 0 ? first_z - 1 : 0 };
+	const size_t last_cell[3] = { last_x < x_res - 2 ? last_x : x_res - 2, last_y < y_res - 2 ? last_y : y_res - 2, last_z < z_res - 2 ? last_z : z_res - 2 };
+
+	for(size_t bz = first_cell[2] / brick_width; bz <= last_cell[2] / brick_width; bz++)
+	{
+		for(size_t by = first_cell[1] / brick_width; by <= last_cell[1] / brick_width; by++)
+		{
+			for(size_t bx = first_cell[0] / brick_width; bx <= last_cell[0] / brick_width; bx++)
+			{
+				const size_t b = brick_index(bx, by, bz);
+
+				if(false == dirty[b])
+				{
+					dirty[b] = true;
+					dirty_bricks.push_back(b);
+				}
+			}
+		}
+	}
+}
+
+template<class T>
+bool incremental_extractor::update(const basic_voxel_volume<T> &volume, indexed_mesh &mesh)
+{
+	if(volume.x_res != x_res || volume.y_res != y_res || volume.z_res != z_res || 0 == dirty.size())
+	{
+		fail(mesh);
+		return false;
+	}
+
+	if(0 == dirty_bricks.size())
+		return true;
+
+	sort(dirty_bricks.begin(), dirty_bricks.end());
+
+	// Free the vertices that only dirty bricks used, so that the new ones can reuse them.
+	for(size_t i = 0; i < dirty_bricks.size(); i++)
+		release_brick(dirty_bricks[i]);
+
+	// Rebuild the triangle array in brick order: runs of clean bricks are copied across
+	// whole, and each dirty brick's range is replaced by its new triangles.
+	const size_t num_bricks = dirty.size();
+	vector<indexed_triangle> triangles;
+	vector<indexed_triangle> brick_triangles;
+	vector<size_t> first_triangles(num_bricks + 1);
+
+	triangles.reserve(mesh.triangles.size() + mesh.triangles.size()/8);
+
+	size_t run_start = 0;
+
+	for(size_t i = 0; i <= dirty_bricks.size(); i++)
+	{
+		const size_t run_end = (i < dirty_bricks.size()) ? dirty_bricks[i] : num_bricks;
+		const size_t base = triangles.size();
+
+		for(size_t b = run_start; b < run_end; b++)
+			first_triangles[b] = base + brick_first_triangles[b] - brick_first_triangles[run_start];
+
+		triangles.insert(triangles.end(), mesh.triangles.begin() + brick_first_triangles[run_start], mesh.triangles.begin() + brick_first_triangles[run_end]);
+
+		if(run_end == num_bricks)
+			break;
+
+		first_triangles[run_end] = triangles.size();
+		brick_triangles.clear();
+
+		if(false == extract_brick(volume, run_end, mesh, brick_triangles))
+		{
+			fail(mesh);
+			return false;
+		}
+
+		triangles.insert(triangles.end(), brick_triangles.begin(), brick_triangles.end());
+		dirty[run_end] = false;
+		run_start = run_end + 1;
+	}
+
+	first_triangles[num_bricks] = triangles.size();
+
+	brick_first_triangles.swap(first_triangles);
+	mesh.triangles.swap(triangles);
+	dirty_bricks.clear();
+
+	mesh.vertex_to_triangle_indices.clear();
+	mesh.vertex_to_vertex_indices.clear();
+	mesh.vertex_normals.clear();
+	mesh.triangle_normals.clear();
+
+	return true;
+}
+
+// Polygonises the brick's cells into brick_triangles, looking up (or creating) the vertices in
+// the mesh, and records which edges the brick uses.
+template<class T>
+bool incremental_extractor::extract_brick(const basic_voxel_volume<T> &volume, const size_t brick, indexed_mesh &mesh, vector<indexed_triangle> &brick_triangles)
+{
+	const size_t bx = brick % bricks_x;
+	const size_t by = (brick / bricks_x) % bricks_y;
+	const size_t bz = brick / (bricks_x*bricks_y);
+
+	const size_t first_x = bx*brick_width, first_y = by*brick_width, first_z = bz*brick_width;
+	const size_t last_x = (first_x + brick_width < x_res - 1) ? first_x + brick_width : x_res - 1;
+	const size_t last_y = (first_y + brick_width < y_res - 1) ? first_y + brick_width : y_res - 1;
+	const size_t last_z = (first_z + brick_width < z_res - 1) ? first_z + brick_width : z_res - 1;
+	const size_t count = last_x - first_x;
+
+	vector<uint64_t> &keys = brick_edge_keys[brick];
+	keys.clear();
+
+	// The brick's own edge table, indexed by the edge's lower voxel relative to the brick, and
+	// axis. An entry is only valid if its stamp is the current one, which saves clearing it.
+	const size_t local_edges = (brick_width + 1)*(brick_width + 1)*(brick_width + 1)*3;
+
+	if(brick_vertices.size() != local_edges || 0 == ++stamp)
+	{
+		brick_vertices.assign(local_edges, 0);
+		brick_vertex_stamps.assign(local_edges, 0);
+		stamp = 1;
+	}
+
+	if(cases.size() < count)
+		cases.resize(count);
+
+	for(size_t z = first_z; z < last_z; z++)
+	{
+		for(size_t y = first_y; y < last_y; y++)
+		{
+			classify_cell_row(&volume.values[volume.index(first_x, y, z)], &volume.values[volume.index(first_x, y + 1, z)],
+							  &volume.values[volume.index(first_x, y, z + 1)], &volume.values[volume.index(first_x, y + 1, z + 1)],
+							  count, isolevel, &cases[0], classifier_scratch);
+
+			for(size_t i = 0; i < count; i++)
+			{
+				const int cube_index = cases[i];
+
+				if(0 == edge_table[cube_index])
+					continue;
+
+				const size_t x = first_x + i;
+				mesh_index edge_vertices[12];
+
+				for(size_t e = 0; e < 12; e++)
+				{
+					if(0 == (edge_table[cube_index] & (1 << e)))
+						continue;
+
+					const int c0 = edge_corners[e][0];
+					const int c1 = edge_corners[e][1];
+					const size_t ex = x + corner_offsets[c0][0];
+					const size_t ey = y + corner_offsets[c0][1];
+					const size_t ez = z + corner_offsets[c0][2];
+					const size_t axis = (corner_offsets[c1][0] != corner_offsets[c0][0]) ? 0 : ((corner_offsets[c1][1] != corner_offsets[c0][1]) ? 1 : 2);
+					const size_t local = (((ez - first_z)*(brick_width + 1) + (ey - first_y))*(brick_width + 1) + (ex - first_x))*3 + axis;
+
+					if(stamp == brick_vertex_stamps[local])
+					{
+						edge_vertices[e] = brick_vertices[local];
+						continue;
+					}
+
+					// The brick's first use of the edge.
+					const uint64_t key = 3*static_cast<uint64_t>(volume.index(ex, ey, ez)) + axis;
+
+					unordered_map<uint64_t, shared_vertex>::iterator it = vertex_lookup.find(key);
+
+					if(vertex_lookup.end() == it)
+					{
+						shared_vertex v;
+						v.bricks = 0;
+
+						if(0 != free_vertices.size())
+						{
+							v.index = free_vertices.back();
+							free_vertices.pop_back();
+						}
+						else
+						{
+							if(mesh.vertices.size() >= static_cast<size_t>(static_cast<mesh_index>(~static_cast<mesh_index>(0))))
+								return false;
+
+							v.index = static_cast<mesh_index>(mesh.vertices.size());
+							mesh.vertices.push_back(vertex_3());
+						}
+
+						it = vertex_lookup.insert(make_pair(key, v)).first;
+					}
+
+					// (Re)place the vertex, since the samples at the edge's ends may have been edited.
+					double p[2][3];
+					const int corners[2] = { c0, c1 };
+
+					for(size_t k = 0; k < 2; k++)
+					{
+						p[k][0] = volume.origin.x + volume.voxel_size.x*static_cast<double>(x + corner_offsets[corners[k]][0]);
+						p[k][1] = volume.origin.y + volume.voxel_size.y*static_cast<double>(y + corner_offsets[corners[k]][1]);
+						p[k][2] = volume.origin.z + volume.voxel_size.z*static_cast<double>(z + corner_offsets[corners[k]][2]);
+					}
+
+					mesh.vertices[it->second.index] = interpolate_edge(isolevel, p[0], p[1],
+																	   volume(x + corner_offsets[c0][0], y + corner_offsets[c0][1], z + corner_offsets[c0][2]),
+																	   volume(x + corner_offsets[c1][0], y + corner_offsets[c1][1], z + corner_offsets[c1][2]));
+
+					it->second.bricks++;
+					keys.push_back(key);
+					brick_vertex_stamps[local] = stamp;
+					brick_vertices[local] = it->second.index;
+					edge_vertices[e] = it->second.index;
+				}
+
+				for(size_t t = 0; tri_table[cube_index][t] != -1; t += 3)
+				{
+					indexed_triangle tri;
+
+					for(size_t j = 0; j < 3; j++)
+						tri.vertex_indices[j] = edge_vertices[tri_table[cube_index][t + j]];
+
+					brick_triangles.push_back(tri);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+void incremental_extractor::release_brick(const size_t brick)
+{
+	vector<uint64_t> &keys = brick_edge_keys[brick];
+
+	for(size_t i = 0; i < keys.size(); i++)
+	{
+		unordered_map<uint64_t, shared_vertex>::iterator it = vertex_lookup.find(keys[i]);
+
+		if(0 == --it->second.bricks)
+		{
+			free_vertices.push_back(it->second.index);
+			vertex_lookup.erase(it);
+		}
+	}
+
+	keys.clear();
+}
+
+void incremental_extractor::fail(indexed_mesh &mesh)
+{
+	mesh.clear();
+	brick_first_triangles.clear();
+	brick_edge_keys.clear();
+	vertex_lookup.clear();
+	free_vertices.clear();
+	dirty.clear();
+	dirty_bricks.clear();
+}
+
+// The sample types of basic_voxel_volume.
+template bool incremental_extractor::extract<double>(const basic_voxel_volume<double> &volume, const double src_isolevel, indexed_mesh &mesh);
+template bool incremental_extractor::update<double>(const basic_voxel_volume<double> &volume, indexed_mesh &mesh);
+
+template bool incremental_extractor::extract<float>(const basic_voxel_volume<float> &volume, const double src_isolevel, indexed_mesh &mesh);
+template bool incremental_extractor::update<float>(const basic_voxel_volume<float> &volume, indexed_mesh &mesh);
+
+template bool incremental_extractor::extract<int16_t>(const basic_voxel_volume<int16_t> &volume, const double src_isolevel, indexed_mesh &mesh);
+template bool incremental_extractor::update<int16_t>(const basic_voxel_volume<int16_t> &volume, indexed_mesh &mesh);
+
+template bool incremental_extractor::extract<uint16_t>(const basic_voxel_volume<uint16_t> &volume, const double src_isolevel, indexed_mesh &mesh);
+template bool incremental_extractor::update<uint16_t>(const basic_voxel_volume<uint16_t> &volume, indexed_mesh &mesh);
@@ -0,0 +1,99 @@
+#ifndef INCREMENTAL_EXTRACTOR_H
+#define INCREMENTAL_EXTRACTOR_H
+
+#include "voxel_volume.h"
+#include "marching_cubes_tables.h"
+#include "cell_classifier.h"
+#include "../common/mesh.h"
+
+#include <unordered_map>
+using std::unordered_map;
+
+
+// Marching cubes that can redo just the parts of a volume that were edited.
+//
+// The cells are grouped into bricks of brick_width^3 (as in min_max_pyramid). The mesh's
+// triangles are kept in brick order, and each brick remembers where its range starts and
+// which cut edges its triangles use. Vertices are looked up by edge (the edge's lower
+// voxel and axis), with a count of the bricks that use them, so the bricks on either
+// side of a face share the vertices on it.
+//
+// After the volume is edited, mark_dirty() flags the bricks whose cells touch the edited
+// voxels, and update() re-extracts only those. The triangle ranges of the dirty bricks
+// are replaced in one pass over the triangle array, vertices that no brick uses any more
+// are freed for reuse, and vertices on edges that were re-extracted are moved. The
+// other triangles keep their vertex indices.
+//
+// Freed vertices stay in mesh.vertices, unused, until a later edit reuses them.
+// extract() and update() clear the mesh's adjacency and normals, since rebuilding them
+// is a whole-mesh pass; call generate_adjacency() when they are needed (e.g. to smooth).
+// The member templates are instantiated in incremental_extractor.cpp for the sample
+// types of basic_voxel_volume.
+class incremental_extractor
+{
+public:
+	static const size_t brick_width = 8;
+
+	incremental_extractor(void) : isolevel(0), x_res(0), y_res(0), z_res(0), bricks_x(0), bricks_y(0), bricks_z(0), stamp(0) { }
+
+	// Replaces the mesh's contents with the whole volume's surface. Returns false if the
+	// volume is smaller than one cell, or would need more vertices than mesh_index can address.
+	template<class T>
+	bool extract(const basic_voxel_volume<T> &volume, const double src_isolevel, indexed_mesh &mesh);
+
+	// Flags the bricks whose cells use any voxel in [first, last] (inclusive, in voxels).
+	void mark_dirty(const size_t first_x, const size_t first_y, const size_t first_z, const size_t last_x, const size_t last_y, const size_t last_z);
+
+	// Re-extracts the dirty bricks of the volume last given to extract(), which the mesh must
+	// still be from. Returns false, and clears the mesh, on the same failures as extract().
+	template<class T>
+	bool update(const basic_voxel_volume<T> &volume, indexed_mesh &mesh);
+
+	inline size_t dirty_brick_count(void) const { return dirty_bricks.size(); }
+
+private:
+	class shared_vertex
+	{
+	public:
+		mesh_index index;
+		uint32_t bricks;
+	};
+
+	inline size_t brick_index(const size_t bx, const size_t by, const size_t bz) const
+	{
+		return (bz*bricks_y + by)*bricks_x + bx;
+	}
+
+	template<class T>
+	bool extract_brick(const basic_voxel_volume<T> &volume, const size_t brick, indexed_mesh &mesh, vector<indexed_triangle> &brick_triangles);
+	void release_brick(const size_t brick);
+	void fail(indexed_mesh &mesh);
+
+	double isolevel;
+	size_t x_res, y_res, z_res;
+	size_t bricks_x, bricks_y, bricks_z;
+
+	// Brick b's triangles are mesh.triangles[brick_first_triangles[b]] to [brick_first_triangles[b + 1] - 1].
+	vector<size_t> brick_first_triangles;
+
+	// The cut edges each brick's triangles use, as keys of vertex_lookup.
+	vector<vector<uint64_t> > brick_edge_keys;
+
+	unordered_map<uint64_t, shared_vertex> vertex_lookup;
+	vector<mesh_index> free_vertices;
+
+	// The vertex of each edge the brick being extracted has used so far (see extract_brick()).
+	vector<mesh_index> brick_vertices;
+	vector<uint32_t> brick_vertex_stamps;
+	uint32_t stamp;
+
+	vector<bool> dirty;
+	vector<size_t> dirty_bricks;
+
+	// Case indices of the cell row being polygonised, and the classifier's scratch space.
+	vector<uint8_t> cases;
+	vector<uint8_t> classifier_scratch;
+};
+
+
+#endif
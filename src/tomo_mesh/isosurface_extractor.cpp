@@ -0,0 +1,540 @@
+#include "isosurface_extractor.h"
+
+#include <cmath>
+
+
+const mesh_index isosurface_slab::no_vertex;
+const mesh_index isosurface_slab::pending_vertex;
+
+vertex_3 interpolate_edge(const double isolevel, const double p1[3], const double p2[3], const double v1, const double v2)
+{
+	// A sample exactly on the isolevel counts as above it, so the surface passes it by
+	// rather than through it. VertexInterp() would put every cut edge's vertex there;
+	// kept a little way off both ends instead, the vertices of the edges that meet at a
+	// sample stay apart, and so do their triangles' corners.
+	const double edge_margin = 1.0/64.0;
+	double mu = 0.5;
+
+	if(v1 != v2)
+		mu = (isolevel - v1) / (v2 - v1);
+
+	if(false == (mu > edge_margin))
+		mu = edge_margin;
+	else if(mu > 1.0 - edge_margin)
+		mu = 1.0 - edge_margin;
+
+	return vertex_3(static_cast<float>(p1[0] + mu*(p2[0] - p1[0])),
+					static_cast<float>(p1[1] + mu*(p2[1] - p1[1])),
+					static_cast<float>(p1[2] + mu*(p2[2] - p1[2])));
+}
+
+template<class T>
+bool isosurface_slab::extract(const basic_voxel_volume<T> &volume, const double isolevel, const size_t src_first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method src_method)
+{
+	return extract_layers(volume, isolevel, src_first_layer, last_layer, pyramid, src_method, 0 != src_first_layer);
+}
+
+template<class T>
+bool isosurface_slab::extract_window(const basic_voxel_volume<T> &window, const double isolevel, const bool src_bottom_is_shared, const isosurface_method src_method)
+{
+	if(2 != window.z_res)
+		return false;
+
+	return extract_layers(window, isolevel, 0, 1, 0, src_method, src_bottom_is_shared);
+}
+
+template<class T>
+bool isosurface_slab::extract_layers(const basic_voxel_volume<T> &volume, const double isolevel, const size_t src_first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method src_method, const bool src_bottom_is_shared)
+{
+	vertices.clear();
+	triangles.clear();
+	pending_corners.clear();
+	pending_edge_codes.clear();
+
+	const size_t x_res = volume.x_res;
+	const size_t y_res = volume.y_res;
+	const bool diagonals = (ISOSURFACE_MARCHING_TETRAHEDRA == src_method);
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		x_edges[i].assign((x_res - 1)*y_res, no_vertex);
+		y_edges[i].assign(x_res*(y_res - 1), no_vertex);
+		xy_diagonals[i].assign(diagonals ? (x_res - 1)*(y_res - 1) : 0, no_vertex);
+		touched_x_edges[i].clear();
+		touched_y_edges[i].clear();
+		touched_xy_diagonals[i].clear();
+	}
+
+	z_edges.assign(x_res*y_res, no_vertex);
+	xz_diagonals.assign(diagonals ? (x_res - 1)*y_res : 0, no_vertex);
+	yz_diagonals.assign(diagonals ? x_res*(y_res - 1) : 0, no_vertex);
+	touched_z_edges.clear();
+	touched_xz_diagonals.clear();
+	touched_yz_diagonals.clear();
+	bottom = 0;
+	first_layer = src_first_layer;
+	bottom_is_shared = src_bottom_is_shared;
+	method = src_method;
+
+	for(size_t z = first_layer; z < last_layer; z++)
+	{
+		// The old top slice is the new bottom one; start the new top slice and z edges afresh.
+		// Only the entries that were set are reset, so empty layers cost nothing here.
+		if(z > first_layer)
+		{
+			bottom = 1 - bottom;
+			reset_entries(x_edges[1 - bottom], touched_x_edges[1 - bottom]);
+			reset_entries(y_edges[1 - bottom], touched_y_edges[1 - bottom]);
+			reset_entries(z_edges, touched_z_edges);
+			reset_entries(xy_diagonals[1 - bottom], touched_xy_diagonals[1 - bottom]);
+			reset_entries(xz_diagonals, touched_xz_diagonals);
+			reset_entries(yz_diagonals, touched_yz_diagonals);
+		}
+
+		for(size_t y = 0; y < y_res - 1; y++)
+		{
+			if(0 == pyramid)
+			{
+				if(false == polygonise_cell_span(volume, isolevel, 0, x_res - 1, y, z))
+					return false;
+
+				continue;
+			}
+
+			// Visit only the bricks whose range straddles the isolevel, still in x order,
+			// so the vertices are numbered just as they would be by a full scan.
+			const size_t brick_width = min_max_pyramid::brick_width;
+			const size_t by = y / brick_width;
+			const size_t bz = z / brick_width;
+
+			for(size_t bx = pyramid->next_straddling_brick(0, by, bz, isolevel); bx < pyramid->bricks_x(); bx = pyramid->next_straddling_brick(bx + 1, by, bz, isolevel))
+			{
+				const size_t x_end = ((bx + 1)*brick_width < x_res - 1) ? (bx + 1)*brick_width : x_res - 1;
+
+				if(false == polygonise_cell_span(volume, isolevel, bx*brick_width, x_end, y, z))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Classifies cells [first_x, last_x) of row (y, z) together, then polygonises those the surface cuts.
+template<class T>
+bool isosurface_slab::polygonise_cell_span(const basic_voxel_volume<T> &volume, const double isolevel, const size_t first_x, const size_t last_x, const size_t y, const size_t z)
+{
+	const size_t count = last_x - first_x;
+
+	if(cases.size() < count)
+		cases.resize(count);
+
+	classify_cell_row(&volume.values[volume.index(first_x, y, z)], &volume.values[volume.index(first_x, y + 1, z)],
+					  &volume.values[volume.index(first_x, y, z + 1)], &volume.values[volume.index(first_x, y + 1, z + 1)],
+					  count, isolevel, &cases[0], classifier_scratch);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		// The cell is entirely inside or outside of the surface.
+		if(0 == edge_table[cases[i]])
+			continue;
+
+		if(ISOSURFACE_MARCHING_TETRAHEDRA == method)
+		{
+			if(false == polygonise_tetrahedra(volume, isolevel, first_x + i, y, z, cases[i]))
+				return false;
+		}
+		else if(false == polygonise_cell(volume, isolevel, first_x + i, y, z, cases[i]))
+			return false;
+	}
+
+	return true;
+}
+
+void isosurface_slab::reset_entries(vector<mesh_index> &table, vector<size_t> &touched)
+{
+	for(size_t i = 0; i < touched.size(); i++)
+		table[touched[i]] = no_vertex;
+
+	touched.clear();
+}
+
+template<class T>
+bool isosurface_slab::polygonise_cell(const basic_voxel_volume<T> &volume, const double isolevel, const size_t x, const size_t y, const size_t z, const int cube_index)
+{
+	double corner_values[8];
+
+	for(size_t c = 0; c < 8; c++)
+		corner_values[c] = volume(x + corner_offsets[c][0], y + corner_offsets[c][1], z + corner_offsets[c][2]);
+
+	mesh_index edge_vertices[12];
+	size_t edge_codes[12];
+
+	for(size_t e = 0; e < 12; e++)
+	{
+		if(edge_table[cube_index] & (1 << e))
+		{
+			edge_vertices[e] = get_edge_vertex(volume, isolevel, e, x, y, z, corner_values, edge_codes[e]);
+
+			if(no_vertex == edge_vertices[e])
+				return false;
+		}
+	}
+
+	for(size_t i = 0; tri_table[cube_index][i] != -1; i += 3)
+	{
+		const int a = tri_table[cube_index][i];
+		const int b = tri_table[cube_index][i + 1];
+		const int c = tri_table[cube_index][i + 2];
+
+		add_triangle(edge_vertices[a], edge_vertices[b], edge_vertices[c], edge_codes[a], edge_codes[b], edge_codes[c]);
+	}
+
+	return true;
+}
+
+template<class T>
+bool isosurface_slab::polygonise_tetrahedra(const basic_voxel_volume<T> &volume, const double isolevel, const size_t x, const size_t y, const size_t z, const int cube_index)
+{
+	double corner_values[8];
+
+	for(size_t c = 0; c < 8; c++)
+		corner_values[c] = volume(x + corner_offsets[c][0], y + corner_offsets[c][1], z + corner_offsets[c][2]);
+
+	// An edge is cut when its corners are on opposite sides of the isolevel.
+	mesh_index edge_vertices[19];
+	size_t edge_codes[19];
+
+	for(size_t e = 0; e < 19; e++)
+	{
+		if(((cube_index >> edge_corners[e][0]) & 1) != ((cube_index >> edge_corners[e][1]) & 1))
+		{
+			edge_vertices[e] = get_edge_vertex(volume, isolevel, e, x, y, z, corner_values, edge_codes[e]);
+
+			if(no_vertex == edge_vertices[e])
+				return false;
+		}
+	}
+
+	for(size_t t = 0; t < 6; t++)
+	{
+		int tetrahedron_index = 0;
+
+		for(size_t c = 0; c < 4; c++)
+			if(cube_index & (1 << tetrahedra[t][c]))
+				tetrahedron_index |= (1 << c);
+
+		const int *tri = tetrahedron_tri_table[tetrahedron_index];
+
+		for(size_t i = 0; tri[i] != -1; i += 3)
+		{
+			const int a = tetrahedron_edges[t][tri[i]];
+			const int b = tetrahedron_edges[t][tri[i + 1]];
+			const int c = tetrahedron_edges[t][tri[i + 2]];
+
+			add_triangle(edge_vertices[a], edge_vertices[b], edge_vertices[c], edge_codes[a], edge_codes[b], edge_codes[c]);
+		}
+	}
+
+	return true;
+}
+
+// Adds a triangle, noting which of its corners are left pending.
+void isosurface_slab::add_triangle(const mesh_index a, const mesh_index b, const mesh_index c, const size_t code_a, const size_t code_b, const size_t code_c)
+{
+	const mesh_index corners[3] = { a, b, c };
+	const size_t codes[3] = { code_a, code_b, code_c };
+	indexed_triangle t;
+
+	for(size_t j = 0; j < 3; j++)
+	{
+		t.vertex_indices[j] = corners[j];
+
+		if(pending_vertex == corners[j])
+		{
+			pending_corners.push_back(3*triangles.size() + j);
+			pending_edge_codes.push_back(codes[j]);
+		}
+	}
+
+	triangles.push_back(t);
+}
+
+// Returns the index of the vertex on the given edge of cell (x, y, z), creating it on first use.
+template<class T>
+mesh_index isosurface_slab::get_edge_vertex(const basic_voxel_volume<T> &volume, const double isolevel, const size_t edge, const size_t x, const size_t y, const size_t z, const double *corner_values, size_t &edge_code)
+{
+	const int c0 = edge_corners[edge][0];
+	const int c1 = edge_corners[edge][1];
+
+	// The edge's lower voxel, relative to the cell's own.
+	const size_t ex = x + corner_offsets[c0][0];
+	const size_t ey = y + corner_offsets[c0][1];
+	const bool on_bottom_slice = (0 == corner_offsets[c0][2] && 0 == corner_offsets[c1][2]);
+	const size_t slice = (0 == corner_offsets[c0][2]) ? bottom : 1 - bottom;
+
+	const bool along_x = (corner_offsets[c1][0] != corner_offsets[c0][0]);
+	const bool along_y = (corner_offsets[c1][1] != corner_offsets[c0][1]);
+	const bool along_z = (corner_offsets[c1][2] != corner_offsets[c0][2]);
+
+	vector<mesh_index> *table = 0;
+	vector<size_t> *touched = 0;
+	size_t slot_index = 0;
+
+	// Only edges on the slices can be left pending, so only they need a code.
+	edge_code = 0;
+
+	if(true == along_x && true == along_y && true == along_z)
+	{
+		// The cell's own diagonal; no other cell uses it.
+	}
+	else if(true == along_x && true == along_y)
+	{
+		table = &xy_diagonals[slice];
+		touched = &touched_xy_diagonals[slice];
+		slot_index = ey*(volume.x_res - 1) + ex;
+		edge_code = (volume.x_res - 1)*volume.y_res + volume.x_res*(volume.y_res - 1) + slot_index;
+	}
+	else if(true == along_x && true == along_z)
+	{
+		table = &xz_diagonals;
+		touched = &touched_xz_diagonals;
+		slot_index = ey*(volume.x_res - 1) + ex;
+	}
+	else if(true == along_y && true == along_z)
+	{
+		table = &yz_diagonals;
+		touched = &touched_yz_diagonals;
+		slot_index = ey*volume.x_res + ex;
+	}
+	else if(true == along_x)
+	{
+		table = &x_edges[slice];
+		touched = &touched_x_edges[slice];
+		slot_index = ey*(volume.x_res - 1) + ex;
+		edge_code = slot_index;
+	}
+	else if(true == along_y)
+	{
+		table = &y_edges[slice];
+		touched = &touched_y_edges[slice];
+		slot_index = ey*volume.x_res + ex;
+		edge_code = (volume.x_res - 1)*volume.y_res + slot_index;
+	}
+	else
+	{
+		table = &z_edges;
+		touched = &touched_z_edges;
+		slot_index = ey*volume.x_res + ex;
+	}
+
+	mesh_index *slot = 0;
+
+	if(0 != table)
+	{
+		slot = &(*table)[slot_index];
+
+		if(no_vertex != *slot)
+			return *slot;
+	}
+
+	if(true == on_bottom_slice && z == first_layer && true == bottom_is_shared)
+		return pending_vertex;
+
+	if(vertices.size() >= static_cast<size_t>(pending_vertex))
+		return no_vertex;
+
+	double p[2][3];
+	const int corners[2] = { c0, c1 };
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		p[i][0] = volume.origin.x + volume.voxel_size.x*static_cast<double>(x + corner_offsets[corners[i]][0]);
+		p[i][1] = volume.origin.y + volume.voxel_size.y*static_cast<double>(y + corner_offsets[corners[i]][1]);
+		p[i][2] = volume.origin.z + volume.voxel_size.z*static_cast<double>(z + corner_offsets[corners[i]][2]);
+	}
+
+	const mesh_index v = static_cast<mesh_index>(vertices.size());
+	vertices.push_back(interpolate_edge(isolevel, p[0], p[1], corner_values[c0], corner_values[c1]));
+
+	if(0 != slot)
+	{
+		*slot = v;
+		touched->push_back(slot_index);
+	}
+
+	return v;
+}
+
+mesh_index isosurface_slab::top_slice_vertex(const size_t edge_code) const
+{
+	const size_t top = 1 - bottom;
+
+	if(edge_code < x_edges[top].size())
+		return x_edges[top][edge_code];
+
+	if(edge_code < x_edges[top].size() + y_edges[top].size())
+		return y_edges[top][edge_code - x_edges[top].size()];
+
+	return xy_diagonals[top][edge_code - x_edges[top].size() - y_edges[top].size()];
+}
+
+void isosurface_slab::release_working_tables(void)
+{
+	vector<mesh_index>().swap(x_edges[bottom]);
+	vector<mesh_index>().swap(y_edges[bottom]);
+	vector<mesh_index>().swap(z_edges);
+	vector<mesh_index>().swap(xy_diagonals[bottom]);
+	vector<mesh_index>().swap(xz_diagonals);
+	vector<mesh_index>().swap(yz_diagonals);
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		vector<size_t>().swap(touched_x_edges[i]);
+		vector<size_t>().swap(touched_y_edges[i]);
+		vector<size_t>().swap(touched_xy_diagonals[i]);
+	}
+
+	vector<size_t>().swap(touched_z_edges);
+	vector<size_t>().swap(touched_xz_diagonals);
+	vector<size_t>().swap(touched_yz_diagonals);
+}
+
+// Extracts slabs, taking the next unclaimed one each time, until there are none left.
+template<class T>
+static void extract_slabs(const basic_voxel_volume<T> &volume, const double isolevel, const min_max_pyramid *pyramid, const isosurface_method method, const size_t layers_per_slab, vector<isosurface_slab> &slabs, atomic<size_t> &next_slab, atomic<bool> &failed)
+{
+	const size_t num_layers = volume.z_res - 1;
+
+	for(size_t s = next_slab++; s < slabs.size(); s = next_slab++)
+	{
+		const size_t first_layer = s*layers_per_slab;
+		const size_t last_layer = (first_layer + layers_per_slab < num_layers) ? first_layer + layers_per_slab : num_layers;
+
+		if(false == slabs[s].extract(volume, isolevel, first_layer, last_layer, pyramid, method))
+			failed = true;
+
+		slabs[s].release_working_tables();
+	}
+}
+
+template<class T>
+bool isosurface_extractor::extract(const basic_voxel_volume<T> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads, const min_max_pyramid *pyramid, const isosurface_method method)
+{
+	mesh.clear();
+
+	if(volume.x_res < 2 || volume.y_res < 2 || volume.z_res < 2)
+		return false;
+
+	if(0 != pyramid && false == pyramid->fits(volume))
+		pyramid = 0;
+
+	const size_t num_layers = volume.z_res - 1;
+	size_t layers_per_slab = num_layers;
+
+	// A few slabs per thread, so that there are spares to even out the load,
+	// but enough layers per slab to keep the stitching small.
+	if(num_threads > 1)
+	{
+		layers_per_slab = num_layers / (4*num_threads);
+
+		if(layers_per_slab < 8)
+			layers_per_slab = 8;
+	}
+
+	vector<isosurface_slab> slabs((num_layers + layers_per_slab - 1) / layers_per_slab);
+	atomic<size_t> next_slab(0);
+	atomic<bool> failed(false);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < num_threads && t < slabs.size(); t++)
+		threads.push_back(thread(extract_slabs<T>, cref(volume), isolevel, pyramid, method, layers_per_slab, ref(slabs), ref(next_slab), ref(failed)));
+
+	extract_slabs(volume, isolevel, pyramid, method, layers_per_slab, slabs, next_slab, failed);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	if(true == failed || false == stitch_slabs(slabs, mesh))
+	{
+		mesh.clear();
+		return false;
+	}
+
+	mesh.generate_adjacency(num_threads);
+
+	return true;
+}
+
+// Appends the slabs' vertices and triangles in slab order, which is the order
+// a single slab covering the whole volume would have created them in.
+bool isosurface_extractor::stitch_slabs(vector<isosurface_slab> &slabs, indexed_mesh &mesh) const
+{
+	vector<size_t> first_vertices(slabs.size() + 1, 0);
+	size_t num_triangles = 0;
+
+	for(size_t s = 0; s < slabs.size(); s++)
+	{
+		first_vertices[s + 1] = first_vertices[s] + slabs[s].vertices.size();
+		num_triangles += slabs[s].triangles.size();
+	}
+
+	if(first_vertices[slabs.size()] >= static_cast<size_t>(isosurface_slab::pending_vertex))
+		return false;
+
+	// With one slab, there is nothing to renumber.
+	if(1 == slabs.size())
+	{
+		mesh.vertices.swap(slabs[0].vertices);
+		mesh.triangles.swap(slabs[0].triangles);
+		return true;
+	}
+
+	mesh.vertices.reserve(first_vertices[slabs.size()]);
+	mesh.triangles.reserve(num_triangles);
+
+	for(size_t s = 0; s < slabs.size(); s++)
+	{
+		isosurface_slab &slab = slabs[s];
+
+		for(size_t i = 0; i < slab.triangles.size(); i++)
+			for(size_t j = 0; j < 3; j++)
+				slab.triangles[i].vertex_indices[j] = static_cast<mesh_index>(slab.triangles[i].vertex_indices[j] + first_vertices[s]);
+
+		// Point the pending corners at the slab below's top slice vertices.
+		for(size_t i = 0; i < slab.pending_corners.size(); i++)
+		{
+			const mesh_index v = slabs[s - 1].top_slice_vertex(slab.pending_edge_codes[i]);
+
+			if(isosurface_slab::no_vertex == v)
+				return false;
+
+			slab.triangles[slab.pending_corners[i] / 3].vertex_indices[slab.pending_corners[i] % 3] = static_cast<mesh_index>(first_vertices[s - 1] + v);
+		}
+
+		mesh.vertices.insert(mesh.vertices.end(), slab.vertices.begin(), slab.vertices.end());
+		mesh.triangles.insert(mesh.triangles.end(), slab.triangles.begin(), slab.triangles.end());
+
+		vector<vertex_3>().swap(slab.vertices);
+		vector<indexed_triangle>().swap(slab.triangles);
+	}
+
+	return true;
+}
+
+// The sample types of basic_voxel_volume.
+template bool isosurface_slab::extract<double>(const basic_voxel_volume<double> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method method);
+template bool isosurface_slab::extract_window<double>(const basic_voxel_volume<double> &window, const double isolevel, const bool bottom_is_shared, const isosurface_method method);
+template bool isosurface_extractor::extract<double>(const basic_voxel_volume<double> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads, const min_max_pyramid *pyramid, const isosurface_method method);
+
+template bool isosurface_slab::extract<float>(const basic_voxel_volume<float> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method method);
+template bool isosurface_slab::extract_window<float>(const basic_voxel_volume<float> &window, const double isolevel, const bool bottom_is_shared, const isosurface_method method);
+template bool isosurface_extractor::extract<float>(const basic_voxel_volume<float> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads, const min_max_pyramid *pyramid, const isosurface_method method);
+
+template bool isosurface_slab::extract<int16_t>(const basic_voxel_volume<int16_t> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method method);
+template bool isosurface_slab::extract_window<int16_t>(const basic_voxel_volume<int16_t> &window, const double isolevel, const bool bottom_is_shared, const isosurface_method method);
+template bool isosurface_extractor::extract<int16_t>(const basic_voxel_volume<int16_t> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads, const min_max_pyramid *pyramid, const isosurface_method method);
+
+template bool isosurface_slab::extract<uint16_t>(const basic_voxel_volume<uint16_t> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method method);
+template bool isosurface_slab::extract_window<uint16_t>(const basic_voxel_volume<uint16_t> &window, const double isolevel, const bool bottom_is_shared, const isosurface_method method);
+template bool isosurface_extractor::extract<uint16_t>(const basic_voxel_volume<uint16_t> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads, const min_max_pyramid *pyramid, const isosurface_method method);
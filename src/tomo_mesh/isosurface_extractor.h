@@ -0,0 +1,147 @@
+#ifndef ISOSURFACE_EXTRACTOR_H
+#define ISOSURFACE_EXTRACTOR_H
+
+#include "voxel_volume.h"
+#include "marching_cubes_tables.h"
+#include "min_max_pyramid.h"
+#include "cell_classifier.h"
+#include "../common/mesh.h"
+
+#include <atomic>
+using std::atomic;
+
+
+enum isosurface_method
+{
+	ISOSURFACE_MARCHING_CUBES,      // Polygonise()'s tables: fewest triangles; ambiguous cells get whichever topology the table lists
+	ISOSURFACE_MARCHING_TETRAHEDRA  // Six tetrahedra per cell (see tetrahedra[]): two to three times the triangles, and no ambiguous faces
+};
+
+// Where the surface cuts the edge from p1 (value v1) to p2 (value v2): interpolated as
+// in VertexInterp(), but never within 1/64 of the edge of either end, so that no two cut
+// edges share a vertex position even where samples sit exactly on the isolevel.
+vertex_3 interpolate_edge(const double isolevel, const double p1[3], const double p2[3], const double v1, const double v2);
+
+// The cells of z layers [first_layer, last_layer), meshed with their own vertex numbering.
+//
+// Every edge that the surface cuts gets one vertex, interpolated once (see
+// interpolate_edge()), and its index is cached: x and y edges in two slice-sized tables
+// (the current layer's bottom and top slices, which swap roles when moving up a layer)
+// and z edges in one table for the layer. Neighbouring cells look the index up instead of
+// interpolating again, so the slab comes out welded.
+//
+// The cut edges on a slab's bottom slice are all cut edges of the layer below it too,
+// so they belong to the slab below. Corners that use them are left pending, to be
+// filled in from that slab's top slice tables.
+//
+// Marching tetrahedra also cuts the cells' face diagonals, which are cached in the same
+// way: xy diagonals with the slices, xz and yz diagonals with the layer. The diagonal
+// through each cell is only used by that cell, so it is not cached.
+class isosurface_slab
+{
+public:
+	// Returns false if the slab would need more vertices than mesh_index can address.
+	// With a pyramid, only the bricks that straddle the isolevel are visited.
+	template<class T>
+	bool extract(const basic_voxel_volume<T> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid = 0, const isosurface_method method = ISOSURFACE_MARCHING_CUBES);
+
+	// Meshes the one layer of a two-slice window. With bottom_is_shared, the window's bottom
+	// slice is the top slice of the window meshed before it, and its corners are left pending
+	// just like those of a slab that does not start at layer 0.
+	template<class T>
+	bool extract_window(const basic_voxel_volume<T> &window, const double isolevel, const bool bottom_is_shared, const isosurface_method method = ISOSURFACE_MARCHING_CUBES);
+
+	// Index of the vertex on the given edge of the slab's top slice, or no_vertex.
+	// Codes below (x_res - 1)*y_res are x edges, the next x_res*(y_res - 1) are y edges,
+	// and the rest xy diagonals.
+	mesh_index top_slice_vertex(const size_t edge_code) const;
+
+	// Drops everything but the top slice tables.
+	void release_working_tables(void);
+
+	static const mesh_index no_vertex = static_cast<mesh_index>(~static_cast<mesh_index>(0));
+	static const mesh_index pending_vertex = no_vertex - 1;
+
+	vector<vertex_3> vertices;
+	vector<indexed_triangle> triangles;
+
+	// Corners (3*triangle + corner) that use a bottom slice vertex, and that vertex's edge code.
+	vector<size_t> pending_corners;
+	vector<size_t> pending_edge_codes;
+
+private:
+	template<class T>
+	bool extract_layers(const basic_voxel_volume<T> &volume, const double isolevel, const size_t first_layer, const size_t last_layer, const min_max_pyramid *pyramid, const isosurface_method method, const bool bottom_is_shared);
+	template<class T>
+	bool polygonise_cell_span(const basic_voxel_volume<T> &volume, const double isolevel, const size_t first_x, const size_t last_x, const size_t y, const size_t z);
+	template<class T>
+	bool polygonise_cell(const basic_voxel_volume<T> &volume, const double isolevel, const size_t x, const size_t y, const size_t z, const int cube_index);
+	template<class T>
+	bool polygonise_tetrahedra(const basic_voxel_volume<T> &volume, const double isolevel, const size_t x, const size_t y, const size_t z, const int cube_index);
+	void add_triangle(const mesh_index a, const mesh_index b, const mesh_index c, const size_t code_a, const size_t code_b, const size_t code_c);
+	static void reset_entries(vector<mesh_index> &table, vector<size_t> &touched);
+	template<class T>
+	mesh_index get_edge_vertex(const basic_voxel_volume<T> &volume, const double isolevel, const size_t edge, const size_t x, const size_t y, const size_t z, const double *corner_values, size_t &edge_code);
+
+	// Vertex indices of the cut x and y edges on the layer's bottom and top slices, and of its z edges.
+	vector<mesh_index> x_edges[2];
+	vector<mesh_index> y_edges[2];
+	vector<mesh_index> z_edges;
+
+	// Vertex indices of the cut face diagonals; only used by marching tetrahedra.
+	vector<mesh_index> xy_diagonals[2];
+	vector<mesh_index> xz_diagonals;
+	vector<mesh_index> yz_diagonals;
+
+	// Which entries of each table have been set, so that they can be reset one by one.
+	vector<size_t> touched_x_edges[2];
+	vector<size_t> touched_y_edges[2];
+	vector<size_t> touched_z_edges;
+	vector<size_t> touched_xy_diagonals[2];
+	vector<size_t> touched_xz_diagonals;
+	vector<size_t> touched_yz_diagonals;
+
+	size_t bottom;
+	size_t first_layer;
+	bool bottom_is_shared;
+	isosurface_method method;
+
+	// Case indices of the cell span being polygonised, and the classifier's scratch space.
+	vector<uint8_t> cases;
+	vector<uint8_t> classifier_scratch;
+};
+
+// Marching cubes over a whole volume, written straight into an indexed_mesh.
+//
+// With num_threads > 1 the z layers are cut into slabs, which the threads take one at a
+// time from a shared counter until none are left, so that slabs with more surface in
+// them do not hold the others up. The slabs are then stitched together in order; the
+// vertex and triangle numbering is the same as that of a single-threaded run.
+//
+// Triangles are wound so that their normals point from the samples at or above the
+// isolevel towards those below it (out of dense material, for CT data).
+//
+// The samples are read in the volume's own type (double, float, int16_t or uint16_t; the
+// instantiations are in isosurface_extractor.cpp) and only widened to double for the
+// corners of cells that the surface cuts.
+//
+// With ISOSURFACE_MARCHING_TETRAHEDRA every cut edge is shared by exactly the cells
+// around it and no face is ambiguous, so a surface that stays inside the volume comes
+// out closed and manifold; indexed_mesh::fix_cracks() has nothing to do on it. That
+// holds where samples sit on the isolevel too, since no vertex is put on a sample (see
+// interpolate_edge()). surface_check.cpp checks both methods on such volumes.
+class isosurface_extractor
+{
+public:
+	// Replaces the mesh's contents. Returns false if the volume is smaller than one cell,
+	// or would need more vertices than mesh_index can address.
+	// If given a pyramid built from this volume, empty bricks are skipped; the mesh is the same either way.
+	template<class T>
+	bool extract(const basic_voxel_volume<T> &volume, const double isolevel, indexed_mesh &mesh, const size_t num_threads = 1, const min_max_pyramid *pyramid = 0, const isosurface_method method = ISOSURFACE_MARCHING_CUBES);
+
+private:
+	bool stitch_slabs(vector<isosurface_slab> &slabs, indexed_mesh &mesh) const;
+};
+
+
+#endif
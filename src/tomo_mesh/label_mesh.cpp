@@ -0,0 +1,62 @@
+// Meshes the given labels of a segmented volume in one pass, one STL file per label.
+//
+// Example usage: label_mesh labels.raw 512 512 400 bone 1 2 7
+// writes bone_1.stl, bone_2.stl and bone_7.stl.
+
+#include "multi_label_extractor.h"
+
+#include <cstdio>  // for snprintf()
+#include <cstdlib> // for strtoul()
+
+
+int main(int argc, char **argv)
+{
+	if(argc < 7)
+	{
+		cout << "Example usage: " << argv[0] << " labels.raw x_res y_res z_res out_prefix label [label ...]" << endl;
+		cout << "(labels.raw holds little-endian 16-bit unsigned labels)" << endl;
+		return 1;
+	}
+
+	uint16_voxel_volume labels;
+
+	if(false == labels.load_from_raw_file(argv[1], strtoul(argv[2], 0, 10), strtoul(argv[3], 0, 10), strtoul(argv[4], 0, 10)))
+	{
+		cout << "Error: Could not properly read file " << argv[1] << endl;
+		return 2;
+	}
+
+	vector<uint16_t> wanted_labels;
+
+	for(int i = 6; i < argc; i++)
+		wanted_labels.push_back(static_cast<uint16_t>(strtoul(argv[i], 0, 10)));
+
+	multi_label_extractor extractor;
+	vector<indexed_mesh> meshes;
+
+	if(false == extractor.extract(labels, wanted_labels, meshes, thread::hardware_concurrency()))
+	{
+		cout << "Error: Could not extract surfaces" << endl;
+		return 2;
+	}
+
+	for(size_t i = 0; i < meshes.size(); i++)
+	{
+		char file_name[4096];
+		snprintf(file_name, sizeof(file_name), "%s_%u.stl", argv[5], static_cast<unsigned int>(wanted_labels[i]));
+
+		if(0 == meshes[i].triangles.size())
+		{
+			cout << "Label " << wanted_labels[i] << " has no surface" << endl;
+			continue;
+		}
+
+		if(false == meshes[i].save_to_binary_stereo_lithography_file(file_name))
+		{
+			cout << "Error: Could not properly write file " << file_name << endl;
+			return 2;
+		}
+	}
+
+	return 0;
+}
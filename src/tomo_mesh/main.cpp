@@ -0,0 +1,65 @@
+#include "isosurface_extractor.h"
+
+#include <cstdlib> // for strtoul(), atof()
+
+
+int main(int argc, char **argv)
+{
+	if(argc != 7 && argc != 8)
+	{
+		cout << "Example usage: " << argv[0] << " volume.raw x_res y_res z_res isolevel out.stl [cubes|tetrahedra]" << endl;
+		cout << "(volume.raw holds little-endian 16-bit unsigned samples)" << endl;
+		cout << "(tetrahedra gives a manifold, crack-free mesh, at two to three times the triangle count)" << endl;
+		return 1;
+	}
+
+	isosurface_method method = ISOSURFACE_MARCHING_CUBES;
+
+	if(8 == argc)
+	{
+		if(string("tetrahedra") == argv[7])
+			method = ISOSURFACE_MARCHING_TETRAHEDRA;
+		else if(string("cubes") != argv[7])
+		{
+			cout << "Error: Unknown method " << argv[7] << endl;
+			return 1;
+		}
+	}
+
+	uint16_voxel_volume volume;
+
+	if(false == volume.load_from_raw_file(argv[1], strtoul(argv[2], 0, 10), strtoul(argv[3], 0, 10), strtoul(argv[4], 0, 10)))
+	{
+		cout << "Error: Could not properly read file " << argv[1] << endl;
+		return 2;
+	}
+
+	const double isolevel = atof(argv[5]);
+
+	isosurface_extractor extractor;
+	indexed_mesh mesh;
+
+	const size_t num_threads = thread::hardware_concurrency();
+
+	min_max_pyramid pyramid;
+	pyramid.build(volume, num_threads);
+
+	cout << "Extracting isosurface at " << isolevel << " on " << num_threads << " thread(s)" << endl;
+
+	if(false == extractor.extract(volume, isolevel, mesh, num_threads, &pyramid, method))
+	{
+		cout << "Error: Could not extract isosurface" << endl;
+		return 2;
+	}
+
+	cout << "Triangles: " << mesh.triangles.size() << endl;
+	cout << "Vertices:  " << mesh.vertices.size() << endl;
+
+	if(false == mesh.save_to_binary_stereo_lithography_file(argv[6]))
+	{
+		cout << "Error: Could not properly write file " << argv[6] << endl;
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef MARCHING_CUBES_TABLES_H
+#define MARCHING_CUBES_TABLES_H
+
+
+// Cube corners are numbered as in Polygonise(): 0 through 3 go around the bottom face
+// (z), starting at the cell's own voxel, then 4 through 7 do the same on the top face (z + 1).
+// Bit c of a case index is set when corner c is below the isolevel.
+//
+// Edges 0 through 3 join corners 0-1, 1-2, 2-3, 3-0, edges 4 through 7 the same
+// corners on the top face, and edges 8 through 11 join corner c to corner c + 4.
+
+// Bit e is set when edge e is cut by the surface.
+extern const int edge_table[256];
+
+// Up to five triangles per case, as triples of edge numbers, ended by -1.
+extern const int tri_table[256][16];
+
+// Voxel offset (x, y, z) of each corner from the cell's own voxel.
+extern const int corner_offsets[8][3];
+
+// The two corners of each edge, lower voxel first. Edges 12 through 18 are the diagonals
+// that marching tetrahedra adds: 0-2 and 4-6 across the bottom and top faces, 0-5 and 3-6
+// across the front (y) and back (y + 1) faces, 0-7 and 1-6 across the left (x) and right
+// (x + 1) faces, and 0-6 through the cell.
+extern const int edge_corners[19][2];
+
+// Marching tetrahedra cuts every cell into the same six tetrahedra around its 0-6 diagonal
+// (the Kuhn triangulation). Two cells that share a face therefore cut it along the same
+// diagonal, and the surface has no ambiguous faces to crack at.
+//
+// Each tetrahedron's corners, ordered so that (c1 - c0).(c2 - c0)x(c3 - c0) > 0.
+extern const int tetrahedra[6][4];
+
+// The cell edges joining tetrahedron corners 0-1, 0-2, 0-3, 1-2, 1-3 and 2-3.
+extern const int tetrahedron_edges[6][6];
+
+// Up to two triangles per case, as triples of tetrahedron edges (0 through 5, in the
+// order above), ended by -1. Bit c of a case index is set when corner c is below the isolevel.
+extern const int tetrahedron_tri_table[16][7];
+
+
+#endif
@@ -0,0 +1,150 @@
+#include "min_max_pyramid.h"
+
+
+const size_t min_max_pyramid::brick_width;
+
+// Fills in the ranges of the bricks in brick layers [first_bz, last_bz).
+template<class T>
+void min_max_pyramid::build_brick_layers(const basic_voxel_volume<T> &volume, level &bricks, const size_t first_bz, const size_t last_bz)
+{
+	for(size_t bz = first_bz; bz < last_bz; bz++)
+	{
+		for(size_t by = 0; by < bricks.y_res; by++)
+		{
+			for(size_t bx = 0; bx < bricks.x_res; bx++)
+			{
+				// The brick's cells, plus the voxels on its far faces.
+				const size_t x_end = (bx + 1)*brick_width < volume.x_res - 1 ? (bx + 1)*brick_width : volume.x_res - 1;
+				const size_t y_end = (by + 1)*brick_width < volume.y_res - 1 ? (by + 1)*brick_width : volume.y_res - 1;
+				const size_t z_end = (bz + 1)*brick_width < volume.z_res - 1 ? (bz + 1)*brick_width : volume.z_res - 1;
+
+				T brick_min = volume(bx*brick_width, by*brick_width, bz*brick_width);
+				T brick_max = brick_min;
+
+				for(size_t z = bz*brick_width; z <= z_end; z++)
+				{
+					for(size_t y = by*brick_width; y <= y_end; y++)
+					{
+						const T *row = &volume.values[volume.index(0, y, z)];
+
+						for(size_t x = bx*brick_width; x <= x_end; x++)
+						{
+							if(row[x] < brick_min)
+								brick_min = row[x];
+
+							if(row[x] > brick_max)
+								brick_max = row[x];
+						}
+					}
+				}
+
+				const size_t i = bricks.index(bx, by, bz);
+				bricks.mins[i] = brick_min;
+				bricks.maxs[i] = brick_max;
+			}
+		}
+	}
+}
+
+template<class T>
+void min_max_pyramid::build(const basic_voxel_volume<T> &volume, const size_t num_threads)
+{
+	clear();
+
+	if(volume.x_res < 2 || volume.y_res < 2 || volume.z_res < 2)
+		return;
+
+	x_res = volume.x_res;
+	y_res = volume.y_res;
+	z_res = volume.z_res;
+
+	level bricks;
+	bricks.x_res = (x_res - 1 + brick_width - 1) / brick_width;
+	bricks.y_res = (y_res - 1 + brick_width - 1) / brick_width;
+	bricks.z_res = (z_res - 1 + brick_width - 1) / brick_width;
+	bricks.mins.resize(bricks.x_res*bricks.y_res*bricks.z_res);
+	bricks.maxs.resize(bricks.mins.size());
+
+	levels.push_back(bricks);
+
+	// The bricks read every voxel once, so split them by brick layer across the threads.
+	const size_t num_ranges = (num_threads < 1) ? 1 : (num_threads < bricks.z_res ? num_threads : bricks.z_res);
+	vector<thread> threads;
+
+	for(size_t t = 1; t < num_ranges; t++)
+		threads.push_back(thread(build_brick_layers<T>, cref(volume), ref(levels[0]), bricks.z_res*t / num_ranges, bricks.z_res*(t + 1) / num_ranges));
+
+	build_brick_layers(volume, levels[0], 0, bricks.z_res / num_ranges);
+
+	for(size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	while(levels.back().x_res > 1 || levels.back().y_res > 1 || levels.back().z_res > 1)
+	{
+		const level &below = levels.back();
+
+		level above;
+		above.x_res = (below.x_res + 1) / 2;
+		above.y_res = (below.y_res + 1) / 2;
+		above.z_res = (below.z_res + 1) / 2;
+		above.mins.resize(above.x_res*above.y_res*above.z_res);
+		above.maxs.resize(above.mins.size());
+
+		for(size_t z = 0; z < above.z_res; z++)
+		{
+			for(size_t y = 0; y < above.y_res; y++)
+			{
+				for(size_t x = 0; x < above.x_res; x++)
+				{
+					const size_t i = above.index(x, y, z);
+					bool first = true;
+
+					for(size_t cz = 2*z; cz < 2*z + 2 && cz < below.z_res; cz++)
+					{
+						for(size_t cy = 2*y; cy < 2*y + 2 && cy < below.y_res; cy++)
+						{
+							for(size_t cx = 2*x; cx < 2*x + 2 && cx < below.x_res; cx++)
+							{
+								const size_t j = below.index(cx, cy, cz);
+
+								if(true == first || below.mins[j] < above.mins[i])
+									above.mins[i] = below.mins[j];
+
+								if(true == first || below.maxs[j] > above.maxs[i])
+									above.maxs[i] = below.maxs[j];
+
+								first = false;
+							}
+						}
+					}
+				}
+			}
+		}
+
+		levels.push_back(above);
+	}
+}
+
+size_t min_max_pyramid::next_straddling_brick(size_t bx, const size_t by, const size_t bz, const double isolevel) const
+{
+	while(bx < levels[0].x_res)
+	{
+		if(true == straddles(0, bx, by, bz, isolevel))
+			return bx;
+
+		// Climb to the largest node around this brick that holds no surface, then skip past it.
+		size_t l = 0;
+
+		while(l + 1 < levels.size() && false == straddles(l + 1, bx >> (l + 1), by >> (l + 1), bz >> (l + 1), isolevel))
+			l++;
+
+		bx = ((bx >> l) + 1) << l;
+	}
+
+	return levels[0].x_res;
+}
+
+template void min_max_pyramid::build<double>(const basic_voxel_volume<double> &volume, const size_t num_threads);
+template void min_max_pyramid::build<float>(const basic_voxel_volume<float> &volume, const size_t num_threads);
+template void min_max_pyramid::build<int16_t>(const basic_voxel_volume<int16_t> &volume, const size_t num_threads);
+template void min_max_pyramid::build<uint16_t>(const basic_voxel_volume<uint16_t> &volume, const size_t num_threads);
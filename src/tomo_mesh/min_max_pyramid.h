@@ -0,0 +1,84 @@
+#ifndef MIN_MAX_PYRAMID_H
+#define MIN_MAX_PYRAMID_H
+
+#include "voxel_volume.h"
+
+#include <thread>
+using std::thread;
+
+#include <functional>
+using std::ref;
+using std::cref;
+
+
+// Value ranges of a volume's cells, brick by brick, for skipping empty space.
+//
+// Level 0 holds the smallest and largest sample of each brick of brick_width^3 cells,
+// counting the voxels on its far faces, which the brick's cells share with the next
+// brick. Each level above merges 2x2x2 nodes of the one below, until a single node
+// is left. A cell can only be cut by the surface if some corner is below the isolevel
+// and some corner is not, so a node whose range does not straddle the isolevel holds
+// no surface at all.
+//
+// The pyramid depends only on the volume, so it can be built once and reused for
+// every isolevel.
+class min_max_pyramid
+{
+public:
+	static const size_t brick_width = 8;
+
+	void clear(void)
+	{
+		levels.clear();
+		x_res = y_res = z_res = 0;
+	}
+
+	// Instantiated in min_max_pyramid.cpp for the sample types of basic_voxel_volume.
+	template<class T>
+	void build(const basic_voxel_volume<T> &volume, const size_t num_threads = 1);
+
+	// True if the pyramid was built from a volume of this size.
+	template<class T>
+	inline bool fits(const basic_voxel_volume<T> &volume) const
+	{
+		return 0 != levels.size() && volume.x_res == x_res && volume.y_res == y_res && volume.z_res == z_res;
+	}
+
+	inline bool straddles(const size_t level, const size_t bx, const size_t by, const size_t bz, const double isolevel) const
+	{
+		const size_t i = levels[level].index(bx, by, bz);
+
+		return levels[level].mins[i] < isolevel && levels[level].maxs[i] >= isolevel;
+	}
+
+	// The first brick at or after bx, in brick row (by, bz), that may hold the surface,
+	// or bricks_x() if there is none. Runs of empty bricks are skipped a whole
+	// pyramid node at a time.
+	size_t next_straddling_brick(size_t bx, const size_t by, const size_t bz, const double isolevel) const;
+
+	inline size_t bricks_x(void) const { return levels[0].x_res; }
+	inline size_t num_levels(void) const { return levels.size(); }
+
+private:
+	class level
+	{
+	public:
+		inline size_t index(const size_t x, const size_t y, const size_t z) const
+		{
+			return (z*y_res + y)*x_res + x;
+		}
+
+		size_t x_res, y_res, z_res;
+		vector<double> mins;
+		vector<double> maxs;
+	};
+
+	template<class T>
+	static void build_brick_layers(const basic_voxel_volume<T> &volume, level &bricks, const size_t first_bz, const size_t last_bz);
+
+	vector<level> levels;
+	size_t x_res, y_res, z_res;
+};
+
+
+#endif
@@ -0,0 +1,223 @@
+#include "multi_label_extractor.h"
+
+
+const mesh_index multi_label_extractor::no_vertex;
+
+bool multi_label_extractor::extract(const uint16_voxel_volume &labels, const vector<uint16_t> &wanted_labels, vector<indexed_mesh> &meshes, const size_t num_threads)
+{
+	meshes.resize(wanted_labels.size());
+
+	for(size_t i = 0; i < meshes.size(); i++)
+		meshes[i].clear();
+
+	if(labels.x_res < 2 || labels.y_res < 2 || labels.z_res < 2)
+		return false;
+
+	label_meshes.assign(65536, -1);
+
+	for(size_t i = 0; i < wanted_labels.size(); i++)
+		label_meshes[wanted_labels[i]] = static_cast<int32_t>(i);
+
+	const size_t x_res = labels.x_res;
+	const size_t y_res = labels.y_res;
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		x_edges[i].assign(2*(x_res - 1)*y_res, no_vertex);
+		y_edges[i].assign(2*x_res*(y_res - 1), no_vertex);
+		touched_x_edges[i].clear();
+		touched_y_edges[i].clear();
+	}
+
+	z_edges.assign(2*x_res*y_res, no_vertex);
+	touched_z_edges.clear();
+	bottom = 0;
+
+	bool failed = false;
+
+	for(size_t z = 0; z < labels.z_res - 1 && false == failed; z++)
+	{
+		if(z > 0)
+		{
+			bottom = 1 - bottom;
+			reset_entries(x_edges[1 - bottom], touched_x_edges[1 - bottom]);
+			reset_entries(y_edges[1 - bottom], touched_y_edges[1 - bottom]);
+			reset_entries(z_edges, touched_z_edges);
+		}
+
+		for(size_t y = 0; y < y_res - 1 && false == failed; y++)
+		{
+			const uint16_t *rows[4] =
+			{
+				&labels.values[labels.index(0, y, z)],
+				&labels.values[labels.index(0, y + 1, z)],
+				&labels.values[labels.index(0, y, z + 1)],
+				&labels.values[labels.index(0, y + 1, z + 1)]
+			};
+
+			for(size_t x = 0; x < x_res - 1; x++)
+			{
+				// Corners in Polygonise() order.
+				const uint16_t corner_labels[8] =
+				{
+					rows[0][x], rows[0][x + 1], rows[1][x + 1], rows[1][x],
+					rows[2][x], rows[2][x + 1], rows[3][x + 1], rows[3][x]
+				};
+
+				bool uniform = true;
+
+				for(size_t c = 1; c < 8 && true == uniform; c++)
+					if(corner_labels[c] != corner_labels[0])
+						uniform = false;
+
+				if(true == uniform)
+					continue;
+
+				if(false == polygonise_cell(labels, x, y, z, corner_labels, meshes))
+				{
+					failed = true;
+					break;
+				}
+			}
+		}
+	}
+
+	vector<mesh_index>().swap(z_edges);
+
+	for(size_t i = 0; i < 2; i++)
+	{
+		vector<mesh_index>().swap(x_edges[i]);
+		vector<mesh_index>().swap(y_edges[i]);
+	}
+
+	if(true == failed)
+	{
+		for(size_t i = 0; i < meshes.size(); i++)
+			meshes[i].clear();
+
+		return false;
+	}
+
+	for(size_t i = 0; i < meshes.size(); i++)
+		if(0 != meshes[i].triangles.size())
+			meshes[i].generate_adjacency(num_threads);
+
+	return true;
+}
+
+void multi_label_extractor::reset_entries(vector<mesh_index> &table, vector<size_t> &touched)
+{
+	for(size_t i = 0; i < touched.size(); i++)
+		table[touched[i]] = no_vertex;
+
+	touched.clear();
+}
+
+bool multi_label_extractor::polygonise_cell(const uint16_voxel_volume &labels, const size_t x, const size_t y, const size_t z, const uint16_t *corner_labels, vector<indexed_mesh> &meshes)
+{
+	for(size_t c = 0; c < 8; c++)
+	{
+		// Each label is handled at its first corner.
+		bool seen = false;
+
+		for(size_t d = 0; d < c && false == seen; d++)
+			if(corner_labels[d] == corner_labels[c])
+				seen = true;
+
+		if(true == seen || -1 == label_meshes[corner_labels[c]])
+			continue;
+
+		indexed_mesh &mesh = meshes[label_meshes[corner_labels[c]]];
+
+		// Corners outside of the label count as below the isolevel.
+		int cube_index = 0;
+
+		for(size_t d = 0; d < 8; d++)
+			if(corner_labels[d] != corner_labels[c])
+				cube_index |= (1 << d);
+
+		mesh_index edge_vertices[12];
+
+		for(size_t e = 0; e < 12; e++)
+		{
+			if(edge_table[cube_index] & (1 << e))
+			{
+				const bool upper = (corner_labels[edge_corners[e][1]] == corner_labels[c]);
+				edge_vertices[e] = get_edge_vertex(labels, e, x, y, z, upper, mesh);
+
+				if(no_vertex == edge_vertices[e])
+					return false;
+			}
+		}
+
+		for(size_t i = 0; tri_table[cube_index][i] != -1; i += 3)
+		{
+			indexed_triangle t;
+
+			for(size_t j = 0; j < 3; j++)
+				t.vertex_indices[j] = edge_vertices[tri_table[cube_index][i + j]];
+
+			mesh.triangles.push_back(t);
+		}
+	}
+
+	return true;
+}
+
+// Returns the index of the vertex on the given edge of cell (x, y, z) in the given mesh, creating
+// it on first use. The mesh is that of the label at the edge's upper voxel if upper is set,
+// and that of the label at its lower voxel otherwise.
+mesh_index multi_label_extractor::get_edge_vertex(const uint16_voxel_volume &labels, const size_t edge, const size_t x, const size_t y, const size_t z, const bool upper, indexed_mesh &mesh)
+{
+	const int c0 = edge_corners[edge][0];
+	const int c1 = edge_corners[edge][1];
+
+	const size_t ex = x + corner_offsets[c0][0];
+	const size_t ey = y + corner_offsets[c0][1];
+	const size_t slice = (0 == corner_offsets[c0][2]) ? bottom : 1 - bottom;
+
+	vector<mesh_index> *table = 0;
+	vector<size_t> *touched = 0;
+	size_t slot_index = 0;
+
+	if(corner_offsets[c1][0] != corner_offsets[c0][0])
+	{
+		table = &x_edges[slice];
+		touched = &touched_x_edges[slice];
+		slot_index = ey*(labels.x_res - 1) + ex;
+	}
+	else if(corner_offsets[c1][1] != corner_offsets[c0][1])
+	{
+		table = &y_edges[slice];
+		touched = &touched_y_edges[slice];
+		slot_index = ey*labels.x_res + ex;
+	}
+	else
+	{
+		table = &z_edges;
+		touched = &touched_z_edges;
+		slot_index = ey*labels.x_res + ex;
+	}
+
+	slot_index = 2*slot_index + (true == upper ? 1 : 0);
+	mesh_index *slot = &(*table)[slot_index];
+
+	if(no_vertex != *slot)
+		return *slot;
+
+	if(mesh.vertices.size() >= static_cast<size_t>(no_vertex))
+		return no_vertex;
+
+	// The middle of the edge.
+	const double mx = static_cast<double>(ex) + 0.5*(corner_offsets[c1][0] - corner_offsets[c0][0]);
+	const double my = static_cast<double>(ey) + 0.5*(corner_offsets[c1][1] - corner_offsets[c0][1]);
+	const double mz = static_cast<double>(z + corner_offsets[c0][2]) + 0.5*(corner_offsets[c1][2] - corner_offsets[c0][2]);
+
+	*slot = static_cast<mesh_index>(mesh.vertices.size());
+	touched->push_back(slot_index);
+	mesh.vertices.push_back(vertex_3(static_cast<float>(labels.origin.x + labels.voxel_size.x*mx),
+									 static_cast<float>(labels.origin.y + labels.voxel_size.y*my),
+									 static_cast<float>(labels.origin.z + labels.voxel_size.z*mz)));
+
+	return *slot;
+}
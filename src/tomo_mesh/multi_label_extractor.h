@@ -0,0 +1,56 @@
+#ifndef MULTI_LABEL_EXTRACTOR_H
+#define MULTI_LABEL_EXTRACTOR_H
+
+#include "voxel_volume.h"
+#include "marching_cubes_tables.h"
+#include "../common/mesh.h"
+
+
+// Surfaces of every wanted label of a segmented volume, in one sweep over the cells.
+//
+// For label L, a cell is marching cubes on the indicator "corner == L" at an isolevel of
+// one half, so each surface vertex sits at the middle of its edge. A cell whose corners
+// all carry the same label holds no surface and costs eight loads; any other cell is
+// polygonised once for each wanted label among its corners, which is at most eight,
+// so the cost follows the number of cells and not the number of labels.
+//
+// An edge whose ends carry labels A and B is cut by the surface of A and by that of B,
+// and by no other, so the edge tables (laid out as in isosurface_slab) hold two vertex
+// indices per edge: one in the mesh of the lower voxel's label, one in that of the upper
+// voxel's label. Where two wanted labels touch, both meshes get the interface, wound
+// in opposite directions.
+//
+// Normals point out of each label, like those of isosurface_extractor for samples at or
+// above the isolevel.
+class multi_label_extractor
+{
+public:
+	// meshes[i] is replaced with the surface of wanted_labels[i]. Labels that are not
+	// wanted act as background. Returns false if the volume is smaller than one cell,
+	// or a mesh would need more vertices than mesh_index can address.
+	bool extract(const uint16_voxel_volume &labels, const vector<uint16_t> &wanted_labels, vector<indexed_mesh> &meshes, const size_t num_threads = 1);
+
+	static const mesh_index no_vertex = static_cast<mesh_index>(~static_cast<mesh_index>(0));
+
+private:
+	bool polygonise_cell(const uint16_voxel_volume &labels, const size_t x, const size_t y, const size_t z, const uint16_t *corner_labels, vector<indexed_mesh> &meshes);
+	mesh_index get_edge_vertex(const uint16_voxel_volume &labels, const size_t edge, const size_t x, const size_t y, const size_t z, const bool upper, indexed_mesh &mesh);
+	static void reset_entries(vector<mesh_index> &table, vector<size_t> &touched);
+
+	// Which of meshes each label goes to, or -1.
+	vector<int32_t> label_meshes;
+
+	// Two entries per edge: the vertex in the lower voxel's label's mesh, then the upper's.
+	vector<mesh_index> x_edges[2];
+	vector<mesh_index> y_edges[2];
+	vector<mesh_index> z_edges;
+
+	vector<size_t> touched_x_edges[2];
+	vector<size_t> touched_y_edges[2];
+	vector<size_t> touched_z_edges;
+
+	size_t bottom;
+};
+
+
+#endif
@@ -0,0 +1,145 @@
+#include "slice_stack_reader.h"
+
+#include <fstream>
+using std::ifstream;
+
+#include <ios>
+using std::ios_base;
+
+#include <cctype>
+
+
+// Reads the next number of a PGM header, skipping whitespace and comments.
+static bool read_pgm_number(ifstream &in, size_t &n)
+{
+	int c = in.get();
+
+	while(in.good() && (isspace(c) || '#' == c))
+	{
+		if('#' == c)
+			while(in.good() && '\n' != c)
+				c = in.get();
+
+		c = in.get();
+	}
+
+	if(!isdigit(c))
+		return false;
+
+	n = 0;
+
+	while(in.good() && isdigit(c))
+	{
+		n = n*10 + static_cast<size_t>(c - '0');
+		c = in.get();
+	}
+
+	// The single whitespace character after maxval is the last byte of the header.
+	return in.good() && isspace(c);
+}
+
+// Opens a slice file and reads its header, if it has one. Leaves the stream at the samples.
+static bool open_slice_file(const string &file_name, ifstream &in, size_t &x_res, size_t &y_res, size_t &bytes_per_sample, bool &big_endian)
+{
+	in.open(file_name.c_str(), ios_base::binary);
+
+	if(in.fail())
+		return false;
+
+	char magic[2] = { 0, 0 };
+	in.read(magic, 2);
+
+	if(2 != in.gcount() || 'P' != magic[0] || '5' != magic[1])
+	{
+		// Raw samples.
+		in.clear();
+		in.seekg(0, ios_base::beg);
+		bytes_per_sample = 2;
+		big_endian = false;
+		return in.good();
+	}
+
+	size_t max_value = 0;
+
+	if(false == read_pgm_number(in, x_res) || false == read_pgm_number(in, y_res) || false == read_pgm_number(in, max_value))
+		return false;
+
+	if(0 == max_value || max_value > 65535)
+		return false;
+
+	bytes_per_sample = (max_value < 256) ? 1 : 2;
+	big_endian = true;
+
+	return true;
+}
+
+bool slice_stack_reader::open(const vector<string> &src_file_names, const size_t raw_x_res, const size_t raw_y_res)
+{
+	file_names.clear();
+	x_res = raw_x_res;
+	y_res = raw_y_res;
+
+	if(0 == src_file_names.size())
+		return false;
+
+	ifstream in;
+	size_t bytes_per_sample = 0;
+	bool big_endian = false;
+
+	if(false == open_slice_file(src_file_names[0], in, x_res, y_res, bytes_per_sample, big_endian) || 0 == x_res*y_res)
+	{
+		x_res = y_res = 0;
+		return false;
+	}
+
+	file_names = src_file_names;
+
+	return true;
+}
+
+template<class T>
+bool slice_stack_reader::read_slice(const size_t z, T *slice)
+{
+	if(z >= file_names.size())
+		return false;
+
+	ifstream in;
+	size_t file_x_res = x_res, file_y_res = y_res;
+	size_t bytes_per_sample = 0;
+	bool big_endian = false;
+
+	if(false == open_slice_file(file_names[z], in, file_x_res, file_y_res, bytes_per_sample, big_endian))
+		return false;
+
+	if(file_x_res != x_res || file_y_res != y_res)
+		return false;
+
+	const size_t slice_size = x_res*y_res;
+	buffer.resize(slice_size*bytes_per_sample);
+
+	in.read(reinterpret_cast<char *>(&buffer[0]), buffer.size());
+
+	if(static_cast<size_t>(in.gcount()) != buffer.size())
+		return false;
+
+	if(1 == bytes_per_sample)
+	{
+		for(size_t i = 0; i < slice_size; i++)
+			slice[i] = static_cast<T>(buffer[i]);
+	}
+	else if(true == big_endian)
+	{
+		for(size_t i = 0; i < slice_size; i++)
+			slice[i] = static_cast<T>((buffer[2*i] << 8) | buffer[2*i + 1]);
+	}
+	else
+	{
+		for(size_t i = 0; i < slice_size; i++)
+			slice[i] = static_cast<T>(buffer[2*i] | (buffer[2*i + 1] << 8));
+	}
+
+	return true;
+}
+
+template bool slice_stack_reader::read_slice<double>(const size_t z, double *slice);
+template bool slice_stack_reader::read_slice<uint16_t>(const size_t z, uint16_t *slice);
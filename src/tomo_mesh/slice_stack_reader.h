@@ -0,0 +1,43 @@
+#ifndef SLICE_STACK_READER_H
+#define SLICE_STACK_READER_H
+
+#include <vector>
+using std::vector;
+
+#include <string>
+using std::string;
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+// Reads a volume one slice at a time from a series of slice files, one file per z.
+//
+// A file that starts with "P5" is read as a binary PGM, with 8-bit samples if its maxval
+// is below 256 and 16-bit big-endian ones otherwise; the slice size comes from its header.
+// Any other file is read as raw little-endian 16-bit unsigned samples, x_res*y_res of them.
+// Every slice must be the same size as the first.
+class slice_stack_reader
+{
+public:
+	slice_stack_reader(void) : x_res(0), y_res(0) { }
+
+	// Reads the first file's header. raw_x_res and raw_y_res are only used for raw slices.
+	bool open(const vector<string> &src_file_names, const size_t raw_x_res = 0, const size_t raw_y_res = 0);
+
+	// Reads slice z into x_res*y_res samples, x fastest.
+	// Instantiated in slice_stack_reader.cpp for double and uint16_t samples.
+	template<class T>
+	bool read_slice(const size_t z, T *slice);
+
+	inline size_t z_res(void) const { return file_names.size(); }
+
+	size_t x_res, y_res;
+
+private:
+	vector<string> file_names;
+	vector<unsigned char> buffer;
+};
+
+
+#endif
@@ -0,0 +1,112 @@
+#include "stl_stream_writer.h"
+
+#include <ios>
+using std::ios_base;
+
+#include <cstring> // for memcpy()
+
+
+static const size_t header_size = 80;
+
+// Enough bytes for twelve 4-byte floats plus one 2-byte integer, per triangle.
+static const size_t per_triangle_data_size = 12*sizeof(float) + sizeof(short unsigned int);
+
+
+stl_stream_writer::stl_stream_writer(void)
+{
+	buffer_width = 0;
+	buffer_count = 0;
+	num_triangles = 0;
+	failed = false;
+}
+
+stl_stream_writer::~stl_stream_writer(void)
+{
+	if(out.is_open())
+		close();
+}
+
+bool stl_stream_writer::open(const char *const file_name, const size_t src_buffer_width)
+{
+	if(out.is_open())
+		close();
+
+	buffer_width = (0 == src_buffer_width) ? 1 : src_buffer_width;
+	buffer_count = 0;
+	num_triangles = 0;
+	failed = false;
+
+	out.clear();
+	out.open(file_name, ios_base::binary);
+
+	if(out.fail())
+		return false;
+
+	// Write a blank header, and a triangle count to be filled in later.
+	buffer.assign(header_size + sizeof(unsigned int), 0);
+	out.write(&buffer[0], buffer.size());
+
+	buffer.assign(per_triangle_data_size*buffer_width, 0);
+
+	return out.good();
+}
+
+void stl_stream_writer::add_triangle(const vertex_3 &v0, const vertex_3 &v1, const vertex_3 &v2)
+{
+	vertex_3 normal = (v1 - v0).cross(v2 - v0);
+	normal.normalize();
+
+	char *cp = &buffer[per_triangle_data_size*buffer_count];
+	const vertex_3 *const data[4] = { &normal, &v0, &v1, &v2 };
+
+	for(size_t i = 0; i < 4; i++)
+	{
+		memcpy(cp, &data[i]->x, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &data[i]->y, sizeof(float)); cp += sizeof(float);
+		memcpy(cp, &data[i]->z, sizeof(float)); cp += sizeof(float);
+	}
+
+	// The attribute byte count stays zero.
+
+	num_triangles++;
+
+	if(++buffer_count == buffer_width)
+		flush();
+}
+
+bool stl_stream_writer::flush(void)
+{
+	if(0 != buffer_count)
+		out.write(&buffer[0], per_triangle_data_size*buffer_count);
+
+	buffer_count = 0;
+
+	if(out.fail())
+		failed = true;
+
+	return false == failed;
+}
+
+bool stl_stream_writer::close(void)
+{
+	if(false == out.is_open())
+		return false;
+
+	flush();
+
+	if(num_triangles > 0xffffffff)
+		failed = true;
+
+	const unsigned int count = static_cast<unsigned int>(num_triangles); // Must be 4-byte unsigned int.
+
+	out.seekp(header_size, ios_base::beg);
+	out.write(reinterpret_cast<const char *>(&count), sizeof(unsigned int));
+	out.close();
+
+	if(out.fail())
+		failed = true;
+
+	vector<char>().swap(buffer);
+
+	return false == failed;
+}
@@ -0,0 +1,42 @@
+#ifndef STL_STREAM_WRITER_H
+#define STL_STREAM_WRITER_H
+
+#include "../common/primitives.h"
+
+#include <fstream>
+using std::ofstream;
+
+#include <vector>
+using std::vector;
+
+
+// Writes a binary STL file a triangle at a time, in the same layout as
+// indexed_mesh::save_to_binary_stereo_lithography_file(), without holding the mesh.
+// The triangle count in the header is filled in by close().
+class stl_stream_writer
+{
+public:
+	stl_stream_writer(void);
+	~stl_stream_writer(void);
+
+	bool open(const char *const file_name, const size_t src_buffer_width = 65536);
+	void add_triangle(const vertex_3 &v0, const vertex_3 &v1, const vertex_3 &v2);
+
+	// Returns false if any write failed, or if there were more triangles than the header can count.
+	bool close(void);
+
+	inline size_t triangle_count(void) const { return num_triangles; }
+
+private:
+	bool flush(void);
+
+	ofstream out;
+	vector<char> buffer;
+	size_t buffer_width;
+	size_t buffer_count;
+	size_t num_triangles;
+	bool failed;
+};
+
+
+#endif
@@ -0,0 +1,88 @@
+#include "streaming_extractor.h"
+
+#include <algorithm>
+using std::copy;
+
+
+bool streaming_extractor::extract(slice_stack_reader &reader, const double isolevel, stl_stream_writer &writer, const vertex_3 &origin, const vertex_3 &voxel_size, const isosurface_method method)
+{
+	num_vertices = 0;
+
+	const size_t slice_size = reader.x_res*reader.y_res;
+
+	if(reader.x_res < 2 || reader.y_res < 2 || reader.z_res() < 2)
+		return false;
+
+	// Every format the reader knows fits in 16 unsigned bits.
+	uint16_voxel_volume window;
+	window.resize(reader.x_res, reader.y_res, 2);
+	window.voxel_size = voxel_size;
+
+	if(false == reader.read_slice(0, &window.values[slice_size]))
+		return false;
+
+	// The layers take turns with the two slabs, so that the layer below is still
+	// there to take the shared vertices from.
+	isosurface_slab slabs[2];
+
+	for(size_t z = 0; z < reader.z_res() - 1; z++)
+	{
+		isosurface_slab &layer = slabs[z % 2];
+		const isosurface_slab &layer_below = slabs[1 - z % 2];
+
+		// Slide the window up a slice.
+		copy(window.values.begin() + slice_size, window.values.end(), window.values.begin());
+
+		if(false == reader.read_slice(z + 1, &window.values[slice_size]))
+			return false;
+
+		window.origin = origin;
+		window.origin.z = static_cast<float>(origin.z + static_cast<double>(voxel_size.z)*static_cast<double>(z));
+
+		if(false == layer.extract_window(window, isolevel, 0 != z, method))
+			return false;
+
+		if(false == write_layer(layer, layer_below, writer))
+			return false;
+
+		num_vertices += layer.vertices.size();
+
+		// The next layer only needs this one's top slice tables, and the vertices they point to.
+		layer.release_working_tables();
+		vector<indexed_triangle>().swap(layer.triangles);
+	}
+
+	return true;
+}
+
+// Writes the layer's triangles, taking pending corners from the layer below.
+bool streaming_extractor::write_layer(const isosurface_slab &layer, const isosurface_slab &layer_below, stl_stream_writer &writer) const
+{
+	size_t next_pending = 0;
+
+	for(size_t i = 0; i < layer.triangles.size(); i++)
+	{
+		const vertex_3 *corners[3];
+
+		for(size_t j = 0; j < 3; j++)
+		{
+			if(next_pending < layer.pending_corners.size() && layer.pending_corners[next_pending] == 3*i + j)
+			{
+				const mesh_index v = layer_below.top_slice_vertex(layer.pending_edge_codes[next_pending++]);
+
+				if(isosurface_slab::no_vertex == v)
+					return false;
+
+				corners[j] = &layer_below.vertices[v];
+			}
+			else
+			{
+				corners[j] = &layer.vertices[layer.triangles[i].vertex_indices[j]];
+			}
+		}
+
+		writer.add_triangle(*corners[0], *corners[1], *corners[2]);
+	}
+
+	return true;
+}
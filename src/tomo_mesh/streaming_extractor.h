@@ -0,0 +1,32 @@
+#ifndef STREAMING_EXTRACTOR_H
+#define STREAMING_EXTRACTOR_H
+
+#include "isosurface_extractor.h"
+#include "slice_stack_reader.h"
+#include "stl_stream_writer.h"
+
+
+// Marching cubes over a volume too large to hold in memory, a layer at a time.
+//
+// Only a window of two slices (of 16-bit samples) is held, along with the meshes (and edge tables) of the
+// current layer and the one below it. Each layer is meshed as a slab of its own, whose
+// bottom slice vertices are taken from the layer below (see isosurface_slab), so the
+// triangles come out in the same order as those of isosurface_extractor, and meet along
+// the slices just the same. They are written out as soon as their layer is done.
+class streaming_extractor
+{
+public:
+	// origin and voxel_size place the volume as voxel_volume's members do.
+	bool extract(slice_stack_reader &reader, const double isolevel, stl_stream_writer &writer, const vertex_3 &origin = vertex_3(0, 0, 0), const vertex_3 &voxel_size = vertex_3(1, 1, 1), const isosurface_method method = ISOSURFACE_MARCHING_CUBES);
+
+	// Distinct vertices in the last extraction.
+	size_t vertex_count(void) const { return num_vertices; }
+
+private:
+	bool write_layer(const isosurface_slab &layer, const isosurface_slab &layer_below, stl_stream_writer &writer) const;
+
+	size_t num_vertices;
+};
+
+
+#endif
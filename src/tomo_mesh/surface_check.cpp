@@ -0,0 +1,172 @@
+// Checks that both extraction methods give closed, manifold meshes, also where samples
+// sit exactly on the isolevel, as they often do in integer CT data at an integer isolevel.
+//
+// Each volume has a border of samples below the isolevel, so the surface stays inside it.
+// Each mesh must be closed (each edge used once in each direction, so no edge has more
+// than two triangles) and welded (no two vertices in the same place), with no two
+// triangles on the same three vertices and no triangle without area.
+//
+// The volumes are three-level noise (0, 500 and 1000, at isolevel 500), a stepped sphere
+// with a whole shell of samples on the isolevel, and noise with none on it.
+//
+// Example usage: surface_check [resolution]
+
+#include "isosurface_extractor.h"
+#include "../boolean_poly/test_support.h"
+
+#include <iostream>
+using std::cout;
+using std::endl;
+
+#include <algorithm>
+using std::sort;
+using std::adjacent_find;
+
+#include <cmath>
+#include <cstdlib> // for strtoul()
+
+
+// A fixed sequence, so that every run checks the same volumes.
+static uint32_t next_random(uint32_t &state)
+{
+	state = state*1664525u + 1013904223u;
+	return state >> 8;
+}
+
+// Whether some two triangles use the same three vertices, in whatever order.
+static bool has_repeated_triangles(const indexed_mesh &mesh)
+{
+	vector< vector<mesh_index> > keys(mesh.triangles.size(), vector<mesh_index>(3));
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		for(size_t j = 0; j < 3; j++)
+			keys[i][j] = mesh.triangles[i].vertex_indices[j];
+
+		sort(keys[i].begin(), keys[i].end());
+	}
+
+	sort(keys.begin(), keys.end());
+
+	return (keys.end() != adjacent_find(keys.begin(), keys.end()));
+}
+
+static size_t count_flat_triangles(const indexed_mesh &mesh)
+{
+	size_t count = 0;
+
+	for(size_t i = 0; i < mesh.triangles.size(); i++)
+	{
+		const vertex_3 &a = mesh.vertices[mesh.triangles[i].vertex_indices[0]];
+		const vertex_3 &b = mesh.vertices[mesh.triangles[i].vertex_indices[1]];
+		const vertex_3 &c = mesh.vertices[mesh.triangles[i].vertex_indices[2]];
+
+		const double u[3] = { double(b.x) - a.x, double(b.y) - a.y, double(b.z) - a.z };
+		const double v[3] = { double(c.x) - a.x, double(c.y) - a.y, double(c.z) - a.z };
+		const double n[3] = { u[1]*v[2] - u[2]*v[1], u[2]*v[0] - u[0]*v[2], u[0]*v[1] - u[1]*v[0] };
+
+		if(0.0 == n[0] && 0.0 == n[1] && 0.0 == n[2])
+			count++;
+	}
+
+	return count;
+}
+
+static bool check_volume(const char *const name, const uint16_voxel_volume &volume, const double isolevel)
+{
+	size_t on_isolevel = 0;
+
+	for(size_t i = 0; i < volume.values.size(); i++)
+		if(isolevel == volume.values[i])
+			on_isolevel++;
+
+	cout << name << ": " << volume.x_res << "^3 samples, " << on_isolevel << " on the isolevel" << endl;
+
+	const isosurface_method methods[2] = { ISOSURFACE_MARCHING_CUBES, ISOSURFACE_MARCHING_TETRAHEDRA };
+	const char *const method_names[2] = { "cubes", "tetrahedra" };
+	bool passed = true;
+
+	for(size_t m = 0; m < 2; m++)
+	{
+		isosurface_extractor extractor;
+		indexed_mesh mesh;
+
+		if(false == extractor.extract(volume, isolevel, mesh, 1, 0, methods[m]))
+		{
+			cout << "  " << method_names[m] << ": could not extract" << endl;
+			passed = false;
+			continue;
+		}
+
+		const bool closed = is_closed(mesh), welded = is_welded(mesh);
+		const bool repeated = has_repeated_triangles(mesh);
+		const size_t flat_count = count_flat_triangles(mesh);
+
+		cout << "  " << method_names[m] << ": " << mesh.triangles.size() << " triangles, " << mesh.vertices.size() << " vertices, "
+		     << (closed ? "closed" : "NOT CLOSED") << ", " << (welded ? "welded" : "NOT WELDED") << ", "
+		     << (repeated ? "REPEATED TRIANGLES" : "no repeated triangles") << ", " << flat_count << " without area" << endl;
+
+		passed = passed && closed && welded && false == repeated && 0 == flat_count && false == mesh.triangles.empty();
+	}
+
+	return passed;
+}
+
+int main(int argc, char **argv)
+{
+	size_t resolution = 64;
+
+	if(argc > 1)
+		resolution = strtoul(argv[1], 0, 10);
+
+	if(resolution < 8)
+	{
+		cout << "Example usage: " << argv[0] << " [resolution]" << endl;
+		return 1;
+	}
+
+	uint16_voxel_volume volume;
+	volume.resize(resolution, resolution, resolution);
+	bool passed = true;
+	uint32_t state = 1;
+
+	const double middle = 0.5*(resolution - 1);
+
+	for(size_t z = 1; z + 1 < resolution; z++)
+		for(size_t y = 1; y + 1 < resolution; y++)
+			for(size_t x = 1; x + 1 < resolution; x++)
+				volume(x, y, z) = static_cast<uint16_t>(500*(next_random(state) % 3));
+
+	passed = check_volume("Three-level noise", volume, 500.0) && passed;
+
+	// Steps of 100 per voxel out from the middle, so that a whole shell of voxels, one
+	// voxel thick, sits on the isolevel.
+	const double radius = 0.3*resolution;
+
+	for(size_t z = 0; z < resolution; z++)
+	{
+		for(size_t y = 0; y < resolution; y++)
+		{
+			for(size_t x = 0; x < resolution; x++)
+			{
+				const double r = sqrt((x - middle)*(x - middle) + (y - middle)*(y - middle) + (z - middle)*(z - middle));
+				const double value = 500.0 + 100.0*floor(radius - r + 0.5);
+
+				volume(x, y, z) = static_cast<uint16_t>((value < 0.0) ? 0.0 : ((value > 1000.0) ? 1000.0 : value));
+			}
+		}
+	}
+
+	passed = check_volume("Stepped sphere", volume, 500.0) && passed;
+
+	for(size_t z = 1; z + 1 < resolution; z++)
+		for(size_t y = 1; y + 1 < resolution; y++)
+			for(size_t x = 1; x + 1 < resolution; x++)
+				volume(x, y, z) = static_cast<uint16_t>(next_random(state) % 1000);
+
+	passed = check_volume("Noise", volume, 499.5) && passed;
+
+	cout << (passed ? "All surfaces closed and manifold" : "SOME SURFACES FAILED") << endl;
+
+	return passed ? 0 : 2;
+}
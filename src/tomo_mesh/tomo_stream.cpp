@@ -0,0 +1,127 @@
+// Meshes a stack of slice files without loading the whole volume, and writes the
+// triangles to a binary STL file as it goes.
+//
+// Example usage: tomo_stream slices/slice_%04d.pgm 0 511 1200 out.stl
+// Raw slices (little-endian 16-bit unsigned samples) also need their size:
+//                tomo_stream slices/slice_%04d.raw 0 511 1200 out.stl 512 512
+
+#include "streaming_extractor.h"
+
+#include <cstdio>  // for snprintf()
+#include <cstdlib> // for strtoul(), atof()
+#include <cstring> // for strchr()
+
+
+// Whether pattern holds exactly one conversion, and it is of an int (%d or %i, with any
+// flags, width and precision, but no * or length modifier); %% is allowed anywhere. Only
+// then can it be handed to snprintf() with the slice index.
+static bool is_index_pattern(const char *pattern)
+{
+	size_t conversions = 0;
+
+	for(const char *c = pattern; '\0' != *c; c++)
+	{
+		if('%' != *c)
+			continue;
+
+		c++;
+
+		if('%' == *c)
+			continue;
+
+		while('\0' != *c && 0 != strchr("-+ #0", *c))
+			c++;
+
+		while(*c >= '0' && *c <= '9')
+			c++;
+
+		if('.' == *c)
+			for(c++; *c >= '0' && *c <= '9'; c++);
+
+		if('d' != *c && 'i' != *c)
+			return false;
+
+		conversions++;
+	}
+
+	return (1 == conversions);
+}
+
+int main(int argc, char **argv)
+{
+	if(argc != 6 && argc != 8)
+	{
+		cout << "Example usage: " << argv[0] << " slice_%04d.pgm first_index last_index isolevel out.stl [x_res y_res]" << endl;
+		cout << "(x_res and y_res are needed for raw slices of little-endian 16-bit unsigned samples)" << endl;
+		return 1;
+	}
+
+	const size_t first_index = strtoul(argv[2], 0, 10);
+	const size_t last_index = strtoul(argv[3], 0, 10);
+	const double isolevel = atof(argv[4]);
+	size_t raw_x_res = 0, raw_y_res = 0;
+
+	if(8 == argc)
+	{
+		raw_x_res = strtoul(argv[6], 0, 10);
+		raw_y_res = strtoul(argv[7], 0, 10);
+	}
+
+	if(false == is_index_pattern(argv[1]))
+	{
+		cout << "Error: " << argv[1] << " must hold one %d (e.g. %04d) for the slice index, and no other conversion" << endl;
+		return 1;
+	}
+
+	if(last_index < first_index)
+	{
+		cout << "Error: No slices from " << first_index << " to " << last_index << endl;
+		return 1;
+	}
+
+	vector<string> file_names;
+	char file_name[4096];
+
+	for(size_t i = first_index; i <= last_index; i++)
+	{
+		snprintf(file_name, sizeof(file_name), argv[1], static_cast<int>(i));
+		file_names.push_back(file_name);
+	}
+
+	slice_stack_reader reader;
+
+	if(false == reader.open(file_names, raw_x_res, raw_y_res))
+	{
+		cout << "Error: Could not properly read slices " << argv[1] << " from " << first_index << " to " << last_index << endl;
+		return 2;
+	}
+
+	cout << "Streaming " << reader.x_res << "x" << reader.y_res << "x" << reader.z_res() << " voxels, isolevel " << isolevel << endl;
+
+	stl_stream_writer writer;
+
+	if(false == writer.open(argv[5]))
+	{
+		cout << "Error: Could not properly write file " << argv[5] << endl;
+		return 2;
+	}
+
+	streaming_extractor extractor;
+
+	if(false == extractor.extract(reader, isolevel, writer))
+	{
+		cout << "Error: Could not extract isosurface" << endl;
+		return 2;
+	}
+
+	if(false == writer.close())
+	{
+		cout << "Error: Could not properly write file " << argv[5] << endl;
+		return 2;
+	}
+
+	cout << "Triangles: " << writer.triangle_count() << endl;
+	cout << "Vertices:  " << extractor.vertex_count() << endl;
+
+	return 0;
+}
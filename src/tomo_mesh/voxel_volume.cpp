@@ -0,0 +1,64 @@
+#include "voxel_volume.h"
+
+#include <fstream>
+using std::ifstream;
+
+#include <ios>
+using std::ios_base;
+
+
+// Converts a raw 16-bit unsigned sample to the volume's sample type.
+template<class T>
+static inline T from_raw_sample(const uint16_t s)
+{
+	return static_cast<T>(s);
+}
+
+template<>
+inline int16_t from_raw_sample<int16_t>(const uint16_t s)
+{
+	return static_cast<int16_t>(s > 32767 ? 32767 : s);
+}
+
+template<class T>
+bool basic_voxel_volume<T>::load_from_raw_file(const char *const file_name, const size_t src_x_res, const size_t src_y_res, const size_t src_z_res)
+{
+	clear();
+
+	if(0 == src_x_res*src_y_res*src_z_res)
+		return false;
+
+	ifstream in(file_name, ios_base::binary);
+
+	if(in.fail())
+		return false;
+
+	resize(src_x_res, src_y_res, src_z_res);
+
+	// Read a slice at a time.
+	const size_t slice_size = x_res*y_res;
+	vector<unsigned char> buffer(slice_size*2);
+
+	for(size_t z = 0; z < z_res; z++)
+	{
+		in.read(reinterpret_cast<char *>(&buffer[0]), buffer.size());
+
+		if(static_cast<size_t>(in.gcount()) != buffer.size())
+		{
+			clear();
+			return false;
+		}
+
+		T *slice = &values[z*slice_size];
+
+		for(size_t i = 0; i < slice_size; i++)
+			slice[i] = from_raw_sample<T>(static_cast<uint16_t>(buffer[2*i] | (buffer[2*i + 1] << 8)));
+	}
+
+	return true;
+}
+
+template class basic_voxel_volume<double>;
+template class basic_voxel_volume<float>;
+template class basic_voxel_volume<int16_t>;
+template class basic_voxel_volume<uint16_t>;
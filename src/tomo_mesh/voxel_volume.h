@@ -0,0 +1,73 @@
+#ifndef VOXEL_VOLUME_H
+#define VOXEL_VOLUME_H
+
+#include "../common/primitives.h"
+
+#include <vector>
+using std::vector;
+
+#include <stdint.h>
+
+
+// A regular grid of scalar samples (e.g. CT densities), stored x fastest, then y, then z.
+// Voxel (x, y, z) sits at origin + (x*voxel_size.x, y*voxel_size.y, z*voxel_size.z).
+//
+// The samples can be kept in their native type: 16-bit CT data kept as uint16_t takes a
+// quarter of the memory, and of the memory traffic, that it does as doubles. Positions
+// are never stored; they are worked out from the grid coordinates when needed.
+// The member functions are instantiated in voxel_volume.cpp for double, float,
+// int16_t and uint16_t.
+template<class T>
+class basic_voxel_volume
+{
+public:
+	typedef T sample_type;
+
+	basic_voxel_volume(void) : x_res(0), y_res(0), z_res(0), origin(0, 0, 0), voxel_size(1, 1, 1) { }
+
+	void clear(void)
+	{
+		x_res = y_res = z_res = 0;
+		values.clear();
+	}
+
+	void resize(const size_t src_x_res, const size_t src_y_res, const size_t src_z_res)
+	{
+		x_res = src_x_res;
+		y_res = src_y_res;
+		z_res = src_z_res;
+		values.assign(x_res*y_res*z_res, T(0));
+	}
+
+	inline size_t index(const size_t x, const size_t y, const size_t z) const
+	{
+		return (z*y_res + y)*x_res + x;
+	}
+
+	inline T operator()(const size_t x, const size_t y, const size_t z) const
+	{
+		return values[index(x, y, z)];
+	}
+
+	inline T &operator()(const size_t x, const size_t y, const size_t z)
+	{
+		return values[index(x, y, z)];
+	}
+
+	// Reads x_res*y_res*z_res little-endian 16-bit unsigned samples, the usual CT export.
+	// For int16_t samples, values above 32767 are clamped.
+	bool load_from_raw_file(const char *const file_name, const size_t src_x_res, const size_t src_y_res, const size_t src_z_res);
+
+	size_t x_res, y_res, z_res;
+	vertex_3 origin;
+	vertex_3 voxel_size;
+	vector<T> values;
+};
+
+typedef basic_voxel_volume<double> voxel_volume;
+typedef basic_voxel_volume<float> float_voxel_volume;
+typedef basic_voxel_volume<int16_t> int16_voxel_volume;
+typedef basic_voxel_volume<uint16_t> uint16_voxel_volume;
+
+
+#endif